@@ -2,6 +2,7 @@
 
 #include "broadway-buffer.h"
 
+#include <stdlib.h>
 #include <string.h>
 
 /* This code is based on some code from weston with this license:
@@ -36,13 +37,15 @@ struct entry {
 };
 
 struct _BroadwayBuffer {
+  int ref_count;
   guint8 *data;
   struct entry *table;
+  guint32 *block_hashes;
+  BroadwayRect *damage;
+  int n_damage;
   int width, height, stride;
-  int encoded;
   int block_stride, length, block_count, shift;
   int stats[5];
-  int clashes;
 };
 
 static const guint32 prime = 0x1f821e2d;
@@ -59,7 +62,8 @@ static const int block_size = 32, block_mask = 31;
 
 static gboolean
 verify_block_match (BroadwayBuffer *buffer, int x, int y,
-                    BroadwayBuffer *prev, struct entry *entry)
+                    BroadwayBuffer *prev, struct entry *entry,
+                    int *clashes)
 {
   int i;
   void *old, *match;
@@ -90,7 +94,7 @@ verify_block_match (BroadwayBuffer *buffer, int x, int y,
       old = prev->data + (entry->y + i) * prev->stride + entry->x * 4;
       if (memcmp (match, old, w1 * 4) != 0)
         {
-          buffer->clashes++;
+          (*clashes)++;
           return FALSE;
         }
     }
@@ -148,6 +152,8 @@ struct encoder {
   guint32 delta_run;
   GString *dest;
   int bytes;
+  int matches;
+  int clashes;
 };
 
 /* Encoding:
@@ -258,6 +264,33 @@ encode_pixel (struct encoder *encoder, guint32 color, guint32 prev_color)
     }
 }
 
+/* Emits length pixels that are unchanged from the previous buffer,
+ * merging them into the current delta 0 run if possible */
+static void
+encode_skip (struct encoder *encoder, guint32 length)
+{
+  guint32 n;
+
+  while (length > 0)
+    {
+      if (encoder->delta != 0 ||
+          encoder->delta_run <= encoder->color_run ||
+          encoder->delta_run == 0xFFFFF)
+        {
+          encode_run (encoder);
+          encoder->delta = 0;
+          encoder->delta_run = 0;
+        }
+
+      /* The skipped pixels end any color run */
+      encoder->color_run = 0;
+
+      n = MIN (length, 0xFFFFF - encoder->delta_run);
+      encoder->delta_run += n;
+      length -= n;
+    }
+}
+
 static void
 encoder_flush (struct encoder *encoder)
 {
@@ -278,11 +311,24 @@ encode_block (struct encoder *encoder, struct entry *entry, int x, int y)
   emit (encoder, (x << 16) | y);
 }
 
+BroadwayBuffer *
+broadway_buffer_ref (BroadwayBuffer *buffer)
+{
+  g_atomic_int_inc (&buffer->ref_count);
+
+  return buffer;
+}
+
 void
-broadway_buffer_destroy (BroadwayBuffer *buffer)
+broadway_buffer_unref (BroadwayBuffer *buffer)
 {
+  if (!g_atomic_int_dec_and_test (&buffer->ref_count))
+    return;
+
   g_free (buffer->data);
   g_free (buffer->table);
+  g_free (buffer->block_hashes);
+  g_free (buffer->damage);
   g_free (buffer);
 }
 
@@ -327,13 +373,83 @@ unpremultiply_line (void *destp, void *srcp, int width)
     }
 }
 
+/* Hash of the block_size pixels starting at x in row y, pixels outside
+ * the buffer count as 0. This is what the sliding row hash in
+ * encode_span() computes incrementally. */
+static guint32
+row_hash (BroadwayBuffer *buffer, int x, int y)
+{
+  guint32 *line;
+  guint32 hash;
+  int j;
+
+  if (y >= buffer->height)
+    return 0;
+
+  line = (guint32 *)(buffer->data + y * buffer->stride);
+  hash = 0;
+  for (j = x; j < x + block_size; j++)
+    {
+      hash = hash * prime;
+      if (j < buffer->width)
+        hash += line[j];
+    }
+
+  return hash;
+}
+
+static guint32
+block_hash (BroadwayBuffer *buffer, int x, int y)
+{
+  guint32 hash;
+  int i;
+
+  hash = 0;
+  for (i = y; i < y + block_size; i++)
+    hash = hash * vprime + row_hash (buffer, x, i);
+
+  return hash;
+}
+
+static void
+update_block_hashes (BroadwayBuffer *buffer, const BroadwayRect *rect)
+{
+  int bx, by, bx0, bx1, by0, by1;
+
+  bx0 = rect->x / block_size;
+  by0 = rect->y / block_size;
+  bx1 = (rect->x + rect->width + block_size - 1) / block_size;
+  by1 = (rect->y + rect->height + block_size - 1) / block_size;
+
+  for (by = by0; by < by1; by++)
+    for (bx = bx0; bx < bx1; bx++)
+      buffer->block_hashes[by * buffer->block_stride + bx] =
+        block_hash (buffer, bx * block_size, by * block_size);
+}
+
+/* Creates a buffer from the (premultiplied) data.
+ *
+ * If prev is a buffer of the same size, only the pixels inside the
+ * damage rectangles are read from data, the rest is taken from prev,
+ * and a later broadway_buffer_encode() against prev only looks at the
+ * damaged area. The rectangles must not overlap and be sorted in the
+ * y-x banded order of cairo_region_get_rectangle().
+ */
 BroadwayBuffer *
-broadway_buffer_create (int width, int height, guint8 *data, int stride)
+broadway_buffer_create (int                 width,
+                        int                 height,
+                        guint8             *data,
+                        int                 stride,
+                        BroadwayBuffer     *prev,
+                        const BroadwayRect *damage,
+                        int                 n_damage)
 {
   BroadwayBuffer *buffer;
-  int y, bits_required;
+  const BroadwayRect *rect;
+  int x, y, i, bits_required;
 
   buffer = g_new0 (BroadwayBuffer, 1);
+  buffer->ref_count = 1;
   buffer->width = width;
   buffer->stride = width * 4;
   buffer->height = height;
@@ -346,161 +462,577 @@ broadway_buffer_create (int width, int height, guint8 *data, int stride)
   buffer->length = 1 << bits_required;
 
   buffer->table = g_malloc0 (buffer->length * sizeof buffer->table[0]);
+  buffer->block_hashes = g_new (guint32, buffer->block_count);
 
   memset (buffer->stats, 0, sizeof buffer->stats);
-  buffer->clashes = 0;
 
   buffer->data = g_malloc (buffer->stride * height);
 
-  for (y = 0; y < height; y++)
-    unpremultiply_line (buffer->data + y * buffer->stride, data + y * stride, width);
+  if (prev != NULL && damage != NULL &&
+      prev->width == width && prev->height == height)
+    {
+      buffer->damage = g_new (BroadwayRect, MAX (n_damage, 1));
+      memcpy (buffer->damage, damage, n_damage * sizeof damage[0]);
+      buffer->n_damage = n_damage;
+
+      memcpy (buffer->data, prev->data, buffer->stride * height);
+      memcpy (buffer->block_hashes, prev->block_hashes,
+              buffer->block_count * sizeof buffer->block_hashes[0]);
+
+      for (i = 0; i < n_damage; i++)
+        {
+          rect = &damage[i];
+          for (y = rect->y; y < rect->y + rect->height; y++)
+            unpremultiply_line (buffer->data + y * buffer->stride + rect->x * 4,
+                                data + y * stride + rect->x * 4,
+                                rect->width);
+        }
+
+      for (i = 0; i < n_damage; i++)
+        update_block_hashes (buffer, &damage[i]);
+    }
+  else
+    {
+      for (y = 0; y < height; y++)
+        unpremultiply_line (buffer->data + y * buffer->stride, data + y * stride, width);
+
+      for (y = 0; y < height; y += block_size)
+        for (x = 0; x < width; x += block_size)
+          buffer->block_hashes[(y / block_size) * buffer->block_stride + x / block_size] =
+            block_hash (buffer, x, y);
+    }
+
+  for (y = 0; y < height; y += block_size)
+    for (x = 0; x < width; x += block_size)
+      insert_block (buffer,
+                    buffer->block_hashes[(y / block_size) * buffer->block_stride + x / block_size],
+                    x, y);
 
   return buffer;
 }
 
-void
-broadway_buffer_encode (BroadwayBuffer *buffer, BroadwayBuffer *prev, GString *dest)
+/* Sets up the vertical block hashes for columns x0 to x1 at row y */
+static void
+init_block_hashes (BroadwayBuffer *buffer, guint32 *block_hashes,
+                   int x0, int x1, int y)
+{
+  guint32 hash, *line;
+  int i, j;
+
+  for (j = x0; j < x1; j++)
+    block_hashes[j] = 0;
+
+  for (i = y; i < y + block_size; i++)
+    {
+      if (i >= buffer->height)
+        {
+          // Do the last rows if we're close to the bottom
+          for (j = x0; j < x1; j++)
+            block_hashes[j] = block_hashes[j] * vprime;
+          continue;
+        }
+
+      line = (guint32 *)(buffer->data + i * buffer->stride);
+      hash = row_hash (buffer, x0, i);
+
+      for (j = x0; j < x1; j++)
+        {
+          block_hashes[j] = block_hashes[j] * vprime + hash;
+
+          hash = hash * prime - line[j] * end_prime;
+          if (j + block_size < buffer->width)
+            hash += line[j + block_size];
+        }
+    }
+}
+
+/* Encodes the pixels x0 to x1 of row i, and slides the block hashes
+ * of those columns down to the next row */
+static void
+encode_span (struct encoder *encoder,
+             BroadwayBuffer *buffer,
+             BroadwayBuffer *prev,
+             guint32        *block_hashes,
+             int            *skyline,
+             int             x0,
+             int             x1,
+             int             i,
+             int             block_limit)
 {
   struct entry *entry;
-  int i, j, k;
-  int x0, x1, y0, y1;
-  guint32 *block_hashes;
   guint32 hash, bottom_hash, h, *line, *bottom, *prev_line;
   int width, height;
-  struct encoder encoder = { 0 };
-  int *skyline, skyline_pixels;
-  int matches;
+  int j, k;
+  int skyline_pixels;
 
   width = buffer->width;
   height = buffer->height;
-  x0 = 0;
-  x1 = width;
-  y0 = 0;
-  y1 = height;
-
-  skyline = g_malloc0 ((width + block_size) * sizeof skyline[0]);
 
-  block_hashes = g_malloc0 (width * sizeof block_hashes[0]);
+  line = (guint32 *) (buffer->data + i * buffer->stride);
+  if (i + block_size < height)
+    bottom = (guint32 *) (buffer->data + (i + block_size) * buffer->stride);
+  else
+    bottom = NULL;
+  bottom_hash = 0;
+  hash = 0;
+  skyline_pixels = 0;
 
-  matches = 0;
-  encoder.dest = dest;
+  if (prev && i < prev->height)
+    prev_line = (guint32 *) (prev->data + i * prev->stride);
+  else
+    prev_line = NULL;
 
-  // Calculate the block hashes for the first row
-  for (i = y0; i < MIN(y1, y0 + block_size); i++)
+  for (j = x0; j < x0 + block_size; j++)
     {
-      line = (guint32 *)(buffer->data + i * buffer->stride);
-      hash = 0;
-      for (j = x0; j < MIN(x1, x0 + block_size); j++)
-        hash = hash * prime + line[j];
-      for (; j < x0 + block_size; j++)
-        hash = hash * prime;
+      hash = hash * prime;
+      if (j < width)
+        hash += line[j];
+      if (bottom)
+        {
+          bottom_hash = bottom_hash * prime;
+          if (j < width)
+            bottom_hash += bottom[j];
+        }
+      if (i < skyline[j])
+        skyline_pixels = 0;
+      else
+        skyline_pixels++;
+    }
 
-      for (j = x0; j < x1; j++)
+  for (j = x0; j < x1; j++)
+    {
+      if (i < skyline[j])
+        encode_pixel (encoder, line[j], line[j]);
+      else if (prev)
         {
-          block_hashes[j] = block_hashes[j] * vprime + hash;
+          /* FIXME: Add back overlap exception
+           * for consecutive blocks */
+
+          h = block_hashes[j];
+          entry = lookup_block (prev, h);
+          if (entry && entry->count < 2 &&
+              i < block_limit &&
+              skyline_pixels >= block_size &&
+              verify_block_match (buffer, j, i, prev, entry,
+                                  &encoder->clashes) &&
+              (entry->x != j || entry->y != i))
+            {
+              encoder->matches++;
+              encode_block (encoder, entry, j, i);
 
-          hash = hash * prime - line[j] * end_prime;
+              for (k = 0; k < block_size; k++)
+                skyline[j + k] = i + block_size;
+
+              encode_pixel (encoder, line[j], line[j]);
+            }
+          else
+            {
+              if (prev_line && j < prev->width)
+                encode_pixel (encoder, line[j],
+                              prev_line[j]);
+              else
+                encode_pixel (encoder, line[j], 0);
+            }
+        }
+      else
+        encode_pixel (encoder, line[j], 0);
+
+      if (i < skyline[j + block_size])
+        skyline_pixels = 0;
+      else
+        skyline_pixels++;
+
+      /* Update sliding block hash */
+      block_hashes[j] =
+        block_hashes[j] * vprime + bottom_hash -
+        hash * end_vprime;
+
+      if (bottom)
+        {
+          bottom_hash = bottom_hash * prime - bottom[j] * end_prime;
           if (j + block_size < width)
-            hash += line[j + block_size];
+            bottom_hash += bottom[j + block_size];
         }
+      hash = hash * prime - line[j] * end_prime;
+      if  (j + block_size < width)
+        hash += line[j + block_size] ;
     }
-  // Do the last rows if height < block_size
-  for (; i < y0 + block_size; i++)
+}
+
+/* Scrolled areas need to be at least this big in both directions */
+#define MIN_COPY_SIZE 32
+/* and this many lines need to agree on the offset */
+#define MIN_COPY_VOTES 4
+
+typedef struct {
+  guint32 hash;
+  int index;
+} LineHash;
+
+static int
+compare_line_hash (const void *a, const void *b)
+{
+  const LineHash *la = a, *lb = b;
+
+  if (la->hash != lb->hash)
+    return la->hash < lb->hash ? -1 : 1;
+
+  return la->index - lb->index;
+}
+
+/* Returns the first line with the hash */
+static LineHash *
+find_line_hash (LineHash *sorted, int n, guint32 hash)
+{
+  int lo, hi, mid;
+
+  lo = 0;
+  hi = n;
+  while (lo < hi)
     {
-      for (j = x0; j < x1; j++)
-        block_hashes[j] = block_hashes[j] * vprime;
+      mid = (lo + hi) / 2;
+      if (sorted[mid].hash < hash)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  if (lo < n && sorted[lo].hash == hash)
+    return &sorted[lo];
+
+  return NULL;
+}
+
+/* Hashes the rows (or columns) of the pixels in x0..x1, y0..y1 */
+static void
+compute_line_hashes (BroadwayBuffer *buffer,
+                     int x0, int x1, int y0, int y1,
+                     gboolean vertical,
+                     guint32 *hashes)
+{
+  guint32 *line;
+  int x, y;
+
+  if (vertical)
+    {
+      for (y = y0; y < y1; y++)
+        {
+          line = (guint32 *)(buffer->data + y * buffer->stride);
+          hashes[y - y0] = 0;
+          for (x = x0; x < x1; x++)
+            hashes[y - y0] = hashes[y - y0] * prime + line[x];
+        }
+    }
+  else
+    {
+      memset (hashes, 0, (x1 - x0) * sizeof hashes[0]);
+      for (y = y0; y < y1; y++)
+        {
+          line = (guint32 *)(buffer->data + y * buffer->stride);
+          for (x = x0; x < x1; x++)
+            hashes[x - x0] = hashes[x - x0] * prime + line[x];
+        }
     }
+}
+
+static gboolean
+lines_equal (BroadwayBuffer *buffer, BroadwayBuffer *prev,
+             const BroadwayRect *rect, gboolean vertical,
+             int line, int prev_line)
+{
+  int y;
 
-  for (i = y0; i < y1; i++)
+  if (vertical)
+    return memcmp (buffer->data + line * buffer->stride + rect->x * 4,
+                   prev->data + prev_line * prev->stride + rect->x * 4,
+                   rect->width * 4) == 0;
+
+  for (y = rect->y; y < rect->y + rect->height; y++)
     {
-      line = (guint32 *) (buffer->data + i * buffer->stride);
-      bottom = (guint32 *) (buffer->data + (i + block_size) * buffer->stride);
-      bottom_hash = 0;
-      hash = 0;
-      skyline_pixels = 0;
+      if (((guint32 *)(buffer->data + y * buffer->stride))[line] !=
+          ((guint32 *)(prev->data + y * prev->stride))[prev_line])
+        return FALSE;
+    }
 
-      if (prev && i < prev->height)
-        prev_line = (guint32 *) (prev->data + i * prev->stride);
-      else
-        prev_line = NULL;
+  return TRUE;
+}
 
-      for (j = x0; j < x0 + block_size; j++)
+/* Looks for a vertical (or horizontal) translation of the previous
+ * buffer in the damaged rect. The rows of the rect are looked up in all
+ * rows of the previous buffer (over the same columns), and the offset
+ * most of the changed rows agree on wins. The copy is then the longest
+ * run of rows that really match at that offset. */
+static gboolean
+find_copy (BroadwayBuffer     *buffer,
+           BroadwayBuffer     *prev,
+           const BroadwayRect *rect,
+           gboolean            vertical,
+           BroadwayCopy       *copy)
+{
+  guint32 *hashes, *prev_hashes;
+  LineHash *sorted, *found;
+  int *votes;
+  int start, n, n_prev, n_offsets;
+  int i, j, offset, best, run, best_run, best_start;
+
+  if (rect->width < MIN_COPY_SIZE || rect->height < MIN_COPY_SIZE)
+    return FALSE;
+
+  if (vertical)
+    {
+      start = rect->y;
+      n = rect->height;
+      n_prev = prev->height;
+    }
+  else
+    {
+      start = rect->x;
+      n = rect->width;
+      n_prev = prev->width;
+    }
+
+  hashes = g_new (guint32, n);
+  prev_hashes = g_new (guint32, n_prev);
+
+  if (vertical)
+    {
+      compute_line_hashes (buffer, rect->x, rect->x + rect->width,
+                           rect->y, rect->y + rect->height, TRUE, hashes);
+      compute_line_hashes (prev, rect->x, rect->x + rect->width,
+                           0, prev->height, TRUE, prev_hashes);
+    }
+  else
+    {
+      compute_line_hashes (buffer, rect->x, rect->x + rect->width,
+                           rect->y, rect->y + rect->height, FALSE, hashes);
+      compute_line_hashes (prev, 0, prev->width,
+                           rect->y, rect->y + rect->height, FALSE, prev_hashes);
+    }
+
+  sorted = g_new (LineHash, n_prev);
+  for (j = 0; j < n_prev; j++)
+    {
+      sorted[j].hash = prev_hashes[j];
+      sorted[j].index = j;
+    }
+  qsort (sorted, n_prev, sizeof sorted[0], compare_line_hash);
+
+  /* Offsets go from -(start + n - 1) to n_prev - 1 */
+  n_offsets = start + n + n_prev;
+  votes = g_new0 (int, n_offsets);
+
+  for (i = 0; i < n; i++)
+    {
+      if (hashes[i] == prev_hashes[start + i])
+        continue; /* Unchanged */
+
+      found = find_line_hash (sorted, n_prev, hashes[i]);
+      if (found == NULL)
+        continue;
+
+      /* Lines that occur several times, like blank ones, don't
+       * tell us anything */
+      if (found + 1 < sorted + n_prev && found[1].hash == found->hash)
+        continue;
+
+      votes[found->index - (start + i) + start + n]++;
+    }
+
+  best = -1;
+  for (j = 0; j < n_offsets; j++)
+    {
+      if (j == start + n)
+        continue; /* Offset 0 */
+      if (votes[j] >= MIN_COPY_VOTES && (best == -1 || votes[j] > votes[best]))
+        best = j;
+    }
+
+  best_run = 0;
+  best_start = 0;
+  if (best != -1)
+    {
+      offset = best - (start + n);
+
+      run = 0;
+      for (i = 0; i < n; i++)
         {
-          hash = hash * prime;
-          if (j < width)
-            hash += line[j];
-          if (i + block_size < height)
+          j = start + i + offset;
+          if (j >= 0 && j < n_prev &&
+              hashes[i] == prev_hashes[j] &&
+              lines_equal (buffer, prev, rect, vertical, start + i, j))
             {
-              bottom_hash = bottom_hash * prime;
-              if (j < width)
-                bottom_hash += bottom[j];
+              run++;
+              if (run > best_run)
+                {
+                  best_run = run;
+                  best_start = i - run + 1;
+                }
             }
-          if (i < skyline[j])
-            skyline_pixels = 0;
           else
-            skyline_pixels++;
+            run = 0;
         }
 
-      for (j = x0; j < x1; j++)
+      if (best_run >= MIN_COPY_SIZE)
         {
-          if (i < skyline[j])
-            encode_pixel (&encoder, line[j], line[j]);
-          else if (prev)
+          copy->rect = *rect;
+          if (vertical)
             {
-              /* FIXME: Add back overlap exception
-               * for consecutive blocks */
-
-              h = block_hashes[j];
-              entry = lookup_block (prev, h);
-              if (entry && entry->count < 2 &&
-                  skyline_pixels >= block_size &&
-                  verify_block_match (buffer, j, i, prev, entry) &&
-                  (entry->x != j || entry->y != i))
-                {
-                  matches++;
-                  encode_block (&encoder, entry, j, i);
-
-                  for (k = 0; k < block_size; k++)
-                    skyline[j + k] = i + block_size;
-
-                  encode_pixel (&encoder, line[j], line[j]);
-                }
-              else
-                {
-                  if (prev_line && j < prev->width)
-                    encode_pixel (&encoder, line[j],
-                                  prev_line[j]);
-                  else
-                    encode_pixel (&encoder, line[j], 0);
-                }
+              copy->rect.y = start + best_start;
+              copy->rect.height = best_run;
+              copy->src_x = rect->x;
+              copy->src_y = start + best_start + offset;
             }
           else
-            encode_pixel (&encoder, line[j], 0);
+            {
+              copy->rect.x = start + best_start;
+              copy->rect.width = best_run;
+              copy->src_x = start + best_start + offset;
+              copy->src_y = rect->y;
+            }
+        }
+    }
 
-          if (i < skyline[j + block_size])
-            skyline_pixels = 0;
-          else
-            skyline_pixels++;
+  g_free (votes);
+  g_free (sorted);
+  g_free (prev_hashes);
+  g_free (hashes);
+
+  return best_run >= MIN_COPY_SIZE;
+}
+
+/* Finds areas of the damage that are just the previous buffer moved
+ * around, at most one per damage rectangle. Vertical moves are tried
+ * first, since scrolling is much more common that way. */
+int
+broadway_buffer_find_copies (BroadwayBuffer  *buffer,
+                             BroadwayBuffer  *prev,
+                             BroadwayCopy   **copies)
+{
+  int i, n_copies;
+
+  *copies = NULL;
+
+  if (prev == NULL || buffer->damage == NULL ||
+      prev->width != buffer->width || prev->height != buffer->height)
+    return 0;
+
+  n_copies = 0;
+  for (i = 0; i < buffer->n_damage; i++)
+    {
+      if (*copies == NULL)
+        *copies = g_new (BroadwayCopy, buffer->n_damage);
+
+      if (find_copy (buffer, prev, &buffer->damage[i], TRUE, &(*copies)[n_copies]) ||
+          find_copy (buffer, prev, &buffer->damage[i], FALSE, &(*copies)[n_copies]))
+        n_copies++;
+    }
+
+  if (n_copies == 0)
+    g_clear_pointer (copies, g_free);
+
+  return n_copies;
+}
 
-          /* Insert block in hash table if we're on a
-           * grid point. */
-          if (((i | j) & block_mask) == 0 && !buffer->encoded)
-            insert_block (buffer, block_hashes[j], j, i);
+/* Encodes rows y0 to y1 of the buffer. The stream starts at the first
+ * pixel of row y0, and only places blocks that lie completely inside
+ * the rows, so separate row ranges can be encoded (and decoded)
+ * independently of each other. */
+void
+broadway_buffer_encode (BroadwayBuffer     *buffer,
+                        BroadwayBuffer     *prev,
+                        const BroadwayCopy *copies,
+                        int                 n_copies,
+                        int                 y0,
+                        int                 y1,
+                        GString            *dest)
+{
+  BroadwayRect full;
+  const BroadwayRect *rects, *band, *band_end, *rect;
+  const BroadwayCopy *copy;
+  int i, k, n_rects, band_y0, band_y1, block_limit;
+  guint32 *block_hashes;
+  int width, height;
+  struct encoder encoder = { 0 };
+  int *skyline;
+  gsize pos, start;
+
+  width = buffer->width;
+  height = buffer->height;
 
-          /* Update sliding block hash */
-          block_hashes[j] =
-            block_hashes[j] * vprime + bottom_hash -
-            hash * end_vprime;
+  /* The damage is only meaningful relative to the buffer we were
+   * created from, anything else gets the full treatment */
+  if (prev != NULL && buffer->damage != NULL &&
+      prev->width == width && prev->height == height)
+    {
+      rects = buffer->damage;
+      n_rects = buffer->n_damage;
+    }
+  else
+    {
+      full.x = 0;
+      full.y = 0;
+      full.width = width;
+      full.height = height;
+      rects = &full;
+      n_rects = 1;
+    }
+
+  skyline = g_malloc0 ((width + block_size) * sizeof skyline[0]);
 
-          if (i + block_size < height)
+  block_hashes = g_malloc0 (width * sizeof block_hashes[0]);
+
+  /* Blocks may extend past the bottom of the buffer, but not
+   * into the rows of the next range */
+  if (y1 >= height)
+    block_limit = height;
+  else
+    block_limit = y1 - block_size + 1;
+
+  encoder.dest = dest;
+  pos = (gsize) y0 * width;
+
+  /* Walk the damage band by band, all rectangles in a band share
+   * the same rows, so each row is emitted as skip, span, skip, span... */
+  for (band = rects; band < rects + n_rects; band = band_end)
+    {
+      for (band_end = band;
+           band_end < rects + n_rects && band_end->y == band->y;
+           band_end++)
+        ;
+
+      band_y0 = MAX (band->y, y0);
+      band_y1 = MIN (band->y + band->height, y1);
+      if (band_y0 >= band_y1)
+        continue;
+
+      for (rect = band; rect < band_end; rect++)
+        init_block_hashes (buffer, block_hashes,
+                           rect->x, rect->x + rect->width,
+                           band_y0);
+
+      for (i = band_y0; i < band_y1; i++)
+        {
+          /* The client applies the copies before decoding, so treat
+           * them like blocks that were already placed */
+          for (copy = copies; copy < copies + n_copies; copy++)
             {
-              bottom_hash = bottom_hash * prime - bottom[j] * end_prime;
-              if (j + block_size < width)
-                bottom_hash += bottom[j + block_size];
+              if (i == MAX (copy->rect.y, y0) &&
+                  i < copy->rect.y + copy->rect.height)
+                {
+                  for (k = copy->rect.x; k < copy->rect.x + copy->rect.width; k++)
+                    skyline[k] = MAX (skyline[k], copy->rect.y + copy->rect.height);
+                }
+            }
+
+          for (rect = band; rect < band_end; rect++)
+            {
+              start = (gsize) i * width + rect->x;
+              encode_skip (&encoder, start - pos);
+
+              encode_span (&encoder, buffer, prev, block_hashes, skyline,
+                           rect->x, rect->x + rect->width, i, block_limit);
+              pos = start + rect->width;
             }
-          hash = hash * prime - line[j] * end_prime;
-          if  (j + block_size < width)
-            hash += line[j + block_size] ;
         }
     }
 
@@ -513,8 +1045,8 @@ broadway_buffer_encode (BroadwayBuffer *buffer, BroadwayBuffer *prev, GString *d
   fprintf(stderr, "\n");
 
   fprintf(stderr, "%d / %d blocks (%d%%) matched, %d clashes\n",
-          matches, buffer->block_count,
-          100 * matches / buffer->block_count, buffer->clashes);
+          encoder.matches, buffer->block_count,
+          100 * encoder.matches / buffer->block_count, encoder.clashes);
 
   fprintf(stderr, "output stream %d bytes, raw buffer %d bytes (%d%%)\n",
           encoder.bytes, height * buffer->stride,
@@ -523,6 +1055,4 @@ broadway_buffer_encode (BroadwayBuffer *buffer, BroadwayBuffer *prev, GString *d
 
   g_free (skyline);
   g_free (block_hashes);
-
-  buffer->encoded = TRUE;
 }
@@ -6,14 +6,32 @@
 
 typedef struct _BroadwayBuffer BroadwayBuffer;
 
-BroadwayBuffer *broadway_buffer_create     (int             width,
-                                            int             height,
-                                            guint8         *data,
-                                            int             stride);
-void            broadway_buffer_destroy    (BroadwayBuffer *buffer);
-void            broadway_buffer_encode     (BroadwayBuffer *buffer,
-                                            BroadwayBuffer *prev,
-                                            GString        *dest);
+/* Pixels of the previous buffer that reappear at another position,
+ * e.g. due to scrolling */
+typedef struct {
+  BroadwayRect rect;
+  gint32 src_x, src_y;
+} BroadwayCopy;
+
+BroadwayBuffer *broadway_buffer_create     (int                 width,
+                                            int                 height,
+                                            guint8             *data,
+                                            int                 stride,
+                                            BroadwayBuffer     *prev,
+                                            const BroadwayRect *damage,
+                                            int                 n_damage);
+BroadwayBuffer *broadway_buffer_ref        (BroadwayBuffer *buffer);
+void            broadway_buffer_unref      (BroadwayBuffer *buffer);
+int             broadway_buffer_find_copies (BroadwayBuffer  *buffer,
+                                             BroadwayBuffer  *prev,
+                                             BroadwayCopy   **copies);
+void            broadway_buffer_encode     (BroadwayBuffer     *buffer,
+                                            BroadwayBuffer     *prev,
+                                            const BroadwayCopy *copies,
+                                            int                 n_copies,
+                                            int                 y0,
+                                            int                 y1,
+                                            GString            *dest);
 int             broadway_buffer_get_width  (BroadwayBuffer *buffer);
 int             broadway_buffer_get_height (BroadwayBuffer *buffer);
 
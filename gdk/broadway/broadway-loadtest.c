@@ -0,0 +1,1426 @@
+/* broadway-loadtest - a headless broadway client for benchmarking broadwayd
+ *
+ * This speaks the same websocket protocol as broadway.js: it decodes
+ * every buffer update into a local copy of each surface, acknowledges
+ * them like a browser would, and optionally replays an input script
+ * against the windows it sees. At the end it reports the amount of
+ * data received, frame rate, decode times and input round trip times,
+ * together with the encode latency and round trip times broadwayd
+ * itself measured (see /stats).
+ *
+ * broadwayd only serves a single browser at a time, so each simulated
+ * client needs its own display. With --clients=N the clients connect
+ * to N consecutive ports, which is what you get from running
+ * broadwayd :1 ... broadwayd :N with the same application on each.
+ *
+ * The input script has one event per line, each starting with the
+ * delay in milliseconds since the previous event:
+ *
+ *   # delay  event
+ *   100      motion 200 150
+ *   0        press 1
+ *   50       release 1
+ *   20       scroll down
+ *   10       key 65293
+ *
+ * "key" takes an X keysym and sends a press and a release. The script
+ * is repeated until --duration seconds have passed.
+ *
+ * The input round trip time is measured from an input event to the
+ * next buffer update that arrives after it, so it only means something
+ * for workloads that don't redraw continuously on their own.
+ */
+
+#include "config.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <locale.h>
+
+#include <glib.h>
+#include <gio/gio.h>
+#ifdef G_OS_UNIX
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#endif
+
+#include "broadway-protocol.h"
+#include "broadway-output.h"
+
+#define DEFAULT_PORT 8080
+
+/* Matches the block size used by broadway-buffer.c */
+#define BLOCK_SIZE 32
+
+typedef enum {
+  SCRIPT_MOTION,
+  SCRIPT_PRESS,
+  SCRIPT_RELEASE,
+  SCRIPT_SCROLL,
+  SCRIPT_KEY
+} ScriptOp;
+
+typedef struct {
+  gint64 delay; /* in microseconds */
+  ScriptOp op;
+  int arg1;
+  int arg2;
+} ScriptEvent;
+
+typedef struct {
+  guint32 id;
+  int x, y;
+  int width, height;
+  gboolean visible;
+  /* Last decoded contents, 4 bytes per pixel in wire order */
+  guint8 *pixels;
+  int pixels_width;
+  int pixels_height;
+} Surface;
+
+typedef struct {
+  guint64 bytes;
+  guint64 messages;
+  guint64 frames;
+  guint64 tiles;
+  guint64 copies;
+  guint64 decode_errors;
+  gint64 decode_total;
+  gint64 decode_max;
+  guint64 input_events;
+  guint64 latency_samples;
+  gint64 latency_total;
+  gint64 latency_min;
+  gint64 latency_max;
+  gint64 elapsed;
+
+  gboolean have_server_stats;
+  gint64 server_encode_avg;
+  gint64 server_encode_max;
+  gint64 server_rtt_avg;
+  gint64 server_rtt_max;
+  gint64 server_frames_coalesced;
+} ClientStats;
+
+typedef struct {
+  int index;
+  char *host;
+  guint16 port;
+
+  GSocketConnection *connection;
+  GSocket *socket;
+  GInputStream *in;
+  GOutputStream *out;
+  GByteArray *in_buf;
+  gboolean disconnected;
+
+  GHashTable *surfaces;
+  GList *stack; /* bottom to top */
+
+  guint32 last_serial;
+  gint64 start_time;
+  int pointer_x, pointer_y;
+  guint32 window_with_mouse;
+  guint32 grab_window;
+  guint32 state;
+  gint64 pending_input_time;
+
+  ClientStats stats;
+  char *error;
+} Client;
+
+typedef struct {
+  const guint8 *data;
+  gsize len;
+  gsize pos;
+  gboolean error;
+} Reader;
+
+static ScriptEvent *script;
+static guint n_script;
+static int screen_width = 1024;
+static int screen_height = 768;
+static gint64 run_time;
+
+/************************************************************************
+ *                Input script                                          *
+ ************************************************************************/
+
+static gboolean
+load_script (const char  *filename,
+             GError     **error)
+{
+  GArray *events;
+  char *contents;
+  char **lines;
+  gint64 total_delay = 0;
+  int i;
+
+  if (!g_file_get_contents (filename, &contents, NULL, error))
+    return FALSE;
+
+  events = g_array_new (FALSE, TRUE, sizeof (ScriptEvent));
+  lines = g_strsplit (contents, "\n", 0);
+  g_free (contents);
+
+  for (i = 0; lines[i] != NULL; i++)
+    {
+      ScriptEvent event = { 0 };
+      char op[16], arg[16];
+      int delay, n;
+
+      g_strstrip (lines[i]);
+      if (lines[i][0] == 0 || lines[i][0] == '#')
+        continue;
+
+      n = sscanf (lines[i], "%d %15s %d %d", &delay, op, &event.arg1, &event.arg2);
+      event.delay = (gint64)delay * 1000;
+
+      if (n == 4 && strcmp (op, "motion") == 0)
+        event.op = SCRIPT_MOTION;
+      else if (n == 3 && strcmp (op, "press") == 0)
+        event.op = SCRIPT_PRESS;
+      else if (n == 3 && strcmp (op, "release") == 0)
+        event.op = SCRIPT_RELEASE;
+      else if (n == 3 && strcmp (op, "key") == 0)
+        event.op = SCRIPT_KEY;
+      else if (sscanf (lines[i], "%d %15s %15s", &delay, op, arg) == 3 &&
+               strcmp (op, "scroll") == 0 &&
+               (strcmp (arg, "up") == 0 || strcmp (arg, "down") == 0))
+        {
+          event.op = SCRIPT_SCROLL;
+          event.arg1 = strcmp (arg, "down") == 0;
+        }
+      else
+        {
+          g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                       "%s:%d: can't parse \"%s\"", filename, i + 1, lines[i]);
+          g_strfreev (lines);
+          g_array_free (events, TRUE);
+          return FALSE;
+        }
+
+      if (delay < 0)
+        event.delay = 0;
+
+      g_array_append_val (events, event);
+      total_delay += event.delay;
+    }
+
+  g_strfreev (lines);
+
+  /* The script is played in a loop */
+  if (events->len > 0 && total_delay == 0)
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                   "%s: all delays are zero", filename);
+      g_array_free (events, TRUE);
+      return FALSE;
+    }
+
+  n_script = events->len;
+  script = (ScriptEvent *) g_array_free (events, FALSE);
+
+  return TRUE;
+}
+
+/************************************************************************
+ *                Websocket I/O                                         *
+ ************************************************************************/
+
+static gboolean
+client_write (Client     *client,
+              const void *data,
+              gsize       len)
+{
+  GError *error = NULL;
+
+  if (!g_output_stream_write_all (client->out, data, len, NULL, NULL, &error))
+    {
+      if (client->error == NULL)
+        client->error = g_strdup (error->message);
+      g_error_free (error);
+      client->disconnected = TRUE;
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Waits up to timeout microseconds (or forever if negative) for more
+ * data and appends it to in_buf */
+static gboolean
+client_read (Client *client,
+             gint64  timeout)
+{
+  GError *error = NULL;
+  guint8 buf[64 * 1024];
+  gssize res;
+
+  if (!g_socket_condition_timed_wait (client->socket, G_IO_IN | G_IO_HUP | G_IO_ERR,
+                                      timeout, NULL, &error))
+    {
+      if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_TIMED_OUT))
+        {
+          g_error_free (error);
+          return TRUE;
+        }
+      goto failed;
+    }
+
+  res = g_input_stream_read (client->in, buf, sizeof (buf), NULL, &error);
+  if (res < 0)
+    goto failed;
+
+  if (res == 0)
+    {
+      if (client->error == NULL)
+        client->error = g_strdup ("Connection closed by broadwayd");
+      client->disconnected = TRUE;
+      return FALSE;
+    }
+
+  g_byte_array_append (client->in_buf, buf, res);
+  return TRUE;
+
+ failed:
+  if (client->error == NULL)
+    client->error = g_strdup (error->message);
+  g_error_free (error);
+  client->disconnected = TRUE;
+  return FALSE;
+}
+
+static gboolean
+send_ws_frame (Client                 *client,
+               BroadwayWSOpCode        code,
+               const guint8           *payload,
+               gsize                   len)
+{
+  GString *frame;
+  guint32 mask;
+  guint8 mask_bytes[4];
+  gsize i;
+
+  frame = g_string_sized_new (len + 14);
+  g_string_append_c (frame, 0x80 | code);
+
+  /* Frames from the client are always masked */
+  if (len < 126)
+    g_string_append_c (frame, 0x80 | len);
+  else if (len < 65536)
+    {
+      g_string_append_c (frame, 0x80 | 126);
+      g_string_append_c (frame, (len >> 8) & 0xff);
+      g_string_append_c (frame, len & 0xff);
+    }
+  else
+    {
+      g_string_append_c (frame, 0x80 | 127);
+      for (i = 0; i < 8; i++)
+        g_string_append_c (frame, ((guint64)len >> (56 - i * 8)) & 0xff);
+    }
+
+  mask = g_random_int ();
+  memcpy (mask_bytes, &mask, 4);
+  g_string_append_len (frame, (char *)mask_bytes, 4);
+
+  for (i = 0; i < len; i++)
+    g_string_append_c (frame, payload[i] ^ mask_bytes[i % 4]);
+
+  client_write (client, frame->str, frame->len);
+  g_string_free (frame, TRUE);
+
+  return !client->disconnected;
+}
+
+/* Same layout as sendInput() in broadway.js: big endian int32s,
+ * starting with the command, the last serial seen and a timestamp */
+static void
+send_input (Client       *client,
+            char          cmd,
+            const gint32 *args,
+            int           n_args)
+{
+  guint32 msg[16];
+  guint32 time_;
+  int i;
+
+  g_assert (n_args + 3 <= (int)G_N_ELEMENTS (msg));
+
+  time_ = MAX ((g_get_monotonic_time () - client->start_time) / 1000, 1);
+
+  msg[0] = GUINT32_TO_BE ((guint32)cmd);
+  msg[1] = GUINT32_TO_BE (client->last_serial);
+  msg[2] = GUINT32_TO_BE (time_);
+  for (i = 0; i < n_args; i++)
+    msg[3 + i] = GUINT32_TO_BE ((guint32)args[i]);
+
+  send_ws_frame (client, BROADWAY_WS_BINARY, (guint8 *)msg, (3 + n_args) * 4);
+}
+
+static gboolean
+client_connect (Client  *client,
+                GError **error)
+{
+  GSocketClient *socket_client;
+  guint8 nonce[16];
+  char *key, *request;
+  guint8 *end;
+  gsize i;
+
+  socket_client = g_socket_client_new ();
+  client->connection = g_socket_client_connect_to_host (socket_client,
+                                                        client->host, client->port,
+                                                        NULL, error);
+  g_object_unref (socket_client);
+  if (client->connection == NULL)
+    return FALSE;
+
+  client->socket = g_socket_connection_get_socket (client->connection);
+  client->in = g_io_stream_get_input_stream (G_IO_STREAM (client->connection));
+  client->out = g_io_stream_get_output_stream (G_IO_STREAM (client->connection));
+#ifdef G_OS_UNIX
+  g_socket_set_option (client->socket, IPPROTO_TCP, TCP_NODELAY, 1, NULL);
+#endif
+
+  for (i = 0; i < sizeof (nonce); i++)
+    nonce[i] = g_random_int_range (0, 256);
+  key = g_base64_encode (nonce, sizeof (nonce));
+
+  request = g_strdup_printf ("GET /socket HTTP/1.1\r\n"
+                             "Host: %s:%d\r\n"
+                             "Upgrade: websocket\r\n"
+                             "Connection: Upgrade\r\n"
+                             "Sec-WebSocket-Key: %s\r\n"
+                             "Sec-WebSocket-Protocol: broadway\r\n"
+                             "Sec-WebSocket-Version: 13\r\n"
+                             "\r\n",
+                             client->host, client->port, key);
+  g_free (key);
+
+  client_write (client, request, strlen (request));
+  g_free (request);
+
+  /* Read the response headers, anything after them is already
+   * websocket data */
+  end = NULL;
+  while (!client->disconnected)
+    {
+      g_byte_array_append (client->in_buf, (guint8 *)"", 1);
+      end = (guint8 *)strstr ((char *)client->in_buf->data, "\r\n\r\n");
+      g_byte_array_set_size (client->in_buf, client->in_buf->len - 1);
+      if (end != NULL)
+        break;
+
+      if (client->in_buf->len > 16 * 1024)
+        break;
+
+      client_read (client, 5 * G_USEC_PER_SEC);
+    }
+
+  if (end == NULL ||
+      !g_str_has_prefix ((char *)client->in_buf->data, "HTTP/1.1 101"))
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                   "Websocket handshake failed%s%s",
+                   client->error ? ": " : "",
+                   client->error ? client->error : "");
+      return FALSE;
+    }
+
+  g_byte_array_remove_range (client->in_buf, 0, end + 4 - client->in_buf->data);
+
+  return TRUE;
+}
+
+/************************************************************************
+ *                Decoding                                              *
+ ************************************************************************/
+
+static guint8
+reader_get_8 (Reader *r)
+{
+  if (r->pos + 1 > r->len)
+    {
+      r->error = TRUE;
+      return 0;
+    }
+  return r->data[r->pos++];
+}
+
+static guint16
+reader_get_16 (Reader *r)
+{
+  guint16 v;
+
+  if (r->pos + 2 > r->len)
+    {
+      r->error = TRUE;
+      return 0;
+    }
+  v = r->data[r->pos] | r->data[r->pos + 1] << 8;
+  r->pos += 2;
+  return v;
+}
+
+static guint32
+reader_get_32 (Reader *r)
+{
+  guint32 v;
+
+  if (r->pos + 4 > r->len)
+    {
+      r->error = TRUE;
+      return 0;
+    }
+  v = (guint32)r->data[r->pos] |
+    (guint32)r->data[r->pos + 1] << 8 |
+    (guint32)r->data[r->pos + 2] << 16 |
+    (guint32)r->data[r->pos + 3] << 24;
+  r->pos += 4;
+  return v;
+}
+
+static const guint8 *
+reader_get_data (Reader *r,
+                 gsize  *len)
+{
+  const guint8 *data;
+
+  *len = reader_get_32 (r);
+  if (r->error || *len > r->len - r->pos)
+    {
+      r->error = TRUE;
+      *len = 0;
+      return NULL;
+    }
+
+  data = r->data + r->pos;
+  r->pos += *len;
+  return data;
+}
+
+static GByteArray *
+inflate_tile (const guint8 *data,
+              gsize         len)
+{
+  GZlibDecompressor *decompressor;
+  GConverterResult res;
+  GByteArray *out;
+  gsize read, written, out_len;
+  GError *error = NULL;
+
+  decompressor = g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_RAW);
+  out = g_byte_array_sized_new (len * 4);
+  out_len = 0;
+
+  do
+    {
+      if (out->len - out_len < 64 * 1024)
+        g_byte_array_set_size (out, out_len + MAX (out_len, 64 * 1024));
+
+      res = g_converter_convert (G_CONVERTER (decompressor),
+                                 data, len,
+                                 out->data + out_len, out->len - out_len,
+                                 G_CONVERTER_INPUT_AT_END,
+                                 &read, &written, &error);
+      if (res == G_CONVERTER_ERROR)
+        {
+          if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NO_SPACE))
+            {
+              g_clear_error (&error);
+              g_byte_array_set_size (out, out->len * 2);
+              continue;
+            }
+
+          g_error_free (error);
+          g_byte_array_free (out, TRUE);
+          g_object_unref (decompressor);
+          return NULL;
+        }
+
+      data += read;
+      len -= read;
+      out_len += written;
+    }
+  while (res != G_CONVERTER_FINISHED);
+
+  g_object_unref (decompressor);
+  g_byte_array_set_size (out, out_len);
+
+  return out;
+}
+
+static void
+copy_rect (const guint8 *src, int src_width, int src_height, int src_x, int src_y,
+           guint8 *dest, int dest_width, int dest_height, int dest_x, int dest_y,
+           int width, int height)
+{
+  int i;
+
+  /* Clip like copyRect() in broadway.js */
+  width = MIN (width, src_width - src_x);
+  height = MIN (height, src_height - src_y);
+  width = MIN (width, dest_width - dest_x);
+  height = MIN (height, dest_height - dest_y);
+
+  if (width <= 0 || height <= 0 ||
+      src_x < 0 || src_y < 0 || dest_x < 0 || dest_y < 0)
+    return;
+
+  for (i = 0; i < height; i++)
+    memmove (dest + ((dest_y + i) * dest_width + dest_x) * 4,
+             src + ((src_y + i) * src_width + src_x) * 4,
+             width * 4);
+}
+
+/* The C version of decodeTile() in broadway.js */
+static gboolean
+decode_tile (Surface      *surface,
+             guint8       *pixels,
+             int           width,
+             int           height,
+             int           y,
+             const guint8 *data,
+             gsize         len)
+{
+  gsize src, dest, end;
+  guint8 b, g, r, alpha;
+  int block_stride, block_x, block_y, dest_x, dest_y;
+  guint32 n, i;
+
+  src = 0;
+  dest = (gsize)y * width * 4;
+  end = (gsize)width * height * 4;
+
+  while (src + 4 <= len)
+    {
+      b = data[src++];
+      g = data[src++];
+      r = data[src++];
+      alpha = data[src++];
+
+      if (alpha != 0)
+        {
+          if (dest + 4 > end)
+            return FALSE;
+          memcpy (pixels + dest, data + src - 4, 4);
+          dest += 4;
+          continue;
+        }
+
+      n = (r & 0xf) << 16 | g << 8 | b;
+
+      switch (r & 0xf0)
+        {
+        case 0x00: /* Transparent pixel */
+          if (dest + 4 > end)
+            return FALSE;
+          memset (pixels + dest, 0, 4);
+          dest += 4;
+          break;
+
+        case 0x10: /* Delta 0 run */
+          dest += (gsize)n * 4;
+          if (dest > end)
+            return FALSE;
+          break;
+
+        case 0x20: /* Block reference */
+          if (src + 4 > len || surface->pixels == NULL)
+            return FALSE;
+
+          block_stride = (surface->pixels_width + BLOCK_SIZE - 1) / BLOCK_SIZE;
+          block_y = (n / block_stride) * BLOCK_SIZE;
+          block_x = (n % block_stride) * BLOCK_SIZE;
+          dest_y = data[src] | data[src + 1] << 8;
+          dest_x = data[src + 2] | data[src + 3] << 8;
+          src += 4;
+
+          if (block_y >= surface->pixels_height)
+            return FALSE;
+
+          copy_rect (surface->pixels, surface->pixels_width, surface->pixels_height,
+                     block_x, block_y,
+                     pixels, width, height, dest_x, dest_y,
+                     BLOCK_SIZE, BLOCK_SIZE);
+          break;
+
+        case 0x30: /* Color run */
+          if (src + 4 > len || dest + (gsize)n * 4 > end)
+            return FALSE;
+          for (i = 0; i < n; i++)
+            memcpy (pixels + dest + i * 4, data + src, 4);
+          src += 4;
+          dest += (gsize)n * 4;
+          break;
+
+        case 0x40: /* Delta run */
+          if (src + 4 > len || dest + (gsize)n * 4 > end)
+            return FALSE;
+          for (i = 0; i < n * 4; i++)
+            pixels[dest + i] += data[src + i % 4];
+          src += 4;
+          dest += (gsize)n * 4;
+          break;
+
+        default:
+          return FALSE;
+        }
+    }
+
+  return src == len;
+}
+
+static gboolean
+decode_put_buffer (Client *client,
+                   Reader *r)
+{
+  Surface *surface;
+  guint32 id;
+  int w, h, n_copies, n_tiles, i;
+  guint16 copies[6];
+  guint8 *pixels;
+  gboolean ok;
+  gint64 start, time_;
+
+  id = reader_get_16 (r);
+  w = reader_get_16 (r);
+  h = reader_get_16 (r);
+
+  surface = g_hash_table_lookup (client->surfaces, GUINT_TO_POINTER (id));
+
+  start = g_get_monotonic_time ();
+  ok = TRUE;
+
+  pixels = g_malloc0 ((gsize)w * h * 4);
+  if (surface && surface->pixels)
+    copy_rect (surface->pixels, surface->pixels_width, surface->pixels_height, 0, 0,
+               pixels, w, h, 0, 0,
+               surface->pixels_width, surface->pixels_height);
+
+  n_copies = reader_get_16 (r);
+  for (i = 0; i < n_copies && !r->error; i++)
+    {
+      int j;
+
+      for (j = 0; j < 6; j++)
+        copies[j] = reader_get_16 (r);
+
+      if (surface && surface->pixels)
+        copy_rect (surface->pixels, surface->pixels_width, surface->pixels_height,
+                   copies[4], copies[5],
+                   pixels, w, h, copies[0], copies[1],
+                   copies[2], copies[3]);
+    }
+  client->stats.copies += n_copies;
+
+  n_tiles = reader_get_16 (r);
+  for (i = 0; i < n_tiles && !r->error; i++)
+    {
+      const guint8 *data;
+      GByteArray *tile;
+      gsize len;
+      int y;
+
+      y = reader_get_16 (r);
+      data = reader_get_data (r, &len);
+      if (r->error)
+        break;
+
+      tile = inflate_tile (data, len);
+      if (tile == NULL ||
+          surface == NULL ||
+          y >= h ||
+          !decode_tile (surface, pixels, w, h, y, tile->data, tile->len))
+        ok = FALSE;
+
+      if (tile)
+        g_byte_array_free (tile, TRUE);
+    }
+  client->stats.tiles += n_tiles;
+
+  if (surface)
+    {
+      g_free (surface->pixels);
+      surface->pixels = pixels;
+      surface->pixels_width = w;
+      surface->pixels_height = h;
+    }
+  else
+    g_free (pixels);
+
+  if (!ok)
+    client->stats.decode_errors++;
+
+  time_ = g_get_monotonic_time () - start;
+  client->stats.decode_total += time_;
+  client->stats.decode_max = MAX (client->stats.decode_max, time_);
+  client->stats.frames++;
+
+  return !r->error;
+}
+
+/************************************************************************
+ *                Windows and input                                     *
+ ************************************************************************/
+
+static void
+surface_free (Surface *surface)
+{
+  g_free (surface->pixels);
+  g_free (surface);
+}
+
+static Surface *
+surface_at (Client *client,
+            int     x,
+            int     y)
+{
+  GList *l;
+
+  for (l = g_list_last (client->stack); l != NULL; l = l->prev)
+    {
+      Surface *surface = l->data;
+
+      if (surface->visible &&
+          x >= surface->x && x < surface->x + surface->width &&
+          y >= surface->y && y < surface->y + surface->height)
+        return surface;
+    }
+
+  return NULL;
+}
+
+static void
+send_pointer_event (Client *client,
+                    char    cmd,
+                    guint32 window_id,
+                    int     extra)
+{
+  Surface *surface;
+  gint32 args[8];
+  int n_args;
+
+  surface = g_hash_table_lookup (client->surfaces, GUINT_TO_POINTER (window_id));
+
+  args[0] = client->window_with_mouse;
+  args[1] = window_id;
+  args[2] = client->pointer_x;
+  args[3] = client->pointer_y;
+  args[4] = client->pointer_x - (surface ? surface->x : 0);
+  args[5] = client->pointer_y - (surface ? surface->y : 0);
+  args[6] = client->state;
+  args[7] = extra;
+  n_args = cmd == BROADWAY_EVENT_POINTER_MOVE ? 7 : 8;
+
+  send_input (client, cmd, args, n_args);
+}
+
+static guint32
+event_window (Client *client)
+{
+  return client->grab_window ? client->grab_window : client->window_with_mouse;
+}
+
+static void
+play_event (Client      *client,
+            ScriptEvent *event)
+{
+  Surface *surface;
+  guint32 id;
+  gint32 args[2];
+
+  switch (event->op)
+    {
+    case SCRIPT_MOTION:
+      client->pointer_x = event->arg1;
+      client->pointer_y = event->arg2;
+
+      surface = surface_at (client, client->pointer_x, client->pointer_y);
+      id = surface ? surface->id : 0;
+      if (id != client->window_with_mouse && client->grab_window == 0)
+        {
+          if (client->window_with_mouse != 0)
+            send_pointer_event (client, BROADWAY_EVENT_LEAVE,
+                                client->window_with_mouse, 0 /* GDK_CROSSING_NORMAL */);
+          client->window_with_mouse = id;
+          if (id != 0)
+            send_pointer_event (client, BROADWAY_EVENT_ENTER,
+                                id, 0 /* GDK_CROSSING_NORMAL */);
+        }
+      else
+        client->window_with_mouse = id;
+
+      send_pointer_event (client, BROADWAY_EVENT_POINTER_MOVE, event_window (client), 0);
+      break;
+
+    case SCRIPT_PRESS:
+      send_pointer_event (client, BROADWAY_EVENT_BUTTON_PRESS,
+                          event_window (client), event->arg1);
+      if (event->arg1 >= 1 && event->arg1 <= 5)
+        client->state |= 1 << (7 + event->arg1); /* GDK_BUTTON1_MASK... */
+      break;
+
+    case SCRIPT_RELEASE:
+      if (event->arg1 >= 1 && event->arg1 <= 5)
+        client->state &= ~(1 << (7 + event->arg1));
+      send_pointer_event (client, BROADWAY_EVENT_BUTTON_RELEASE,
+                          event_window (client), event->arg1);
+      break;
+
+    case SCRIPT_SCROLL:
+      send_pointer_event (client, BROADWAY_EVENT_SCROLL,
+                          event_window (client), event->arg1);
+      break;
+
+    case SCRIPT_KEY:
+      args[0] = event->arg1;
+      args[1] = client->state;
+      send_input (client, BROADWAY_EVENT_KEY_PRESS, args, 2);
+      send_input (client, BROADWAY_EVENT_KEY_RELEASE, args, 2);
+      break;
+
+    default:
+      g_assert_not_reached ();
+    }
+
+  client->stats.input_events++;
+  if (client->pending_input_time == 0)
+    client->pending_input_time = g_get_monotonic_time ();
+}
+
+/************************************************************************
+ *                Commands                                              *
+ ************************************************************************/
+
+static void
+handle_commands (Client       *client,
+                 const guint8 *data,
+                 gsize         len)
+{
+  Reader r = { data, len, 0, FALSE };
+  Surface *surface;
+  gint64 latency;
+  guint32 id;
+  char op;
+  int flags;
+
+  while (r.pos < r.len && !r.error)
+    {
+      op = reader_get_8 (&r);
+      client->last_serial = reader_get_32 (&r);
+
+      switch (op)
+        {
+        case BROADWAY_OP_DISCONNECTED:
+          if (client->error == NULL)
+            client->error = g_strdup ("Replaced by another browser");
+          client->disconnected = TRUE;
+          return;
+
+        case BROADWAY_OP_NEW_SURFACE:
+          surface = g_new0 (Surface, 1);
+          surface->id = reader_get_16 (&r);
+          surface->x = (gint16)reader_get_16 (&r);
+          surface->y = (gint16)reader_get_16 (&r);
+          surface->width = reader_get_16 (&r);
+          surface->height = reader_get_16 (&r);
+          reader_get_8 (&r); /* is_temp */
+          g_hash_table_replace (client->surfaces, GUINT_TO_POINTER (surface->id), surface);
+          client->stack = g_list_append (client->stack, surface);
+          break;
+
+        case BROADWAY_OP_SHOW_SURFACE:
+        case BROADWAY_OP_HIDE_SURFACE:
+          id = reader_get_16 (&r);
+          surface = g_hash_table_lookup (client->surfaces, GUINT_TO_POINTER (id));
+          if (surface)
+            surface->visible = op == BROADWAY_OP_SHOW_SURFACE;
+          break;
+
+        case BROADWAY_OP_RAISE_SURFACE:
+        case BROADWAY_OP_LOWER_SURFACE:
+          id = reader_get_16 (&r);
+          surface = g_hash_table_lookup (client->surfaces, GUINT_TO_POINTER (id));
+          if (surface)
+            {
+              client->stack = g_list_remove (client->stack, surface);
+              if (op == BROADWAY_OP_RAISE_SURFACE)
+                client->stack = g_list_append (client->stack, surface);
+              else
+                client->stack = g_list_prepend (client->stack, surface);
+            }
+          break;
+
+        case BROADWAY_OP_DESTROY_SURFACE:
+          id = reader_get_16 (&r);
+          surface = g_hash_table_lookup (client->surfaces, GUINT_TO_POINTER (id));
+          if (surface)
+            {
+              client->stack = g_list_remove (client->stack, surface);
+              g_hash_table_remove (client->surfaces, GUINT_TO_POINTER (id));
+            }
+          if (client->window_with_mouse == id)
+            client->window_with_mouse = 0;
+          if (client->grab_window == id)
+            client->grab_window = 0;
+          break;
+
+        case BROADWAY_OP_SET_TRANSIENT_FOR:
+          reader_get_16 (&r);
+          reader_get_16 (&r);
+          break;
+
+        case BROADWAY_OP_MOVE_RESIZE:
+          id = reader_get_16 (&r);
+          surface = g_hash_table_lookup (client->surfaces, GUINT_TO_POINTER (id));
+          flags = reader_get_8 (&r);
+          if (flags & 1)
+            {
+              int x = (gint16)reader_get_16 (&r);
+              int y = (gint16)reader_get_16 (&r);
+              if (surface)
+                {
+                  surface->x = x;
+                  surface->y = y;
+                }
+            }
+          if (flags & 2)
+            {
+              int w = reader_get_16 (&r);
+              int h = reader_get_16 (&r);
+              if (surface)
+                {
+                  surface->width = w;
+                  surface->height = h;
+                }
+            }
+          break;
+
+        case BROADWAY_OP_PUT_BUFFER:
+          if (!decode_put_buffer (client, &r))
+            break;
+
+          if (client->pending_input_time != 0)
+            {
+              latency = g_get_monotonic_time () - client->pending_input_time;
+              client->pending_input_time = 0;
+              if (client->stats.latency_samples == 0)
+                client->stats.latency_min = latency;
+              client->stats.latency_min = MIN (client->stats.latency_min, latency);
+              client->stats.latency_max = MAX (client->stats.latency_max, latency);
+              client->stats.latency_total += latency;
+              client->stats.latency_samples++;
+            }
+
+          /* Let the server know we're keeping up */
+          send_input (client, BROADWAY_EVENT_FRAME_ACK, NULL, 0);
+          break;
+
+        case BROADWAY_OP_GRAB_POINTER:
+          {
+            gint32 res = 0; /* GDK_GRAB_SUCCESS */
+
+            client->grab_window = reader_get_16 (&r);
+            reader_get_8 (&r); /* owner_events */
+            send_input (client, BROADWAY_EVENT_GRAB_NOTIFY, &res, 1);
+          }
+          break;
+
+        case BROADWAY_OP_UNGRAB_POINTER:
+          {
+            gint32 res = 0;
+
+            client->grab_window = 0;
+            send_input (client, BROADWAY_EVENT_UNGRAB_NOTIFY, &res, 1);
+          }
+          break;
+
+        case BROADWAY_OP_SET_SHOW_KEYBOARD:
+          reader_get_16 (&r);
+          break;
+
+        default:
+          if (client->error == NULL)
+            client->error = g_strdup_printf ("Unknown op %c", op);
+          client->disconnected = TRUE;
+          return;
+        }
+    }
+
+  if (r.error)
+    client->stats.decode_errors++;
+}
+
+/* Handles all complete websocket frames in in_buf */
+static void
+process_input (Client *client)
+{
+  guint8 *data;
+  guint64 payload_len;
+  gsize header_len;
+  int opcode, i;
+
+  while (!client->disconnected && client->in_buf->len >= 2)
+    {
+      data = client->in_buf->data;
+      opcode = data[0] & 0x0f;
+      payload_len = data[1] & 0x7f;
+      header_len = 2;
+
+      if (payload_len == 126)
+        {
+          if (client->in_buf->len < 4)
+            return;
+          payload_len = data[2] << 8 | data[3];
+          header_len = 4;
+        }
+      else if (payload_len == 127)
+        {
+          if (client->in_buf->len < 10)
+            return;
+          payload_len = 0;
+          for (i = 0; i < 8; i++)
+            payload_len = payload_len << 8 | data[2 + i];
+          header_len = 10;
+        }
+
+      /* broadwayd never masks its frames */
+      if (data[1] & 0x80)
+        {
+          if (client->error == NULL)
+            client->error = g_strdup ("Unexpected masked frame");
+          client->disconnected = TRUE;
+          return;
+        }
+
+      if (client->in_buf->len - header_len < payload_len)
+        return;
+
+      switch (opcode)
+        {
+        case BROADWAY_WS_BINARY:
+          client->stats.bytes += payload_len;
+          client->stats.messages++;
+          handle_commands (client, data + header_len, payload_len);
+          break;
+
+        case BROADWAY_WS_CNX_PING:
+          send_ws_frame (client, BROADWAY_WS_CNX_PONG, data + header_len, payload_len);
+          break;
+
+        case BROADWAY_WS_CNX_CLOSE:
+          if (client->error == NULL)
+            client->error = g_strdup ("Connection closed by broadwayd");
+          client->disconnected = TRUE;
+          return;
+
+        default:
+          break;
+        }
+
+      g_byte_array_remove_range (client->in_buf, 0, header_len + payload_len);
+    }
+}
+
+/************************************************************************
+ *                Server statistics                                     *
+ ************************************************************************/
+
+static gint64
+json_get_int (const char *json,
+              const char *name)
+{
+  char *key;
+  const char *p;
+
+  key = g_strdup_printf ("\"%s\":", name);
+  p = strstr (json, key);
+  g_free (key);
+
+  if (p == NULL)
+    return 0;
+
+  return g_ascii_strtoll (p + strlen (name) + 3, NULL, 10);
+}
+
+/* Fetches /stats for this client's connection, which has to be done
+ * while it is still connected */
+static void
+fetch_server_stats (Client *client)
+{
+  GSocketClient *socket_client;
+  GSocketConnection *connection;
+  GInputStream *in;
+  GString *response;
+  char *request, *body;
+  char buf[4096];
+  gssize res;
+
+  socket_client = g_socket_client_new ();
+  g_socket_client_set_timeout (socket_client, 5);
+  connection = g_socket_client_connect_to_host (socket_client,
+                                                client->host, client->port,
+                                                NULL, NULL);
+  g_object_unref (socket_client);
+  if (connection == NULL)
+    return;
+
+  request = g_strdup_printf ("GET /stats HTTP/1.0\r\n"
+                             "Host: %s:%d\r\n"
+                             "\r\n",
+                             client->host, client->port);
+  g_output_stream_write_all (g_io_stream_get_output_stream (G_IO_STREAM (connection)),
+                             request, strlen (request), NULL, NULL, NULL);
+  g_free (request);
+
+  response = g_string_new ("");
+  in = g_io_stream_get_input_stream (G_IO_STREAM (connection));
+  while ((res = g_input_stream_read (in, buf, sizeof (buf), NULL, NULL)) > 0)
+    g_string_append_len (response, buf, res);
+
+  body = strstr (response->str, "\r\n\r\n");
+  if (g_str_has_prefix (response->str, "HTTP/1.0 200") && body != NULL &&
+      strstr (body, "\"connected\": true") != NULL)
+    {
+      client->stats.have_server_stats = TRUE;
+      client->stats.server_encode_avg = json_get_int (body, "encode-avg");
+      client->stats.server_encode_max = json_get_int (body, "encode-max");
+      client->stats.server_rtt_avg = json_get_int (body, "rtt-avg");
+      client->stats.server_rtt_max = json_get_int (body, "rtt-max");
+      client->stats.server_frames_coalesced = json_get_int (body, "frames-coalesced");
+    }
+
+  g_string_free (response, TRUE);
+  g_object_unref (connection);
+}
+
+/************************************************************************
+ *                Clients                                               *
+ ************************************************************************/
+
+static gpointer
+client_thread (gpointer data)
+{
+  Client *client = data;
+  GError *error = NULL;
+  gint64 end_time, next_event_time, now;
+  guint next_event;
+  gint32 size[2];
+
+  client->start_time = g_get_monotonic_time ();
+
+  if (!client_connect (client, &error))
+    {
+      g_free (client->error);
+      client->error = g_strdup (error->message);
+      g_error_free (error);
+      g_clear_object (&client->connection);
+      return NULL;
+    }
+
+  size[0] = screen_width;
+  size[1] = screen_height;
+  send_input (client, BROADWAY_EVENT_SCREEN_SIZE_CHANGED, size, 2);
+
+  end_time = client->start_time + run_time;
+  next_event = 0;
+  next_event_time = n_script > 0 ? client->start_time + script[0].delay : G_MAXINT64;
+
+  while (!client->disconnected)
+    {
+      now = g_get_monotonic_time ();
+      if (now >= end_time)
+        break;
+
+      while (now >= next_event_time && !client->disconnected)
+        {
+          play_event (client, &script[next_event]);
+          next_event = (next_event + 1) % n_script;
+          next_event_time += script[next_event].delay;
+        }
+
+      client_read (client, MIN (next_event_time, end_time) - now);
+      process_input (client);
+    }
+
+  client->stats.elapsed = g_get_monotonic_time () - client->start_time;
+
+  if (!client->disconnected)
+    fetch_server_stats (client);
+
+  g_io_stream_close (G_IO_STREAM (client->connection), NULL, NULL);
+
+  return NULL;
+}
+
+static void
+print_stats (const char        *name,
+             const ClientStats *stats)
+{
+  double secs = MAX (stats->elapsed, 1) / (double)G_USEC_PER_SEC;
+
+  g_print ("%s:\n", name);
+  g_print ("  received     %.2f MB in %" G_GUINT64_FORMAT " messages (%.2f MB/s)\n",
+           stats->bytes / (1024.0 * 1024.0), stats->messages,
+           stats->bytes / (1024.0 * 1024.0) / secs);
+  g_print ("  frames       %" G_GUINT64_FORMAT " (%.1f/s), %" G_GUINT64_FORMAT " tiles, %"
+           G_GUINT64_FORMAT " copies, %" G_GUINT64_FORMAT " decode errors\n",
+           stats->frames, stats->frames / secs, stats->tiles, stats->copies,
+           stats->decode_errors);
+  g_print ("  decode       avg %.2f ms, max %.2f ms\n",
+           stats->frames ? stats->decode_total / (double)stats->frames / 1000.0 : 0.0,
+           stats->decode_max / 1000.0);
+  if (stats->latency_samples > 0)
+    g_print ("  input rtt    avg %.2f ms, min %.2f ms, max %.2f ms (%" G_GUINT64_FORMAT
+             " samples, %" G_GUINT64_FORMAT " events)\n",
+             stats->latency_total / (double)stats->latency_samples / 1000.0,
+             stats->latency_min / 1000.0, stats->latency_max / 1000.0,
+             stats->latency_samples, stats->input_events);
+  if (stats->have_server_stats)
+    {
+      g_print ("  encode       avg %.2f ms, max %.2f ms (broadwayd)\n",
+               stats->server_encode_avg / 1000.0, stats->server_encode_max / 1000.0);
+      g_print ("  frame rtt    avg %.2f ms, max %.2f ms, %" G_GINT64_FORMAT " coalesced (broadwayd)\n",
+               stats->server_rtt_avg / 1000.0, stats->server_rtt_max / 1000.0,
+               stats->server_frames_coalesced);
+    }
+}
+
+static void
+add_stats (ClientStats       *total,
+           const ClientStats *stats)
+{
+  total->bytes += stats->bytes;
+  total->messages += stats->messages;
+  total->frames += stats->frames;
+  total->tiles += stats->tiles;
+  total->copies += stats->copies;
+  total->decode_errors += stats->decode_errors;
+  total->decode_total += stats->decode_total;
+  total->decode_max = MAX (total->decode_max, stats->decode_max);
+  total->input_events += stats->input_events;
+  if (stats->latency_samples > 0)
+    {
+      if (total->latency_samples == 0)
+        total->latency_min = stats->latency_min;
+      total->latency_min = MIN (total->latency_min, stats->latency_min);
+      total->latency_max = MAX (total->latency_max, stats->latency_max);
+    }
+  total->latency_samples += stats->latency_samples;
+  total->latency_total += stats->latency_total;
+  total->elapsed = MAX (total->elapsed, stats->elapsed);
+}
+
+int
+main (int argc, char *argv[])
+{
+  GError *error = NULL;
+  GOptionContext *context;
+  Client *clients;
+  GThread **threads;
+  ClientStats total = { 0 };
+  char *script_file = NULL;
+  char *size = NULL;
+  char *host;
+  int n_clients = 1;
+  int duration = 10;
+  int port, i, failed;
+  const GOptionEntry entries[] = {
+    { "clients", 'n', 0, G_OPTION_ARG_INT, &n_clients, "Number of clients, on consecutive ports", "N" },
+    { "duration", 'd', 0, G_OPTION_ARG_INT, &duration, "Run for SECONDS", "SECONDS" },
+    { "script", 's', 0, G_OPTION_ARG_FILENAME, &script_file, "Replay input events from FILE", "FILE" },
+    { "size", 0, 0, G_OPTION_ARG_STRING, &size, "Browser window size", "WIDTHxHEIGHT" },
+    { NULL }
+  };
+
+  setlocale (LC_ALL, "");
+
+  context = g_option_context_new ("[HOST[:PORT]] - broadwayd load test");
+  g_option_context_add_main_entries (context, entries, GETTEXT_PACKAGE);
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("option parsing failed: %s\n", error->message);
+      exit (1);
+    }
+
+  if (n_clients < 1 || duration < 1)
+    {
+      g_printerr ("Need at least one client and one second\n");
+      exit (1);
+    }
+
+  if (size != NULL &&
+      (sscanf (size, "%dx%d", &screen_width, &screen_height) != 2 ||
+       screen_width <= 0 || screen_height <= 0))
+    {
+      g_printerr ("Invalid size %s\n", size);
+      exit (1);
+    }
+
+  run_time = (gint64)duration * G_USEC_PER_SEC;
+
+  if (script_file != NULL && !load_script (script_file, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      exit (1);
+    }
+
+  host = g_strdup (argc > 1 ? argv[1] : "127.0.0.1");
+  port = DEFAULT_PORT;
+  if (strrchr (host, ':') != NULL && strchr (host, ']') == NULL)
+    {
+      char *colon = strrchr (host, ':');
+
+      port = atoi (colon + 1);
+      *colon = 0;
+    }
+
+  clients = g_new0 (Client, n_clients);
+  threads = g_new0 (GThread *, n_clients);
+
+  for (i = 0; i < n_clients; i++)
+    {
+      Client *client = &clients[i];
+
+      client->index = i;
+      client->host = host;
+      client->port = port + i;
+      client->in_buf = g_byte_array_new ();
+      client->surfaces = g_hash_table_new_full (NULL, NULL, NULL, (GDestroyNotify)surface_free);
+    }
+
+  for (i = 0; i < n_clients; i++)
+    threads[i] = g_thread_new ("broadway client", client_thread, &clients[i]);
+
+  failed = 0;
+  for (i = 0; i < n_clients; i++)
+    {
+      Client *client = &clients[i];
+      char *name;
+
+      g_thread_join (threads[i]);
+
+      name = g_strdup_printf ("client %d (%s:%d)", i, client->host, client->port);
+      if (client->connection == NULL)
+        {
+          g_printerr ("%s: %s\n", name, client->error);
+          failed++;
+        }
+      else
+        {
+          if (client->error)
+            g_printerr ("%s: %s\n", name, client->error);
+          print_stats (name, &client->stats);
+          add_stats (&total, &client->stats);
+        }
+      g_free (name);
+    }
+
+  if (n_clients > 1)
+    print_stats ("total", &total);
+
+  return failed > 0 || total.decode_errors > 0;
+}
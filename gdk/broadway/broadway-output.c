@@ -11,13 +11,67 @@
  *                Basic I/O primitives                                  *
  ************************************************************************/
 
+/* Buffer updates are encoded and compressed in horizontal tiles of
+ * this many rows, each on its own worker thread */
+#define TILE_HEIGHT 256
+
+typedef struct _BroadwayFrame BroadwayFrame;
+
+typedef struct {
+  BroadwayFrame *frame;
+  int y0, y1;
+  gpointer data;
+  gsize len;
+} BroadwayTile;
+
+/* A put_buffer command that is still being encoded. Everything written
+ * to the output before it is kept in data, and the command can't be
+ * sent (and nothing after it) until all its tiles are done. */
+struct _BroadwayFrame {
+  int ref_count;
+  guint32 serial;
+  BroadwayOutput *output;
+  GString *data;
+  BroadwayBuffer *buffer;
+  BroadwayBuffer *prev_buffer;
+  BroadwayCopy *copies;
+  int n_copies;
+  BroadwayTile *tiles;
+  int n_tiles;
+  int pending;
+  gboolean done;
+  gint64 queued_time;
+};
+
+/* A buffer update that was sent but not yet acknowledged */
+typedef struct {
+  guint32 serial;
+  gint64 sent_time;
+} BroadwayInFlight;
+
 struct BroadwayOutput {
   GOutputStream *out;
   GString *buf;
+  GQueue frames;
+  GQueue in_flight;
+  BroadwayOutputStats stats;
   int error;
   guint32 serial;
 };
 
+/* How many buffer updates a client may be behind before we
+ * start coalescing them */
+#define MAX_FRAMES_IN_FLIGHT 3
+
+static GThreadPool *analyze_pool;
+static GThreadPool *encode_pool;
+
+static void
+broadway_in_flight_free (gpointer data)
+{
+  g_slice_free (BroadwayInFlight, data);
+}
+
 static void
 broadway_output_send_cmd (BroadwayOutput *output,
 			  gboolean fin, BroadwayWSOpCode code,
@@ -56,16 +110,72 @@ void broadway_output_pong (BroadwayOutput *output)
   broadway_output_send_cmd (output, TRUE, BROADWAY_WS_CNX_PONG, NULL, 0);
 }
 
+static void
+broadway_frame_unref (BroadwayFrame *frame)
+{
+  int i;
+
+  if (!g_atomic_int_dec_and_test (&frame->ref_count))
+    return;
+
+  for (i = 0; i < frame->n_tiles; i++)
+    g_free (frame->tiles[i].data);
+  g_free (frame->tiles);
+  g_free (frame->copies);
+
+  if (frame->prev_buffer)
+    broadway_buffer_unref (frame->prev_buffer);
+  broadway_buffer_unref (frame->buffer);
+
+  g_string_free (frame->data, TRUE);
+  g_free (frame);
+}
+
 int
 broadway_output_flush (BroadwayOutput *output)
 {
-  if (output->buf->len == 0)
-    return TRUE;
+  BroadwayFrame *frame;
+  BroadwayInFlight *in_flight;
+  GString *ready;
+  gboolean sent;
+
+  sent = FALSE;
 
-  broadway_output_send_cmd (output, TRUE, BROADWAY_WS_BINARY,
-                            output->buf->str, output->buf->len);
+  /* Send the frames that are done, in order, along with
+   * everything written before them */
+  while ((frame = g_queue_peek_head (&output->frames)) != NULL &&
+         frame->done)
+    {
+      g_queue_pop_head (&output->frames);
+      frame->output = NULL;
+
+      ready = frame->data;
+      if (g_queue_is_empty (&output->frames) && output->buf->len > 0)
+        {
+          g_string_append_len (ready, output->buf->str, output->buf->len);
+          g_string_set_size (output->buf, 0);
+        }
+
+      broadway_output_send_cmd (output, TRUE, BROADWAY_WS_BINARY,
+                                ready->str, ready->len);
+
+      in_flight = g_slice_new (BroadwayInFlight);
+      in_flight->serial = frame->serial;
+      in_flight->sent_time = g_get_monotonic_time ();
+      g_queue_push_tail (&output->in_flight, in_flight);
+      output->stats.frames_sent++;
+
+      broadway_frame_unref (frame);
+      sent = TRUE;
+    }
 
-  g_string_set_size (output->buf, 0);
+  if (!sent && g_queue_is_empty (&output->frames) && output->buf->len > 0)
+    {
+      broadway_output_send_cmd (output, TRUE, BROADWAY_WS_BINARY,
+                                output->buf->str, output->buf->len);
+
+      g_string_set_size (output->buf, 0);
+    }
 
   return !output->error;
 
@@ -88,10 +198,82 @@ broadway_output_new (GOutputStream *out, guint32 serial)
 void
 broadway_output_free (BroadwayOutput *output)
 {
+  BroadwayFrame *frame;
+
+  /* Frames still being encoded are just dropped when they're done */
+  while ((frame = g_queue_pop_head (&output->frames)) != NULL)
+    {
+      frame->output = NULL;
+      broadway_frame_unref (frame);
+    }
+
+  g_queue_foreach (&output->in_flight, (GFunc) broadway_in_flight_free, NULL);
+  g_queue_clear (&output->in_flight);
+
+  g_string_free (output->buf, TRUE);
   g_object_unref (output->out);
   free (output);
 }
 
+/* The client acknowledges each buffer update once it has decoded it,
+ * which clocks how fast we send it more */
+void
+broadway_output_ack (BroadwayOutput *output,
+                     guint32         serial)
+{
+  BroadwayInFlight *in_flight;
+  gint64 rtt;
+
+  while ((in_flight = g_queue_peek_head (&output->in_flight)) != NULL &&
+         (gint32) (in_flight->serial - serial) <= 0)
+    {
+      g_queue_pop_head (&output->in_flight);
+
+      rtt = g_get_monotonic_time () - in_flight->sent_time;
+
+      output->stats.rtt_last = rtt;
+      if (output->stats.frames_acked == 0)
+        {
+          output->stats.rtt_avg = rtt;
+          output->stats.rtt_min = rtt;
+          output->stats.rtt_max = rtt;
+        }
+      else
+        {
+          output->stats.rtt_avg = (7 * output->stats.rtt_avg + rtt) / 8;
+          output->stats.rtt_min = MIN (output->stats.rtt_min, rtt);
+          output->stats.rtt_max = MAX (output->stats.rtt_max, rtt);
+        }
+      output->stats.frames_acked++;
+
+      broadway_in_flight_free (in_flight);
+    }
+}
+
+/* Buffer updates that are being encoded, or sent but not acknowledged */
+guint
+broadway_output_get_queue_depth (BroadwayOutput *output)
+{
+  return g_queue_get_length (&output->frames) +
+         g_queue_get_length (&output->in_flight);
+}
+
+/* Whether the client is behind, and further buffer
+ * updates should be held back (and coalesced) */
+gboolean
+broadway_output_is_congested (BroadwayOutput *output)
+{
+  return broadway_output_get_queue_depth (output) >= MAX_FRAMES_IN_FLIGHT;
+}
+
+void
+broadway_output_get_stats (BroadwayOutput      *output,
+                           BroadwayOutputStats *stats)
+{
+  *stats = output->stats;
+  stats->queue_depth = broadway_output_get_queue_depth (output);
+}
+
 guint32
 broadway_output_get_next_serial (BroadwayOutput *output)
 {
@@ -129,29 +311,41 @@ append_flags (BroadwayOutput *output, guint32 val)
 }
 
 static void
-append_uint16 (BroadwayOutput *output, guint32 v)
+string_append_uint16 (GString *buf, guint32 v)
 {
-  gsize old_len = output->buf->len;
-  guint8 *buf;
+  gsize old_len = buf->len;
+  guint8 *p;
 
-  g_string_set_size (output->buf, old_len + 2);
-  buf = (guint8 *)output->buf->str + old_len;
-  buf[0] = (v >> 0) & 0xff;
-  buf[1] = (v >> 8) & 0xff;
+  g_string_set_size (buf, old_len + 2);
+  p = (guint8 *)buf->str + old_len;
+  p[0] = (v >> 0) & 0xff;
+  p[1] = (v >> 8) & 0xff;
 }
 
 static void
-append_uint32 (BroadwayOutput *output, guint32 v)
+string_append_uint32 (GString *buf, guint32 v)
 {
-  gsize old_len = output->buf->len;
-  guint8 *buf;
+  gsize old_len = buf->len;
+  guint8 *p;
+
+  g_string_set_size (buf, old_len + 4);
+  p = (guint8 *)buf->str + old_len;
+  p[0] = (v >> 0) & 0xff;
+  p[1] = (v >> 8) & 0xff;
+  p[2] = (v >> 16) & 0xff;
+  p[3] = (v >> 24) & 0xff;
+}
 
-  g_string_set_size (output->buf, old_len + 4);
-  buf = (guint8 *)output->buf->str + old_len;
-  buf[0] = (v >> 0) & 0xff;
-  buf[1] = (v >> 8) & 0xff;
-  buf[2] = (v >> 16) & 0xff;
-  buf[3] = (v >> 24) & 0xff;
+static void
+append_uint16 (BroadwayOutput *output, guint32 v)
+{
+  string_append_uint16 (output->buf, v);
+}
+
+static void
+append_uint32 (BroadwayOutput *output, guint32 v)
+{
+  string_append_uint32 (output->buf, v);
 }
 
 static void
@@ -286,18 +480,158 @@ broadway_output_set_transient_for (BroadwayOutput *output,
   append_uint16 (output, parent_id);
 }
 
+static void
+record_encode_time (BroadwayOutput *output,
+                    gint64          time)
+{
+  BroadwayOutputStats *stats = &output->stats;
+
+  if (stats->encode_max == 0)
+    stats->encode_avg = time;
+  else
+    stats->encode_avg = (7 * stats->encode_avg + time) / 8;
+  stats->encode_last = time;
+  stats->encode_max = MAX (stats->encode_max, time);
+}
+
+static gboolean
+frame_encoded_cb (gpointer user_data)
+{
+  BroadwayFrame *frame = user_data;
+  BroadwayCopy *copy;
+  BroadwayTile *tile;
+  int i, n_tiles;
+
+  string_append_uint16 (frame->data, frame->n_copies);
+  for (i = 0; i < frame->n_copies; i++)
+    {
+      copy = &frame->copies[i];
+      string_append_uint16 (frame->data, copy->rect.x);
+      string_append_uint16 (frame->data, copy->rect.y);
+      string_append_uint16 (frame->data, copy->rect.width);
+      string_append_uint16 (frame->data, copy->rect.height);
+      string_append_uint16 (frame->data, copy->src_x);
+      string_append_uint16 (frame->data, copy->src_y);
+    }
+
+  /* Tiles without any damage are left out */
+  n_tiles = 0;
+  for (i = 0; i < frame->n_tiles; i++)
+    {
+      if (frame->tiles[i].len > 0)
+        n_tiles++;
+    }
+
+  string_append_uint16 (frame->data, n_tiles);
+  for (i = 0; i < frame->n_tiles; i++)
+    {
+      tile = &frame->tiles[i];
+      if (tile->len == 0)
+        continue;
+
+      string_append_uint16 (frame->data, tile->y0);
+      string_append_uint32 (frame->data, tile->len);
+      g_string_append_len (frame->data, tile->data, tile->len);
+    }
+
+  frame->done = TRUE;
+
+  if (frame->output)
+    {
+      record_encode_time (frame->output,
+                          g_get_monotonic_time () - frame->queued_time);
+      broadway_output_flush (frame->output);
+    }
+
+  broadway_frame_unref (frame);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Runs in a worker thread. Each tile gets its own raw deflate stream,
+ * so they can be compressed in parallel. */
+static void
+encode_tile (gpointer data,
+             gpointer user_data)
+{
+  BroadwayTile *tile = data;
+  BroadwayFrame *frame = tile->frame;
+  GZlibCompressor *compressor;
+  GOutputStream *out, *out_mem;
+  GString *encoded;
+
+  encoded = g_string_new ("");
+  broadway_buffer_encode (frame->buffer, frame->prev_buffer,
+                          frame->copies, frame->n_copies,
+                          tile->y0, tile->y1, encoded);
+
+  if (encoded->len > 0)
+    {
+      compressor = g_zlib_compressor_new (G_ZLIB_COMPRESSOR_FORMAT_RAW, -1);
+      out_mem = g_memory_output_stream_new_resizable ();
+      out = g_converter_output_stream_new (out_mem, G_CONVERTER (compressor));
+      g_object_unref (compressor);
+
+      if (!g_output_stream_write_all (out, encoded->str, encoded->len,
+                                      NULL, NULL, NULL) ||
+          !g_output_stream_close (out, NULL, NULL))
+        g_warning ("compression failed");
+      else
+        {
+          tile->len = g_memory_output_stream_get_data_size (G_MEMORY_OUTPUT_STREAM (out_mem));
+          tile->data = g_memory_output_stream_steal_data (G_MEMORY_OUTPUT_STREAM (out_mem));
+        }
+
+      g_object_unref (out);
+      g_object_unref (out_mem);
+    }
+
+  g_string_free (encoded, TRUE);
+
+  /* The last tile hands the frame back to the main loop */
+  if (g_atomic_int_dec_and_test (&frame->pending))
+    g_idle_add (frame_encoded_cb, frame);
+}
+
+/* Runs in a worker thread. Scrolled areas have to be known
+ * before any of the tiles can be encoded. */
+static void
+analyze_frame (gpointer data,
+               gpointer user_data)
+{
+  BroadwayFrame *frame = data;
+  int i;
+
+  frame->n_copies = broadway_buffer_find_copies (frame->buffer,
+                                                 frame->prev_buffer,
+                                                 &frame->copies);
+
+  for (i = 0; i < frame->n_tiles; i++)
+    g_thread_pool_push (encode_pool, &frame->tiles[i], NULL);
+}
+
 void
 broadway_output_put_buffer (BroadwayOutput *output,
                             int             id,
                             BroadwayBuffer *prev_buffer,
                             BroadwayBuffer *buffer)
 {
-  gsize len;
-  int w, h;
-  GZlibCompressor *compressor;
-  GOutputStream *out, *out_mem;
-  GString *encoded;
+  BroadwayFrame *frame;
+  BroadwayTile *tile;
+  guint32 serial;
+  int w, h, i;
+
+  if (encode_pool == NULL)
+    {
+      analyze_pool = g_thread_pool_new (analyze_frame, NULL,
+                                        g_get_num_processors (),
+                                        FALSE, NULL);
+      encode_pool = g_thread_pool_new (encode_tile, NULL,
+                                       g_get_num_processors (),
+                                       FALSE, NULL);
+    }
 
+  serial = output->serial;
   write_header (output, BROADWAY_OP_PUT_BUFFER);
 
   w = broadway_buffer_get_width (buffer);
@@ -307,26 +641,33 @@ broadway_output_put_buffer (BroadwayOutput *output,
   append_uint16 (output, w);
   append_uint16 (output, h);
 
-  encoded = g_string_new ("");
-  broadway_buffer_encode (buffer, prev_buffer, encoded);
-
-  compressor = g_zlib_compressor_new (G_ZLIB_COMPRESSOR_FORMAT_RAW, -1);
-  out_mem = g_memory_output_stream_new_resizable ();
-  out = g_converter_output_stream_new (out_mem, G_CONVERTER (compressor));
-  g_object_unref (compressor);
+  /* Take over everything written so far, the tiles
+   * are appended to it once they're done */
+  frame = g_new0 (BroadwayFrame, 1);
+  frame->ref_count = 2; /* One for the output, one for the workers */
+  frame->serial = serial;
+  frame->output = output;
+  frame->queued_time = g_get_monotonic_time ();
+  frame->data = output->buf;
+  output->buf = g_string_new ("");
 
-  if (!g_output_stream_write_all (out, encoded->str, encoded->len,
-                                  NULL, NULL, NULL) ||
-      !g_output_stream_close (out, NULL, NULL))
-    g_warning ("compression failed");
+  frame->buffer = broadway_buffer_ref (buffer);
+  if (prev_buffer)
+    frame->prev_buffer = broadway_buffer_ref (prev_buffer);
 
+  frame->n_tiles = MAX ((h + TILE_HEIGHT - 1) / TILE_HEIGHT, 1);
+  frame->tiles = g_new0 (BroadwayTile, frame->n_tiles);
+  frame->pending = frame->n_tiles;
 
-  len = g_memory_output_stream_get_data_size (G_MEMORY_OUTPUT_STREAM (out_mem));
-  append_uint32 (output, len);
+  g_queue_push_tail (&output->frames, frame);
 
-  g_string_append_len (output->buf, g_memory_output_stream_get_data (G_MEMORY_OUTPUT_STREAM (out_mem)), len);
+  for (i = 0; i < frame->n_tiles; i++)
+    {
+      tile = &frame->tiles[i];
+      tile->frame = frame;
+      tile->y0 = i * TILE_HEIGHT;
+      tile->y1 = MIN (tile->y0 + TILE_HEIGHT, h);
+    }
 
-  g_string_free (encoded, TRUE);
-  g_object_unref (out);
-  g_object_unref (out_mem);
+  g_thread_pool_push (analyze_pool, frame, NULL);
 }
@@ -8,6 +8,22 @@
 
 typedef struct BroadwayOutput BroadwayOutput;
 
+typedef struct {
+  guint queue_depth;
+  guint64 frames_sent;
+  guint64 frames_acked;
+  /* Round trip times of buffer updates, in microseconds */
+  gint64 rtt_last;
+  gint64 rtt_avg;
+  gint64 rtt_min;
+  gint64 rtt_max;
+  /* Time from queueing a buffer update until it is encoded and
+   * compressed, in microseconds */
+  gint64 encode_last;
+  gint64 encode_avg;
+  gint64 encode_max;
+} BroadwayOutputStats;
+
 typedef enum {
   BROADWAY_WS_CONTINUATION = 0,
   BROADWAY_WS_TEXT = 1,
@@ -63,6 +79,12 @@ void            broadway_output_grab_pointer    (BroadwayOutput *output,
 						 gboolean owner_event);
 guint32         broadway_output_ungrab_pointer  (BroadwayOutput *output);
 void            broadway_output_pong            (BroadwayOutput *output);
+void            broadway_output_ack             (BroadwayOutput *output,
+                                                 guint32         serial);
+guint           broadway_output_get_queue_depth (BroadwayOutput *output);
+gboolean        broadway_output_is_congested    (BroadwayOutput *output);
+void            broadway_output_get_stats       (BroadwayOutput      *output,
+                                                 BroadwayOutputStats *stats);
 void            broadway_output_set_show_keyboard (BroadwayOutput *output,
                                                    gboolean show);
 
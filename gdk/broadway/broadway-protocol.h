@@ -23,7 +23,8 @@ typedef enum {
   BROADWAY_EVENT_CONFIGURE_NOTIFY = 'w',
   BROADWAY_EVENT_DELETE_NOTIFY = 'W',
   BROADWAY_EVENT_SCREEN_SIZE_CHANGED = 'd',
-  BROADWAY_EVENT_FOCUS = 'f'
+  BROADWAY_EVENT_FOCUS = 'f',
+  BROADWAY_EVENT_FRAME_ACK = 'a' /* Only seen by the daemon */
 } BroadwayEventType;
 
 typedef enum {
@@ -157,7 +158,8 @@ typedef enum {
   BROADWAY_REQUEST_GRAB_POINTER,
   BROADWAY_REQUEST_UNGRAB_POINTER,
   BROADWAY_REQUEST_FOCUS_WINDOW,
-  BROADWAY_REQUEST_SET_SHOW_KEYBOARD
+  BROADWAY_REQUEST_SET_SHOW_KEYBOARD,
+  BROADWAY_REQUEST_RELEASE_SHM
 } BroadwayRequestType;
 
 typedef struct {
@@ -190,10 +192,16 @@ typedef struct {
   BroadwayRequestBase base;
   guint32 id;
   char name[36];
+  guint32 shm_size;
   guint32 width;
   guint32 height;
+  guint32 n_rects;
+  BroadwayRect rects[1];
 } BroadwayRequestUpdate;
 
+/* Damage with more rectangles than this is sent as its extents */
+#define BROADWAY_MAX_DAMAGE_RECTS 32
+
 typedef struct {
   BroadwayRequestBase base;
   guint32 id;
@@ -231,6 +239,11 @@ typedef struct {
   guint32 show_keyboard;
 } BroadwayRequestSetShowKeyboard;
 
+typedef struct {
+  BroadwayRequestBase base;
+  char name[36];
+} BroadwayRequestReleaseShm;
+
 typedef union {
   BroadwayRequestBase base;
   BroadwayRequestNewWindow new_window;
@@ -248,6 +261,7 @@ typedef union {
   BroadwayRequestTranslate translate;
   BroadwayRequestFocusWindow focus_window;
   BroadwayRequestSetShowKeyboard set_show_keyboard;
+  BroadwayRequestReleaseShm release_shm;
 } BroadwayRequest;
 
 typedef enum {
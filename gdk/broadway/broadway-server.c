@@ -78,6 +78,12 @@ struct _BroadwayServer {
   int future_root_y;
   guint32 future_state;
   int future_mouse_in_toplevel;
+
+  /* Buffer updates replaced by newer ones before they were sent */
+  guint64 frames_coalesced;
+
+  /* Shared memory segments of the clients, by name */
+  GHashTable *shm_segments;
 };
 
 struct _BroadwayServerClass
@@ -115,13 +121,16 @@ struct BroadwayWindow {
   gint32 transient_for;
 
   BroadwayBuffer *buffer;
-  gboolean buffer_synced;
+  BroadwayBuffer *sent_buffer; /* The one the client has, if any */
+  cairo_region_t *unsent_damage; /* Between sent_buffer and buffer */
 
   char *cached_surface_name;
   cairo_surface_t *cached_surface;
 };
 
 static void broadway_server_resync_windows (BroadwayServer *server);
+static void shm_segment_unref (void *_segment);
+static void broadway_server_send_pending_buffers (BroadwayServer *server);
 
 static GType broadway_server_get_type (void);
 
@@ -138,6 +147,8 @@ broadway_server_init (BroadwayServer *server)
   server->last_seen_time = 1;
   server->id_ht = g_hash_table_new (NULL, NULL);
   server->id_counter = 0;
+  server->shm_segments = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                g_free, shm_segment_unref);
 
   root = g_new0 (BroadwayWindow, 1);
   root->id = server->id_counter++;
@@ -160,6 +171,7 @@ broadway_server_finalize (GObject *object)
   g_free (server->address);
   g_free (server->ssl_cert);
   g_free (server->ssl_key);
+  g_hash_table_destroy (server->shm_segments);
 
   G_OBJECT_CLASS (broadway_server_parent_class)->finalize (object);
 }
@@ -511,6 +523,16 @@ parse_input_message (BroadwayInput *input, const unsigned char *message)
     msg.screen_resize_notify.height = ntohl (*p++);
     break;
 
+  case BROADWAY_EVENT_FRAME_ACK:
+    /* This is just for us, not for the clients */
+    broadway_output_ack (input->output, msg.base.serial);
+    if (input->output == server->output)
+      {
+        broadway_server_send_pending_buffers (server);
+        broadway_server_flush (server);
+      }
+    return;
+
   default:
     g_printerr ("parse_input_message - Unknown input command %c (%s)\n", msg.base.type, message);
     break;
@@ -1139,6 +1161,47 @@ send_data (HttpRequest *request,
 #include "clienthtml.h"
 #include "broadwayjs.h"
 
+static void
+send_stats (HttpRequest *request)
+{
+  BroadwayServer *server = request->server;
+  BroadwayOutputStats stats = { 0 };
+  char *json;
+
+  if (server->output)
+    broadway_output_get_stats (server->output, &stats);
+
+  json = g_strdup_printf ("{\n"
+                          "  \"connected\": %s,\n"
+                          "  \"queue-depth\": %u,\n"
+                          "  \"frames-sent\": %" G_GUINT64_FORMAT ",\n"
+                          "  \"frames-acked\": %" G_GUINT64_FORMAT ",\n"
+                          "  \"frames-coalesced\": %" G_GUINT64_FORMAT ",\n"
+                          "  \"rtt-last\": %" G_GINT64_FORMAT ",\n"
+                          "  \"rtt-avg\": %" G_GINT64_FORMAT ",\n"
+                          "  \"rtt-min\": %" G_GINT64_FORMAT ",\n"
+                          "  \"rtt-max\": %" G_GINT64_FORMAT ",\n"
+                          "  \"encode-last\": %" G_GINT64_FORMAT ",\n"
+                          "  \"encode-avg\": %" G_GINT64_FORMAT ",\n"
+                          "  \"encode-max\": %" G_GINT64_FORMAT "\n"
+                          "}\n",
+                          server->output ? "true" : "false",
+                          stats.queue_depth,
+                          stats.frames_sent,
+                          stats.frames_acked,
+                          server->frames_coalesced,
+                          stats.rtt_last,
+                          stats.rtt_avg,
+                          stats.rtt_min,
+                          stats.rtt_max,
+                          stats.encode_last,
+                          stats.encode_avg,
+                          stats.encode_max);
+
+  send_data (request, "application/json", json, strlen (json));
+  g_free (json);
+}
+
 static void
 got_request (HttpRequest *request)
 {
@@ -1179,6 +1242,8 @@ got_request (HttpRequest *request)
     send_data (request, "text/javascript", broadway_js, G_N_ELEMENTS(broadway_js) - 1);
   else if (strcmp (escaped, "/socket") == 0)
     start_input (request);
+  else if (strcmp (escaped, "/stats") == 0)
+    send_stats (request);
   else
     send_error (request, 404, "File not found");
 
@@ -1461,6 +1526,10 @@ broadway_server_destroy_window (BroadwayServer *server,
       if (window->cached_surface != NULL)
 	cairo_surface_destroy (window->cached_surface);
 
+      g_clear_pointer (&window->buffer, broadway_buffer_unref);
+      g_clear_pointer (&window->sent_buffer, broadway_buffer_unref);
+      g_clear_pointer (&window->unsent_damage, cairo_region_destroy);
+
       g_free (window);
     }
 }
@@ -1594,13 +1663,59 @@ broadway_server_has_client (BroadwayServer *server)
   return server->output != NULL;
 }
 
+/* Sends the latest buffer of the window, unless the client is
+ * still busy with earlier ones. In that case the update stays
+ * pending, and later updates are coalesced into it. */
+static void
+broadway_server_send_buffer (BroadwayServer *server,
+			     BroadwayWindow *window)
+{
+  if (server->output == NULL ||
+      window->buffer == NULL ||
+      window->buffer == window->sent_buffer ||
+      broadway_output_is_congested (server->output))
+    return;
+
+  broadway_output_put_buffer (server->output, window->id,
+			      window->sent_buffer, window->buffer);
+
+  if (window->sent_buffer)
+    broadway_buffer_unref (window->sent_buffer);
+  window->sent_buffer = broadway_buffer_ref (window->buffer);
+
+  g_clear_pointer (&window->unsent_damage, cairo_region_destroy);
+}
+
+static void
+broadway_server_send_pending_buffers (BroadwayServer *server)
+{
+  GList *l;
+
+  for (l = server->toplevels; l != NULL; l = l->next)
+    {
+      BroadwayWindow *window = l->data;
+
+      if (server->output == NULL ||
+	  broadway_output_is_congested (server->output))
+	break;
+
+      broadway_server_send_buffer (server, window);
+    }
+}
+
 void
 broadway_server_window_update (BroadwayServer *server,
 			       gint id,
-			       cairo_surface_t *surface)
+			       cairo_surface_t *surface,
+			       const BroadwayRect *rects,
+			       int n_rects)
 {
   BroadwayWindow *window;
   BroadwayBuffer *buffer;
+  BroadwayRect *damage;
+  cairo_region_t *region;
+  cairo_rectangle_int_t rect;
+  int i, n_damage;
 
   if (surface == NULL)
     return;
@@ -1613,21 +1728,58 @@ broadway_server_window_update (BroadwayServer *server,
   g_assert (window->width == cairo_image_surface_get_width (surface));
   g_assert (window->height == cairo_image_surface_get_height (surface));
 
-  buffer = broadway_buffer_create (window->width, window->height,
-                                   cairo_image_surface_get_data (surface),
-                                   cairo_image_surface_get_stride (surface));
+  /* Normalize the client supplied damage into the banded, clipped form
+   * the encoder expects */
+  region = cairo_region_create ();
+  for (i = 0; i < n_rects; i++)
+    {
+      rect.x = rects[i].x;
+      rect.y = rects[i].y;
+      rect.width = rects[i].width;
+      rect.height = rects[i].height;
+      cairo_region_union_rectangle (region, &rect);
+    }
 
-  if (server->output != NULL)
+  /* If the previous update is still pending, this one replaces it,
+   * so it needs to cover the damage of both */
+  if (window->unsent_damage != NULL)
     {
-      window->buffer_synced = TRUE;
-      broadway_output_put_buffer (server->output, window->id,
-                                  window->buffer, buffer);
+      cairo_region_union (region, window->unsent_damage);
+      cairo_region_destroy (window->unsent_damage);
+      if (server->output)
+        server->frames_coalesced++;
     }
 
+  rect.x = 0;
+  rect.y = 0;
+  rect.width = window->width;
+  rect.height = window->height;
+  cairo_region_intersect_rectangle (region, &rect);
+
+  n_damage = cairo_region_num_rectangles (region);
+  damage = g_new (BroadwayRect, MAX (n_damage, 1));
+  for (i = 0; i < n_damage; i++)
+    {
+      cairo_region_get_rectangle (region, i, &rect);
+      damage[i].x = rect.x;
+      damage[i].y = rect.y;
+      damage[i].width = rect.width;
+      damage[i].height = rect.height;
+    }
+
+  buffer = broadway_buffer_create (window->width, window->height,
+                                   cairo_image_surface_get_data (surface),
+                                   cairo_image_surface_get_stride (surface),
+                                   window->buffer, damage, n_damage);
+  g_free (damage);
+
   if (window->buffer)
-    broadway_buffer_destroy (window->buffer);
+    broadway_buffer_unref (window->buffer);
 
   window->buffer = buffer;
+  window->unsent_damage = region;
+
+  broadway_server_send_buffer (server, window);
 }
 
 gboolean
@@ -1757,34 +1909,43 @@ broadway_server_ungrab_pointer (BroadwayServer *server,
 
 static const cairo_user_data_key_t shm_cairo_key;
 
+/* Clients allocate their surfaces from a pool of shared memory
+ * segments that get reused for other sizes, e.g. while a window is
+ * being resized. We keep each segment mapped until the client
+ * releases it, so only the first update using it needs to map it. */
 typedef struct {
+  int ref_count;
   void *data;
   gsize data_size;
-} ShmSurfaceData;
+} ShmSegment;
 
 static void
-shm_data_unmap (void *_data)
+shm_segment_unref (void *_segment)
 {
-  ShmSurfaceData *data = _data;
+  ShmSegment *segment = _segment;
+
+  if (--segment->ref_count > 0)
+    return;
+
 #ifdef G_OS_UNIX
-  munmap (data->data, data->data_size);
+  munmap (segment->data, segment->data_size);
 #elif defined(G_OS_WIN32)
-  UnmapViewOfFile (data->data);
+  UnmapViewOfFile (segment->data);
 #endif
-  g_free (data);
+  g_free (segment);
 }
 
 cairo_surface_t *
 broadway_server_open_surface (BroadwayServer *server,
 			      guint32 id,
 			      char *name,
+			      gsize shm_size,
 			      int width,
 			      int height)
 {
   BroadwayWindow *window;
-  ShmSurfaceData *data;
+  ShmSegment *segment;
   cairo_surface_t *surface;
-  gsize size;
   void *ptr;
 
   window = g_hash_table_lookup (server->id_ht,
@@ -1792,30 +1953,39 @@ broadway_server_open_surface (BroadwayServer *server,
   if (window == NULL)
     return NULL;
 
+  if ((gsize)width * height * sizeof (guint32) > shm_size)
+    return NULL;
+
   if (window->cached_surface_name != NULL &&
-      strcmp (name, window->cached_surface_name) == 0)
+      strcmp (name, window->cached_surface_name) == 0 &&
+      cairo_image_surface_get_width (window->cached_surface) == width &&
+      cairo_image_surface_get_height (window->cached_surface) == height)
     return cairo_surface_reference (window->cached_surface);
 
-  size = width * height * sizeof (guint32);
-
-  ptr = map_named_shm (name, size);
-
-  if (ptr == NULL)
-    return NULL;
+  segment = g_hash_table_lookup (server->shm_segments, name);
+  if (segment == NULL)
+    {
+      ptr = map_named_shm (name, shm_size);
+      if (ptr == NULL)
+	return NULL;
 
-  data = g_new0 (ShmSurfaceData, 1);
+      segment = g_new0 (ShmSegment, 1);
+      segment->ref_count = 1;
+      segment->data = ptr;
+      segment->data_size = shm_size;
 
-  data->data = ptr;
-  data->data_size = size;
+      g_hash_table_insert (server->shm_segments, g_strdup (name), segment);
+    }
 
-  surface = cairo_image_surface_create_for_data ((guchar *)data->data,
+  surface = cairo_image_surface_create_for_data ((guchar *)segment->data,
 						 CAIRO_FORMAT_ARGB32,
 						 width, height,
 						 width * sizeof (guint32));
   g_assert (surface != NULL);
 
+  segment->ref_count++;
   cairo_surface_set_user_data (surface, &shm_cairo_key,
-			       data, shm_data_unmap);
+			       segment, shm_segment_unref);
 
   g_free (window->cached_surface_name);
   window->cached_surface_name = g_strdup (name);
@@ -1827,6 +1997,15 @@ broadway_server_open_surface (BroadwayServer *server,
   return surface;
 }
 
+/* The client is not going to use the segment anymore, it is unmapped
+ * once no window surface refers to it */
+void
+broadway_server_release_shm (BroadwayServer *server,
+			     const char *name)
+{
+  g_hash_table_remove (server->shm_segments, name);
+}
+
 guint32
 broadway_server_new_window (BroadwayServer *server,
 			    int x,
@@ -1887,7 +2066,7 @@ broadway_server_resync_windows (BroadwayServer *server)
       if (window->id == 0)
 	continue; /* Skip root */
 
-      window->buffer_synced = FALSE;
+      g_clear_pointer (&window->sent_buffer, broadway_buffer_unref);
       broadway_output_new_surface (server->output,
 				   window->id,
 				   window->x,
@@ -1911,12 +2090,7 @@ broadway_server_resync_windows (BroadwayServer *server)
 	{
 	  broadway_output_show_surface (server->output, window->id);
 
-	  if (window->buffer != NULL)
-	    {
-	      window->buffer_synced = TRUE;
-              broadway_output_put_buffer (server->output, window->id,
-                                          NULL, window->buffer);
-	    }
+	  broadway_server_send_buffer (server, window);
 	}
     }
 
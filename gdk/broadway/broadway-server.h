@@ -80,7 +80,9 @@ cairo_surface_t   * broadway_server_create_surface           (int
 							      int               height);
 void                broadway_server_window_update            (BroadwayServer   *server,
 							      gint              id,
-							      cairo_surface_t  *surface);
+							      cairo_surface_t  *surface,
+							      const BroadwayRect *rects,
+							      int               n_rects);
 gboolean            broadway_server_window_move_resize       (BroadwayServer   *server,
 							      gint              id,
 							      gboolean          with_move,
@@ -93,7 +95,10 @@ void                broadway_server_focus_window             (BroadwayServer   *
 cairo_surface_t * broadway_server_open_surface (BroadwayServer *server,
 						guint32 id,
 						char *name,
+						gsize shm_size,
 						int width,
 						int height);
+void              broadway_server_release_shm  (BroadwayServer *server,
+						const char *name);
 
 #endif /* __BROADWAY_SERVER__ */
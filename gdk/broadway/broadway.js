@@ -382,18 +382,35 @@ function markRect(src, srcX, srcY, dest, destX, destY, width, height, r, g, b)
     }
 }
 
-function decodeBuffer(context, oldData, w, h, data, debug)
+function decodeBuffer(context, oldData, w, h, copies, tiles, debug)
 {
-    var i, j;
     var imageData = context.createImageData(w, h);
 
     if (oldData != null) {
         // Copy old frame into new buffer
         copyRect(oldData, 0, 0, imageData, 0, 0, oldData.width, oldData.height);
+
+        // Then move the scrolled areas, the tiles are relative to that
+        for (var c = 0; c < copies.length; c++) {
+            var copy = copies[c];
+            copyRect(oldData, copy.srcX, copy.srcY, imageData, copy.x, copy.y, copy.w, copy.h);
+            if (debug) // copies are yellow
+                markRect(oldData, copy.srcX, copy.srcY, imageData, copy.x, copy.y, copy.w, copy.h, 128, 128, 0x00);
+        }
     }
 
+    // Each tile is a separate stream starting at its first row
+    for (var t = 0; t < tiles.length; t++)
+        decodeTile(imageData, oldData, w, tiles[t].y, tiles[t].data, debug);
+
+    return imageData;
+}
+
+function decodeTile(imageData, oldData, w, y, data, debug)
+{
+    var i, j;
     var src = 0;
-    var dest = 0;
+    var dest = y * w * 4;
 
     while (src < data.length)  {
         var b = data[src++];
@@ -507,23 +524,24 @@ function decodeBuffer(context, oldData, w, h, data, debug)
             }
         }
     }
-
-    return imageData;
 }
 
-function cmdPutBuffer(id, w, h, compressed)
+function cmdPutBuffer(id, w, h, copies, compressedTiles)
 {
     var surface = surfaces[id];
     var context = surface.canvas.getContext("2d");
 
-    var inflate = new Zlib.RawInflate(compressed);
-    var data = inflate.decompress();
+    var tiles = [];
+    for (var i = 0; i < compressedTiles.length; i++) {
+        var inflate = new Zlib.RawInflate(compressedTiles[i].data);
+        tiles.push({ y: compressedTiles[i].y, data: inflate.decompress() });
+    }
 
-    var imageData = decodeBuffer (context, surface.imageData, w, h, data, debugDecoding);
+    var imageData = decodeBuffer (context, surface.imageData, w, h, copies, tiles, debugDecoding);
     context.putImageData(imageData, 0, 0);
 
     if (debugDecoding)
-        imageData = decodeBuffer (context, surface.imageData, w, h, data, false);
+        imageData = decodeBuffer (context, surface.imageData, w, h, copies, tiles, false);
 
     surface.imageData = imageData;
 }
@@ -620,8 +638,22 @@ function handleCommands(cmd)
 	    id = cmd.get_16();
 	    w = cmd.get_16();
 	    h = cmd.get_16();
-            var data = cmd.get_data();
-            cmdPutBuffer(id, w, h, data);
+            var nCopies = cmd.get_16();
+            var copies = [];
+            for (var c = 0; c < nCopies; c++) {
+                copies.push({ x: cmd.get_16(), y: cmd.get_16(),
+                              w: cmd.get_16(), h: cmd.get_16(),
+                              srcX: cmd.get_16(), srcY: cmd.get_16() });
+            }
+            var nTiles = cmd.get_16();
+            var tiles = [];
+            for (var t = 0; t < nTiles; t++) {
+                y = cmd.get_16();
+                tiles.push({ y: y, data: cmd.get_data() });
+            }
+            cmdPutBuffer(id, w, h, copies, tiles);
+            // Let the server know we're keeping up
+            sendInput ("a", []);
             break;
 
 	case 'g': // Grab
@@ -51,6 +51,7 @@ typedef struct  {
   GBufferedInputStream *in;
   GSList *serial_mappings;
   GList *windows;
+  GHashTable *shm_names; /* Segments the server mapped for us */
   guint disconnect_idle;
 } BroadwayClient;
 
@@ -63,12 +64,15 @@ client_free (BroadwayClient *client)
   g_object_unref (client->connection);
   g_object_unref (client->in);
   g_slist_free_full (client->serial_mappings, g_free);
+  g_hash_table_destroy (client->shm_names);
   g_free (client);
 }
 
 static void
 client_disconnected (BroadwayClient *client)
 {
+  GHashTableIter iter;
+  const char *name;
   GList *l;
 
   if (client->disconnect_idle != 0)
@@ -83,6 +87,11 @@ client_disconnected (BroadwayClient *client)
   g_list_free (client->windows);
   client->windows = NULL;
 
+  g_hash_table_iter_init (&iter, client->shm_names);
+  while (g_hash_table_iter_next (&iter, (gpointer *)&name, NULL))
+    broadway_server_release_shm (server, name);
+  g_hash_table_remove_all (client->shm_names);
+
   broadway_server_flush (server);
 
   client_free (client);
@@ -200,6 +209,7 @@ client_handle_request (BroadwayClient *client,
   BroadwayReplyUngrabPointer reply_ungrab_pointer;
   cairo_surface_t *surface;
   guint32 before_serial, now_serial;
+  guint32 max_rects;
 
   before_serial = broadway_server_get_next_serial (server);
 
@@ -255,16 +265,29 @@ client_handle_request (BroadwayClient *client,
 						request->set_transient_for.parent);
       break;
     case BROADWAY_REQUEST_UPDATE:
+      max_rects = 0;
+      if (request->base.size > G_STRUCT_OFFSET (BroadwayRequestUpdate, rects))
+	max_rects = (request->base.size - G_STRUCT_OFFSET (BroadwayRequestUpdate, rects)) / sizeof (BroadwayRect);
+      if (request->update.n_rects > max_rects)
+	request->update.n_rects = max_rects;
+      request->update.name[sizeof (request->update.name) - 1] = 0;
+
       surface = broadway_server_open_surface (server,
 					      request->update.id,
 					      request->update.name,
+					      request->update.shm_size,
 					      request->update.width,
 					      request->update.height);
       if (surface != NULL)
 	{
+	  if (!g_hash_table_contains (client->shm_names, request->update.name))
+	    g_hash_table_add (client->shm_names, g_strdup (request->update.name));
+
 	  broadway_server_window_update (server,
 					 request->update.id,
-					 surface);
+					 surface,
+					 request->update.rects,
+					 request->update.n_rects);
 	  cairo_surface_destroy (surface);
 	}
       break;
@@ -301,6 +324,11 @@ client_handle_request (BroadwayClient *client,
     case BROADWAY_REQUEST_SET_SHOW_KEYBOARD:
       broadway_server_set_show_keyboard (server, request->set_show_keyboard.show_keyboard);
       break;
+    case BROADWAY_REQUEST_RELEASE_SHM:
+      request->release_shm.name[sizeof (request->release_shm.name) - 1] = 0;
+      if (g_hash_table_remove (client->shm_names, request->release_shm.name))
+	broadway_server_release_shm (server, request->release_shm.name);
+      break;
     default:
       g_warning ("Unknown request of type %d", request->base.type);
     }
@@ -350,6 +378,8 @@ client_fill_cb (GObject *source_object,
 	      remaining -= size;
 	      buffer += size;
 	    }
+	  else
+	    break;
 	}
       
       /* This is guaranteed not to block */
@@ -380,6 +410,7 @@ incoming_client (GSocketService    *service,
   client = g_new0 (BroadwayClient, 1);
   client->id = client_id_count++;
   client->connection = g_object_ref (connection);
+  client->shm_names = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 
   input = g_io_stream_get_input_stream (G_IO_STREAM (client->connection));
   client->in = (GBufferedInputStream *)g_buffered_input_stream_new (input);
@@ -43,7 +43,10 @@ struct _GdkBroadwayServer {
 
   guint process_input_idle;
   GList *incomming;
-  
+
+  /* Unused shared memory segments, most recently used first */
+  GList *free_shm;
+  gsize free_shm_size;
 };
 
 struct _GdkBroadwayServerClass
@@ -54,6 +57,7 @@ struct _GdkBroadwayServerClass
 static gboolean input_available_cb (gpointer stream, gpointer user_data);
 
 static GType gdk_broadway_server_get_type (void);
+static void shm_segment_free (gpointer _data);
 
 G_DEFINE_TYPE (GdkBroadwayServer, gdk_broadway_server, G_TYPE_OBJECT)
 
@@ -66,6 +70,10 @@ gdk_broadway_server_init (GdkBroadwayServer *server)
 static void
 gdk_broadway_server_finalize (GObject *object)
 {
+  GdkBroadwayServer *server = GDK_BROADWAY_SERVER (object);
+
+  g_list_free_full (server->free_shm, shm_segment_free);
+
   G_OBJECT_CLASS (gdk_broadway_server_parent_class)->finalize (object);
 }
 
@@ -665,15 +673,41 @@ create_random_shm (char *name, gsize size, gboolean *is_shm)
 
 static const cairo_user_data_key_t gdk_broadway_shm_cairo_key;
 
+/* Window surfaces live in shared memory segments of a few size classes.
+ * When a surface goes away, e.g. on every step of an interactive resize,
+ * its segment is kept for the next surface of the same class, and the
+ * daemon keeps it mapped until we release it. */
+#define SHM_MIN_SEGMENT_SIZE (64 * 1024)
+#define SHM_MAX_FREE_SEGMENTS 4
+#define SHM_MAX_FREE_SIZE (64 * 1024 * 1024)
+
 typedef struct {
   char name[36];
   void *data;
   gsize data_size;
   gboolean is_shm;
+  GdkBroadwayServer *server; /* Set while a surface uses it */
 } BroadwayShmSurfaceData;
 
+/* Powers of two and one and a half times powers of two, so at most
+ * a third of a segment goes unused */
+static gsize
+shm_segment_size (gsize size)
+{
+  gsize segment_size = SHM_MIN_SEGMENT_SIZE;
+
+  while (segment_size < size)
+    {
+      if (segment_size + segment_size / 2 >= size)
+	return segment_size + segment_size / 2;
+      segment_size *= 2;
+    }
+
+  return segment_size;
+}
+
 static void
-shm_data_destroy (void *_data)
+shm_segment_free (gpointer _data)
 {
   BroadwayShmSurfaceData *data = _data;
 
@@ -707,16 +741,72 @@ shm_data_destroy (void *_data)
   g_free (data);
 }
 
+static void
+shm_data_destroy (void *_data)
+{
+  BroadwayShmSurfaceData *data = _data;
+  GdkBroadwayServer *server = data->server;
+  BroadwayRequestReleaseShm msg;
+  GList *last;
+
+  data->server = NULL;
+  server->free_shm = g_list_prepend (server->free_shm, data);
+  server->free_shm_size += data->data_size;
+
+  while (g_list_length (server->free_shm) > SHM_MAX_FREE_SEGMENTS ||
+	 server->free_shm_size > SHM_MAX_FREE_SIZE)
+    {
+      last = g_list_last (server->free_shm);
+      data = last->data;
+      server->free_shm = g_list_delete_link (server->free_shm, last);
+      server->free_shm_size -= data->data_size;
+
+      memcpy (msg.name, data->name, 36);
+      gdk_broadway_server_send_message (server, msg,
+					BROADWAY_REQUEST_RELEASE_SHM);
+      shm_segment_free (data);
+    }
+
+  g_object_unref (server);
+}
+
 cairo_surface_t *
-_gdk_broadway_server_create_surface (int                 width,
-				     int                 height)
+_gdk_broadway_server_create_surface (GdkBroadwayServer *server,
+				     int                width,
+				     int                height)
 {
   BroadwayShmSurfaceData *data;
   cairo_surface_t *surface;
+  gsize size, segment_size;
+  GList *l;
 
-  data = g_new (BroadwayShmSurfaceData, 1);
-  data->data_size = width * height * sizeof (guint32);
-  data->data = create_random_shm (data->name, data->data_size, &data->is_shm);
+  size = (gsize)width * height * sizeof (guint32);
+  segment_size = shm_segment_size (size);
+
+  data = NULL;
+  for (l = server->free_shm; l != NULL; l = l->next)
+    {
+      BroadwayShmSurfaceData *free_data = l->data;
+
+      if (free_data->data_size == segment_size)
+	{
+	  data = free_data;
+	  server->free_shm = g_list_delete_link (server->free_shm, l);
+	  server->free_shm_size -= data->data_size;
+	  /* Start out cleared, like a new segment */
+	  memset (data->data, 0, size);
+	  break;
+	}
+    }
+
+  if (data == NULL)
+    {
+      data = g_new (BroadwayShmSurfaceData, 1);
+      data->data_size = segment_size;
+      data->data = create_random_shm (data->name, data->data_size, &data->is_shm);
+    }
+
+  data->server = g_object_ref (server);
 
   surface = cairo_image_surface_create_for_data ((guchar *)data->data,
 						 CAIRO_FORMAT_ARGB32, width, height, width * sizeof (guint32));
@@ -731,10 +821,14 @@ _gdk_broadway_server_create_surface (int                 width,
 void
 _gdk_broadway_server_window_update (GdkBroadwayServer *server,
 				    gint id,
-				    cairo_surface_t *surface)
+				    cairo_surface_t *surface,
+				    cairo_region_t *damage)
 {
-  BroadwayRequestUpdate msg;
+  BroadwayRequestUpdate *msg;
   BroadwayShmSurfaceData *data;
+  cairo_rectangle_int_t rect;
+  gsize size;
+  int i, n_rects;
 
   if (surface == NULL)
     return;
@@ -742,13 +836,55 @@ _gdk_broadway_server_window_update (GdkBroadwayServer *server,
   data = cairo_surface_get_user_data (surface, &gdk_broadway_shm_cairo_key);
   g_assert (data != NULL);
 
-  msg.id = id;
-  memcpy (msg.name, data->name, 36);
-  msg.width = cairo_image_surface_get_width (surface);
-  msg.height = cairo_image_surface_get_height (surface);
+  if (damage != NULL)
+    n_rects = cairo_region_num_rectangles (damage);
+  else
+    n_rects = 0;
 
-  gdk_broadway_server_send_message (server, msg,
-				    BROADWAY_REQUEST_UPDATE);
+  /* Let the daemon encode everything if we don't know any better, and
+   * don't bother describing very fragmented damage in detail. */
+  if (n_rects == 0 || n_rects > BROADWAY_MAX_DAMAGE_RECTS)
+    n_rects = 1;
+
+  size = sizeof (BroadwayRequestUpdate) + (n_rects - 1) * sizeof (BroadwayRect);
+  msg = g_alloca (size);
+
+  msg->id = id;
+  memcpy (msg->name, data->name, 36);
+  msg->shm_size = data->data_size;
+  msg->width = cairo_image_surface_get_width (surface);
+  msg->height = cairo_image_surface_get_height (surface);
+  msg->n_rects = n_rects;
+
+  if (damage == NULL || cairo_region_is_empty (damage))
+    {
+      msg->rects[0].x = 0;
+      msg->rects[0].y = 0;
+      msg->rects[0].width = msg->width;
+      msg->rects[0].height = msg->height;
+    }
+  else if (n_rects == 1)
+    {
+      cairo_region_get_extents (damage, &rect);
+      msg->rects[0].x = rect.x;
+      msg->rects[0].y = rect.y;
+      msg->rects[0].width = rect.width;
+      msg->rects[0].height = rect.height;
+    }
+  else
+    {
+      for (i = 0; i < n_rects; i++)
+        {
+          cairo_region_get_rectangle (damage, i, &rect);
+          msg->rects[i].x = rect.x;
+          msg->rects[i].y = rect.y;
+          msg->rects[i].width = rect.width;
+          msg->rects[i].height = rect.height;
+        }
+    }
+
+  gdk_broadway_server_send_message_with_size (server, (BroadwayRequestBase *) msg,
+					      size, BROADWAY_REQUEST_UPDATE);
 }
 
 gboolean
@@ -59,11 +59,13 @@ gboolean           _gdk_broadway_server_window_translate         (GdkBroadwaySer
 								  cairo_region_t     *area,
 								  gint                dx,
 								  gint                dy);
-cairo_surface_t   *_gdk_broadway_server_create_surface           (int                 width,
+cairo_surface_t   *_gdk_broadway_server_create_surface           (GdkBroadwayServer  *server,
+								  int                 width,
 								  int                 height);
 void               _gdk_broadway_server_window_update            (GdkBroadwayServer  *server,
 								  gint                id,
-								  cairo_surface_t    *surface);
+								  cairo_surface_t    *surface,
+								  cairo_region_t     *damage);
 gboolean           _gdk_broadway_server_window_move_resize       (GdkBroadwayServer  *server,
 								  gint                id,
 								  gboolean            with_move,
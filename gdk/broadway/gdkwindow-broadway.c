@@ -126,7 +126,9 @@ update_dirty_windows_and_sync (void)
 	  updated_surface = TRUE;
 	  _gdk_broadway_server_window_update (display->server,
 					      impl->id,
-					      impl->surface);
+					      impl->surface,
+					      impl->damage);
+	  g_clear_pointer (&impl->damage, cairo_region_destroy);
 	}
     }
 
@@ -195,6 +197,8 @@ gdk_window_impl_broadway_finalize (GObject *object)
 
   g_hash_table_destroy (impl->device_cursor);
 
+  g_clear_pointer (&impl->damage, cairo_region_destroy);
+
   broadway_display->toplevels = g_list_remove (broadway_display->toplevels, impl);
 
   G_OBJECT_CLASS (gdk_window_impl_broadway_parent_class)->finalize (object);
@@ -297,12 +301,16 @@ void
 _gdk_broadway_window_resize_surface (GdkWindow *window)
 {
   GdkWindowImplBroadway *impl = GDK_WINDOW_IMPL_BROADWAY (window->impl);
+  GdkBroadwayDisplay *broadway_display;
 
   if (impl->surface)
     {
+      /* Destroy the old surface first, so its memory can be reused */
       cairo_surface_destroy (impl->surface);
 
-      impl->surface = _gdk_broadway_server_create_surface (gdk_window_get_width (impl->wrapper),
+      broadway_display = GDK_BROADWAY_DISPLAY (gdk_window_get_display (window));
+      impl->surface = _gdk_broadway_server_create_surface (broadway_display->server,
+							   gdk_window_get_width (impl->wrapper),
 							   gdk_window_get_height (impl->wrapper));
     }
 
@@ -339,7 +347,12 @@ gdk_window_broadway_ref_cairo_surface (GdkWindow *window)
 
   /* Create actual backing store if missing */
   if (!impl->surface)
-    impl->surface = _gdk_broadway_server_create_surface (w, h);
+    {
+      GdkBroadwayDisplay *broadway_display;
+
+      broadway_display = GDK_BROADWAY_DISPLAY (gdk_window_get_display (impl->wrapper));
+      impl->surface = _gdk_broadway_server_create_surface (broadway_display->server, w, h);
+    }
 
   /* Create a destroyable surface referencing the real one */
   if (!impl->ref_surface)
@@ -499,6 +512,7 @@ gdk_window_broadway_move_resize (GdkWindow *window,
 	  /* Resize clears the content */
 	  impl->dirty = TRUE;
 	  impl->last_synced = FALSE;
+	  g_clear_pointer (&impl->damage, cairo_region_destroy);
 
 	  window->width = width;
 	  window->height = height;
@@ -1047,6 +1061,15 @@ gdk_broadway_window_end_paint (GdkWindow *window)
 {
   GdkWindowImplBroadway *impl;
   impl = GDK_WINDOW_IMPL_BROADWAY (window->impl);
+
+  /* Collect what was painted since the last update so the daemon only
+   * has to encode that. A NULL damage on a dirty window means the whole
+   * surface, e.g. after a resize. */
+  if (!impl->dirty)
+    impl->damage = cairo_region_copy (window->current_paint.region);
+  else if (impl->damage != NULL)
+    cairo_region_union (impl->damage, window->current_paint.region);
+
   impl->dirty = TRUE;
 }
 
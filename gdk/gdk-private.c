@@ -17,7 +17,10 @@ gdk__private__ (void)
     gdk_display_set_rendering_mode,
     gdk_display_get_debug_updates,
     gdk_display_set_debug_updates,
-    gdk_window_move_to_rect
+    gdk_window_move_to_rect,
+    gdk_frame_recorder_is_enabled,
+    gdk_frame_recorder_add,
+    gdk_window_set_invalidate_notify
   };
 
   return &table;
@@ -3,6 +3,7 @@
 
 #include <gdk/gdk.h>
 #include "gdk/gdkinternals.h"
+#include "gdk/gdkframerecorderprivate.h"
 
 #define GDK_PRIVATE_CALL(symbol)        (gdk__private__ ()->symbol)
 
@@ -39,6 +40,8 @@ void            gdk_window_move_to_rect         (GdkWindow          *window,
                                                  gint                rect_anchor_dx,
                                                  gint                rect_anchor_dy);
 
+void            gdk_window_set_invalidate_notify (GdkWindowInvalidateHandlerFunc notify);
+
 typedef struct {
   /* add all private functions here, initialize them in gdk-private.c */
   gboolean (* gdk_device_grab_info) (GdkDisplay  *display,
@@ -72,6 +75,14 @@ typedef struct {
                                     GdkAnchorHints      anchor_hints,
                                     gint                rect_anchor_dx,
                                     gint                rect_anchor_dy);
+
+  gboolean (* gdk_frame_recorder_is_enabled) (void);
+  void     (* gdk_frame_recorder_add)        (const char *category,
+                                              const char *name,
+                                              gint64      start_time,
+                                              gint64      end_time);
+
+  void (* gdk_window_set_invalidate_notify) (GdkWindowInvalidateHandlerFunc notify);
 } GdkPrivateVTable;
 
 GDK_AVAILABLE_IN_ALL
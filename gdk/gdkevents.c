@@ -27,6 +27,7 @@
 #include "gdkinternals.h"
 #include "gdkdisplayprivate.h"
 #include "gdkdndprivate.h"
+#include "gdkdeviceprivate.h"
 
 #include <string.h>
 #include <math.h>
@@ -251,6 +252,32 @@ _gdk_event_unqueue (GdkDisplay *display)
   return event;
 }
 
+static void
+gdk_event_push_history (GdkEvent *event,
+                        GdkEvent *history_event)
+{
+  GdkEventPrivate *private = (GdkEventPrivate *) event;
+  GdkEventPrivate *history_private = (GdkEventPrivate *) history_event;
+  guint i;
+
+  if (private->history == NULL)
+    private->history = g_ptr_array_new_with_free_func ((GDestroyNotify) gdk_event_free);
+
+  /* Anything that was compressed into @history_event happened before it */
+  if (history_private->history)
+    {
+      for (i = 0; i < history_private->history->len; i++)
+        g_ptr_array_add (private->history,
+                         g_ptr_array_index (history_private->history, i));
+
+      g_ptr_array_set_free_func (history_private->history, NULL);
+      g_ptr_array_free (history_private->history, TRUE);
+      history_private->history = NULL;
+    }
+
+  g_ptr_array_add (private->history, history_event);
+}
+
 void
 _gdk_event_queue_handle_motion_compression (GdkDisplay *display)
 {
@@ -258,9 +285,13 @@ _gdk_event_queue_handle_motion_compression (GdkDisplay *display)
   GList *pending_motions = NULL;
   GdkWindow *pending_motion_window = NULL;
   GdkDevice *pending_motion_device = NULL;
+  GdkDevice *pending_motion_source_device = NULL;
+  GdkDeviceTool *pending_motion_tool = NULL;
 
   /* If the last N events in the event queue are motion notify
-   * events for the same window, drop all but the last */
+   * events for the same window and device, drop all but the last.
+   * The dropped events are kept as the history of the last one.
+   */
 
   tmp_list = display->queued_tail;
 
@@ -282,11 +313,21 @@ _gdk_event_queue_handle_motion_compression (GdkDisplay *display)
           pending_motion_device != event->event.motion.device)
         break;
 
+      /* Don't merge different physical devices or tools behind the
+       * same master pointer, their axes don't line up.
+       */
+      if (pending_motions != NULL &&
+          (pending_motion_source_device != event->source_device ||
+           pending_motion_tool != event->tool))
+        break;
+
       if (!event->event.motion.window->event_compression)
         break;
 
       pending_motion_window = event->event.motion.window;
       pending_motion_device = event->event.motion.device;
+      pending_motion_source_device = event->source_device;
+      pending_motion_tool = event->tool;
       pending_motions = tmp_list;
 
       tmp_list = tmp_list->prev;
@@ -295,7 +336,7 @@ _gdk_event_queue_handle_motion_compression (GdkDisplay *display)
   while (pending_motions && pending_motions->next != NULL)
     {
       GList *next = pending_motions->next;
-      gdk_event_free (pending_motions->data);
+      gdk_event_push_history (display->queued_tail->data, pending_motions->data);
       display->queued_events = g_list_delete_link (display->queued_events,
                                                    pending_motions);
       pending_motions = next;
@@ -663,6 +704,18 @@ gdk_event_copy (const GdkEvent *event)
       new_private->source_device = private->source_device ? g_object_ref (private->source_device) : NULL;
       new_private->seat = private->seat;
       new_private->tool = private->tool;
+
+      if (private->history)
+        {
+          guint i;
+
+          new_private->history =
+            g_ptr_array_new_full (private->history->len,
+                                  (GDestroyNotify) gdk_event_free);
+          for (i = 0; i < private->history->len; i++)
+            g_ptr_array_add (new_private->history,
+                             gdk_event_copy (g_ptr_array_index (private->history, i)));
+        }
     }
 
   switch (event->any.type)
@@ -767,6 +820,7 @@ gdk_event_free (GdkEvent *event)
       private = (GdkEventPrivate *) event;
       g_clear_object (&private->device);
       g_clear_object (&private->source_device);
+      g_clear_pointer (&private->history, g_ptr_array_unref);
     }
 
   switch (event->any.type)
@@ -2499,6 +2553,103 @@ gdk_event_set_scancode (GdkEvent *event,
   private->key_scancode = scancode;
 }
 
+/**
+ * gdk_event_get_history:
+ * @event: a #GdkEvent of type %GDK_MOTION_NOTIFY
+ * @coords: (out) (optional) (transfer full) (array length=n_coords):
+ *     return location for the intermediate positions, or %NULL
+ * @n_coords: (out) (optional): return location for the number of
+ *     positions in @coords, or %NULL
+ *
+ * Retrieves the pointer positions that were compressed into @event
+ * and thus never delivered as separate motion events, see
+ * gdk_window_set_event_compression(). Applications that need every
+ * position, such as drawing programs, can use this instead of turning
+ * off event compression.
+ *
+ * The positions are ordered oldest first and do not include the
+ * position of @event itself. Like the ones returned by
+ * gdk_device_get_history(), use gdk_device_get_axis() to get the
+ * individual axes, the %GDK_AXIS_X and %GDK_AXIS_Y values are
+ * relative to the window of @event. Free @coords with
+ * gdk_device_free_history().
+ *
+ * Returns: %TRUE if @event has intermediate positions
+ *
+ * Since: 3.22
+ **/
+gboolean
+gdk_event_get_history (const GdkEvent   *event,
+                       GdkTimeCoord   ***coords,
+                       gint             *n_coords)
+{
+  GdkEventPrivate *private;
+  GdkDevice *device;
+  GdkTimeCoord **result;
+  guint i, j, n_axes;
+
+  g_return_val_if_fail (event != NULL, FALSE);
+
+  if (coords)
+    *coords = NULL;
+  if (n_coords)
+    *n_coords = 0;
+
+  if (event->type != GDK_MOTION_NOTIFY ||
+      !gdk_event_is_allocated (event))
+    return FALSE;
+
+  private = (GdkEventPrivate *) event;
+  device = event->motion.device;
+
+  if (private->history == NULL || private->history->len == 0 || device == NULL)
+    return FALSE;
+
+  if (coords)
+    {
+      n_axes = gdk_device_get_n_axes (device);
+      result = _gdk_device_allocate_history (device, private->history->len);
+
+      for (i = 0; i < private->history->len; i++)
+        {
+          const GdkEvent *history_event = g_ptr_array_index (private->history, i);
+
+          result[i]->time = history_event->motion.time;
+
+          if (history_event->motion.axes)
+            memcpy (result[i]->axes, history_event->motion.axes,
+                    sizeof (gdouble) * n_axes);
+
+          /* The axes of the event are relative to the native window,
+           * like in gdk_event_get_axis(), use the translated position.
+           */
+          for (j = 0; j < n_axes; j++)
+            {
+              switch ((guint) gdk_device_get_axis_use (device, j))
+                {
+                case GDK_AXIS_X:
+                  result[i]->axes[j] = history_event->motion.x;
+                  break;
+                case GDK_AXIS_Y:
+                  result[i]->axes[j] = history_event->motion.y;
+                  break;
+                default:
+                  if (history_event->motion.axes == NULL)
+                    result[i]->axes[j] = 0;
+                  break;
+                }
+            }
+        }
+
+      *coords = result;
+    }
+
+  if (n_coords)
+    *n_coords = private->history->len;
+
+  return TRUE;
+}
+
 /**
  * gdk_event_get_scancode:
  * @event: a #GdkEvent
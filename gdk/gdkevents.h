@@ -1580,6 +1580,11 @@ int            gdk_event_get_scancode    (GdkEvent *event);
 GDK_AVAILABLE_IN_3_22
 gboolean       gdk_event_get_pointer_emulated (GdkEvent *event);
 
+GDK_AVAILABLE_IN_3_22
+gboolean       gdk_event_get_history     (const GdkEvent   *event,
+                                          GdkTimeCoord   ***coords,
+                                          gint             *n_coords);
+
 G_END_DECLS
 
 #endif /* __GDK_EVENTS_H__ */
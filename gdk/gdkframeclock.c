@@ -528,6 +528,14 @@ _gdk_frame_clock_debug_print_timings (GdkFrameClock   *clock,
     g_string_append_printf (str, " predicted=%-4.1f", (timings->predicted_presentation_time - timings->frame_time) / 1000.);
   if (timings->refresh_interval != 0)
     g_string_append_printf (str, " refresh_interval=%-4.1f", timings->refresh_interval / 1000.);
+  g_string_append_printf (str, " phases=%.1f/%.1f/%.1f/%.1f/%.1f/%.1f/%.1f",
+                          timings->flush_events_duration / 1000.,
+                          timings->before_paint_duration / 1000.,
+                          timings->update_duration / 1000.,
+                          timings->layout_duration / 1000.,
+                          timings->paint_duration / 1000.,
+                          timings->after_paint_duration / 1000.,
+                          timings->resume_events_duration / 1000.);
 
   g_message ("%s", str->str);
   g_string_free (str, TRUE);
@@ -27,6 +27,7 @@
 #include "gdkinternals.h"
 #include "gdkframeclockprivate.h"
 #include "gdkframeclockidle.h"
+#include "gdkframerecorderprivate.h"
 #include "gdk.h"
 
 #ifdef G_OS_WIN32
@@ -52,6 +53,8 @@ struct _GdkFrameClockIdlePrivate
   GdkFrameClockPhase requested;
   GdkFrameClockPhase phase;
 
+  gint64 flush_events_duration; /* of the last flush, for the next frame's timings */
+
   guint in_paint_idle : 1;
 #ifdef G_OS_WIN32
   guint begin_period : 1;
@@ -293,12 +296,25 @@ compute_min_next_frame_time (GdkFrameClockIdle *clock_idle,
     return presentation_time + refresh_interval / 2;
 }
 
+/* Returns the time since @start_time and records it as @phase */
+static gint64
+end_phase (const char *phase,
+           gint64      start_time)
+{
+  gint64 end_time = g_get_monotonic_time ();
+
+  gdk_frame_recorder_add ("frame", phase, start_time, end_time);
+
+  return end_time - start_time;
+}
+
 static gboolean
 gdk_frame_clock_flush_idle (void *data)
 {
   GdkFrameClock *clock = GDK_FRAME_CLOCK (data);
   GdkFrameClockIdle *clock_idle = GDK_FRAME_CLOCK_IDLE (clock);
   GdkFrameClockIdlePrivate *priv = clock_idle->priv;
+  gint64 start_time;
 
   priv->flush_idle_id = 0;
 
@@ -308,7 +324,9 @@ gdk_frame_clock_flush_idle (void *data)
   priv->phase = GDK_FRAME_CLOCK_PHASE_FLUSH_EVENTS;
   priv->requested &= ~GDK_FRAME_CLOCK_PHASE_FLUSH_EVENTS;
 
+  start_time = g_get_monotonic_time ();
   _gdk_frame_clock_emit_flush_events (clock);
+  priv->flush_events_duration = end_phase ("flush-events", start_time);
 
   if ((priv->requested & ~GDK_FRAME_CLOCK_PHASE_FLUSH_EVENTS) != 0 ||
       priv->updating_count > 0)
@@ -327,6 +345,7 @@ gdk_frame_clock_paint_idle (void *data)
   GdkFrameClockIdlePrivate *priv = clock_idle->priv;
   gboolean skip_to_resume_events;
   GdkFrameTimings *timings = NULL;
+  gint64 start_time;
 
   priv->paint_idle_id = 0;
   priv->in_paint_idle = TRUE;
@@ -386,6 +405,8 @@ gdk_frame_clock_paint_idle (void *data)
 
               timings->frame_time = priv->frame_time;
               timings->slept_before = priv->sleep_serial != get_sleep_serial ();
+              timings->flush_events_duration = priv->flush_events_duration;
+              priv->flush_events_duration = 0;
 
               priv->phase = GDK_FRAME_CLOCK_PHASE_BEFORE_PAINT;
 
@@ -395,7 +416,9 @@ gdk_frame_clock_paint_idle (void *data)
                * in them.
                */
               priv->requested &= ~GDK_FRAME_CLOCK_PHASE_BEFORE_PAINT;
+              start_time = g_get_monotonic_time ();
               _gdk_frame_clock_emit_before_paint (clock);
+              timings->before_paint_duration = end_phase ("before-paint", start_time);
               priv->phase = GDK_FRAME_CLOCK_PHASE_UPDATE;
             }
           /* fallthrough */
@@ -406,7 +429,10 @@ gdk_frame_clock_paint_idle (void *data)
                   priv->updating_count > 0)
                 {
                   priv->requested &= ~GDK_FRAME_CLOCK_PHASE_UPDATE;
+                  start_time = g_get_monotonic_time ();
                   _gdk_frame_clock_emit_update (clock);
+                  if (timings)
+                    timings->update_duration += end_phase ("update", start_time);
                 }
             }
           /* fallthrough */
@@ -434,7 +460,10 @@ gdk_frame_clock_paint_idle (void *data)
 		     priv->freeze_count == 0 && iter++ < 4)
                 {
                   priv->requested &= ~GDK_FRAME_CLOCK_PHASE_LAYOUT;
+                  start_time = g_get_monotonic_time ();
                   _gdk_frame_clock_emit_layout (clock);
+                  if (timings)
+                    timings->layout_duration += end_phase ("layout", start_time);
                 }
 	      if (iter == 5)
 		g_warning ("gdk-frame-clock: layout continuously requested, giving up after 4 tries");
@@ -456,7 +485,10 @@ gdk_frame_clock_paint_idle (void *data)
               if (priv->requested & GDK_FRAME_CLOCK_PHASE_PAINT)
                 {
                   priv->requested &= ~GDK_FRAME_CLOCK_PHASE_PAINT;
+                  start_time = g_get_monotonic_time ();
                   _gdk_frame_clock_emit_paint (clock);
+                  if (timings)
+                    timings->paint_duration += end_phase ("paint", start_time);
                 }
             }
           /* fallthrough */
@@ -464,7 +496,10 @@ gdk_frame_clock_paint_idle (void *data)
           if (priv->freeze_count == 0)
             {
               priv->requested &= ~GDK_FRAME_CLOCK_PHASE_AFTER_PAINT;
+              start_time = g_get_monotonic_time ();
               _gdk_frame_clock_emit_after_paint (clock);
+              if (timings)
+                timings->after_paint_duration = end_phase ("after-paint", start_time);
               /* the ::after-paint phase doesn't get repeated on freeze/thaw,
                */
               priv->phase = GDK_FRAME_CLOCK_PHASE_NONE;
@@ -490,8 +525,14 @@ gdk_frame_clock_paint_idle (void *data)
 
   if (priv->requested & GDK_FRAME_CLOCK_PHASE_RESUME_EVENTS)
     {
+      gint64 duration;
+
       priv->requested &= ~GDK_FRAME_CLOCK_PHASE_RESUME_EVENTS;
+      start_time = g_get_monotonic_time ();
       _gdk_frame_clock_emit_resume_events (clock);
+      duration = end_phase ("resume-events", start_time);
+      if (timings)
+        timings->resume_events_duration = duration;
     }
 
   if (priv->freeze_count == 0)
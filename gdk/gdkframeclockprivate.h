@@ -94,6 +94,15 @@ struct _GdkFrameTimings
   gint64 refresh_interval;
   gint64 predicted_presentation_time;
 
+  /* Time spent in each phase of the frame, in microseconds */
+  gint64 flush_events_duration;
+  gint64 before_paint_duration;
+  gint64 update_duration;
+  gint64 layout_duration;
+  gint64 paint_duration;
+  gint64 after_paint_duration;
+  gint64 resume_events_duration;
+
 #ifdef G_ENABLE_DEBUG
   gint64 layout_start_time;
   gint64 paint_start_time;
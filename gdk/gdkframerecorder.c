@@ -0,0 +1,193 @@
+/* GDK - The GIMP Drawing Kit
+ * Copyright (C) 2017 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gdkframerecorderprivate.h"
+
+#include <stdlib.h>
+
+/* The frame recorder keeps the most recent timing events in a ring
+ * buffer and writes them to the file named by the GDK_FRAME_RECORDER
+ * environment variable when the application exits. The file uses the
+ * JSON trace event format, which can be loaded into the usual trace
+ * viewers, e.g. chrome://tracing.
+ */
+
+#define MAX_EVENTS 65536
+
+typedef struct {
+  const char *category;         /* static or interned strings */
+  const char *name;
+  gint64 start_time;
+  gint64 end_time;
+  gpointer thread;
+} FrameEvent;
+
+static FrameEvent *events = NULL;
+static guint n_events = 0;      /* number of events ever added */
+static gchar *output_filename = NULL;
+static gboolean enabled = FALSE;
+G_LOCK_DEFINE_STATIC (events);
+
+static void
+save_at_exit (void)
+{
+  GError *error = NULL;
+
+  if (!gdk_frame_recorder_save (output_filename, &error))
+    {
+      g_printerr ("Failed to save frame timings to %s: %s\n", output_filename, error->message);
+      g_error_free (error);
+    }
+}
+
+/**
+ * gdk_frame_recorder_is_enabled:
+ *
+ * Returns whether timing events are recorded. This is the case when
+ * the GDK_FRAME_RECORDER environment variable is set to a filename.
+ *
+ * Returns: %TRUE if timing events are recorded
+ */
+gboolean
+gdk_frame_recorder_is_enabled (void)
+{
+  static gsize initialized = 0;
+
+  if (g_once_init_enter (&initialized))
+    {
+      const char *env = g_getenv ("GDK_FRAME_RECORDER");
+
+      if (env != NULL && env[0] != '\0')
+        {
+          output_filename = g_strdup (env);
+          events = g_new0 (FrameEvent, MAX_EVENTS);
+          enabled = TRUE;
+          atexit (save_at_exit);
+        }
+
+      g_once_init_leave (&initialized, 1);
+    }
+
+  return enabled;
+}
+
+/**
+ * gdk_frame_recorder_add:
+ * @category: the category of the event, like "frame" or "draw"
+ * @name: the name of the event
+ * @start_time: the monotonic time the event started at
+ * @end_time: the monotonic time the event ended at
+ *
+ * Records a timing event, overwriting the oldest one if the buffer
+ * is full. @category and @name must stay valid until exit, use
+ * g_intern_string() for strings that aren't static.
+ */
+void
+gdk_frame_recorder_add (const char *category,
+                        const char *name,
+                        gint64      start_time,
+                        gint64      end_time)
+{
+  FrameEvent *event;
+
+  if (!gdk_frame_recorder_is_enabled ())
+    return;
+
+  G_LOCK (events);
+
+  event = &events[n_events % MAX_EVENTS];
+  event->category = category;
+  event->name = name;
+  event->start_time = start_time;
+  event->end_time = end_time;
+  event->thread = g_thread_self ();
+  n_events++;
+
+  G_UNLOCK (events);
+}
+
+static void
+append_json_string (GString    *str,
+                    const char *s)
+{
+  g_string_append_c (str, '"');
+  for (; *s; s++)
+    {
+      if (*s == '"' || *s == '\\')
+        g_string_append_printf (str, "\\%c", *s);
+      else if ((guchar) *s < 0x20)
+        g_string_append_printf (str, "\\u%04x", (guint) *s);
+      else
+        g_string_append_c (str, *s);
+    }
+  g_string_append_c (str, '"');
+}
+
+/**
+ * gdk_frame_recorder_save:
+ * @filename: the file to write to
+ * @error: return location for an error
+ *
+ * Writes the recorded events to @filename.
+ *
+ * Returns: %TRUE on success
+ */
+gboolean
+gdk_frame_recorder_save (const char  *filename,
+                         GError     **error)
+{
+  GString *str;
+  guint i, first, n;
+  gboolean result;
+
+  if (!gdk_frame_recorder_is_enabled ())
+    return TRUE;
+
+  str = g_string_new ("{\"traceEvents\":[\n");
+
+  G_LOCK (events);
+
+  n = MIN (n_events, MAX_EVENTS);
+  first = n_events - n;
+  for (i = 0; i < n; i++)
+    {
+      FrameEvent *event = &events[(first + i) % MAX_EVENTS];
+
+      g_string_append (str, "{\"cat\":");
+      append_json_string (str, event->category);
+      g_string_append (str, ",\"name\":");
+      append_json_string (str, event->name);
+      g_string_append_printf (str,
+                              ",\"ph\":\"X\",\"ts\":%" G_GINT64_FORMAT ",\"dur\":%" G_GINT64_FORMAT ",\"pid\":1,\"tid\":%" G_GUINTPTR_FORMAT "}%s\n",
+                              event->start_time,
+                              event->end_time - event->start_time,
+                              (guintptr) event->thread,
+                              i + 1 < n ? "," : "");
+    }
+
+  G_UNLOCK (events);
+
+  g_string_append (str, "]}\n");
+
+  result = g_file_set_contents (filename, str->str, str->len, error);
+
+  g_string_free (str, TRUE);
+
+  return result;
+}
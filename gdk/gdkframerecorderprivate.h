@@ -0,0 +1,37 @@
+/* GDK - The GIMP Drawing Kit
+ * Copyright (C) 2017 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Uninstalled header, internal to GDK */
+
+#ifndef __GDK_FRAME_RECORDER_PRIVATE_H__
+#define __GDK_FRAME_RECORDER_PRIVATE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+gboolean        gdk_frame_recorder_is_enabled   (void);
+void            gdk_frame_recorder_add          (const char     *category,
+                                                 const char     *name,
+                                                 gint64          start_time,
+                                                 gint64          end_time);
+gboolean        gdk_frame_recorder_save         (const char     *filename,
+                                                 GError        **error);
+
+G_END_DECLS
+
+#endif /* __GDK_FRAME_RECORDER_PRIVATE_H__ */
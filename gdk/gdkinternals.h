@@ -192,6 +192,8 @@ struct _GdkEventPrivate
   GdkSeat   *seat;
   GdkDeviceTool *tool;
   guint16    key_scancode;
+  /* Motion events that were compressed into this one, oldest first */
+  GPtrArray *history;
 };
 
 typedef struct _GdkWindowPaint GdkWindowPaint;
@@ -4225,6 +4225,37 @@ gdk_window_process_updates (GdkWindow *window,
                                         PROCESS_UPDATES_NO_RECURSE);
 }
 
+static GdkWindowInvalidateHandlerFunc invalidate_notify = NULL;
+
+/* Sets a function that is told about every region that is invalidated
+ * through the public invalidation API. Unlike the per-window invalidate
+ * handler, it is not called when GDK invalidates newly exposed areas,
+ * as their contents did not change. GTK+ uses this to drop the retained
+ * drawing of the affected widgets.
+ */
+void
+gdk_window_set_invalidate_notify (GdkWindowInvalidateHandlerFunc notify)
+{
+  invalidate_notify = notify;
+}
+
+static void
+gdk_window_notify_invalidate (GdkWindow            *window,
+                              const cairo_region_t *region)
+{
+  cairo_region_t *copy;
+
+  if (invalidate_notify == NULL ||
+      GDK_WINDOW_DESTROYED (window) ||
+      window->input_only ||
+      !window->viewable)
+    return;
+
+  copy = cairo_region_copy (region);
+  invalidate_notify (window, copy);
+  cairo_region_destroy (copy);
+}
+
 static void
 gdk_window_invalidate_rect_full (GdkWindow          *window,
 				  const GdkRectangle *rect,
@@ -4271,6 +4302,25 @@ gdk_window_invalidate_rect (GdkWindow          *window,
 			    const GdkRectangle *rect,
 			    gboolean            invalidate_children)
 {
+  if (invalidate_notify != NULL && GDK_IS_WINDOW (window))
+    {
+      GdkRectangle window_rect;
+      cairo_region_t *region;
+
+      if (!rect)
+        {
+          window_rect.x = 0;
+          window_rect.y = 0;
+          window_rect.width = window->width;
+          window_rect.height = window->height;
+          rect = &window_rect;
+        }
+
+      region = cairo_region_create_rectangle (rect);
+      gdk_window_notify_invalidate (window, region);
+      cairo_region_destroy (region);
+    }
+
   gdk_window_invalidate_rect_full (window, rect, invalidate_children);
 }
 
@@ -4505,6 +4555,9 @@ gdk_window_invalidate_maybe_recurse (GdkWindow            *window,
                                      GdkWindowChildFunc    child_func,
 				     gpointer              user_data)
 {
+  if (GDK_IS_WINDOW (window))
+    gdk_window_notify_invalidate (window, region);
+
   gdk_window_invalidate_maybe_recurse_full (window, region,
 					    child_func, user_data);
 }
@@ -10645,7 +10698,8 @@ gdk_window_set_focus_on_map (GdkWindow *window,
  * event will be delivered.
  *
  * Some types of applications, e.g. paint programs, need to see all
- * motion events and will benefit from turning off event compression.
+ * motion positions. They can either turn off event compression, or
+ * get the positions of the discarded events with gdk_event_get_history().
  *
  * By default, event compression is enabled.
  *
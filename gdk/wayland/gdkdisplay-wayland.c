@@ -1201,13 +1201,23 @@ gdk_wayland_display_get_wl_compositor (GdkDisplay *display)
 
 static const cairo_user_data_key_t gdk_wayland_shm_surface_cairo_key;
 
-typedef struct _GdkWaylandCairoSurfaceData {
+/* A shared memory file holding one or more equally sized buffers */
+struct _GdkWaylandShmPool {
+  int ref_count;
   gpointer buf;
   size_t buf_length;
   struct wl_shm_pool *pool;
-  struct wl_buffer *buffer;
   GdkWaylandDisplay *display;
+  int width;
+  int height;
+  int stride;
   uint32_t scale;
+  guint n_buffers;
+};
+
+typedef struct _GdkWaylandCairoSurfaceData {
+  GdkWaylandShmPool *pool;
+  struct wl_buffer *buffer;
 } GdkWaylandCairoSurfaceData;
 
 static int
@@ -1299,6 +1309,55 @@ create_shm_pool (struct wl_shm  *shm,
   return pool;
 }
 
+GdkWaylandShmPool *
+_gdk_wayland_shm_pool_new (GdkWaylandDisplay *display,
+                           int                width,
+                           int                height,
+                           guint              scale,
+                           guint              n_buffers)
+{
+  GdkWaylandShmPool *pool;
+
+  pool = g_new0 (GdkWaylandShmPool, 1);
+  pool->ref_count = 1;
+  pool->display = display;
+  pool->width = width * scale;
+  pool->height = height * scale;
+  pool->scale = scale;
+  pool->n_buffers = n_buffers;
+  pool->stride = cairo_format_stride_for_width (CAIRO_FORMAT_ARGB32, pool->width);
+
+  pool->pool = create_shm_pool (display->shm,
+                                pool->height * pool->stride * n_buffers,
+                                &pool->buf_length,
+                                &pool->buf);
+
+  return pool;
+}
+
+GdkWaylandShmPool *
+_gdk_wayland_shm_pool_ref (GdkWaylandShmPool *pool)
+{
+  pool->ref_count++;
+
+  return pool;
+}
+
+void
+_gdk_wayland_shm_pool_unref (GdkWaylandShmPool *pool)
+{
+  if (--pool->ref_count > 0)
+    return;
+
+  if (pool->pool)
+    {
+      wl_shm_pool_destroy (pool->pool);
+      munmap (pool->buf, pool->buf_length);
+    }
+
+  g_free (pool);
+}
+
 static void
 gdk_wayland_cairo_surface_destroy (void *p)
 {
@@ -1307,50 +1366,44 @@ gdk_wayland_cairo_surface_destroy (void *p)
   if (data->buffer)
     wl_buffer_destroy (data->buffer);
 
-  if (data->pool)
-    wl_shm_pool_destroy (data->pool);
-
-  munmap (data->buf, data->buf_length);
+  _gdk_wayland_shm_pool_unref (data->pool);
   g_free (data);
 }
 
+/* Returns a surface for the index'th buffer of the pool. The surfaces
+ * keep the pool alive. */
 cairo_surface_t *
-_gdk_wayland_display_create_shm_surface (GdkWaylandDisplay *display,
-                                         int                width,
-                                         int                height,
-                                         guint              scale)
+_gdk_wayland_shm_pool_create_surface (GdkWaylandShmPool *pool,
+                                      guint              index)
 {
   GdkWaylandCairoSurfaceData *data;
   cairo_surface_t *surface = NULL;
   cairo_status_t status;
-  int stride;
+  gsize offset;
+
+  g_assert (index < pool->n_buffers);
 
   data = g_new (GdkWaylandCairoSurfaceData, 1);
-  data->display = display;
+  data->pool = _gdk_wayland_shm_pool_ref (pool);
   data->buffer = NULL;
-  data->scale = scale;
-
-  stride = cairo_format_stride_for_width (CAIRO_FORMAT_ARGB32, width*scale);
 
-  data->pool = create_shm_pool (display->shm,
-                                height*scale*stride,
-                                &data->buf_length,
-                                &data->buf);
+  offset = (gsize) pool->height * pool->stride * index;
 
-  surface = cairo_image_surface_create_for_data (data->buf,
+  surface = cairo_image_surface_create_for_data ((guchar *) pool->buf + offset,
                                                  CAIRO_FORMAT_ARGB32,
-                                                 width*scale,
-                                                 height*scale,
-                                                 stride);
+                                                 pool->width,
+                                                 pool->height,
+                                                 pool->stride);
 
-  data->buffer = wl_shm_pool_create_buffer (data->pool, 0,
-                                            width*scale, height*scale,
-                                            stride, WL_SHM_FORMAT_ARGB8888);
+  if (pool->pool)
+    data->buffer = wl_shm_pool_create_buffer (pool->pool, offset,
+                                              pool->width, pool->height,
+                                              pool->stride, WL_SHM_FORMAT_ARGB8888);
 
   cairo_surface_set_user_data (surface, &gdk_wayland_shm_surface_cairo_key,
                                data, gdk_wayland_cairo_surface_destroy);
 
-  cairo_surface_set_device_scale (surface, scale, scale);
+  cairo_surface_set_device_scale (surface, pool->scale, pool->scale);
 
   status = cairo_surface_status (surface);
   if (status != CAIRO_STATUS_SUCCESS)
@@ -1362,6 +1415,22 @@ _gdk_wayland_display_create_shm_surface (GdkWaylandDisplay *display,
   return surface;
 }
 
+cairo_surface_t *
+_gdk_wayland_display_create_shm_surface (GdkWaylandDisplay *display,
+                                         int                width,
+                                         int                height,
+                                         guint              scale)
+{
+  GdkWaylandShmPool *pool;
+  cairo_surface_t *surface;
+
+  pool = _gdk_wayland_shm_pool_new (display, width, height, scale, 1);
+  surface = _gdk_wayland_shm_pool_create_surface (pool, 0);
+  _gdk_wayland_shm_pool_unref (pool);
+
+  return surface;
+}
+
 struct wl_buffer *
 _gdk_wayland_shm_surface_get_wl_buffer (cairo_surface_t *surface)
 {
@@ -238,6 +238,18 @@ cairo_surface_t * _gdk_wayland_display_create_shm_surface (GdkWaylandDisplay *di
                                                            int                width,
                                                            int                height,
                                                            guint              scale);
+
+typedef struct _GdkWaylandShmPool GdkWaylandShmPool;
+
+GdkWaylandShmPool *_gdk_wayland_shm_pool_new            (GdkWaylandDisplay *display,
+                                                         int                width,
+                                                         int                height,
+                                                         guint              scale,
+                                                         guint              n_buffers);
+GdkWaylandShmPool *_gdk_wayland_shm_pool_ref            (GdkWaylandShmPool *pool);
+void               _gdk_wayland_shm_pool_unref          (GdkWaylandShmPool *pool);
+cairo_surface_t   *_gdk_wayland_shm_pool_create_surface (GdkWaylandShmPool *pool,
+                                                         guint              index);
 struct wl_buffer *_gdk_wayland_shm_surface_get_wl_buffer (cairo_surface_t *surface);
 gboolean _gdk_wayland_is_shm_surface (cairo_surface_t *surface);
 
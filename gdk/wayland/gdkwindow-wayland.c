@@ -107,6 +107,19 @@ typedef struct _ExportedClosure
   GDestroyNotify destroy_func;
 } ExportedClosure;
 
+/* Number of shm buffers a window takes turns drawing into */
+#define N_WINDOW_BUFFERS 3
+
+typedef struct _GdkWaylandWindowBuffer
+{
+  cairo_surface_t *surface;
+  /* Committed and not released by the compositor yet */
+  gboolean busy;
+  /* Where the contents differ from the last committed frame,
+   * or NULL if the contents are undefined */
+  cairo_region_t *stale;
+} GdkWaylandWindowBuffer;
+
 struct _GdkWindowImplWayland
 {
   GdkWindowImpl parent_instance;
@@ -147,6 +160,10 @@ struct _GdkWindowImplWayland
   cairo_surface_t *committed_cairo_surface;
   cairo_surface_t *backfill_cairo_surface;
 
+  GdkWaylandShmPool *shm_pool;
+  GdkWaylandWindowBuffer buffers[N_WINDOW_BUFFERS];
+  cairo_region_t *frame_damage; /* Painted since the last commit */
+
   int pending_buffer_offset_x;
   int pending_buffer_offset_y;
 
@@ -280,14 +297,39 @@ static void
 drop_cairo_surfaces (GdkWindow *window)
 {
   GdkWindowImplWayland *impl = GDK_WINDOW_IMPL_WAYLAND (window->impl);
+  int i;
 
   g_clear_pointer (&impl->staging_cairo_surface, cairo_surface_destroy);
   g_clear_pointer (&impl->backfill_cairo_surface, cairo_surface_destroy);
+  g_clear_pointer (&impl->committed_cairo_surface, cairo_surface_destroy);
 
-  /* We nullify this so if a buffer release comes in later, we won't
-   * try to reuse that buffer since it's no longer suitable
+  /* Buffers the compositor still uses are kept alive by the reference
+   * taken when committing them, until they are released
    */
-  impl->committed_cairo_surface = NULL;
+  for (i = 0; i < N_WINDOW_BUFFERS; i++)
+    {
+      g_clear_pointer (&impl->buffers[i].surface, cairo_surface_destroy);
+      g_clear_pointer (&impl->buffers[i].stale, cairo_region_destroy);
+      impl->buffers[i].busy = FALSE;
+    }
+
+  g_clear_pointer (&impl->shm_pool, _gdk_wayland_shm_pool_unref);
+  g_clear_pointer (&impl->frame_damage, cairo_region_destroy);
+}
+
+static GdkWaylandWindowBuffer *
+find_window_buffer (GdkWindowImplWayland *impl,
+                    cairo_surface_t      *surface)
+{
+  int i;
+
+  for (i = 0; i < N_WINDOW_BUFFERS; i++)
+    {
+      if (surface != NULL && impl->buffers[i].surface == surface)
+        return &impl->buffers[i];
+    }
+
+  return NULL;
 }
 
 static void
@@ -467,13 +509,20 @@ static void
 read_back_cairo_surface (GdkWindow *window)
 {
   GdkWindowImplWayland *impl = GDK_WINDOW_IMPL_WAYLAND (window->impl);
+  GdkWaylandWindowBuffer *buffer;
   cairo_t *cr;
   cairo_region_t *paint_region = NULL;
 
   if (!impl->backfill_cairo_surface)
     goto out;
 
+  /* Only the parts that changed since the staging buffer was last
+   * used need to be copied over
+   */
   paint_region = cairo_region_copy (window->clip_region);
+  buffer = find_window_buffer (impl, impl->staging_cairo_surface);
+  if (buffer != NULL && buffer->stale != NULL)
+    cairo_region_intersect (paint_region, buffer->stale);
   cairo_region_subtract (paint_region, impl->staged_updates_region);
 
   if (cairo_region_is_empty (paint_region))
@@ -585,6 +634,40 @@ on_frame_clock_before_paint (GdkFrameClock *clock,
     }
 }
 
+/* The buffer is now the latest frame, and all other buffers fall
+ * behind by the damage of this frame
+ */
+static void
+buffer_committed (GdkWindow       *window,
+                  cairo_surface_t *surface)
+{
+  GdkWindowImplWayland *impl = GDK_WINDOW_IMPL_WAYLAND (window->impl);
+  GdkWaylandWindowBuffer *buffer;
+  int i;
+
+  for (i = 0; i < N_WINDOW_BUFFERS; i++)
+    {
+      buffer = &impl->buffers[i];
+
+      if (buffer->surface == NULL)
+        continue;
+
+      if (buffer->surface == surface)
+        {
+          buffer->busy = TRUE;
+          g_clear_pointer (&buffer->stale, cairo_region_destroy);
+          buffer->stale = cairo_region_create ();
+        }
+      else if (buffer->stale != NULL && impl->frame_damage != NULL)
+        cairo_region_union (buffer->stale, impl->frame_damage);
+    }
+
+  g_clear_pointer (&impl->frame_damage, cairo_region_destroy);
+
+  /* Dropped again when the compositor releases the buffer */
+  cairo_surface_reference (surface);
+}
+
 static void
 on_frame_clock_after_paint (GdkFrameClock *clock,
                             GdkWindow     *window)
@@ -619,7 +702,11 @@ on_frame_clock_after_paint (GdkFrameClock *clock,
   wl_surface_commit (impl->display_server.wl_surface);
 
   if (impl->pending_buffer_attached)
-    impl->committed_cairo_surface = g_steal_pointer (&impl->staging_cairo_surface);
+    {
+      buffer_committed (window, impl->staging_cairo_surface);
+      g_clear_pointer (&impl->committed_cairo_surface, cairo_surface_destroy);
+      impl->committed_cairo_surface = g_steal_pointer (&impl->staging_cairo_surface);
+    }
 
   impl->pending_buffer_attached = FALSE;
   impl->pending_commit = FALSE;
@@ -776,60 +863,101 @@ buffer_release_callback (void             *_data,
 {
   cairo_surface_t *cairo_surface = _data;
   GdkWindowImplWayland *impl = cairo_surface_get_user_data (cairo_surface, &gdk_wayland_window_cairo_key);
+  GdkWaylandWindowBuffer *buffer;
 
   g_return_if_fail (GDK_IS_WINDOW_IMPL_WAYLAND (impl));
 
-  /* The released buffer isn't the latest committed one, we have no further
-   * use for it, so clean it up.
+  /* The buffer can be drawn into again. It may also have been dropped
+   * (e.g. on resize) in the meantime, then this frees it.
    */
-  if (impl->committed_cairo_surface != cairo_surface)
-    {
-      /* If this fails, then the surface buffer got reused before it was
-       * released from the compositor
-       */
-      g_warn_if_fail (impl->staging_cairo_surface != cairo_surface);
+  buffer = find_window_buffer (impl, cairo_surface);
+  if (buffer != NULL)
+    buffer->busy = FALSE;
 
-      cairo_surface_destroy (cairo_surface);
-      return;
-    }
+  cairo_surface_destroy (cairo_surface);
+}
+
+static const struct wl_buffer_listener buffer_listener = {
+  buffer_release_callback
+};
+
+static void
+track_buffer_release (GdkWindowImplWayland *impl,
+                      cairo_surface_t      *surface)
+{
+  struct wl_buffer *buffer;
 
-  if (impl->staged_updates_region != NULL)
+  cairo_surface_set_user_data (surface,
+                               &gdk_wayland_window_cairo_key,
+                               g_object_ref (impl),
+                               (cairo_destroy_func_t)
+                               g_object_unref);
+  buffer = _gdk_wayland_shm_surface_get_wl_buffer (surface);
+  wl_buffer_add_listener (buffer, &buffer_listener, surface);
+}
+
+/* Picks the buffer that needs the least copying from the last
+ * frame, which is the last committed one if the compositor is done
+ * with it already. Buffers are only allocated when all others are
+ * busy.
+ */
+static cairo_surface_t *
+get_free_buffer (GdkWindow *window)
+{
+  GdkWindowImplWayland *impl = GDK_WINDOW_IMPL_WAYLAND (window->impl);
+  GdkWaylandDisplay *display_wayland;
+  GdkWaylandWindowBuffer *buffer, *best;
+  cairo_rectangle_int_t extents;
+  gint64 cost, best_cost;
+  int i;
+
+  best = NULL;
+  best_cost = G_MAXINT64;
+  for (i = 0; i < N_WINDOW_BUFFERS; i++)
     {
-      /* If this fails, then we're tracking staged updates on a staging surface
-       * that doesn't exist.
-       */
-      g_warn_if_fail (impl->staging_cairo_surface != NULL);
-
-      /* If we've staged updates into a new buffer before the release for this
-       * buffer came in, then we can't reuse this buffer, so unref it. It may still
-       * be alive as a readback buffer though (via impl->backfill_cairo_surface).
-       *
-       * It's possible a staging surface was allocated but no updates were staged.
-       * If that happened, clean up that staging surface now, since the old commit
-       * buffer is available again, and reusing the old commit buffer for future
-       * updates will save having to do a read back later.
-       */
-      if (!cairo_region_is_empty (impl->staged_updates_region))
+      buffer = &impl->buffers[i];
+
+      if (buffer->busy)
+        continue;
+
+      if (buffer->surface == NULL)
+        cost = (gint64) window->width * window->height + 1;
+      else if (buffer->stale == NULL)
+        cost = (gint64) window->width * window->height;
+      else
         {
-          g_clear_pointer (&impl->committed_cairo_surface, cairo_surface_destroy);
-          return;
+          cairo_region_get_extents (buffer->stale, &extents);
+          cost = (gint64) extents.width * extents.height;
         }
-      else
+
+      if (cost < best_cost)
         {
-          g_clear_pointer (&impl->staged_updates_region, cairo_region_destroy);
-          g_clear_pointer (&impl->staging_cairo_surface, cairo_surface_destroy);
+          best = buffer;
+          best_cost = cost;
         }
     }
 
-  /* Release came in, we haven't done any interim updates, so we can just use
-   * the old committed buffer again.
-   */
-  impl->staging_cairo_surface = g_steal_pointer (&impl->committed_cairo_surface);
-}
+  if (best == NULL)
+    return NULL;
 
-static const struct wl_buffer_listener buffer_listener = {
-  buffer_release_callback
-};
+  if (best->surface == NULL)
+    {
+      display_wayland = GDK_WAYLAND_DISPLAY (gdk_window_get_display (window));
+
+      if (impl->shm_pool == NULL)
+        impl->shm_pool = _gdk_wayland_shm_pool_new (display_wayland,
+                                                    window->width,
+                                                    window->height,
+                                                    impl->scale,
+                                                    N_WINDOW_BUFFERS);
+
+      best->surface = _gdk_wayland_shm_pool_create_surface (impl->shm_pool,
+                                                            best - impl->buffers);
+      track_buffer_release (impl, best->surface);
+    }
+
+  return cairo_surface_reference (best->surface);
+}
 
 static void
 gdk_wayland_window_ensure_cairo_surface (GdkWindow *window)
@@ -854,20 +982,21 @@ gdk_wayland_window_ensure_cairo_surface (GdkWindow *window)
     }
   else if (!impl->staging_cairo_surface)
     {
-      GdkWaylandDisplay *display_wayland = GDK_WAYLAND_DISPLAY (gdk_window_get_display (impl->wrapper));
-      struct wl_buffer *buffer;
-
-      impl->staging_cairo_surface = _gdk_wayland_display_create_shm_surface (display_wayland,
-                                                                             impl->wrapper->width,
-                                                                             impl->wrapper->height,
-                                                                             impl->scale);
-      cairo_surface_set_user_data (impl->staging_cairo_surface,
-                                   &gdk_wayland_window_cairo_key,
-                                   g_object_ref (impl),
-                                   (cairo_destroy_func_t)
-                                   g_object_unref);
-      buffer = _gdk_wayland_shm_surface_get_wl_buffer (impl->staging_cairo_surface);
-      wl_buffer_add_listener (buffer, &buffer_listener, impl->staging_cairo_surface);
+      impl->staging_cairo_surface = get_free_buffer (impl->wrapper);
+
+      /* All buffers are still in use by the compositor, use a
+       * temporary one that goes away once it is released
+       */
+      if (!impl->staging_cairo_surface)
+        {
+          GdkWaylandDisplay *display_wayland = GDK_WAYLAND_DISPLAY (gdk_window_get_display (impl->wrapper));
+
+          impl->staging_cairo_surface = _gdk_wayland_display_create_shm_surface (display_wayland,
+                                                                                 impl->wrapper->width,
+                                                                                 impl->wrapper->height,
+                                                                                 impl->scale);
+          track_buffer_release (impl, impl->staging_cairo_surface);
+        }
     }
 }
 
@@ -924,6 +1053,11 @@ gdk_window_impl_wayland_end_paint (GdkWindow *window)
     {
       gdk_wayland_window_attach_image (window);
 
+      if (impl->frame_damage == NULL)
+        impl->frame_damage = cairo_region_copy (window->current_paint.region);
+      else
+        cairo_region_union (impl->frame_damage, window->current_paint.region);
+
       /* If there's a committed buffer pending, then track which
        * updates are staged until the next frame, so we can back
        * fill the unstaged parts of the staging buffer with the
@@ -991,6 +1125,7 @@ gdk_window_impl_wayland_finalize (GObject *object)
   g_clear_pointer (&impl->opaque_region, cairo_region_destroy);
   g_clear_pointer (&impl->input_region, cairo_region_destroy);
   g_clear_pointer (&impl->staged_updates_region, cairo_region_destroy);
+  g_clear_pointer (&impl->frame_damage, cairo_region_destroy);
 
   g_hash_table_destroy (impl->shortcuts_inhibitors);
 
@@ -59,6 +59,7 @@ typedef struct _ListChildrenState ListChildrenState;
 typedef struct _SendEventState SendEventState;
 typedef struct _SetInputFocusState SetInputFocusState;
 typedef struct _RoundtripState RoundtripState;
+typedef struct _BatchRequest BatchRequest;
 
 typedef enum {
   CHILD_INFO_GET_PROPERTY,
@@ -124,6 +125,66 @@ struct _RoundtripState
   gpointer data;
 };
 
+typedef enum {
+  BATCH_GET_PROPERTY,
+  BATCH_GET_GEOMETRY,
+  BATCH_TRANSLATE_COORDINATES,
+  BATCH_QUERY_TREE
+} BatchRequestType;
+
+struct _BatchRequest
+{
+  BatchRequestType type;
+  Window window;
+  gulong seq;
+  guint replied : 1;
+  guint have_error : 1;
+  guint data_claimed : 1;
+
+  union {
+    struct {
+      Atom property;
+      Atom req_type;
+      glong length;
+      Atom type;
+      gint format;
+      gulong nitems;
+      gulong bytes_after;
+      guchar *data;
+      gsize data_size;
+    } property;
+    struct {
+      Window root;
+      gint x;
+      gint y;
+      guint width;
+      guint height;
+      guint border_width;
+      guint depth;
+    } geometry;
+    struct {
+      Window dest;
+      gint src_x;
+      gint src_y;
+      gint dest_x;
+      gint dest_y;
+      Window child;
+    } translate;
+    struct {
+      Window root;
+      Window parent;
+    } tree;
+  } u;
+};
+
+struct _GdkX11RequestBatch
+{
+  GdkDisplay *display;
+  GArray *requests;
+  guint current_request;
+  gboolean flushed;
+};
+
 static gboolean
 callback_idle (gpointer data)
 {
@@ -756,3 +817,555 @@ _gdk_x11_roundtrip_async (GdkDisplay           *display,
   UnlockDisplay(dpy);
   SyncHandle();
 }
+
+/* Request batches
+ *
+ * A batch collects GetProperty, GetGeometry, TranslateCoordinates and
+ * QueryTree requests, sends them back to back and waits for all of the
+ * replies with a single round trip, instead of one round trip per
+ * XGetWindowProperty(), XGetGeometry(), XTranslateCoordinates() or
+ * XQueryTree() call. Identical requests queued on the same batch are only
+ * sent once.
+ *
+ * BadWindow and BadDrawable errors for batched requests are swallowed and
+ * reported through the return value of the reply accessors; other errors
+ * go through the normal error handling.
+ */
+
+GdkX11RequestBatch *
+_gdk_x11_request_batch_new (GdkDisplay *display)
+{
+  GdkX11RequestBatch *batch;
+
+  batch = g_new0 (GdkX11RequestBatch, 1);
+  batch->display = display;
+  batch->requests = g_array_new (FALSE, TRUE, sizeof (BatchRequest));
+
+  return batch;
+}
+
+void
+_gdk_x11_request_batch_free (GdkX11RequestBatch *batch)
+{
+  guint i;
+
+  for (i = 0; i < batch->requests->len; i++)
+    {
+      BatchRequest *request = &g_array_index (batch->requests, BatchRequest, i);
+
+      if (request->type == BATCH_GET_PROPERTY &&
+          request->u.property.data && !request->data_claimed)
+        XFree (request->u.property.data);
+    }
+
+  g_array_free (batch->requests, TRUE);
+  g_free (batch);
+}
+
+static guint
+batch_add_request (GdkX11RequestBatch *batch,
+                   BatchRequest       *request)
+{
+  guint i;
+
+  g_return_val_if_fail (!batch->flushed, G_MAXUINT);
+
+  for (i = 0; i < batch->requests->len; i++)
+    {
+      BatchRequest *other = &g_array_index (batch->requests, BatchRequest, i);
+
+      if (other->type != request->type || other->window != request->window)
+        continue;
+
+      switch (request->type)
+        {
+        case BATCH_GET_PROPERTY:
+          if (other->u.property.property == request->u.property.property &&
+              other->u.property.req_type == request->u.property.req_type &&
+              other->u.property.length == request->u.property.length)
+            return i;
+          break;
+        case BATCH_TRANSLATE_COORDINATES:
+          if (other->u.translate.dest == request->u.translate.dest &&
+              other->u.translate.src_x == request->u.translate.src_x &&
+              other->u.translate.src_y == request->u.translate.src_y)
+            return i;
+          break;
+        case BATCH_GET_GEOMETRY:
+        case BATCH_QUERY_TREE:
+          return i;
+        }
+    }
+
+  g_array_append_vals (batch->requests, request, 1);
+
+  return batch->requests->len - 1;
+}
+
+guint
+_gdk_x11_request_batch_get_property (GdkX11RequestBatch *batch,
+                                     Window              window,
+                                     Atom                property,
+                                     Atom                req_type,
+                                     glong               length)
+{
+  BatchRequest request = { 0, };
+
+  request.type = BATCH_GET_PROPERTY;
+  request.window = window;
+  request.u.property.property = property;
+  request.u.property.req_type = req_type;
+  request.u.property.length = length;
+
+  return batch_add_request (batch, &request);
+}
+
+guint
+_gdk_x11_request_batch_get_geometry (GdkX11RequestBatch *batch,
+                                     Window              window)
+{
+  BatchRequest request = { 0, };
+
+  request.type = BATCH_GET_GEOMETRY;
+  request.window = window;
+
+  return batch_add_request (batch, &request);
+}
+
+guint
+_gdk_x11_request_batch_translate_coordinates (GdkX11RequestBatch *batch,
+                                              Window              src_window,
+                                              Window              dest_window,
+                                              gint                src_x,
+                                              gint                src_y)
+{
+  BatchRequest request = { 0, };
+
+  request.type = BATCH_TRANSLATE_COORDINATES;
+  request.window = src_window;
+  request.u.translate.dest = dest_window;
+  request.u.translate.src_x = src_x;
+  request.u.translate.src_y = src_y;
+
+  return batch_add_request (batch, &request);
+}
+
+/* Only the root and parent are kept from the reply, the list of
+ * children is skipped.
+ */
+guint
+_gdk_x11_request_batch_query_tree (GdkX11RequestBatch *batch,
+                                   Window              window)
+{
+  BatchRequest request = { 0, };
+
+  request.type = BATCH_QUERY_TREE;
+  request.window = window;
+
+  return batch_add_request (batch, &request);
+}
+
+static void
+handle_batch_property_reply (Display      *dpy,
+                             BatchRequest *request,
+                             xReply       *rep,
+                             char         *buf,
+                             int           len)
+{
+  xGetPropertyReply replbuf;
+  xGetPropertyReply *repl;
+  gulong nbytes = 0;
+  gulong wire_bytes = 0;
+
+  repl = (xGetPropertyReply *)
+    _XGetAsyncReply(dpy, (char *)&replbuf, rep, buf, len,
+                    (sizeof(xGetPropertyReply) - sizeof(xReply)) >> 2,
+                    False);
+
+  request->u.property.type = repl->propertyType;
+  request->u.property.format = repl->format;
+  request->u.property.bytes_after = repl->bytesAfter;
+  request->u.property.nitems = repl->nItems;
+
+  if (repl->propertyType != None && repl->nItems > 0)
+    {
+      switch (repl->format)
+        {
+        case 8:
+          wire_bytes = repl->nItems;
+          nbytes = repl->nItems;
+          break;
+        case 16:
+          wire_bytes = repl->nItems << 1;
+          nbytes = repl->nItems * sizeof (short);
+          break;
+        case 32:
+          wire_bytes = repl->nItems << 2;
+          nbytes = repl->nItems * sizeof (long);
+          break;
+        default:
+          /* Bogus format, treat it like a failed request, as Xlib does */
+          request->have_error = TRUE;
+          break;
+        }
+    }
+
+  if (nbytes == 0)
+    {
+      _XGetAsyncData(dpy, NULL, buf, len, sizeof(xGetPropertyReply),
+                     0, repl->length << 2);
+      request->u.property.nitems = 0;
+      return;
+    }
+
+  /* Like XGetWindowProperty(), format 32 data is returned as an array
+   * of longs, and there is always a trailing nul byte.
+   */
+  request->u.property.data = Xmalloc (nbytes + 1);
+  request->u.property.data_size = nbytes;
+
+  if (repl->format == 32)
+    {
+      guint32 *wire = g_new (guint32, repl->nItems);
+      long *longs = (long *) request->u.property.data;
+      gulong i;
+
+      _XGetAsyncData(dpy, (char *)wire, buf, len, sizeof(xGetPropertyReply),
+                     wire_bytes, repl->length << 2);
+      for (i = 0; i < repl->nItems; i++)
+        longs[i] = wire[i];
+      g_free (wire);
+    }
+  else
+    {
+      _XGetAsyncData(dpy, (char *)request->u.property.data, buf, len,
+                     sizeof(xGetPropertyReply), wire_bytes, repl->length << 2);
+    }
+
+  request->u.property.data[nbytes] = '\0';
+}
+
+static Bool
+request_batch_handler (Display *dpy,
+                       xReply  *rep,
+                       char    *buf,
+                       int      len,
+                       XPointer data)
+{
+  GdkX11RequestBatch *batch = (GdkX11RequestBatch *)data;
+  BatchRequest *request;
+
+  if (batch->current_request >= batch->requests->len)
+    return False;
+
+  request = &g_array_index (batch->requests, BatchRequest, batch->current_request);
+  if (dpy->last_request_read != request->seq)
+    return False;
+
+  /* Every batched request gets either a reply or an error, in order */
+  batch->current_request++;
+
+  if (rep->generic.type == X_Error)
+    {
+      request->have_error = TRUE;
+      return rep->error.errorCode == BadWindow ||
+             rep->error.errorCode == BadDrawable;
+    }
+
+  request->replied = TRUE;
+
+  switch (request->type)
+    {
+    case BATCH_GET_PROPERTY:
+      handle_batch_property_reply (dpy, request, rep, buf, len);
+      break;
+    case BATCH_GET_GEOMETRY:
+      {
+        xGetGeometryReply replbuf;
+        xGetGeometryReply *repl;
+
+        repl = (xGetGeometryReply *)
+          _XGetAsyncReply(dpy, (char *)&replbuf, rep, buf, len,
+                          (sizeof(xGetGeometryReply) - sizeof(xReply)) >> 2,
+                          True);
+
+        request->u.geometry.root = repl->root;
+        request->u.geometry.x = cvtINT16toInt (repl->x);
+        request->u.geometry.y = cvtINT16toInt (repl->y);
+        request->u.geometry.width = repl->width;
+        request->u.geometry.height = repl->height;
+        request->u.geometry.border_width = repl->borderWidth;
+        request->u.geometry.depth = repl->depth;
+      }
+      break;
+    case BATCH_TRANSLATE_COORDINATES:
+      {
+        xTranslateCoordsReply replbuf;
+        xTranslateCoordsReply *repl;
+
+        repl = (xTranslateCoordsReply *)
+          _XGetAsyncReply(dpy, (char *)&replbuf, rep, buf, len,
+                          (sizeof(xTranslateCoordsReply) - sizeof(xReply)) >> 2,
+                          True);
+
+        /* Like XTranslateCoordinates(), fail if the windows are on
+         * different screens.
+         */
+        if (!repl->sameScreen)
+          request->have_error = TRUE;
+
+        request->u.translate.child = repl->child;
+        request->u.translate.dest_x = cvtINT16toInt (repl->dstX);
+        request->u.translate.dest_y = cvtINT16toInt (repl->dstY);
+      }
+      break;
+    case BATCH_QUERY_TREE:
+      {
+        xQueryTreeReply replbuf;
+        xQueryTreeReply *repl;
+
+        repl = (xQueryTreeReply *)
+          _XGetAsyncReply(dpy, (char *)&replbuf, rep, buf, len,
+                          (sizeof(xQueryTreeReply) - sizeof(xReply)) >> 2,
+                          False);
+
+        request->u.tree.root = repl->root;
+        request->u.tree.parent = repl->parent;
+
+        _XGetAsyncData(dpy, NULL, buf, len, sizeof(xQueryTreeReply),
+                       0, repl->length << 2);
+      }
+      break;
+    }
+
+  return True;
+}
+
+/* Sends all queued requests and blocks until their replies have arrived.
+ * Returns %FALSE if the final round trip failed, which means that none of
+ * the replies can be trusted.
+ */
+gboolean
+_gdk_x11_request_batch_flush (GdkX11RequestBatch *batch)
+{
+  Display *dpy;
+  _XAsyncHandler async;
+  xGetInputFocusReply rep;
+  Bool result;
+  guint i;
+
+  g_return_val_if_fail (!batch->flushed, FALSE);
+
+  batch->flushed = TRUE;
+
+  if (batch->requests->len == 0)
+    return TRUE;
+
+  dpy = GDK_DISPLAY_XDISPLAY (batch->display);
+
+  LockDisplay(dpy);
+
+  async.next = dpy->async_handlers;
+  async.handler = request_batch_handler;
+  async.data = (XPointer) batch;
+  dpy->async_handlers = &async;
+
+  for (i = 0; i < batch->requests->len; i++)
+    {
+      BatchRequest *request = &g_array_index (batch->requests, BatchRequest, i);
+      xResourceReq *resource_req;
+      xGetPropertyReq *prop_req;
+      xTranslateCoordsReq *translate_req;
+
+      switch (request->type)
+        {
+        case BATCH_GET_PROPERTY:
+          GetReq (GetProperty, prop_req);
+          prop_req->window = request->window;
+          prop_req->property = request->u.property.property;
+          prop_req->type = request->u.property.req_type;
+          prop_req->delete = False;
+          prop_req->longOffset = 0;
+          prop_req->longLength = request->u.property.length;
+          break;
+        case BATCH_GET_GEOMETRY:
+          GetResReq(GetGeometry, request->window, resource_req);
+          break;
+        case BATCH_TRANSLATE_COORDINATES:
+          GetReq (TranslateCoords, translate_req);
+          translate_req->srcWid = request->window;
+          translate_req->dstWid = request->u.translate.dest;
+          translate_req->srcX = request->u.translate.src_x;
+          translate_req->srcY = request->u.translate.src_y;
+          break;
+        case BATCH_QUERY_TREE:
+          GetResReq(QueryTree, request->window, resource_req);
+          break;
+        }
+
+      request->seq = dpy->request;
+    }
+
+  /*
+   * XSync (dpy, 0); the replies to the batched requests are handed to
+   * our async handler while we wait for this one.
+   */
+  {
+    G_GNUC_UNUSED xReq *req;
+
+    GetEmptyReq(GetInputFocus, req);
+  }
+  result = _XReply (dpy, (xReply *)&rep, 0, xTrue);
+
+  DeqAsyncHandler(dpy, &async);
+  UnlockDisplay(dpy);
+  SyncHandle();
+
+  return result;
+}
+
+static BatchRequest *
+batch_get_reply (GdkX11RequestBatch *batch,
+                 guint               id,
+                 BatchRequestType    type)
+{
+  BatchRequest *request;
+
+  g_return_val_if_fail (batch->flushed, NULL);
+  g_return_val_if_fail (id < batch->requests->len, NULL);
+
+  request = &g_array_index (batch->requests, BatchRequest, id);
+  g_return_val_if_fail (request->type == type, NULL);
+
+  if (!request->replied || request->have_error)
+    return NULL;
+
+  return request;
+}
+
+/* Like XGetWindowProperty(), the returned @data must be freed with XFree().
+ * If the same property was requested more than once, each caller gets its
+ * own copy.
+ */
+gboolean
+_gdk_x11_request_batch_get_property_reply (GdkX11RequestBatch *batch,
+                                           guint               id,
+                                           Atom               *actual_type,
+                                           gint               *actual_format,
+                                           gulong             *nitems,
+                                           gulong             *bytes_after,
+                                           guchar            **data)
+{
+  BatchRequest *request;
+
+  request = batch_get_reply (batch, id, BATCH_GET_PROPERTY);
+
+  if (actual_type)
+    *actual_type = request ? request->u.property.type : None;
+  if (actual_format)
+    *actual_format = request ? request->u.property.format : 0;
+  if (nitems)
+    *nitems = request ? request->u.property.nitems : 0;
+  if (bytes_after)
+    *bytes_after = request ? request->u.property.bytes_after : 0;
+
+  if (data)
+    {
+      *data = NULL;
+
+      if (request && request->u.property.data)
+        {
+          if (!request->data_claimed)
+            {
+              *data = request->u.property.data;
+              request->data_claimed = TRUE;
+            }
+          else
+            {
+              *data = Xmalloc (request->u.property.data_size + 1);
+              memcpy (*data, request->u.property.data,
+                      request->u.property.data_size + 1);
+            }
+        }
+    }
+
+  return request != NULL;
+}
+
+gboolean
+_gdk_x11_request_batch_get_geometry_reply (GdkX11RequestBatch *batch,
+                                           guint               id,
+                                           Window             *root,
+                                           gint               *x,
+                                           gint               *y,
+                                           guint              *width,
+                                           guint              *height,
+                                           guint              *border_width,
+                                           guint              *depth)
+{
+  BatchRequest *request;
+
+  request = batch_get_reply (batch, id, BATCH_GET_GEOMETRY);
+  if (request == NULL)
+    return FALSE;
+
+  if (root)
+    *root = request->u.geometry.root;
+  if (x)
+    *x = request->u.geometry.x;
+  if (y)
+    *y = request->u.geometry.y;
+  if (width)
+    *width = request->u.geometry.width;
+  if (height)
+    *height = request->u.geometry.height;
+  if (border_width)
+    *border_width = request->u.geometry.border_width;
+  if (depth)
+    *depth = request->u.geometry.depth;
+
+  return TRUE;
+}
+
+gboolean
+_gdk_x11_request_batch_translate_coordinates_reply (GdkX11RequestBatch *batch,
+                                                    guint               id,
+                                                    gint               *dest_x,
+                                                    gint               *dest_y,
+                                                    Window             *child)
+{
+  BatchRequest *request;
+
+  request = batch_get_reply (batch, id, BATCH_TRANSLATE_COORDINATES);
+  if (request == NULL)
+    return FALSE;
+
+  if (dest_x)
+    *dest_x = request->u.translate.dest_x;
+  if (dest_y)
+    *dest_y = request->u.translate.dest_y;
+  if (child)
+    *child = request->u.translate.child;
+
+  return TRUE;
+}
+
+gboolean
+_gdk_x11_request_batch_query_tree_reply (GdkX11RequestBatch *batch,
+                                         guint               id,
+                                         Window             *root,
+                                         Window             *parent)
+{
+  BatchRequest *request;
+
+  request = batch_get_reply (batch, id, BATCH_QUERY_TREE);
+  if (request == NULL)
+    return FALSE;
+
+  if (root)
+    *root = request->u.tree.root;
+  if (parent)
+    *parent = request->u.tree.parent;
+
+  return TRUE;
+}
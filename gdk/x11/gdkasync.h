@@ -25,6 +25,7 @@
 G_BEGIN_DECLS
 
 typedef struct _GdkChildInfoX11 GdkChildInfoX11;
+typedef struct _GdkX11RequestBatch GdkX11RequestBatch;
 
 typedef void (*GdkSendXEventCallback) (Window   window,
 				       gboolean success,
@@ -64,6 +65,50 @@ void _gdk_x11_roundtrip_async           (GdkDisplay           *display,
 					 GdkRoundTripCallback callback,
 					 gpointer              data);
 
+GdkX11RequestBatch *_gdk_x11_request_batch_new   (GdkDisplay         *display);
+void     _gdk_x11_request_batch_free           (GdkX11RequestBatch *batch);
+guint    _gdk_x11_request_batch_get_property   (GdkX11RequestBatch *batch,
+					        Window              window,
+					        Atom                property,
+					        Atom                req_type,
+					        glong               length);
+guint    _gdk_x11_request_batch_get_geometry   (GdkX11RequestBatch *batch,
+					        Window              window);
+guint    _gdk_x11_request_batch_translate_coordinates (GdkX11RequestBatch *batch,
+						       Window              src_window,
+						       Window              dest_window,
+						       gint                src_x,
+						       gint                src_y);
+guint    _gdk_x11_request_batch_query_tree     (GdkX11RequestBatch *batch,
+					        Window              window);
+gboolean _gdk_x11_request_batch_flush          (GdkX11RequestBatch *batch);
+
+gboolean _gdk_x11_request_batch_get_property_reply  (GdkX11RequestBatch *batch,
+						     guint               id,
+						     Atom               *actual_type,
+						     gint               *actual_format,
+						     gulong             *nitems,
+						     gulong             *bytes_after,
+						     guchar            **data);
+gboolean _gdk_x11_request_batch_get_geometry_reply  (GdkX11RequestBatch *batch,
+						     guint               id,
+						     Window             *root,
+						     gint               *x,
+						     gint               *y,
+						     guint              *width,
+						     guint              *height,
+						     guint              *border_width,
+						     guint              *depth);
+gboolean _gdk_x11_request_batch_translate_coordinates_reply (GdkX11RequestBatch *batch,
+							     guint               id,
+							     gint               *dest_x,
+							     gint               *dest_y,
+							     Window             *child);
+gboolean _gdk_x11_request_batch_query_tree_reply    (GdkX11RequestBatch *batch,
+						     guint               id,
+						     Window             *root,
+						     Window             *parent);
+
 G_END_DECLS
 
 #endif /* __GDK_ASYNC_H__ */
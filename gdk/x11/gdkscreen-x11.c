@@ -24,6 +24,7 @@
 #include "gdkscreen-x11.h"
 #include "gdkdisplay-x11.h"
 #include "gdkprivate-x11.h"
+#include "gdkasync.h"
 #include "xsettings-client.h"
 #include "gdkmonitor-x11.h"
 
@@ -197,61 +198,29 @@ gdk_x11_screen_get_monitor_output (GdkScreen *screen,
   return monitor->output;
 }
 
-static int
-get_current_desktop (GdkScreen *screen)
-{
-  Display *display;
-  Window win;
-  Atom current_desktop, type;
-  int format;
-  unsigned long n_items, bytes_after;
-  unsigned char *data_return = NULL;
-  int workspace = 0;
-
-  if (!gdk_x11_screen_supports_net_wm_hint (screen,
-                                            gdk_atom_intern_static_string ("_NET_CURRENT_DESKTOP")))
-    return workspace;
-
-  display = GDK_DISPLAY_XDISPLAY (gdk_screen_get_display (screen));
-  win = XRootWindow (display, GDK_SCREEN_XNUMBER (screen));
-
-  current_desktop = XInternAtom (display, "_NET_CURRENT_DESKTOP", True);
-
-  XGetWindowProperty (display,
-                      win,
-                      current_desktop,
-                      0, G_MAXLONG,
-                      False, XA_CARDINAL,
-                      &type, &format, &n_items, &bytes_after,
-                      &data_return);
-
-  if (type == XA_CARDINAL && format == 32 && n_items > 0)
-    workspace = ((long *) data_return)[0];
-
-  if (data_return)
-    XFree (data_return);
-
-  return workspace;
-}
-
 void
 gdk_x11_screen_get_work_area (GdkScreen    *screen,
                               GdkRectangle *area)
 {
   GdkX11Screen   *x11_screen = GDK_X11_SCREEN (screen);
   Atom            workarea;
+  Atom            current_desktop;
   Atom            type;
   Window          win;
   int             format;
   gulong          num;
+  gulong          n_desktop;
   gulong          leftovers;
   gulong          max_len = 4 * 32;
   guchar         *ret_workarea = NULL;
+  guchar         *ret_desktop = NULL;
   long           *workareas;
-  int             result;
   int             disp_screen;
   int             desktop;
   Display        *display;
+  GdkX11RequestBatch *batch;
+  guint           workarea_req;
+  guint           desktop_req = 0;
 
   display = GDK_DISPLAY_XDISPLAY (gdk_screen_get_display (screen));
   disp_screen = GDK_SCREEN_XNUMBER (screen);
@@ -270,27 +239,38 @@ gdk_x11_screen_get_work_area (GdkScreen    *screen,
   if (workarea == None)
     return;
 
+  current_desktop = None;
+  if (gdk_x11_screen_supports_net_wm_hint (screen,
+                                           gdk_atom_intern_static_string ("_NET_CURRENT_DESKTOP")))
+    current_desktop = XInternAtom (display, "_NET_CURRENT_DESKTOP", True);
+
+  /* Fetch the work areas and the current desktop in one round trip */
   win = XRootWindow (display, disp_screen);
-  result = XGetWindowProperty (display,
-                               win,
-                               workarea,
-                               0,
-                               max_len,
-                               False,
-                               AnyPropertyType,
-                               &type,
-                               &format,
-                               &num,
-                               &leftovers,
-                               &ret_workarea);
-  if (result != Success ||
+  batch = _gdk_x11_request_batch_new (gdk_screen_get_display (screen));
+  workarea_req = _gdk_x11_request_batch_get_property (batch, win, workarea,
+                                                      AnyPropertyType, max_len);
+  if (current_desktop != None)
+    desktop_req = _gdk_x11_request_batch_get_property (batch, win, current_desktop,
+                                                       XA_CARDINAL, G_MAXLONG);
+
+  if (!_gdk_x11_request_batch_flush (batch) ||
+      !_gdk_x11_request_batch_get_property_reply (batch, workarea_req,
+                                                  &type, &format, &num,
+                                                  &leftovers, &ret_workarea) ||
       type == None ||
       format == 0 ||
       leftovers ||
       num % 4 != 0)
     goto out;
 
-  desktop = get_current_desktop (screen);
+  desktop = 0;
+  if (current_desktop != None &&
+      _gdk_x11_request_batch_get_property_reply (batch, desktop_req,
+                                                 &type, &format, &n_desktop,
+                                                 NULL, &ret_desktop) &&
+      type == XA_CARDINAL && format == 32 && n_desktop > 0)
+    desktop = ((long *) ret_desktop)[0];
+
   if (desktop + 1 > num / 4) /* fvwm gets this wrong */
     goto out;
 
@@ -308,6 +288,9 @@ gdk_x11_screen_get_work_area (GdkScreen    *screen,
 out:
   if (ret_workarea)
     XFree (ret_workarea);
+  if (ret_desktop)
+    XFree (ret_desktop);
+  _gdk_x11_request_batch_free (batch);
 }
 
 static GdkVisual *
@@ -1308,6 +1291,21 @@ cleanup_atoms(gpointer data)
   g_free (supported_atoms);
 }
 
+static NetWmSupportedAtoms *
+get_supported_atoms (GdkScreen *screen)
+{
+  NetWmSupportedAtoms *supported_atoms;
+
+  supported_atoms = g_object_get_data (G_OBJECT (screen), "gdk-net-wm-supported-atoms");
+  if (!supported_atoms)
+    {
+      supported_atoms = g_new0 (NetWmSupportedAtoms, 1);
+      g_object_set_data_full (G_OBJECT (screen), "gdk-net-wm-supported-atoms", supported_atoms, cleanup_atoms);
+    }
+
+  return supported_atoms;
+}
+
 static Window
 get_net_supporting_wm_check (GdkX11Screen *screen,
                              Window        window)
@@ -1349,6 +1347,10 @@ fetch_net_wm_check_window (GdkScreen *screen)
   Window window;
   GTimeVal tv;
   gint error;
+  GdkX11RequestBatch *batch;
+  guint check_req, supported_req, name_req;
+  Atom type;
+  guchar *data = NULL;
 
   x11_screen = GDK_X11_SCREEN (screen);
   display = x11_screen->display;
@@ -1367,33 +1369,89 @@ fetch_net_wm_check_window (GdkScreen *screen)
   if (window == None)
     return;
 
-  if (window != get_net_supporting_wm_check (x11_screen, window))
-    return;
-
   gdk_x11_display_error_trap_push (display);
 
   /* Find out if this WM goes away, so we can reset everything. */
   XSelectInput (x11_screen->xdisplay, window, StructureNotifyMask);
 
+  /* Only check that the window points at itself after XSelectInput(),
+   * since the window may have been recycled in between. The properties
+   * we need from a new WM are fetched in the same round trip.
+   */
+  batch = _gdk_x11_request_batch_new (display);
+  check_req = _gdk_x11_request_batch_get_property (batch, window,
+                                                   gdk_x11_get_xatom_by_name_for_display (display, "_NET_SUPPORTING_WM_CHECK"),
+                                                   XA_WINDOW, G_MAXLONG);
+  supported_req = _gdk_x11_request_batch_get_property (batch, x11_screen->xroot_window,
+                                                       gdk_x11_get_xatom_by_name_for_display (display, "_NET_SUPPORTED"),
+                                                       XA_ATOM, G_MAXLONG);
+  name_req = _gdk_x11_request_batch_get_property (batch, window,
+                                                  gdk_x11_get_xatom_by_name_for_display (display, "_NET_WM_NAME"),
+                                                  gdk_x11_get_xatom_by_name_for_display (display, "UTF8_STRING"),
+                                                  G_MAXLONG);
+  if (!_gdk_x11_request_batch_flush (batch))
+    {
+      gdk_x11_display_error_trap_pop_ignored (display);
+      _gdk_x11_request_batch_free (batch);
+      return;
+    }
+
+  /* The batch ended with a round trip, so this doesn't sync again */
   error = gdk_x11_display_error_trap_pop (display);
-  if (!error)
+  if (!error &&
+      _gdk_x11_request_batch_get_property_reply (batch, check_req,
+                                                 &type, NULL, NULL, NULL, &data) &&
+      type == XA_WINDOW && data != NULL &&
+      *(Window *)data == window)
     {
-      /* We check the window property again because after XGetWindowProperty()
-       * and before XSelectInput() the window may have been recycled in such a
-       * way that XSelectInput() doesn't fail but the window is no longer what
-       * we want.
-       */
-      if (window != get_net_supporting_wm_check (x11_screen, window))
-        return;
+      NetWmSupportedAtoms *supported_atoms;
+      gchar *name;
+
+      supported_atoms = get_supported_atoms (screen);
+      if (supported_atoms->atoms)
+        XFree (supported_atoms->atoms);
+      supported_atoms->atoms = NULL;
+      supported_atoms->n_atoms = 0;
+
+      _gdk_x11_request_batch_get_property_reply (batch, supported_req,
+                                                 &type, NULL,
+                                                 &supported_atoms->n_atoms, NULL,
+                                                 (guchar **)&supported_atoms->atoms);
+      if (type != XA_ATOM && supported_atoms->atoms)
+        {
+          XFree (supported_atoms->atoms);
+          supported_atoms->atoms = NULL;
+          supported_atoms->n_atoms = 0;
+        }
+
+      name = NULL;
+      _gdk_x11_request_batch_get_property_reply (batch, name_req,
+                                                 NULL, NULL, NULL, NULL,
+                                                 (guchar **)&name);
+      g_free (x11_screen->window_manager_name);
+      x11_screen->window_manager_name = g_strdup (name ? name : "unknown");
+      if (name)
+        XFree (name);
 
       x11_screen->wmspec_check_window = window;
       x11_screen->last_wmspec_check_time = tv.tv_sec;
-      x11_screen->need_refetch_net_supported = TRUE;
-      x11_screen->need_refetch_wm_name = TRUE;
+      x11_screen->need_refetch_net_supported = FALSE;
+      x11_screen->need_refetch_wm_name = FALSE;
 
       /* Careful, reentrancy */
       _gdk_x11_screen_window_manager_changed (screen);
     }
+  else if (!error && !gdk_x11_window_lookup_for_display (display, window))
+    {
+      /* Not a WM check window (anymore), stop listening to it */
+      gdk_x11_display_error_trap_push (display);
+      XSelectInput (x11_screen->xdisplay, window, NoEventMask);
+      gdk_x11_display_error_trap_pop_ignored (display);
+    }
+
+  if (data)
+    XFree (data);
+  _gdk_x11_request_batch_free (batch);
 }
 
 /**
@@ -1436,12 +1494,7 @@ gdk_x11_screen_supports_net_wm_hint (GdkScreen *screen,
   if (!G_LIKELY (GDK_X11_DISPLAY (display)->trusted_client))
     return FALSE;
 
-  supported_atoms = g_object_get_data (G_OBJECT (screen), "gdk-net-wm-supported-atoms");
-  if (!supported_atoms)
-    {
-      supported_atoms = g_new0 (NetWmSupportedAtoms, 1);
-      g_object_set_data_full (G_OBJECT (screen), "gdk-net-wm-supported-atoms", supported_atoms, cleanup_atoms);
-    }
+  supported_atoms = get_supported_atoms (screen);
 
   fetch_net_wm_check_window (screen);
 
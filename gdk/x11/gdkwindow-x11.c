@@ -3141,20 +3141,24 @@ gdk_x11_window_get_frame_extents (GdkWindow    *window,
   Window xwindow;
   Window xparent;
   Window root;
-  Window child;
-  Window *children;
   guchar *data;
   Window *vroots;
   Atom type_return;
-  guint nchildren;
   guint nvroots;
   gulong nitems_return;
-  gulong bytes_after_return;
   gint format_return;
   gint i;
-  guint ww, wh, wb, wd;
+  guint ww, wh;
   gint wx, wy;
   gboolean got_frame_extents = FALSE;
+  GdkX11RequestBatch *batch;
+  gboolean have_frame_extents;
+  gboolean have_vroots;
+  guint frame_extents_req = 0;
+  guint translate_req = 0;
+  guint geometry_req;
+  guint tree_req;
+  guint vroots_req = 0;
 
   g_return_if_fail (rect != NULL);
 
@@ -3185,17 +3189,47 @@ gdk_x11_window_get_frame_extents (GdkWindow    *window,
   gdk_x11_display_error_trap_push (display);
 
   xwindow = GDK_WINDOW_XID (window);
+  root = GDK_WINDOW_XROOTWIN (window);
+
+  /* Ask for everything we might need up front, so that a remote display
+   * only costs us a single round trip here. The window tree is queried
+   * as well, so that the fallback below starts out one level up.
+   */
+  batch = _gdk_x11_request_batch_new (display);
+
+  geometry_req = _gdk_x11_request_batch_get_geometry (batch, xwindow);
+  tree_req = _gdk_x11_request_batch_query_tree (batch, xwindow);
+
+  have_frame_extents = gdk_x11_screen_supports_net_wm_hint (GDK_WINDOW_SCREEN (window),
+                                                            gdk_atom_intern_static_string ("_NET_FRAME_EXTENTS"));
+  if (have_frame_extents)
+    {
+      frame_extents_req =
+        _gdk_x11_request_batch_get_property (batch, xwindow,
+                                             gdk_x11_get_xatom_by_name_for_display (display,
+                                                                                    "_NET_FRAME_EXTENTS"),
+                                             XA_CARDINAL, G_MAXLONG);
+      translate_req =
+        _gdk_x11_request_batch_translate_coordinates (batch, xwindow, root, 0, 0);
+    }
+
+  have_vroots = gdk_x11_screen_supports_net_wm_hint (GDK_WINDOW_SCREEN (window),
+                                                     gdk_atom_intern_static_string ("_NET_VIRTUAL_ROOTS"));
+  if (have_vroots)
+    vroots_req =
+      _gdk_x11_request_batch_get_property (batch, root,
+                                           gdk_x11_get_xatom_by_name_for_display (display,
+                                                                                  "_NET_VIRTUAL_ROOTS"),
+                                           XA_WINDOW, G_MAXLONG);
+
+  if (!_gdk_x11_request_batch_flush (batch))
+    goto out;
 
   /* first try: use _NET_FRAME_EXTENTS */
-  if (gdk_x11_screen_supports_net_wm_hint (GDK_WINDOW_SCREEN (window),
-                                           gdk_atom_intern_static_string ("_NET_FRAME_EXTENTS")) &&
-      XGetWindowProperty (GDK_DISPLAY_XDISPLAY (display), xwindow,
-                          gdk_x11_get_xatom_by_name_for_display (display,
-                                                                  "_NET_FRAME_EXTENTS"),
-                          0, G_MAXLONG, False, XA_CARDINAL, &type_return,
-                          &format_return, &nitems_return, &bytes_after_return,
-                          &data)
-      == Success)
+  if (have_frame_extents &&
+      _gdk_x11_request_batch_get_property_reply (batch, frame_extents_req,
+                                                 &type_return, &format_return,
+                                                 &nitems_return, NULL, &data))
     {
       if ((type_return == XA_CARDINAL) && (format_return == 32) &&
 	  (nitems_return == 4) && (data))
@@ -3204,10 +3238,11 @@ gdk_x11_window_get_frame_extents (GdkWindow    *window,
 	  got_frame_extents = TRUE;
 
 	  /* try to get the real client window geometry */
-	  if (XGetGeometry (GDK_DISPLAY_XDISPLAY (display), xwindow,
-			    &root, &wx, &wy, &ww, &wh, &wb, &wd) &&
-              XTranslateCoordinates (GDK_DISPLAY_XDISPLAY (display),
-	  			     xwindow, root, 0, 0, &wx, &wy, &child))
+	  if (_gdk_x11_request_batch_get_geometry_reply (batch, geometry_req,
+                                                         NULL, NULL, NULL,
+                                                         &ww, &wh, NULL, NULL) &&
+              _gdk_x11_request_batch_translate_coordinates_reply (batch, translate_req,
+                                                                  &wx, &wy, NULL))
             {
 	      rect->x = wx;
 	      rect->y = wy;
@@ -3236,36 +3271,28 @@ gdk_x11_window_get_frame_extents (GdkWindow    *window,
   /* use NETWM_VIRTUAL_ROOTS if available */
   root = GDK_WINDOW_XROOTWIN (window);
 
-  if (gdk_x11_screen_supports_net_wm_hint (GDK_WINDOW_SCREEN (window),
-                                           gdk_atom_intern_static_string ("_NET_VIRTUAL_ROOTS")) &&
-      XGetWindowProperty (GDK_DISPLAY_XDISPLAY (display), root,
-			  gdk_x11_get_xatom_by_name_for_display (display, 
-								 "_NET_VIRTUAL_ROOTS"),
-			  0, G_MAXLONG, False, XA_WINDOW, &type_return,
-			  &format_return, &nitems_return, &bytes_after_return,
-			  &data)
-      == Success)
+  if (have_vroots &&
+      _gdk_x11_request_batch_get_property_reply (batch, vroots_req,
+                                                 &type_return, &format_return,
+                                                 &nitems_return, NULL, &data))
     {
       if ((type_return == XA_WINDOW) && (format_return == 32) && (data))
 	{
 	  nvroots = nitems_return;
 	  vroots = (Window *)data;
 	}
+      else if (data)
+        XFree (data);
     }
 
-  xparent = GDK_WINDOW_XID (window);
-
-  do
+  /* Each step up the tree fetches the geometry of the window along with
+   * its parent, so the last step already has the answer.
+   */
+  while (TRUE)
     {
-      xwindow = xparent;
-
-      if (!XQueryTree (GDK_DISPLAY_XDISPLAY (display), xwindow,
-		       &root, &xparent,
-		       &children, &nchildren))
+      if (!_gdk_x11_request_batch_query_tree_reply (batch, tree_req,
+                                                    &root, &xparent))
 	goto out;
-      
-      if (children)
-	XFree (children);
 
       /* check virtual roots */
       for (i = 0; i < nvroots; i++)
@@ -3276,11 +3303,24 @@ gdk_x11_window_get_frame_extents (GdkWindow    *window,
 	      break;
            }
 	}
+
+      if (xparent == root)
+        break;
+
+      xwindow = xparent;
+
+      _gdk_x11_request_batch_free (batch);
+      batch = _gdk_x11_request_batch_new (display);
+      geometry_req = _gdk_x11_request_batch_get_geometry (batch, xwindow);
+      tree_req = _gdk_x11_request_batch_query_tree (batch, xwindow);
+
+      if (!_gdk_x11_request_batch_flush (batch))
+        goto out;
     }
-  while (xparent != root);
 
-  if (XGetGeometry (GDK_DISPLAY_XDISPLAY (display), xwindow,
-		    &root, &wx, &wy, &ww, &wh, &wb, &wd))
+  if (_gdk_x11_request_batch_get_geometry_reply (batch, geometry_req,
+                                                 NULL, &wx, &wy, &ww, &wh,
+                                                 NULL, NULL))
     {
       rect->x = wx;
       rect->y = wy;
@@ -3291,6 +3331,7 @@ gdk_x11_window_get_frame_extents (GdkWindow    *window,
  out:
   if (vroots)
     XFree (vroots);
+  _gdk_x11_request_batch_free (batch);
 
   /* Here we extend the size to include the extra pixels if we round x/y down
      as well as round the size up when we divide by scale so that the returned
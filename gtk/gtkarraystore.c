@@ -0,0 +1,1341 @@
+/* gtkarraystore.c
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+#include <string.h>
+#include <gobject/gvaluecollector.h>
+#include "gtktreemodel.h"
+#include "gtkarraystore.h"
+#include "gtkintl.h"
+
+
+/**
+ * SECTION:gtkarraystore
+ * @Short_description: A compact list model for large amounts of plain data
+ * @Title: GtkArrayStore
+ * @See_also: #GtkTreeModel, #GtkListStore
+ *
+ * The #GtkArrayStore object is a list model for use with a #GtkTreeView
+ * widget, like #GtkListStore. Instead of keeping a list of cells for
+ * each row, it keeps every column in one contiguous array. Rows have no
+ * per-row allocations, and converting between a #GtkTreePath and a
+ * #GtkTreeIter is a constant time operation.
+ *
+ * In exchange it only accepts a limited set of column types: integers,
+ * booleans, enums and flags, floating point numbers, strings, pointers
+ * and #GObjects. Strings are copied into storage that is shared by all
+ * rows of the store, so repeated strings are only kept once. That
+ * storage is only released when the store is finalized, which makes
+ * #GtkArrayStore a bad fit for string columns that change all the time.
+ *
+ * The iters of a #GtkArrayStore do not persist: they become invalid
+ * when rows are inserted or removed. Changing values does not
+ * invalidate them.
+ *
+ * gtk_array_store_append_rows_with_data() adds many rows at once, with
+ * the values of each column passed as a C array:
+ * |[<!-- language="C" -->
+ * enum {
+ *   COLUMN_NAME,
+ *   COLUMN_SIZE,
+ *   N_COLUMNS
+ * };
+ *
+ * {
+ *   GtkArrayStore *store;
+ *   const gchar **names;
+ *   gint64 *sizes;
+ *   gconstpointer columns[N_COLUMNS];
+ *   gint first, n;
+ *
+ *   store = gtk_array_store_new (N_COLUMNS, G_TYPE_STRING, G_TYPE_INT64);
+ *
+ *   n = get_some_data (&names, &sizes);
+ *
+ *   columns[COLUMN_NAME] = names;
+ *   columns[COLUMN_SIZE] = sizes;
+ *   first = gtk_array_store_append_rows_with_data (store, n, columns);
+ * }
+ * ]|
+ *
+ * The rows are announced once all their values are in place, so the
+ * store does not emit #GtkTreeModel::row-changed for them.
+ * gtk_array_store_set_rows_data() replaces the values of existing rows
+ * in the same way.
+ *
+ * The store does not implement #GtkTreeSortable, wrap it in a
+ * #GtkTreeModelSort to sort it.
+ */
+
+
+typedef enum
+{
+  STORAGE_INT,
+  STORAGE_LONG,
+  STORAGE_INT64,
+  STORAGE_FLOAT,
+  STORAGE_DOUBLE,
+  STORAGE_STRING,
+  STORAGE_POINTER,
+  STORAGE_OBJECT
+} GtkArrayStoreStorage;
+
+typedef struct
+{
+  GType type;
+  GtkArrayStoreStorage storage;
+  GArray *values;
+} GtkArrayStoreColumn;
+
+struct _GtkArrayStorePrivate
+{
+  gint stamp;
+  gint n_columns;
+  gint n_rows;
+  GtkArrayStoreColumn *columns;
+  GStringChunk *strings;
+};
+
+#define ITER_INDEX(iter) (GPOINTER_TO_INT ((iter)->user_data))
+
+static void         gtk_array_store_tree_model_init (GtkTreeModelIface *iface);
+static void         gtk_array_store_finalize        (GObject           *object);
+static GtkTreeModelFlags gtk_array_store_get_flags  (GtkTreeModel      *tree_model);
+static gint         gtk_array_store_get_n_columns   (GtkTreeModel      *tree_model);
+static GType        gtk_array_store_get_column_type (GtkTreeModel      *tree_model,
+						     gint               index);
+static gboolean     gtk_array_store_get_iter        (GtkTreeModel      *tree_model,
+						     GtkTreeIter       *iter,
+						     GtkTreePath       *path);
+static GtkTreePath *gtk_array_store_get_path        (GtkTreeModel      *tree_model,
+						     GtkTreeIter       *iter);
+static void         gtk_array_store_get_value       (GtkTreeModel      *tree_model,
+						     GtkTreeIter       *iter,
+						     gint               column,
+						     GValue            *value);
+static gboolean     gtk_array_store_iter_next       (GtkTreeModel      *tree_model,
+						     GtkTreeIter       *iter);
+static gboolean     gtk_array_store_iter_previous   (GtkTreeModel      *tree_model,
+						     GtkTreeIter       *iter);
+static gboolean     gtk_array_store_iter_children   (GtkTreeModel      *tree_model,
+						     GtkTreeIter       *iter,
+						     GtkTreeIter       *parent);
+static gboolean     gtk_array_store_iter_has_child  (GtkTreeModel      *tree_model,
+						     GtkTreeIter       *iter);
+static gint         gtk_array_store_iter_n_children (GtkTreeModel      *tree_model,
+						     GtkTreeIter       *iter);
+static gboolean     gtk_array_store_iter_nth_child  (GtkTreeModel      *tree_model,
+						     GtkTreeIter       *iter,
+						     GtkTreeIter       *parent,
+						     gint               n);
+static gboolean     gtk_array_store_iter_parent     (GtkTreeModel      *tree_model,
+						     GtkTreeIter       *iter,
+						     GtkTreeIter       *child);
+
+
+G_DEFINE_TYPE_WITH_CODE (GtkArrayStore, gtk_array_store, G_TYPE_OBJECT,
+                         G_ADD_PRIVATE (GtkArrayStore)
+			 G_IMPLEMENT_INTERFACE (GTK_TYPE_TREE_MODEL,
+						gtk_array_store_tree_model_init))
+
+
+static void
+gtk_array_store_class_init (GtkArrayStoreClass *class)
+{
+  GObjectClass *object_class;
+
+  object_class = (GObjectClass*) class;
+
+  object_class->finalize = gtk_array_store_finalize;
+}
+
+static void
+gtk_array_store_tree_model_init (GtkTreeModelIface *iface)
+{
+  iface->get_flags = gtk_array_store_get_flags;
+  iface->get_n_columns = gtk_array_store_get_n_columns;
+  iface->get_column_type = gtk_array_store_get_column_type;
+  iface->get_iter = gtk_array_store_get_iter;
+  iface->get_path = gtk_array_store_get_path;
+  iface->get_value = gtk_array_store_get_value;
+  iface->iter_next = gtk_array_store_iter_next;
+  iface->iter_previous = gtk_array_store_iter_previous;
+  iface->iter_children = gtk_array_store_iter_children;
+  iface->iter_has_child = gtk_array_store_iter_has_child;
+  iface->iter_n_children = gtk_array_store_iter_n_children;
+  iface->iter_nth_child = gtk_array_store_iter_nth_child;
+  iface->iter_parent = gtk_array_store_iter_parent;
+}
+
+static void
+gtk_array_store_init (GtkArrayStore *array_store)
+{
+  GtkArrayStorePrivate *priv;
+
+  array_store->priv = gtk_array_store_get_instance_private (array_store);
+  priv = array_store->priv;
+
+  priv->stamp = g_random_int ();
+  priv->n_columns = 0;
+  priv->n_rows = 0;
+  priv->columns = NULL;
+  priv->strings = NULL;
+}
+
+static gboolean
+iter_is_valid (GtkTreeIter   *iter,
+               GtkArrayStore *array_store)
+{
+  return iter != NULL &&
+         iter->stamp == array_store->priv->stamp &&
+         ITER_INDEX (iter) >= 0 &&
+         ITER_INDEX (iter) < array_store->priv->n_rows;
+}
+
+static void
+set_iter (GtkArrayStore *array_store,
+          GtkTreeIter   *iter,
+          gint           index)
+{
+  iter->stamp = array_store->priv->stamp;
+  iter->user_data = GINT_TO_POINTER (index);
+  iter->user_data2 = NULL;
+  iter->user_data3 = NULL;
+}
+
+/* Iters don't persist, so any change to the set of rows needs a new stamp */
+static void
+invalidate_iters (GtkArrayStore *array_store)
+{
+  do
+    array_store->priv->stamp++;
+  while (array_store->priv->stamp == 0);
+}
+
+static gboolean
+get_storage_for_type (GType                 type,
+                      GtkArrayStoreStorage *storage,
+                      guint                *element_size)
+{
+  switch (G_TYPE_FUNDAMENTAL (type))
+    {
+    case G_TYPE_BOOLEAN:
+    case G_TYPE_CHAR:
+    case G_TYPE_UCHAR:
+    case G_TYPE_INT:
+    case G_TYPE_UINT:
+    case G_TYPE_ENUM:
+    case G_TYPE_FLAGS:
+      *storage = STORAGE_INT;
+      *element_size = sizeof (gint);
+      return TRUE;
+    case G_TYPE_LONG:
+    case G_TYPE_ULONG:
+      *storage = STORAGE_LONG;
+      *element_size = sizeof (glong);
+      return TRUE;
+    case G_TYPE_INT64:
+    case G_TYPE_UINT64:
+      *storage = STORAGE_INT64;
+      *element_size = sizeof (gint64);
+      return TRUE;
+    case G_TYPE_FLOAT:
+      *storage = STORAGE_FLOAT;
+      *element_size = sizeof (gfloat);
+      return TRUE;
+    case G_TYPE_DOUBLE:
+      *storage = STORAGE_DOUBLE;
+      *element_size = sizeof (gdouble);
+      return TRUE;
+    case G_TYPE_STRING:
+      *storage = STORAGE_STRING;
+      *element_size = sizeof (const gchar *);
+      return TRUE;
+    case G_TYPE_POINTER:
+      *storage = STORAGE_POINTER;
+      *element_size = sizeof (gpointer);
+      return TRUE;
+    case G_TYPE_OBJECT:
+      *storage = STORAGE_OBJECT;
+      *element_size = sizeof (GObject *);
+      return TRUE;
+    default:
+      return FALSE;
+    }
+}
+
+/**
+ * gtk_array_store_new:
+ * @n_columns: number of columns in the array store
+ * @...: all #GType types for the columns, from first to last
+ *
+ * Creates a new array store with @n_columns columns of the given
+ * types. See the #GtkArrayStore documentation for the supported
+ * types.
+ *
+ * Returns: a new #GtkArrayStore
+ *
+ * Since: 3.22
+ **/
+GtkArrayStore *
+gtk_array_store_new (gint n_columns,
+		     ...)
+{
+  GtkArrayStore *retval;
+  GType *types;
+  va_list args;
+  gint i;
+
+  g_return_val_if_fail (n_columns > 0, NULL);
+
+  types = g_new (GType, n_columns);
+
+  va_start (args, n_columns);
+  for (i = 0; i < n_columns; i++)
+    types[i] = va_arg (args, GType);
+  va_end (args);
+
+  retval = gtk_array_store_newv (n_columns, types);
+
+  g_free (types);
+
+  return retval;
+}
+
+/**
+ * gtk_array_store_newv: (rename-to gtk_array_store_new)
+ * @n_columns: number of columns in the array store
+ * @types: (array length=n_columns): an array of #GType types for the columns, from first to last
+ *
+ * Non-vararg creation function. Used primarily by language bindings.
+ *
+ * Returns: (transfer full): a new #GtkArrayStore
+ *
+ * Since: 3.22
+ **/
+GtkArrayStore *
+gtk_array_store_newv (gint   n_columns,
+		      GType *types)
+{
+  GtkArrayStore *retval;
+  GtkArrayStorePrivate *priv;
+  gint i;
+
+  g_return_val_if_fail (n_columns > 0, NULL);
+
+  retval = g_object_new (GTK_TYPE_ARRAY_STORE, NULL);
+  priv = retval->priv;
+
+  priv->columns = g_new0 (GtkArrayStoreColumn, n_columns);
+  priv->n_columns = n_columns;
+
+  for (i = 0; i < n_columns; i++)
+    {
+      GtkArrayStoreColumn *column = &priv->columns[i];
+      guint element_size;
+
+      if (!get_storage_for_type (types[i], &column->storage, &element_size))
+	{
+	  g_warning ("%s: Invalid type %s", G_STRLOC, g_type_name (types[i]));
+	  g_object_unref (retval);
+	  return NULL;
+	}
+
+      column->type = types[i];
+      column->values = g_array_new (FALSE, TRUE, element_size);
+
+      if (column->storage == STORAGE_STRING && priv->strings == NULL)
+        priv->strings = g_string_chunk_new (4096);
+    }
+
+  return retval;
+}
+
+static void
+unref_objects (GtkArrayStoreColumn *column,
+               gint                 first_row,
+               gint                 n_rows)
+{
+  gint i;
+
+  if (column->storage != STORAGE_OBJECT)
+    return;
+
+  for (i = first_row; i < first_row + n_rows; i++)
+    {
+      GObject *object = g_array_index (column->values, GObject *, i);
+
+      if (object)
+        g_object_unref (object);
+    }
+}
+
+static void
+gtk_array_store_finalize (GObject *object)
+{
+  GtkArrayStore *array_store = GTK_ARRAY_STORE (object);
+  GtkArrayStorePrivate *priv = array_store->priv;
+  gint i;
+
+  for (i = 0; i < priv->n_columns; i++)
+    {
+      GtkArrayStoreColumn *column = &priv->columns[i];
+
+      if (column->values == NULL)
+        continue;
+
+      unref_objects (column, 0, priv->n_rows);
+      g_array_free (column->values, TRUE);
+    }
+
+  g_free (priv->columns);
+
+  if (priv->strings)
+    g_string_chunk_free (priv->strings);
+
+  G_OBJECT_CLASS (gtk_array_store_parent_class)->finalize (object);
+}
+
+/* Fulfill the GtkTreeModel requirements */
+static GtkTreeModelFlags
+gtk_array_store_get_flags (GtkTreeModel *tree_model)
+{
+  return GTK_TREE_MODEL_LIST_ONLY;
+}
+
+static gint
+gtk_array_store_get_n_columns (GtkTreeModel *tree_model)
+{
+  return GTK_ARRAY_STORE (tree_model)->priv->n_columns;
+}
+
+static GType
+gtk_array_store_get_column_type (GtkTreeModel *tree_model,
+				 gint          index)
+{
+  GtkArrayStorePrivate *priv = GTK_ARRAY_STORE (tree_model)->priv;
+
+  g_return_val_if_fail (index < priv->n_columns, G_TYPE_INVALID);
+
+  return priv->columns[index].type;
+}
+
+static gboolean
+gtk_array_store_get_iter (GtkTreeModel *tree_model,
+			  GtkTreeIter  *iter,
+			  GtkTreePath  *path)
+{
+  GtkArrayStore *array_store = GTK_ARRAY_STORE (tree_model);
+  gint i;
+
+  if (gtk_tree_path_get_depth (path) != 1)
+    return FALSE;
+
+  i = gtk_tree_path_get_indices (path)[0];
+
+  if (i < 0 || i >= array_store->priv->n_rows)
+    {
+      iter->stamp = 0;
+      return FALSE;
+    }
+
+  set_iter (array_store, iter, i);
+
+  return TRUE;
+}
+
+static GtkTreePath *
+gtk_array_store_get_path (GtkTreeModel *tree_model,
+			  GtkTreeIter  *iter)
+{
+  g_return_val_if_fail (iter_is_valid (iter, GTK_ARRAY_STORE (tree_model)), NULL);
+
+  return gtk_tree_path_new_from_indices (ITER_INDEX (iter), -1);
+}
+
+static void
+gtk_array_store_get_value (GtkTreeModel *tree_model,
+			   GtkTreeIter  *iter,
+			   gint          column,
+			   GValue       *value)
+{
+  GtkArrayStore *array_store = GTK_ARRAY_STORE (tree_model);
+  GtkArrayStorePrivate *priv = array_store->priv;
+  GtkArrayStoreColumn *col;
+  gint i;
+
+  g_return_if_fail (column < priv->n_columns);
+  g_return_if_fail (iter_is_valid (iter, array_store));
+
+  col = &priv->columns[column];
+  i = ITER_INDEX (iter);
+
+  g_value_init (value, col->type);
+
+  switch (col->storage)
+    {
+    case STORAGE_INT:
+      {
+        gint v = g_array_index (col->values, gint, i);
+
+        switch (G_TYPE_FUNDAMENTAL (col->type))
+          {
+          case G_TYPE_BOOLEAN:
+            g_value_set_boolean (value, v);
+            break;
+          case G_TYPE_CHAR:
+            g_value_set_schar (value, v);
+            break;
+          case G_TYPE_UCHAR:
+            g_value_set_uchar (value, v);
+            break;
+          case G_TYPE_INT:
+            g_value_set_int (value, v);
+            break;
+          case G_TYPE_UINT:
+            g_value_set_uint (value, v);
+            break;
+          case G_TYPE_ENUM:
+            g_value_set_enum (value, v);
+            break;
+          case G_TYPE_FLAGS:
+            g_value_set_flags (value, v);
+            break;
+          default:
+            g_assert_not_reached ();
+          }
+      }
+      break;
+    case STORAGE_LONG:
+      if (G_TYPE_FUNDAMENTAL (col->type) == G_TYPE_LONG)
+        g_value_set_long (value, g_array_index (col->values, glong, i));
+      else
+        g_value_set_ulong (value, g_array_index (col->values, glong, i));
+      break;
+    case STORAGE_INT64:
+      if (G_TYPE_FUNDAMENTAL (col->type) == G_TYPE_INT64)
+        g_value_set_int64 (value, g_array_index (col->values, gint64, i));
+      else
+        g_value_set_uint64 (value, g_array_index (col->values, gint64, i));
+      break;
+    case STORAGE_FLOAT:
+      g_value_set_float (value, g_array_index (col->values, gfloat, i));
+      break;
+    case STORAGE_DOUBLE:
+      g_value_set_double (value, g_array_index (col->values, gdouble, i));
+      break;
+    case STORAGE_STRING:
+      /* The string storage lives as long as the store, no need to copy */
+      g_value_set_static_string (value, g_array_index (col->values, const gchar *, i));
+      break;
+    case STORAGE_POINTER:
+      g_value_set_pointer (value, g_array_index (col->values, gpointer, i));
+      break;
+    case STORAGE_OBJECT:
+      g_value_set_object (value, g_array_index (col->values, GObject *, i));
+      break;
+    default:
+      g_assert_not_reached ();
+    }
+}
+
+static gboolean
+gtk_array_store_iter_next (GtkTreeModel *tree_model,
+			   GtkTreeIter  *iter)
+{
+  GtkArrayStore *array_store = GTK_ARRAY_STORE (tree_model);
+
+  g_return_val_if_fail (iter_is_valid (iter, array_store), FALSE);
+
+  if (ITER_INDEX (iter) + 1 >= array_store->priv->n_rows)
+    {
+      iter->stamp = 0;
+      return FALSE;
+    }
+
+  iter->user_data = GINT_TO_POINTER (ITER_INDEX (iter) + 1);
+
+  return TRUE;
+}
+
+static gboolean
+gtk_array_store_iter_previous (GtkTreeModel *tree_model,
+			       GtkTreeIter  *iter)
+{
+  GtkArrayStore *array_store = GTK_ARRAY_STORE (tree_model);
+
+  g_return_val_if_fail (iter_is_valid (iter, array_store), FALSE);
+
+  if (ITER_INDEX (iter) == 0)
+    {
+      iter->stamp = 0;
+      return FALSE;
+    }
+
+  iter->user_data = GINT_TO_POINTER (ITER_INDEX (iter) - 1);
+
+  return TRUE;
+}
+
+static gboolean
+gtk_array_store_iter_children (GtkTreeModel *tree_model,
+			       GtkTreeIter  *iter,
+			       GtkTreeIter  *parent)
+{
+  GtkArrayStore *array_store = GTK_ARRAY_STORE (tree_model);
+
+  /* this is a list, nodes have no children */
+  if (parent || array_store->priv->n_rows == 0)
+    {
+      iter->stamp = 0;
+      return FALSE;
+    }
+
+  set_iter (array_store, iter, 0);
+
+  return TRUE;
+}
+
+static gboolean
+gtk_array_store_iter_has_child (GtkTreeModel *tree_model,
+				GtkTreeIter  *iter)
+{
+  return FALSE;
+}
+
+static gint
+gtk_array_store_iter_n_children (GtkTreeModel *tree_model,
+				 GtkTreeIter  *iter)
+{
+  GtkArrayStore *array_store = GTK_ARRAY_STORE (tree_model);
+
+  if (iter == NULL)
+    return array_store->priv->n_rows;
+
+  g_return_val_if_fail (iter_is_valid (iter, array_store), -1);
+
+  return 0;
+}
+
+static gboolean
+gtk_array_store_iter_nth_child (GtkTreeModel *tree_model,
+				GtkTreeIter  *iter,
+				GtkTreeIter  *parent,
+				gint          n)
+{
+  GtkArrayStore *array_store = GTK_ARRAY_STORE (tree_model);
+
+  if (parent || n < 0 || n >= array_store->priv->n_rows)
+    {
+      iter->stamp = 0;
+      return FALSE;
+    }
+
+  set_iter (array_store, iter, n);
+
+  return TRUE;
+}
+
+static gboolean
+gtk_array_store_iter_parent (GtkTreeModel *tree_model,
+			     GtkTreeIter  *iter,
+			     GtkTreeIter  *child)
+{
+  iter->stamp = 0;
+  return FALSE;
+}
+
+static void
+store_value (GtkArrayStore       *array_store,
+             GtkArrayStoreColumn *column,
+             gint                 row,
+             const GValue        *value)
+{
+  switch (column->storage)
+    {
+    case STORAGE_INT:
+      {
+        gint v;
+
+        switch (G_TYPE_FUNDAMENTAL (column->type))
+          {
+          case G_TYPE_BOOLEAN:
+            v = g_value_get_boolean (value);
+            break;
+          case G_TYPE_CHAR:
+            v = g_value_get_schar (value);
+            break;
+          case G_TYPE_UCHAR:
+            v = g_value_get_uchar (value);
+            break;
+          case G_TYPE_INT:
+            v = g_value_get_int (value);
+            break;
+          case G_TYPE_UINT:
+            v = g_value_get_uint (value);
+            break;
+          case G_TYPE_ENUM:
+            v = g_value_get_enum (value);
+            break;
+          case G_TYPE_FLAGS:
+            v = g_value_get_flags (value);
+            break;
+          default:
+            g_assert_not_reached ();
+            v = 0;
+          }
+
+        g_array_index (column->values, gint, row) = v;
+      }
+      break;
+    case STORAGE_LONG:
+      if (G_TYPE_FUNDAMENTAL (column->type) == G_TYPE_LONG)
+        g_array_index (column->values, glong, row) = g_value_get_long (value);
+      else
+        g_array_index (column->values, glong, row) = g_value_get_ulong (value);
+      break;
+    case STORAGE_INT64:
+      if (G_TYPE_FUNDAMENTAL (column->type) == G_TYPE_INT64)
+        g_array_index (column->values, gint64, row) = g_value_get_int64 (value);
+      else
+        g_array_index (column->values, gint64, row) = g_value_get_uint64 (value);
+      break;
+    case STORAGE_FLOAT:
+      g_array_index (column->values, gfloat, row) = g_value_get_float (value);
+      break;
+    case STORAGE_DOUBLE:
+      g_array_index (column->values, gdouble, row) = g_value_get_double (value);
+      break;
+    case STORAGE_STRING:
+      {
+        const gchar *str = g_value_get_string (value);
+
+        g_array_index (column->values, const gchar *, row) =
+          str ? g_string_chunk_insert_const (array_store->priv->strings, str) : NULL;
+      }
+      break;
+    case STORAGE_POINTER:
+      g_array_index (column->values, gpointer, row) = g_value_get_pointer (value);
+      break;
+    case STORAGE_OBJECT:
+      {
+        GObject *old = g_array_index (column->values, GObject *, row);
+
+        g_array_index (column->values, GObject *, row) = g_value_dup_object (value);
+        if (old)
+          g_object_unref (old);
+      }
+      break;
+    default:
+      g_assert_not_reached ();
+    }
+}
+
+static gboolean
+gtk_array_store_real_set_value (GtkArrayStore *array_store,
+				GtkTreeIter   *iter,
+				gint           column,
+				const GValue  *value)
+{
+  GtkArrayStoreColumn *col = &array_store->priv->columns[column];
+  GValue real_value = G_VALUE_INIT;
+
+  if (! g_type_is_a (G_VALUE_TYPE (value), col->type))
+    {
+      if (! (g_value_type_transformable (G_VALUE_TYPE (value), col->type)))
+	{
+	  g_warning ("%s: Unable to convert from %s to %s",
+		     G_STRLOC,
+		     g_type_name (G_VALUE_TYPE (value)),
+		     g_type_name (col->type));
+	  return FALSE;
+	}
+
+      g_value_init (&real_value, col->type);
+      if (!g_value_transform (value, &real_value))
+	{
+	  g_warning ("%s: Unable to make conversion from %s to %s",
+		     G_STRLOC,
+		     g_type_name (G_VALUE_TYPE (value)),
+		     g_type_name (col->type));
+	  g_value_unset (&real_value);
+	  return FALSE;
+	}
+
+      store_value (array_store, col, ITER_INDEX (iter), &real_value);
+      g_value_unset (&real_value);
+    }
+  else
+    store_value (array_store, col, ITER_INDEX (iter), value);
+
+  return TRUE;
+}
+
+static void
+emit_row_changed (GtkArrayStore *array_store,
+                  GtkTreeIter   *iter)
+{
+  GtkTreePath *path;
+
+  path = gtk_tree_path_new_from_indices (ITER_INDEX (iter), -1);
+  gtk_tree_model_row_changed (GTK_TREE_MODEL (array_store), path, iter);
+  gtk_tree_path_free (path);
+}
+
+/**
+ * gtk_array_store_set_value:
+ * @array_store: A #GtkArrayStore
+ * @iter: A valid #GtkTreeIter for the row being modified
+ * @column: column number to modify
+ * @value: new value for the cell
+ *
+ * Sets the data in the cell specified by @iter and @column.
+ * The type of @value must be convertible to the type of the
+ * column.
+ *
+ * Since: 3.22
+ **/
+void
+gtk_array_store_set_value (GtkArrayStore *array_store,
+			   GtkTreeIter   *iter,
+			   gint           column,
+			   GValue        *value)
+{
+  g_return_if_fail (GTK_IS_ARRAY_STORE (array_store));
+  g_return_if_fail (iter_is_valid (iter, array_store));
+  g_return_if_fail (G_IS_VALUE (value));
+  g_return_if_fail (column >= 0 && column < array_store->priv->n_columns);
+
+  if (gtk_array_store_real_set_value (array_store, iter, column, value))
+    emit_row_changed (array_store, iter);
+}
+
+/**
+ * gtk_array_store_set_valist:
+ * @array_store: A #GtkArrayStore
+ * @iter: A valid #GtkTreeIter for the row being modified
+ * @var_args: va_list of column/value pairs
+ *
+ * See gtk_array_store_set(); this version takes a va_list for use by
+ * language bindings.
+ *
+ * Since: 3.22
+ **/
+void
+gtk_array_store_set_valist (GtkArrayStore *array_store,
+			    GtkTreeIter   *iter,
+			    va_list        var_args)
+{
+  GtkArrayStorePrivate *priv;
+  gboolean emit_signal = FALSE;
+  gint column;
+
+  g_return_if_fail (GTK_IS_ARRAY_STORE (array_store));
+  g_return_if_fail (iter_is_valid (iter, array_store));
+
+  priv = array_store->priv;
+
+  column = va_arg (var_args, gint);
+
+  while (column != -1)
+    {
+      GValue value = G_VALUE_INIT;
+      gchar *error = NULL;
+
+      if (column < 0 || column >= priv->n_columns)
+	{
+	  g_warning ("%s: Invalid column number %d added to iter (remember to end your list of columns with a -1)", G_STRLOC, column);
+	  break;
+	}
+
+      G_VALUE_COLLECT_INIT (&value, priv->columns[column].type,
+                            var_args, 0, &error);
+      if (error)
+	{
+	  g_warning ("%s: %s", G_STRLOC, error);
+	  g_free (error);
+
+ 	  /* we purposely leak the value here, it might not be
+	   * in a sane state if an error condition occoured
+	   */
+	  break;
+	}
+
+      emit_signal = gtk_array_store_real_set_value (array_store,
+                                                    iter,
+                                                    column,
+                                                    &value) || emit_signal;
+
+      g_value_unset (&value);
+
+      column = va_arg (var_args, gint);
+    }
+
+  if (emit_signal)
+    emit_row_changed (array_store, iter);
+}
+
+/**
+ * gtk_array_store_set:
+ * @array_store: a #GtkArrayStore
+ * @iter: row iterator
+ * @...: pairs of column number and value, terminated with -1
+ *
+ * Sets the value of one or more cells in the row referenced by @iter.
+ * The variable argument list should contain integer column numbers,
+ * each column number followed by the value to be set.
+ * The list is terminated by a -1, as for gtk_list_store_set().
+ *
+ * Since: 3.22
+ **/
+void
+gtk_array_store_set (GtkArrayStore *array_store,
+		     GtkTreeIter   *iter,
+		     ...)
+{
+  va_list var_args;
+
+  va_start (var_args, iter);
+  gtk_array_store_set_valist (array_store, iter, var_args);
+  va_end (var_args);
+}
+
+/**
+ * gtk_array_store_remove:
+ * @array_store: A #GtkArrayStore
+ * @iter: A valid #GtkTreeIter
+ *
+ * Removes the given row from the array store. After being removed,
+ * @iter is set to the next valid row, or invalidated if it pointed
+ * to the last row in @array_store.
+ *
+ * Returns: %TRUE if @iter is valid, %FALSE if not.
+ *
+ * Since: 3.22
+ **/
+gboolean
+gtk_array_store_remove (GtkArrayStore *array_store,
+			GtkTreeIter   *iter)
+{
+  GtkArrayStorePrivate *priv;
+  GtkTreePath *path;
+  gint row, i;
+
+  g_return_val_if_fail (GTK_IS_ARRAY_STORE (array_store), FALSE);
+  g_return_val_if_fail (iter_is_valid (iter, array_store), FALSE);
+
+  priv = array_store->priv;
+  row = ITER_INDEX (iter);
+
+  for (i = 0; i < priv->n_columns; i++)
+    {
+      unref_objects (&priv->columns[i], row, 1);
+      g_array_remove_index (priv->columns[i].values, row);
+    }
+
+  priv->n_rows--;
+  invalidate_iters (array_store);
+
+  path = gtk_tree_path_new_from_indices (row, -1);
+  gtk_tree_model_row_deleted (GTK_TREE_MODEL (array_store), path);
+  gtk_tree_path_free (path);
+
+  if (row < priv->n_rows)
+    {
+      set_iter (array_store, iter, row);
+      return TRUE;
+    }
+
+  iter->stamp = 0;
+  return FALSE;
+}
+
+static void
+insert_rows (GtkArrayStore *array_store,
+             gint           position,
+             gint           n_rows)
+{
+  GtkArrayStorePrivate *priv = array_store->priv;
+  gint i;
+
+  for (i = 0; i < priv->n_columns; i++)
+    {
+      GArray *values = priv->columns[i].values;
+      guint element_size = g_array_get_element_size (values);
+
+      /* The array clears new elements, so growing it and moving the
+       * tail out of the way leaves zeroed rows behind.
+       */
+      g_array_set_size (values, priv->n_rows + n_rows);
+      if (position < priv->n_rows)
+        {
+          memmove (values->data + (position + n_rows) * element_size,
+                   values->data + position * element_size,
+                   (priv->n_rows - position) * element_size);
+          memset (values->data + position * element_size, 0,
+                  n_rows * element_size);
+        }
+    }
+
+  priv->n_rows += n_rows;
+  invalidate_iters (array_store);
+}
+
+/**
+ * gtk_array_store_insert:
+ * @array_store: A #GtkArrayStore
+ * @iter: (out): An unset #GtkTreeIter to set to the new row
+ * @position: position to insert the new row, or -1 for last
+ *
+ * Creates a new row at @position. @iter will be changed to point to
+ * this new row. If @position is -1 or is larger than the number of
+ * rows in the list, then the new row will be appended to the list.
+ * The row will be empty after this function is called. To fill in
+ * values, you need to call gtk_array_store_set() or
+ * gtk_array_store_set_value().
+ *
+ * Since: 3.22
+ **/
+void
+gtk_array_store_insert (GtkArrayStore *array_store,
+			GtkTreeIter   *iter,
+			gint           position)
+{
+  GtkTreePath *path;
+
+  g_return_if_fail (GTK_IS_ARRAY_STORE (array_store));
+  g_return_if_fail (iter != NULL);
+
+  if (position < 0 || position > array_store->priv->n_rows)
+    position = array_store->priv->n_rows;
+
+  insert_rows (array_store, position, 1);
+  set_iter (array_store, iter, position);
+
+  path = gtk_tree_path_new_from_indices (position, -1);
+  gtk_tree_model_row_inserted (GTK_TREE_MODEL (array_store), path, iter);
+  gtk_tree_path_free (path);
+}
+
+/**
+ * gtk_array_store_append:
+ * @array_store: A #GtkArrayStore
+ * @iter: (out): An unset #GtkTreeIter to set to the appended row
+ *
+ * Appends a new row to @array_store. @iter will be changed to point
+ * to this new row. The row will be empty after this function is
+ * called. To fill in values, you need to call gtk_array_store_set()
+ * or gtk_array_store_set_value().
+ *
+ * Since: 3.22
+ **/
+void
+gtk_array_store_append (GtkArrayStore *array_store,
+			GtkTreeIter   *iter)
+{
+  gtk_array_store_insert (array_store, iter, -1);
+}
+
+static void
+copy_column_data (GtkArrayStore *array_store,
+                  gint           column,
+                  gint           first_row,
+                  gint           n_rows,
+                  gconstpointer  data)
+{
+  GtkArrayStorePrivate *priv = array_store->priv;
+  GtkArrayStoreColumn *col = &priv->columns[column];
+  gint i;
+
+  switch (col->storage)
+    {
+    case STORAGE_STRING:
+      {
+        const gchar * const *strings = data;
+
+        for (i = 0; i < n_rows; i++)
+          g_array_index (col->values, const gchar *, first_row + i) =
+            strings[i] ? g_string_chunk_insert_const (priv->strings, strings[i]) : NULL;
+      }
+      break;
+    case STORAGE_OBJECT:
+      {
+        GObject * const *objects = data;
+
+        for (i = 0; i < n_rows; i++)
+          {
+            if (objects[i])
+              g_object_ref (objects[i]);
+          }
+        unref_objects (col, first_row, n_rows);
+        memcpy (&g_array_index (col->values, GObject *, first_row),
+                objects, n_rows * sizeof (GObject *));
+      }
+      break;
+    default:
+      memcpy (col->values->data + first_row * g_array_get_element_size (col->values),
+              data, n_rows * g_array_get_element_size (col->values));
+      break;
+    }
+}
+
+static void
+emit_rows_changed (GtkArrayStore *array_store,
+                   gint           first_row,
+                   gint           n_rows)
+{
+  GtkTreePath *path;
+  GtkTreeIter iter;
+  gint i;
+
+  path = gtk_tree_path_new_from_indices (first_row, -1);
+  for (i = first_row; i < first_row + n_rows; i++)
+    {
+      set_iter (array_store, &iter, i);
+      gtk_tree_model_row_changed (GTK_TREE_MODEL (array_store), path, &iter);
+      gtk_tree_path_next (path);
+    }
+  gtk_tree_path_free (path);
+}
+
+/**
+ * gtk_array_store_append_rows:
+ * @array_store: A #GtkArrayStore
+ * @n_rows: the number of rows to append
+ *
+ * Appends @n_rows empty rows to @array_store in one go. Use
+ * gtk_array_store_set_column_data() to fill them in, or use
+ * gtk_array_store_append_rows_with_data() to add rows that already
+ * have their values.
+ *
+ * The rows are announced with a single #GtkTreeModel::rows-inserted
+ * emission, see gtk_tree_model_rows_inserted().
+ *
+ * Returns: the index of the first appended row
+ *
+ * Since: 3.22
+ **/
+gint
+gtk_array_store_append_rows (GtkArrayStore *array_store,
+			     gint           n_rows)
+{
+  return gtk_array_store_append_rows_with_data (array_store, n_rows, NULL);
+}
+
+/**
+ * gtk_array_store_append_rows_with_data:
+ * @array_store: A #GtkArrayStore
+ * @n_rows: the number of rows to append
+ * @data: (nullable) (array): an array with one entry per column of
+ *     @array_store, each a C array of @n_rows values or %NULL
+ *
+ * Appends @n_rows rows to @array_store and fills in their values
+ * before the rows are announced. The entries of @data are laid out
+ * like the @data argument of gtk_array_store_set_column_data(). Columns
+ * whose entry is %NULL are left empty.
+ *
+ * The rows are announced with a single #GtkTreeModel::rows-inserted
+ * emission, see gtk_tree_model_rows_inserted(). Since the values are
+ * already in place, no #GtkTreeModel::row-changed is emitted, which
+ * makes this the cheapest way to populate a store.
+ *
+ * Returns: the index of the first appended row
+ *
+ * Since: 3.22
+ **/
+gint
+gtk_array_store_append_rows_with_data (GtkArrayStore        *array_store,
+				       gint                  n_rows,
+				       const gconstpointer  *data)
+{
+  GtkTreePath *path;
+  GtkTreeIter iter;
+  gint first, i;
+
+  g_return_val_if_fail (GTK_IS_ARRAY_STORE (array_store), -1);
+  g_return_val_if_fail (n_rows >= 0, -1);
+
+  first = array_store->priv->n_rows;
+  if (n_rows == 0)
+    return first;
+
+  insert_rows (array_store, first, n_rows);
+
+  if (data)
+    {
+      for (i = 0; i < array_store->priv->n_columns; i++)
+        {
+          if (data[i])
+            copy_column_data (array_store, i, first, n_rows, data[i]);
+        }
+    }
+
+  path = gtk_tree_path_new_from_indices (first, -1);
+  set_iter (array_store, &iter, first);
+  gtk_tree_model_rows_inserted (GTK_TREE_MODEL (array_store), path, &iter, n_rows);
+  gtk_tree_path_free (path);
+
+  return first;
+}
+
+/**
+ * gtk_array_store_set_column_data:
+ * @array_store: A #GtkArrayStore
+ * @column: the column to set values in
+ * @first_row: the index of the first row to set
+ * @n_rows: the number of rows to set
+ * @data: (not nullable): a C array of @n_rows values
+ *
+ * Replaces the values of @column in @n_rows rows starting at
+ * @first_row with the values in @data, without going through
+ * #GValue for every cell.
+ *
+ * The element type of @data depends on the type of the column:
+ * #gint for boolean, char, integer, enum and flags columns, #glong
+ * for long columns, #gint64 for 64 bit integer columns, #gfloat,
+ * #gdouble, `const gchar *` for string columns (the strings are
+ * copied), #gpointer for pointer columns and #GObject pointers for
+ * object columns (a reference is taken on each object).
+ *
+ * #GtkTreeModel::row-changed is emitted once for each of the rows.
+ * To replace several columns, use gtk_array_store_set_rows_data(),
+ * which does not emit it once per column.
+ *
+ * Since: 3.22
+ **/
+void
+gtk_array_store_set_column_data (GtkArrayStore *array_store,
+				 gint           column,
+				 gint           first_row,
+				 gint           n_rows,
+				 gconstpointer  data)
+{
+  g_return_if_fail (GTK_IS_ARRAY_STORE (array_store));
+  g_return_if_fail (column >= 0 && column < array_store->priv->n_columns);
+  g_return_if_fail (first_row >= 0 && n_rows >= 0);
+  g_return_if_fail (first_row + n_rows <= array_store->priv->n_rows);
+  g_return_if_fail (data != NULL || n_rows == 0);
+
+  if (n_rows == 0)
+    return;
+
+  copy_column_data (array_store, column, first_row, n_rows, data);
+  emit_rows_changed (array_store, first_row, n_rows);
+}
+
+/**
+ * gtk_array_store_set_rows_data:
+ * @array_store: A #GtkArrayStore
+ * @first_row: the index of the first row to set
+ * @n_rows: the number of rows to set
+ * @data: (array): an array with one entry per column of @array_store,
+ *     each a C array of @n_rows values or %NULL
+ *
+ * Replaces the values of @n_rows rows starting at @first_row. The
+ * entries of @data are laid out like the @data argument of
+ * gtk_array_store_set_column_data(). Columns whose entry is %NULL
+ * keep their values.
+ *
+ * #GtkTreeModel::row-changed is emitted once for each of the rows,
+ * however many columns are replaced.
+ *
+ * Since: 3.22
+ **/
+void
+gtk_array_store_set_rows_data (GtkArrayStore        *array_store,
+			       gint                  first_row,
+			       gint                  n_rows,
+			       const gconstpointer  *data)
+{
+  gint i;
+
+  g_return_if_fail (GTK_IS_ARRAY_STORE (array_store));
+  g_return_if_fail (first_row >= 0 && n_rows >= 0);
+  g_return_if_fail (first_row + n_rows <= array_store->priv->n_rows);
+  g_return_if_fail (data != NULL);
+
+  if (n_rows == 0)
+    return;
+
+  for (i = 0; i < array_store->priv->n_columns; i++)
+    {
+      if (data[i])
+        copy_column_data (array_store, i, first_row, n_rows, data[i]);
+    }
+
+  emit_rows_changed (array_store, first_row, n_rows);
+}
+
+/**
+ * gtk_array_store_clear:
+ * @array_store: a #GtkArrayStore.
+ *
+ * Removes all rows from the array store.
+ *
+ * Since: 3.22
+ **/
+void
+gtk_array_store_clear (GtkArrayStore *array_store)
+{
+  GtkArrayStorePrivate *priv;
+  GtkTreePath *path;
+  gint i;
+
+  g_return_if_fail (GTK_IS_ARRAY_STORE (array_store));
+
+  priv = array_store->priv;
+
+  /* Remove from the end, so that the paths of the other rows stay put */
+  path = gtk_tree_path_new_from_indices (priv->n_rows, -1);
+  while (priv->n_rows > 0)
+    {
+      priv->n_rows--;
+
+      for (i = 0; i < priv->n_columns; i++)
+        {
+          unref_objects (&priv->columns[i], priv->n_rows, 1);
+          g_array_set_size (priv->columns[i].values, priv->n_rows);
+        }
+
+      invalidate_iters (array_store);
+
+      gtk_tree_path_prev (path);
+      gtk_tree_model_row_deleted (GTK_TREE_MODEL (array_store), path);
+    }
+  gtk_tree_path_free (path);
+}
+
+/**
+ * gtk_array_store_iter_is_valid:
+ * @array_store: A #GtkArrayStore.
+ * @iter: A #GtkTreeIter.
+ *
+ * Checks if the given iter is a valid iter for this #GtkArrayStore.
+ * Unlike for #GtkListStore this is cheap.
+ *
+ * Returns: %TRUE if the iter is valid, %FALSE if the iter is invalid.
+ *
+ * Since: 3.22
+ **/
+gboolean
+gtk_array_store_iter_is_valid (GtkArrayStore *array_store,
+			       GtkTreeIter   *iter)
+{
+  g_return_val_if_fail (GTK_IS_ARRAY_STORE (array_store), FALSE);
+  g_return_val_if_fail (iter != NULL, FALSE);
+
+  return iter_is_valid (iter, array_store);
+}
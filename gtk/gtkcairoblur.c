@@ -25,6 +25,17 @@
 #include <math.h>
 #include <string.h>
 
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (G_GNUC_CHECK_VERSION(4, 9) || defined(__clang__))
+#define HAVE_BLUR_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define HAVE_BLUR_NEON 1
+#include <arm_neon.h>
+#endif
+
 /*
  * Gets the size for a single box blur.
  *
@@ -185,6 +196,398 @@ flip_buffer (guchar *dst_buffer,
 #undef BLOCK_SIZE
 }
 
+/* The vectorized code paths below do the sliding window vertically,
+ * on a strip of adjacent columns at once: each SIMD lane holds the
+ * running sum for one column. This means the Y pass needs no flipping,
+ * and the X pass is a Y pass on the flipped buffer.
+ *
+ * The sums are kept in 16 bits, which limits these paths to box sizes
+ * of up to 256. The division by d is done in single precision floats;
+ * for n = sum + d / 2 computing (n + 0.5) * (1 / d) and truncating
+ * gives exactly n / d, since the float error (< 256 * 2^-23) is much
+ * smaller than the distance of (n + 0.5) / d to the next integer
+ * (>= 0.5 / 256). The results are thus identical to the scalar code.
+ */
+#define MAX_SIMD_BOX_FILTER_SIZE 256
+
+typedef void (* BlurPassFunc) (guchar       *dst,
+                               const guchar *src,
+                               int           width,
+                               int           height,
+                               int           d,
+                               int           offset);
+
+static void
+blur_cols_pass_scalar (guchar       *dst,
+                       const guchar *src,
+                       int           width,
+                       int           height,
+                       int           d,
+                       int           offset,
+                       int           first_col)
+{
+  int x, i;
+
+  for (x = first_col; x < width; x++)
+    {
+      int sum = 0;
+
+      for (i = -d + offset; i < height + offset; i++)
+        {
+          if (i >= 0 && i < height)
+            sum += src[i * width + x];
+
+          if (i >= offset)
+            {
+              if (i >= d)
+                sum -= src[(i - d) * width + x];
+
+              dst[(i - offset) * width + x] = (sum + d / 2) / d;
+            }
+        }
+    }
+}
+
+#ifdef HAVE_BLUR_X86
+
+__attribute__((target("sse2"))) static inline __m128i
+divide_sse2 (__m128i sum_lo,
+             __m128i sum_hi,
+             __m128  bias,
+             __m128  scale)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+  __m128i q0, q1, q2, q3;
+
+#define DIVIDE_EPI32(v) \
+  _mm_cvttps_epi32 (_mm_mul_ps (_mm_add_ps (_mm_cvtepi32_ps (v), bias), scale))
+
+  q0 = DIVIDE_EPI32 (_mm_unpacklo_epi16 (sum_lo, zero));
+  q1 = DIVIDE_EPI32 (_mm_unpackhi_epi16 (sum_lo, zero));
+  q2 = DIVIDE_EPI32 (_mm_unpacklo_epi16 (sum_hi, zero));
+  q3 = DIVIDE_EPI32 (_mm_unpackhi_epi16 (sum_hi, zero));
+
+#undef DIVIDE_EPI32
+
+  return _mm_packus_epi16 (_mm_packs_epi32 (q0, q1),
+                           _mm_packs_epi32 (q2, q3));
+}
+
+__attribute__((target("sse2"))) static void
+blur_cols_pass_sse2 (guchar       *dst,
+                     const guchar *src,
+                     int           width,
+                     int           height,
+                     int           d,
+                     int           offset)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+  const __m128 bias = _mm_set1_ps (d / 2 + 0.5f);
+  const __m128 scale = _mm_set1_ps (1.0f / d);
+  int x, i;
+
+  for (x = 0; x + 16 <= width; x += 16)
+    {
+      __m128i sum_lo = zero;
+      __m128i sum_hi = zero;
+
+      for (i = -d + offset; i < height + offset; i++)
+        {
+          __m128i v;
+
+          if (i >= 0 && i < height)
+            {
+              v = _mm_loadu_si128 ((const __m128i *) (src + i * width + x));
+              sum_lo = _mm_add_epi16 (sum_lo, _mm_unpacklo_epi8 (v, zero));
+              sum_hi = _mm_add_epi16 (sum_hi, _mm_unpackhi_epi8 (v, zero));
+            }
+
+          if (i >= offset)
+            {
+              if (i >= d)
+                {
+                  v = _mm_loadu_si128 ((const __m128i *) (src + (i - d) * width + x));
+                  sum_lo = _mm_sub_epi16 (sum_lo, _mm_unpacklo_epi8 (v, zero));
+                  sum_hi = _mm_sub_epi16 (sum_hi, _mm_unpackhi_epi8 (v, zero));
+                }
+
+              _mm_storeu_si128 ((__m128i *) (dst + (i - offset) * width + x),
+                                divide_sse2 (sum_lo, sum_hi, bias, scale));
+            }
+        }
+    }
+
+  blur_cols_pass_scalar (dst, src, width, height, d, offset, x);
+}
+
+/* All the 256bit unpack and pack operations work within 128bit lanes;
+ * since we unpack and pack symmetrically, the byte order comes out right.
+ */
+__attribute__((target("avx2"))) static inline __m256i
+divide_avx2 (__m256i sum_lo,
+             __m256i sum_hi,
+             __m256  bias,
+             __m256  scale)
+{
+  const __m256i zero = _mm256_setzero_si256 ();
+  __m256i q0, q1, q2, q3;
+
+#define DIVIDE_EPI32(v) \
+  _mm256_cvttps_epi32 (_mm256_mul_ps (_mm256_add_ps (_mm256_cvtepi32_ps (v), bias), scale))
+
+  q0 = DIVIDE_EPI32 (_mm256_unpacklo_epi16 (sum_lo, zero));
+  q1 = DIVIDE_EPI32 (_mm256_unpackhi_epi16 (sum_lo, zero));
+  q2 = DIVIDE_EPI32 (_mm256_unpacklo_epi16 (sum_hi, zero));
+  q3 = DIVIDE_EPI32 (_mm256_unpackhi_epi16 (sum_hi, zero));
+
+#undef DIVIDE_EPI32
+
+  return _mm256_packus_epi16 (_mm256_packs_epi32 (q0, q1),
+                              _mm256_packs_epi32 (q2, q3));
+}
+
+__attribute__((target("avx2"))) static void
+blur_cols_pass_avx2 (guchar       *dst,
+                     const guchar *src,
+                     int           width,
+                     int           height,
+                     int           d,
+                     int           offset)
+{
+  const __m256i zero = _mm256_setzero_si256 ();
+  const __m256 bias = _mm256_set1_ps (d / 2 + 0.5f);
+  const __m256 scale = _mm256_set1_ps (1.0f / d);
+  int x, i;
+
+  for (x = 0; x + 32 <= width; x += 32)
+    {
+      __m256i sum_lo = zero;
+      __m256i sum_hi = zero;
+
+      for (i = -d + offset; i < height + offset; i++)
+        {
+          __m256i v;
+
+          if (i >= 0 && i < height)
+            {
+              v = _mm256_loadu_si256 ((const __m256i *) (src + i * width + x));
+              sum_lo = _mm256_add_epi16 (sum_lo, _mm256_unpacklo_epi8 (v, zero));
+              sum_hi = _mm256_add_epi16 (sum_hi, _mm256_unpackhi_epi8 (v, zero));
+            }
+
+          if (i >= offset)
+            {
+              if (i >= d)
+                {
+                  v = _mm256_loadu_si256 ((const __m256i *) (src + (i - d) * width + x));
+                  sum_lo = _mm256_sub_epi16 (sum_lo, _mm256_unpacklo_epi8 (v, zero));
+                  sum_hi = _mm256_sub_epi16 (sum_hi, _mm256_unpackhi_epi8 (v, zero));
+                }
+
+              _mm256_storeu_si256 ((__m256i *) (dst + (i - offset) * width + x),
+                                   divide_avx2 (sum_lo, sum_hi, bias, scale));
+            }
+        }
+    }
+
+  blur_cols_pass_scalar (dst, src, width, height, d, offset, x);
+}
+
+#endif /* HAVE_BLUR_X86 */
+
+#ifdef HAVE_BLUR_NEON
+
+static inline uint8x8_t
+divide_neon (uint16x8_t  sum,
+             float32x4_t bias,
+             float32x4_t scale)
+{
+  float32x4_t lo, hi;
+
+  lo = vcvtq_f32_u32 (vmovl_u16 (vget_low_u16 (sum)));
+  hi = vcvtq_f32_u32 (vmovl_u16 (vget_high_u16 (sum)));
+  lo = vmulq_f32 (vaddq_f32 (lo, bias), scale);
+  hi = vmulq_f32 (vaddq_f32 (hi, bias), scale);
+
+  return vmovn_u16 (vcombine_u16 (vmovn_u32 (vcvtq_u32_f32 (lo)),
+                                  vmovn_u32 (vcvtq_u32_f32 (hi))));
+}
+
+static void
+blur_cols_pass_neon (guchar       *dst,
+                     const guchar *src,
+                     int           width,
+                     int           height,
+                     int           d,
+                     int           offset)
+{
+  const float32x4_t bias = vdupq_n_f32 (d / 2 + 0.5f);
+  const float32x4_t scale = vdupq_n_f32 (1.0f / d);
+  int x, i;
+
+  for (x = 0; x + 16 <= width; x += 16)
+    {
+      uint16x8_t sum_lo = vdupq_n_u16 (0);
+      uint16x8_t sum_hi = vdupq_n_u16 (0);
+
+      for (i = -d + offset; i < height + offset; i++)
+        {
+          uint8x16_t v;
+
+          if (i >= 0 && i < height)
+            {
+              v = vld1q_u8 (src + i * width + x);
+              sum_lo = vaddw_u8 (sum_lo, vget_low_u8 (v));
+              sum_hi = vaddw_u8 (sum_hi, vget_high_u8 (v));
+            }
+
+          if (i >= offset)
+            {
+              if (i >= d)
+                {
+                  v = vld1q_u8 (src + (i - d) * width + x);
+                  sum_lo = vsubw_u8 (sum_lo, vget_low_u8 (v));
+                  sum_hi = vsubw_u8 (sum_hi, vget_high_u8 (v));
+                }
+
+              vst1q_u8 (dst + (i - offset) * width + x,
+                        vcombine_u8 (divide_neon (sum_lo, bias, scale),
+                                     divide_neon (sum_hi, bias, scale)));
+            }
+        }
+    }
+
+  blur_cols_pass_scalar (dst, src, width, height, d, offset, x);
+}
+
+#endif /* HAVE_BLUR_NEON */
+
+static GtkBlurImplementation blur_implementation = GTK_BLUR_IMPLEMENTATION_AUTO;
+
+static gboolean
+blur_implementation_supported (GtkBlurImplementation impl)
+{
+  switch (impl)
+    {
+    case GTK_BLUR_IMPLEMENTATION_AUTO:
+    case GTK_BLUR_IMPLEMENTATION_SCALAR:
+      return TRUE;
+#ifdef HAVE_BLUR_X86
+    case GTK_BLUR_IMPLEMENTATION_SSE2:
+      __builtin_cpu_init ();
+      return __builtin_cpu_supports ("sse2");
+    case GTK_BLUR_IMPLEMENTATION_AVX2:
+      __builtin_cpu_init ();
+      return __builtin_cpu_supports ("avx2");
+#endif
+#ifdef HAVE_BLUR_NEON
+    case GTK_BLUR_IMPLEMENTATION_NEON:
+      return TRUE;
+#endif
+    default:
+      return FALSE;
+    }
+}
+
+static BlurPassFunc
+get_blur_pass_func (void)
+{
+  static gsize initialized = 0;
+  static BlurPassFunc auto_func = NULL;
+  GtkBlurImplementation impl = blur_implementation;
+
+  if (impl == GTK_BLUR_IMPLEMENTATION_AUTO)
+    {
+      if (g_once_init_enter (&initialized))
+        {
+#ifdef HAVE_BLUR_X86
+          __builtin_cpu_init ();
+          if (__builtin_cpu_supports ("avx2"))
+            auto_func = blur_cols_pass_avx2;
+          else if (__builtin_cpu_supports ("sse2"))
+            auto_func = blur_cols_pass_sse2;
+#endif
+#ifdef HAVE_BLUR_NEON
+          auto_func = blur_cols_pass_neon;
+#endif
+          g_once_init_leave (&initialized, 1);
+        }
+
+      return auto_func;
+    }
+
+  switch (impl)
+    {
+#ifdef HAVE_BLUR_X86
+    case GTK_BLUR_IMPLEMENTATION_SSE2:
+      return blur_cols_pass_sse2;
+    case GTK_BLUR_IMPLEMENTATION_AVX2:
+      return blur_cols_pass_avx2;
+#endif
+#ifdef HAVE_BLUR_NEON
+    case GTK_BLUR_IMPLEMENTATION_NEON:
+      return blur_cols_pass_neon;
+#endif
+    case GTK_BLUR_IMPLEMENTATION_AUTO:
+    case GTK_BLUR_IMPLEMENTATION_SCALAR:
+    default:
+      return NULL;
+    }
+}
+
+/* Does the three box blur passes on the columns of buffer,
+ * using tmp_buffer (of the same size) as scratch space.
+ */
+static void
+blur_cols (BlurPassFunc  pass,
+           guchar       *buffer,
+           guchar       *tmp_buffer,
+           int           width,
+           int           height,
+           int           d)
+{
+  /* See blur_rows() for how even box sizes are handled */
+  if (d % 2 == 1)
+    {
+      pass (tmp_buffer, buffer, width, height, d, d / 2);
+      pass (buffer, tmp_buffer, width, height, d, d / 2);
+      pass (tmp_buffer, buffer, width, height, d, d / 2);
+    }
+  else
+    {
+      pass (tmp_buffer, buffer, width, height, d, (d - 1) / 2);
+      pass (buffer, tmp_buffer, width, height, d, (d + 1) / 2);
+      pass (tmp_buffer, buffer, width, height, d + 1, (d + 1) / 2);
+    }
+
+  memcpy (buffer, tmp_buffer, width * height);
+}
+
+static void
+_boxblur_simd (BlurPassFunc  pass,
+               guchar       *buffer,
+               int           width,
+               int           height,
+               int           d,
+               GtkBlurFlags  flags)
+{
+  guchar *tmp_buffer;
+
+  tmp_buffer = g_malloc (width * height);
+
+  if (flags & GTK_BLUR_Y)
+    blur_cols (pass, buffer, tmp_buffer, width, height, d);
+
+  if (flags & GTK_BLUR_X)
+    {
+      flip_buffer (tmp_buffer, buffer, width, height);
+      blur_cols (pass, tmp_buffer, buffer, height, width, d);
+      flip_buffer (buffer, tmp_buffer, height, width);
+    }
+
+  g_free (tmp_buffer);
+}
+
 static void
 _boxblur (guchar      *buffer,
           int          width,
@@ -194,6 +597,14 @@ _boxblur (guchar      *buffer,
 {
   guchar *flipped_buffer;
   int d = get_box_filter_size (radius);
+  BlurPassFunc pass;
+
+  pass = get_blur_pass_func ();
+  if (pass != NULL && d < MAX_SIMD_BOX_FILTER_SIZE)
+    {
+      _boxblur_simd (pass, buffer, width, height, d, flags);
+      return;
+    }
 
   flipped_buffer = g_malloc (width * height);
 
@@ -256,6 +667,27 @@ _gtk_cairo_blur_surface (cairo_surface_t* surface,
   cairo_surface_mark_dirty (surface);
 }
 
+/*
+ * _gtk_cairo_blur_set_implementation:
+ * @impl: the implementation to use
+ *
+ * Selects the code path used by _gtk_cairo_blur_surface(). This is
+ * meant for benchmarking and testing; by default the fastest code path
+ * supported by the CPU is picked at runtime.
+ *
+ * Returns: %FALSE if @impl is not supported on this machine
+ */
+gboolean
+_gtk_cairo_blur_set_implementation (GtkBlurImplementation impl)
+{
+  if (!blur_implementation_supported (impl))
+    return FALSE;
+
+  blur_implementation = impl;
+
+  return TRUE;
+}
+
 /*
  * _gtk_cairo_blur_compute_pixels:
  * @radius: the radius to compute the pixels for
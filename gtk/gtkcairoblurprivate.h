@@ -36,10 +36,19 @@ typedef enum {
   GTK_BLUR_REPEAT = 1<<2
 } GtkBlurFlags;
 
+typedef enum {
+  GTK_BLUR_IMPLEMENTATION_AUTO,
+  GTK_BLUR_IMPLEMENTATION_SCALAR,
+  GTK_BLUR_IMPLEMENTATION_SSE2,
+  GTK_BLUR_IMPLEMENTATION_AVX2,
+  GTK_BLUR_IMPLEMENTATION_NEON
+} GtkBlurImplementation;
+
 void            _gtk_cairo_blur_surface         (cairo_surface_t *surface,
                                                  double           radius,
 						 GtkBlurFlags     flags);;
 int             _gtk_cairo_blur_compute_pixels  (double           radius);
+gboolean        _gtk_cairo_blur_set_implementation (GtkBlurImplementation impl);
 
 G_END_DECLS
 
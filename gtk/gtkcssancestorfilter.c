@@ -0,0 +1,252 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 2017 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gtkcssancestorfilterprivate.h"
+
+#include "gtkcssnodeprivate.h"
+
+#include <string.h>
+
+/* A counting Bloom filter of the names, ids and style classes of the
+ * ancestors of the nodes that are currently being validated.
+ *
+ * When matching a descendant combinator, it allows us to find out
+ * that no ancestor can possibly match the selector to the left of
+ * it, without walking up the tree. The filter may report false
+ * positives, but never false negatives.
+ *
+ * The features of each node are remembered when pushing it, so that
+ * popping removes exactly what was added, even if the node changed
+ * in between. gtk_css_ancestor_filter_node_changed() brings them up
+ * to date when a pushed node changes.
+ */
+
+#define FILTER_BITS 12
+#define FILTER_SIZE (1 << FILTER_BITS)
+#define FILTER_MASK (FILTER_SIZE - 1)
+
+#define SALT_NAME  0x9e3779b9u
+#define SALT_CLASS 0x7f4a7c15u
+#define SALT_ID    0x3c6ef372u
+
+typedef struct {
+  GtkCssNode *node;
+  guint       n_hashes;
+} FilterLevel;
+
+struct _GtkCssAncestorFilter {
+  guint8  counters[FILTER_SIZE];
+  GArray *levels;       /* FilterLevel */
+  GArray *hashes;       /* guint */
+};
+
+static inline guint
+filter_hash (guint value,
+             guint salt)
+{
+  guint hash = value ^ salt;
+
+  /* MurmurHash3 finalizer */
+  hash ^= hash >> 16;
+  hash *= 0x85ebca6bu;
+  hash ^= hash >> 13;
+  hash *= 0xc2b2ae35u;
+  hash ^= hash >> 16;
+
+  return hash;
+}
+
+static inline guint
+filter_hash_pointer (gconstpointer pointer,
+                     guint         salt)
+{
+  return filter_hash (GPOINTER_TO_UINT (pointer), salt);
+}
+
+static void
+filter_add (GtkCssAncestorFilter *filter,
+            guint                 hash)
+{
+  guint8 *c1 = &filter->counters[hash & FILTER_MASK];
+  guint8 *c2 = &filter->counters[(hash >> 16) & FILTER_MASK];
+
+  /* Saturated counters stay saturated, so we never get false negatives */
+  if (*c1 < G_MAXUINT8)
+    (*c1)++;
+  if (*c2 < G_MAXUINT8)
+    (*c2)++;
+
+  g_array_append_val (filter->hashes, hash);
+}
+
+static void
+filter_remove (GtkCssAncestorFilter *filter,
+               guint                 hash)
+{
+  guint8 *c1 = &filter->counters[hash & FILTER_MASK];
+  guint8 *c2 = &filter->counters[(hash >> 16) & FILTER_MASK];
+
+  if (*c1 < G_MAXUINT8)
+    (*c1)--;
+  if (*c2 < G_MAXUINT8)
+    (*c2)--;
+}
+
+static inline gboolean
+filter_may_contain (const GtkCssAncestorFilter *filter,
+                    guint                       hash)
+{
+  return filter->counters[hash & FILTER_MASK] != 0 &&
+         filter->counters[(hash >> 16) & FILTER_MASK] != 0;
+}
+
+GtkCssAncestorFilter *
+gtk_css_ancestor_filter_new (void)
+{
+  GtkCssAncestorFilter *filter;
+
+  filter = g_slice_new0 (GtkCssAncestorFilter);
+  filter->levels = g_array_new (FALSE, FALSE, sizeof (FilterLevel));
+  filter->hashes = g_array_new (FALSE, FALSE, sizeof (guint));
+
+  return filter;
+}
+
+void
+gtk_css_ancestor_filter_free (GtkCssAncestorFilter *filter)
+{
+  g_array_free (filter->levels, TRUE);
+  g_array_free (filter->hashes, TRUE);
+  g_slice_free (GtkCssAncestorFilter, filter);
+}
+
+/* Adds the features of @node and returns how many hashes were added */
+static guint
+filter_add_node (GtkCssAncestorFilter *filter,
+                 GtkCssNode           *node)
+{
+  const GQuark *classes;
+  guint i, n_classes, n_hashes;
+  const char *id;
+
+  n_hashes = filter->hashes->len;
+
+  filter_add (filter, filter_hash_pointer (gtk_css_node_get_name (node), SALT_NAME));
+
+  id = gtk_css_node_get_id (node);
+  if (id)
+    filter_add (filter, filter_hash_pointer (id, SALT_ID));
+
+  classes = gtk_css_node_declaration_get_classes (gtk_css_node_get_declaration (node), &n_classes);
+  for (i = 0; i < n_classes; i++)
+    filter_add (filter, filter_hash (classes[i], SALT_CLASS));
+
+  return filter->hashes->len - n_hashes;
+}
+
+void
+gtk_css_ancestor_filter_push (GtkCssAncestorFilter *filter,
+                              GtkCssNode           *node)
+{
+  FilterLevel level;
+
+  level.node = node;
+  level.n_hashes = filter_add_node (filter, node);
+  g_array_append_val (filter->levels, level);
+}
+
+void
+gtk_css_ancestor_filter_pop (GtkCssAncestorFilter *filter)
+{
+  FilterLevel *level;
+  guint i;
+
+  g_return_if_fail (filter->levels->len > 0);
+
+  level = &g_array_index (filter->levels, FilterLevel, filter->levels->len - 1);
+
+  for (i = filter->hashes->len - level->n_hashes; i < filter->hashes->len; i++)
+    filter_remove (filter, g_array_index (filter->hashes, guint, i));
+
+  g_array_set_size (filter->hashes, filter->hashes->len - level->n_hashes);
+  g_array_set_size (filter->levels, filter->levels->len - 1);
+}
+
+/* Must be called when the name, id or style classes of @node change.
+ * If @node has been pushed, the filter is rebuilt from the current
+ * features of all pushed nodes, or it would miss the new ones.
+ */
+void
+gtk_css_ancestor_filter_node_changed (GtkCssAncestorFilter *filter,
+                                      GtkCssNode           *node)
+{
+  guint i;
+
+  for (i = 0; i < filter->levels->len; i++)
+    {
+      if (g_array_index (filter->levels, FilterLevel, i).node == node)
+        break;
+    }
+
+  if (i == filter->levels->len)
+    return;
+
+  memset (filter->counters, 0, sizeof (filter->counters));
+  g_array_set_size (filter->hashes, 0);
+
+  for (i = 0; i < filter->levels->len; i++)
+    {
+      FilterLevel *level = &g_array_index (filter->levels, FilterLevel, i);
+
+      level->n_hashes = filter_add_node (filter, level->node);
+    }
+}
+
+/* Returns the node that was pushed last. The filter describes exactly
+ * the ancestors of the children of this node.
+ */
+GtkCssNode *
+gtk_css_ancestor_filter_get_top (const GtkCssAncestorFilter *filter)
+{
+  if (filter->levels->len == 0)
+    return NULL;
+
+  return g_array_index (filter->levels, FilterLevel, filter->levels->len - 1).node;
+}
+
+gboolean
+gtk_css_ancestor_filter_may_have_name (const GtkCssAncestorFilter *filter,
+                                       /*interned*/ const char     *name)
+{
+  return filter_may_contain (filter, filter_hash_pointer (name, SALT_NAME));
+}
+
+gboolean
+gtk_css_ancestor_filter_may_have_class (const GtkCssAncestorFilter *filter,
+                                        GQuark                      class_name)
+{
+  return filter_may_contain (filter, filter_hash (class_name, SALT_CLASS));
+}
+
+gboolean
+gtk_css_ancestor_filter_may_have_id (const GtkCssAncestorFilter *filter,
+                                     /*interned*/ const char     *id)
+{
+  return filter_may_contain (filter, filter_hash_pointer (id, SALT_ID));
+}
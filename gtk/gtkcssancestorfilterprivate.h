@@ -0,0 +1,48 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 2017 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GTK_CSS_ANCESTOR_FILTER_PRIVATE_H__
+#define __GTK_CSS_ANCESTOR_FILTER_PRIVATE_H__
+
+#include <glib.h>
+
+#include "gtkcsstypesprivate.h"
+
+G_BEGIN_DECLS
+
+typedef struct _GtkCssAncestorFilter GtkCssAncestorFilter;
+
+GtkCssAncestorFilter *  gtk_css_ancestor_filter_new             (void);
+void                    gtk_css_ancestor_filter_free            (GtkCssAncestorFilter   *filter);
+
+void                    gtk_css_ancestor_filter_push            (GtkCssAncestorFilter   *filter,
+                                                                 GtkCssNode             *node);
+void                    gtk_css_ancestor_filter_pop             (GtkCssAncestorFilter   *filter);
+void                    gtk_css_ancestor_filter_node_changed    (GtkCssAncestorFilter   *filter,
+                                                                 GtkCssNode             *node);
+GtkCssNode *            gtk_css_ancestor_filter_get_top         (const GtkCssAncestorFilter *filter);
+
+gboolean                gtk_css_ancestor_filter_may_have_name   (const GtkCssAncestorFilter *filter,
+                                                                 /*interned*/ const char *name);
+gboolean                gtk_css_ancestor_filter_may_have_class  (const GtkCssAncestorFilter *filter,
+                                                                 GQuark                  class_name);
+gboolean                gtk_css_ancestor_filter_may_have_id     (const GtkCssAncestorFilter *filter,
+                                                                 /*interned*/ const char *id);
+
+G_END_DECLS
+
+#endif /* __GTK_CSS_ANCESTOR_FILTER_PRIVATE_H__ */
@@ -198,7 +198,13 @@ gtk_css_matcher_node_get_parent (GtkCssMatcher       *matcher,
   if (node == NULL)
     return FALSE;
 
-  return gtk_css_node_init_matcher (node, matcher);
+  if (!gtk_css_node_init_matcher (node, matcher))
+    return FALSE;
+
+  /* The ancestors of our parent are a subset of our ancestors */
+  _gtk_css_matcher_node_set_ancestor_filter (matcher, child->node.filter);
+
+  return TRUE;
 }
 
 static GtkCssNode *
@@ -231,7 +237,13 @@ gtk_css_matcher_node_get_previous (GtkCssMatcher       *matcher,
   if (node == NULL)
     return FALSE;
 
-  return gtk_css_node_init_matcher (node, matcher);
+  if (!gtk_css_node_init_matcher (node, matcher))
+    return FALSE;
+
+  /* Siblings share their ancestors */
+  _gtk_css_matcher_node_set_ancestor_filter (matcher, next->node.filter);
+
+  return TRUE;
 }
 
 static GtkStateFlags
@@ -302,10 +314,21 @@ gtk_css_matcher_node_has_position (const GtkCssMatcher *matcher,
                                    int                  a,
                                    int                  b)
 {
-  return gtk_css_matcher_node_nth_child (matcher->node.node,
-                                         forward ? get_previous_visible_sibling 
-                                                 : get_next_visible_sibling,
-                                         a, b);
+  gboolean result;
+
+  result = gtk_css_matcher_node_nth_child (matcher->node.node,
+                                           forward ? get_previous_visible_sibling 
+                                                   : get_next_visible_sibling,
+                                           a, b);
+
+  if (matcher->node.positions)
+    {
+      GtkCssPositionQuery query = { forward, result, a, b };
+
+      g_array_append_val (matcher->node.positions, query);
+    }
+
+  return result;
 }
 
 static const GtkCssMatcherClass GTK_CSS_MATCHER_NODE = {
@@ -325,6 +348,94 @@ _gtk_css_matcher_node_init (GtkCssMatcher *matcher,
 {
   matcher->node.klass = &GTK_CSS_MATCHER_NODE;
   matcher->node.node = node;
+  matcher->node.filter = NULL;
+  matcher->node.positions = NULL;
+}
+
+/**
+ * _gtk_css_matcher_node_set_ancestor_filter:
+ * @matcher: a matcher
+ * @filter: (allow-none): a filter containing all ancestors of the
+ *     matcher's node
+ *
+ * Lets the matcher use @filter to quickly rule out selectors with
+ * descendant combinators. The filter must stay alive and unchanged
+ * for as long as the matcher is in use.
+ *
+ * This does nothing if @matcher does not match a #GtkCssNode.
+ */
+void
+_gtk_css_matcher_node_set_ancestor_filter (GtkCssMatcher              *matcher,
+                                           const GtkCssAncestorFilter *filter)
+{
+  if (matcher->klass == &GTK_CSS_MATCHER_NODE)
+    matcher->node.filter = filter;
+}
+
+gboolean
+_gtk_css_matcher_is_node (const GtkCssMatcher *matcher)
+{
+  return matcher->klass == &GTK_CSS_MATCHER_NODE;
+}
+
+const GtkCssAncestorFilter *
+_gtk_css_matcher_get_ancestor_filter (const GtkCssMatcher *matcher)
+{
+  if (matcher->klass == &GTK_CSS_MATCHER_NODE)
+    return matcher->node.filter;
+
+  return NULL;
+}
+
+/**
+ * _gtk_css_matcher_node_set_position_log:
+ * @matcher: a matcher
+ * @positions: (allow-none): an array of #GtkCssPositionQuery
+ *
+ * Makes @matcher append all queries for the position of its node
+ * and their results to @positions. Queries for other nodes reached
+ * from @matcher are not recorded.
+ *
+ * Returns: %FALSE if @matcher does not match a #GtkCssNode and
+ *     cannot record positions
+ */
+gboolean
+_gtk_css_matcher_node_set_position_log (GtkCssMatcher *matcher,
+                                        GArray        *positions)
+{
+  if (matcher->klass != &GTK_CSS_MATCHER_NODE)
+    return FALSE;
+
+  matcher->node.positions = positions;
+
+  return TRUE;
+}
+
+/**
+ * _gtk_css_matcher_check_positions:
+ * @matcher: a matcher
+ * @positions: an array of #GtkCssPositionQuery
+ *
+ * Checks if all the position queries in @positions give the same
+ * results for @matcher.
+ *
+ * Returns: %TRUE if all results are the same
+ */
+gboolean
+_gtk_css_matcher_check_positions (const GtkCssMatcher *matcher,
+                                  GArray              *positions)
+{
+  guint i;
+
+  for (i = 0; i < positions->len; i++)
+    {
+      const GtkCssPositionQuery *query = &g_array_index (positions, GtkCssPositionQuery, i);
+
+      if (!_gtk_css_matcher_has_position (matcher, query->forward, query->a, query->b) != !query->result)
+        return FALSE;
+    }
+
+  return TRUE;
 }
 
 /* GTK_CSS_MATCHER_WIDGET_ANY */
@@ -21,6 +21,7 @@
 #include <gtk/gtkenums.h>
 #include <gtk/gtktypes.h>
 #include "gtk/gtkcsstypesprivate.h"
+#include "gtk/gtkcssancestorfilterprivate.h"
 
 G_BEGIN_DECLS
 
@@ -28,6 +29,7 @@ typedef struct _GtkCssMatcherNode GtkCssMatcherNode;
 typedef struct _GtkCssMatcherSuperset GtkCssMatcherSuperset;
 typedef struct _GtkCssMatcherWidgetPath GtkCssMatcherWidgetPath;
 typedef struct _GtkCssMatcherClass GtkCssMatcherClass;
+typedef struct _GtkCssPositionQuery GtkCssPositionQuery;
 
 struct _GtkCssMatcherClass {
   gboolean        (* get_parent)                  (GtkCssMatcher          *matcher,
@@ -49,6 +51,14 @@ struct _GtkCssMatcherClass {
   gboolean is_any;
 };
 
+/* A recorded call to has_position() and its result */
+struct _GtkCssPositionQuery {
+  guint forward :1;
+  guint result  :1;
+  int   a;
+  int   b;
+};
+
 struct _GtkCssMatcherWidgetPath {
   const GtkCssMatcherClass *klass;
   const GtkCssNodeDeclaration *decl;
@@ -60,6 +70,8 @@ struct _GtkCssMatcherWidgetPath {
 struct _GtkCssMatcherNode {
   const GtkCssMatcherClass *klass;
   GtkCssNode               *node;
+  const GtkCssAncestorFilter *filter;   /* may be NULL */
+  GArray                   *positions;  /* GtkCssPositionQuery, may be NULL */
 };
 
 struct _GtkCssMatcherSuperset {
@@ -80,6 +92,18 @@ gboolean          _gtk_css_matcher_init           (GtkCssMatcher          *match
                                                    const GtkCssNodeDeclaration *decl) G_GNUC_WARN_UNUSED_RESULT;
 void              _gtk_css_matcher_node_init      (GtkCssMatcher          *matcher,
                                                    GtkCssNode             *node);
+void              _gtk_css_matcher_node_set_ancestor_filter
+                                                  (GtkCssMatcher          *matcher,
+                                                   const GtkCssAncestorFilter *filter);
+gboolean          _gtk_css_matcher_is_node        (const GtkCssMatcher    *matcher);
+const GtkCssAncestorFilter *
+                  _gtk_css_matcher_get_ancestor_filter
+                                                  (const GtkCssMatcher    *matcher);
+gboolean          _gtk_css_matcher_node_set_position_log
+                                                  (GtkCssMatcher          *matcher,
+                                                   GArray                 *positions);
+gboolean          _gtk_css_matcher_check_positions (const GtkCssMatcher   *matcher,
+                                                   GArray                 *positions);
 void              _gtk_css_matcher_any_init       (GtkCssMatcher          *matcher);
 void              _gtk_css_matcher_superset_init  (GtkCssMatcher          *matcher,
                                                    const GtkCssMatcher    *subset,
@@ -115,6 +115,12 @@ struct _GtkCssNodeStyleChange {
 static guint cssnode_signals[LAST_SIGNAL] = { 0 };
 static GParamSpec *cssnode_properties[NUM_PROPERTIES];
 
+/* The ancestors of the nodes currently being validated,
+ * see gtk_css_node_validate(). NULL if they can't be used. */
+static GtkCssAncestorFilter *validate_filter = NULL;
+/* The filters of all running validations, which may be nested */
+static GSList *validate_filters = NULL;
+
 static GtkStyleProviderPrivate *
 gtk_css_node_get_style_provider_or_null (GtkCssNode *cssnode)
 {
@@ -352,6 +358,48 @@ store_in_global_parent_cache (GtkCssNode                  *node,
                                                  style);
 }
 
+static GtkCssStyle *
+lookup_in_sibling_cache (GtkCssNode                  *node,
+                         const GtkCssNodeDeclaration *decl,
+                         const GtkCssMatcher         *matcher)
+{
+  GtkCssNode *parent;
+
+  parent = node->parent;
+
+  if (parent == NULL ||
+      !may_use_global_parent_cache (node))
+    return NULL;
+
+  if (parent->cache == NULL)
+    return NULL;
+
+  return gtk_css_node_style_cache_lookup_sibling (parent->cache, decl, matcher);
+}
+
+static void
+store_in_sibling_cache (GtkCssNode                  *node,
+                        const GtkCssNodeDeclaration *decl,
+                        GArray                      *positions,
+                        GtkCssStyle                 *style)
+{
+  GtkCssNode *parent;
+
+  parent = node->parent;
+
+  if (parent == NULL ||
+      !may_use_global_parent_cache (node))
+    return;
+
+  if (parent->cache == NULL)
+    parent->cache = gtk_css_node_style_cache_new (parent->style);
+
+  gtk_css_node_style_cache_insert_sibling (parent->cache,
+                                           (GtkCssNodeDeclaration *) decl,
+                                           positions,
+                                           style);
+}
+
 static GtkCssStyle *
 gtk_css_node_create_style (GtkCssNode *cssnode)
 {
@@ -368,9 +416,40 @@ gtk_css_node_create_style (GtkCssNode *cssnode)
     return g_object_ref (style);
 
   if (gtk_css_node_init_matcher (cssnode, &matcher))
-    style = gtk_css_static_style_new_compute (gtk_css_node_get_style_provider (cssnode),
-                                              &matcher,
-                                              parent);
+    {
+      GArray *positions;
+
+      /* Styles that depend on our position can't be in the global
+       * parent cache, but a sibling may have had the same one */
+      style = lookup_in_sibling_cache (cssnode, decl, &matcher);
+      if (style)
+        return g_object_ref (style);
+
+      /* Only use the filter if it contains exactly our ancestors */
+      if (validate_filter != NULL &&
+          cssnode->parent != NULL &&
+          gtk_css_ancestor_filter_get_top (validate_filter) == cssnode->parent)
+        _gtk_css_matcher_node_set_ancestor_filter (&matcher, validate_filter);
+
+      positions = g_array_new (FALSE, FALSE, sizeof (GtkCssPositionQuery));
+      if (!_gtk_css_matcher_node_set_position_log (&matcher, positions))
+        g_clear_pointer (&positions, g_array_unref);
+
+      style = gtk_css_static_style_new_compute (gtk_css_node_get_style_provider (cssnode),
+                                                &matcher,
+                                                parent);
+
+      store_in_global_parent_cache (cssnode, decl, style);
+
+      if (positions)
+        {
+          if (cssnode->cache == NULL)
+            store_in_sibling_cache (cssnode, decl, positions, style);
+          g_array_unref (positions);
+        }
+
+      return style;
+    }
   else
     style = gtk_css_static_style_new_compute (gtk_css_node_get_style_provider (cssnode),
                                               NULL,
@@ -1365,6 +1444,14 @@ gtk_css_node_invalidate (GtkCssNode   *cssnode,
 
   cssnode->pending_changes |= change;
 
+  if (change & (GTK_CSS_CHANGE_NAME | GTK_CSS_CHANGE_ID | GTK_CSS_CHANGE_CLASS))
+    {
+      GSList *l;
+
+      for (l = validate_filters; l; l = l->next)
+        gtk_css_ancestor_filter_node_changed (l->data, cssnode);
+    }
+
   GTK_CSS_NODE_GET_CLASS (cssnode)->invalidate (cssnode);
 
   if (cssnode->parent)
@@ -1372,10 +1459,28 @@ gtk_css_node_invalidate (GtkCssNode   *cssnode,
   gtk_css_node_invalidate_style (cssnode);
 }
 
+/* Returns %FALSE if matching selectors against the descendants of
+ * @cssnode continues through a widget path when it gets to @cssnode,
+ * instead of through its CSS node ancestors. The ancestor filter
+ * does not describe those ancestors.
+ */
+static gboolean
+gtk_css_node_matches_ancestors_as_nodes (GtkCssNode *cssnode)
+{
+  GtkCssMatcher matcher;
+
+  /* Matching stops here, so the filter just has extra ancestors */
+  if (!gtk_css_node_init_matcher (cssnode, &matcher))
+    return TRUE;
+
+  return _gtk_css_matcher_is_node (&matcher);
+}
+
 void
 gtk_css_node_validate_internal (GtkCssNode *cssnode,
                                 gint64      timestamp)
 {
+  GtkCssAncestorFilter *saved_filter;
   GtkCssNode *child;
 
   if (!cssnode->invalid)
@@ -1390,6 +1495,16 @@ gtk_css_node_validate_internal (GtkCssNode *cssnode,
 
   GTK_CSS_NODE_GET_CLASS (cssnode)->validate (cssnode);
 
+  if (cssnode->first_child == NULL)
+    return;
+
+  saved_filter = validate_filter;
+  if (validate_filter && !gtk_css_node_matches_ancestors_as_nodes (cssnode))
+    validate_filter = NULL;
+
+  if (validate_filter)
+    gtk_css_ancestor_filter_push (validate_filter, cssnode);
+
   for (child = gtk_css_node_get_first_child (cssnode);
        child;
        child = gtk_css_node_get_next_sibling (child))
@@ -1397,16 +1512,53 @@ gtk_css_node_validate_internal (GtkCssNode *cssnode,
       if (child->visible)
         gtk_css_node_validate_internal (child, timestamp);
     }
+
+  if (validate_filter)
+    gtk_css_ancestor_filter_pop (validate_filter);
+
+  validate_filter = saved_filter;
+}
+
+static gboolean
+push_ancestors (GtkCssAncestorFilter *filter,
+                GtkCssNode           *cssnode)
+{
+  if (cssnode == NULL)
+    return TRUE;
+
+  if (!push_ancestors (filter, cssnode->parent) ||
+      !gtk_css_node_matches_ancestors_as_nodes (cssnode))
+    return FALSE;
+
+  gtk_css_ancestor_filter_push (filter, cssnode);
+
+  return TRUE;
 }
 
 void
 gtk_css_node_validate (GtkCssNode *cssnode)
 {
+  GtkCssAncestorFilter *filter, *saved_filter;
   gint64 timestamp;
 
   timestamp = gtk_css_node_get_timestamp (cssnode);
 
+  /* Validation may recurse, for example from signal handlers,
+   * so every validation run gets its own filter. */
+  filter = gtk_css_ancestor_filter_new ();
+  validate_filters = g_slist_prepend (validate_filters, filter);
+
+  saved_filter = validate_filter;
+  if (push_ancestors (filter, cssnode->parent))
+    validate_filter = filter;
+  else
+    validate_filter = NULL;
+
   gtk_css_node_validate_internal (cssnode, timestamp);
+
+  validate_filter = saved_filter;
+  validate_filters = g_slist_remove (validate_filters, filter);
+  gtk_css_ancestor_filter_free (filter);
 }
 
 gboolean
@@ -22,10 +22,25 @@
 #include "gtkdebug.h"
 #include "gtkcssstaticstyleprivate.h"
 
+/* Styles that depend on the position of a node can't be put into the
+ * children hash table. Instead we remember the last few of them along
+ * with the position queries their selector matching did, and share
+ * them with siblings for which these queries give the same results.
+ */
+#define N_SIBLING_STYLES 4
+
+typedef struct {
+  GtkCssNodeDeclaration *decl;
+  GArray                *positions;
+  GtkCssStyle           *style;
+} GtkCssNodeStyleCacheSibling;
+
 struct _GtkCssNodeStyleCache {
   guint        ref_count;
   GtkCssStyle *style;
   GHashTable  *children;
+  GtkCssNodeStyleCacheSibling siblings[N_SIBLING_STYLES];
+  guint        next_sibling;
 };
 
 #define UNPACK_DECLARATION(packed) ((GtkCssNodeDeclaration *) (GPOINTER_TO_SIZE (packed) & ~0x3))
@@ -53,9 +68,19 @@ gtk_css_node_style_cache_ref (GtkCssNodeStyleCache *cache)
   return cache;
 }
 
+static void
+gtk_css_node_style_cache_sibling_clear (GtkCssNodeStyleCacheSibling *sibling)
+{
+  g_clear_pointer (&sibling->decl, gtk_css_node_declaration_unref);
+  g_clear_pointer (&sibling->positions, g_array_unref);
+  g_clear_object (&sibling->style);
+}
+
 void
 gtk_css_node_style_cache_unref (GtkCssNodeStyleCache *cache)
 {
+  guint i;
+
   cache->ref_count--; 
 
   if (cache->ref_count > 0)
@@ -64,6 +89,8 @@ gtk_css_node_style_cache_unref (GtkCssNodeStyleCache *cache)
   g_object_unref (cache->style);
   if (cache->children)
     g_hash_table_unref (cache->children);
+  for (i = 0; i < N_SIBLING_STYLES; i++)
+    gtk_css_node_style_cache_sibling_clear (&cache->siblings[i]);
 
   g_slice_free (GtkCssNodeStyleCache, cache);
 }
@@ -180,3 +207,75 @@ gtk_css_node_style_cache_lookup (GtkCssNodeStyleCache        *parent,
   return gtk_css_node_style_cache_ref (result);
 }
 
+static gboolean
+may_be_shared_with_siblings (GtkCssStyle *style)
+{
+#ifdef G_ENABLE_DEBUG
+  if (GTK_DEBUG_CHECK (NO_CSS_CACHE))
+    return FALSE;
+#endif
+
+  if (!GTK_IS_CSS_STATIC_STYLE (style))
+    return FALSE;
+
+  /* We only record the positions of the node itself, so we can't
+   * tell if siblings would match the same selectors.
+   */
+  if (gtk_css_static_style_get_change (GTK_CSS_STATIC_STYLE (style)) & GTK_CSS_CHANGE_ANY_SIBLING)
+    return FALSE;
+
+  return TRUE;
+}
+
+/**
+ * gtk_css_node_style_cache_insert_sibling:
+ * @parent: the cache of the parent node
+ * @decl: the declaration of the node
+ * @positions: all #GtkCssPositionQuery done when computing @style
+ * @style: the style of the node
+ *
+ * Remembers @style so that siblings of the node with the same
+ * declaration can share it if they get the same results for
+ * all queries in @positions.
+ */
+void
+gtk_css_node_style_cache_insert_sibling (GtkCssNodeStyleCache  *parent,
+                                         GtkCssNodeDeclaration *decl,
+                                         GArray                *positions,
+                                         GtkCssStyle           *style)
+{
+  GtkCssNodeStyleCacheSibling *sibling;
+
+  if (!may_be_shared_with_siblings (style))
+    return;
+
+  sibling = &parent->siblings[parent->next_sibling];
+  parent->next_sibling = (parent->next_sibling + 1) % N_SIBLING_STYLES;
+
+  gtk_css_node_style_cache_sibling_clear (sibling);
+  sibling->decl = gtk_css_node_declaration_ref (decl);
+  sibling->positions = g_array_ref (positions);
+  sibling->style = g_object_ref (style);
+}
+
+GtkCssStyle *
+gtk_css_node_style_cache_lookup_sibling (GtkCssNodeStyleCache        *parent,
+                                         const GtkCssNodeDeclaration *decl,
+                                         const GtkCssMatcher         *matcher)
+{
+  guint i;
+
+  for (i = 0; i < N_SIBLING_STYLES; i++)
+    {
+      GtkCssNodeStyleCacheSibling *sibling = &parent->siblings[i];
+
+      if (sibling->style == NULL ||
+          !gtk_css_node_declaration_equal (sibling->decl, decl))
+        continue;
+
+      if (_gtk_css_matcher_check_positions (matcher, sibling->positions))
+        return sibling->style;
+    }
+
+  return NULL;
+}
@@ -18,6 +18,7 @@
 #ifndef __GTK_CSS_NODE_STYLE_CACHE_PRIVATE_H__
 #define __GTK_CSS_NODE_STYLE_CACHE_PRIVATE_H__
 
+#include "gtkcssmatcherprivate.h"
 #include "gtkcssnodedeclarationprivate.h"
 #include "gtkcssstyleprivate.h"
 
@@ -41,6 +42,14 @@ GtkCssNodeStyleCache *  gtk_css_node_style_cache_lookup         (GtkCssNodeStyle
                                                                  gboolean                     is_first,
                                                                  gboolean                     is_last);
 
+void                    gtk_css_node_style_cache_insert_sibling (GtkCssNodeStyleCache   *parent,
+                                                                 GtkCssNodeDeclaration  *decl,
+                                                                 GArray                 *positions,
+                                                                 GtkCssStyle            *style);
+GtkCssStyle *           gtk_css_node_style_cache_lookup_sibling (GtkCssNodeStyleCache        *parent,
+                                                                 const GtkCssNodeDeclaration *decl,
+                                                                 const GtkCssMatcher         *matcher);
+
 G_END_DECLS
 
 #endif /* __GTK_CSS_NODE_STYLE_CACHE_PRIVATE_H__ */
@@ -1508,6 +1508,45 @@ gtk_css_selectors_skip_initial_selector (GtkCssSelector *selector, const GtkCssS
   return (GtkCssSelector *)gtk_css_selector_previous (selector);
 }
 
+/* Checks if any ancestor can possibly match one of the selectors
+ * following the descendant combinator @tree. We can only tell for
+ * name, class and id selectors; for all others we have to assume
+ * they might match.
+ */
+static gboolean
+gtk_css_selector_tree_may_match_ancestor (const GtkCssSelectorTree   *tree,
+                                          const GtkCssAncestorFilter *filter)
+{
+  const GtkCssSelectorTree *prev;
+
+  for (prev = gtk_css_selector_tree_get_previous (tree);
+       prev != NULL;
+       prev = gtk_css_selector_tree_get_sibling (prev))
+    {
+      const GtkCssSelector *selector = &prev->selector;
+
+      if (selector->class == &GTK_CSS_SELECTOR_NAME)
+        {
+          if (gtk_css_ancestor_filter_may_have_name (filter, selector->name.name))
+            return TRUE;
+        }
+      else if (selector->class == &GTK_CSS_SELECTOR_CLASS)
+        {
+          if (gtk_css_ancestor_filter_may_have_class (filter, selector->style_class.style_class))
+            return TRUE;
+        }
+      else if (selector->class == &GTK_CSS_SELECTOR_ID)
+        {
+          if (gtk_css_ancestor_filter_may_have_id (filter, selector->id.name))
+            return TRUE;
+        }
+      else
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
 static gboolean
 gtk_css_selector_tree_match_foreach (const GtkCssSelector *selector,
                                      const GtkCssMatcher  *matcher,
@@ -1515,16 +1554,27 @@ gtk_css_selector_tree_match_foreach (const GtkCssSelector *selector,
 {
   const GtkCssSelectorTree *tree = (const GtkCssSelectorTree *) selector;
   const GtkCssSelectorTree *prev;
+  const GtkCssAncestorFilter *filter;
 
   if (!gtk_css_selector_match (selector, matcher))
     return FALSE;
 
   gtk_css_selector_tree_found_match (tree, res);
 
+  filter = _gtk_css_matcher_get_ancestor_filter (matcher);
+
   for (prev = gtk_css_selector_tree_get_previous (tree);
        prev != NULL;
        prev = gtk_css_selector_tree_get_sibling (prev))
-    gtk_css_selector_foreach (&prev->selector, matcher, gtk_css_selector_tree_match_foreach, res);
+    {
+      /* Avoid walking up the tree if no ancestor can match */
+      if (filter != NULL &&
+          prev->selector.class == &GTK_CSS_SELECTOR_DESCENDANT &&
+          !gtk_css_selector_tree_may_match_ancestor (prev, filter))
+        continue;
+
+      gtk_css_selector_foreach (&prev->selector, matcher, gtk_css_selector_tree_match_foreach, res);
+    }
 
   return FALSE;
 }
@@ -662,27 +662,157 @@ draw_shadow (const GtkCssValue   *shadow,
     gtk_css_shadow_value_finish_drawing (shadow, shadow_cr, blur_flags);
 }
 
+/* Blurred masks for outset shadows only depend on a few parameters,
+ * and many widgets share the same shadows, so we keep the masks for
+ * the corners and sides in a cache. The cache is bounded by the
+ * total size of the mask surfaces and evicts least recently used
+ * masks first.
+ */
+#define SHADOW_MASK_CACHE_MAX_SIZE (2 * 1024 * 1024)
+
+typedef enum {
+  SHADOW_MASK_CORNER,
+  SHADOW_MASK_SIDE
+} ShadowMaskType;
+
 typedef struct {
+  ShadowMaskType type;
   double radius;
+  double x_scale;
+  double y_scale;
+  /* For corners, the corner radii */
   GtkRoundedBoxCorner corner;
-} CornerMask;
+  /* For sides, which side and the fractional position of its edge */
+  GtkCssSide side;
+  double offset;
+} ShadowMaskKey;
+
+typedef struct {
+  ShadowMaskKey key;
+  cairo_surface_t *mask;
+  gsize size;
+  GList link;
+} ShadowMaskEntry;
+
+typedef struct {
+  GHashTable *entries;
+  GQueue lru;
+  gsize size;
+} ShadowMaskCache;
 
 static guint
-corner_mask_hash (CornerMask *mask)
+shadow_mask_key_hash (gconstpointer data)
 {
-  return ((guint)mask->radius << 24) ^
-    ((guint)(mask->corner.horizontal*4)) << 12 ^
-    ((guint)(mask->corner.vertical*4)) << 0;
+  const ShadowMaskKey *key = data;
+
+  return ((guint)key->radius << 24) ^
+    ((guint)(key->corner.horizontal*4)) << 12 ^
+    ((guint)(key->corner.vertical*4)) << 0 ^
+    ((guint)(key->offset*256)) << 4 ^
+    ((guint)(key->x_scale*4)) << 20 ^
+    ((guint)(key->y_scale*4)) << 26 ^
+    (key->side << 16) ^
+    key->type;
 }
 
 static gboolean
-corner_mask_equal (CornerMask *mask1,
-                   CornerMask *mask2)
+shadow_mask_key_equal (gconstpointer data1,
+                       gconstpointer data2)
 {
+  const ShadowMaskKey *key1 = data1;
+  const ShadowMaskKey *key2 = data2;
+
   return
-    mask1->radius == mask2->radius &&
-    mask1->corner.horizontal == mask2->corner.horizontal &&
-    mask1->corner.vertical == mask2->corner.vertical;
+    key1->type == key2->type &&
+    key1->radius == key2->radius &&
+    key1->x_scale == key2->x_scale &&
+    key1->y_scale == key2->y_scale &&
+    key1->corner.horizontal == key2->corner.horizontal &&
+    key1->corner.vertical == key2->corner.vertical &&
+    key1->side == key2->side &&
+    key1->offset == key2->offset;
+}
+
+static void
+shadow_mask_entry_free (gpointer data)
+{
+  ShadowMaskEntry *entry = data;
+
+  cairo_surface_destroy (entry->mask);
+  g_slice_free (ShadowMaskEntry, entry);
+}
+
+static ShadowMaskCache *
+get_shadow_mask_cache (void)
+{
+  static ShadowMaskCache *cache = NULL;
+
+  if (cache == NULL)
+    {
+      cache = g_new0 (ShadowMaskCache, 1);
+      cache->entries = g_hash_table_new_full (shadow_mask_key_hash,
+                                              shadow_mask_key_equal,
+                                              NULL, shadow_mask_entry_free);
+      g_queue_init (&cache->lru);
+    }
+
+  return cache;
+}
+
+static cairo_surface_t *
+shadow_mask_cache_lookup (const ShadowMaskKey *key)
+{
+  ShadowMaskCache *cache = get_shadow_mask_cache ();
+  ShadowMaskEntry *entry;
+
+  entry = g_hash_table_lookup (cache->entries, key);
+  if (entry == NULL)
+    return NULL;
+
+  /* Move to the front of the LRU list */
+  g_queue_unlink (&cache->lru, &entry->link);
+  g_queue_push_head_link (&cache->lru, &entry->link);
+
+  return entry->mask;
+}
+
+/* Takes ownership of mask */
+static void
+shadow_mask_cache_insert (const ShadowMaskKey *key,
+                          cairo_surface_t     *mask)
+{
+  ShadowMaskCache *cache = get_shadow_mask_cache ();
+  ShadowMaskEntry *entry;
+
+  entry = g_slice_new0 (ShadowMaskEntry);
+  entry->key = *key;
+  entry->mask = mask;
+  entry->size = cairo_image_surface_get_stride (mask) * cairo_image_surface_get_height (mask);
+  entry->link.data = entry;
+
+  /* Make room, but always keep the new mask, even if it is too large */
+  while (cache->size + entry->size > SHADOW_MASK_CACHE_MAX_SIZE &&
+         !g_queue_is_empty (&cache->lru))
+    {
+      ShadowMaskEntry *old = g_queue_peek_tail (&cache->lru);
+
+      g_queue_unlink (&cache->lru, &old->link);
+      cache->size -= old->size;
+      g_hash_table_remove (cache->entries, &old->key);
+    }
+
+  g_queue_push_head_link (&cache->lru, &entry->link);
+  cache->size += entry->size;
+  g_hash_table_insert (cache->entries, &entry->key, entry);
+}
+
+static void
+get_device_scale (cairo_t *cr,
+                  double  *x_scale,
+                  double  *y_scale)
+{
+  *x_scale = *y_scale = 1;
+  cairo_surface_get_device_scale (cairo_get_target (cr), x_scale, y_scale);
 }
 
 static void
@@ -701,9 +831,8 @@ draw_shadow_corner (const GtkCssValue   *shadow,
   cairo_pattern_t *pattern;
   cairo_matrix_t matrix;
   double sx, sy;
-  static GHashTable *corner_mask_cache = NULL;
   double max_other;
-  CornerMask key;
+  ShadowMaskKey key = { 0, };
   gboolean overlapped;
 
   radius = _gtk_css_number_value_get (shadow->radius, 0);
@@ -786,32 +915,38 @@ draw_shadow_corner (const GtkCssValue   *shadow,
    *
    * The the horizontal and vertical corner radius
    *
+   * The device scale of the target
+   *
    * We apply the first position and orientation when drawing the
-   * mask, so we cache rendered masks based on the blur radius and the
-   * corner radius.
+   * mask, so we cache rendered masks based on the blur radius, the
+   * corner radius and the scale.
    */
-  if (corner_mask_cache == NULL)
-    corner_mask_cache = g_hash_table_new_full ((GHashFunc)corner_mask_hash,
-                                               (GEqualFunc)corner_mask_equal,
-                                               g_free, (GDestroyNotify)cairo_surface_destroy);
-
+  key.type = SHADOW_MASK_CORNER;
   key.radius = radius;
   key.corner = box->corner[corner];
+  get_device_scale (cr, &key.x_scale, &key.y_scale);
 
-  mask = g_hash_table_lookup (corner_mask_cache, &key);
+  mask = shadow_mask_cache_lookup (&key);
   if (mask == NULL)
     {
       mask = cairo_surface_create_similar_image (cairo_get_target (cr), CAIRO_FORMAT_A8,
-                                                 drawn_rect->width + clip_radius,
-                                                 drawn_rect->height + clip_radius);
+                                                 key.x_scale * (drawn_rect->width + clip_radius),
+                                                 key.y_scale * (drawn_rect->height + clip_radius));
+      cairo_surface_set_device_scale (mask, key.x_scale, key.y_scale);
       mask_cr = cairo_create (mask);
       _gtk_rounded_box_init_rect (&corner_box, clip_radius, clip_radius, 2*drawn_rect->width, 2*drawn_rect->height);
       corner_box.corner[0] = box->corner[corner];
       _gtk_rounded_box_path (&corner_box, mask_cr);
       cairo_fill (mask_cr);
-      _gtk_cairo_blur_surface (mask, radius, GTK_BLUR_X | GTK_BLUR_Y);
+      if (key.x_scale == key.y_scale)
+        _gtk_cairo_blur_surface (mask, key.x_scale * radius, GTK_BLUR_X | GTK_BLUR_Y);
+      else
+        {
+          _gtk_cairo_blur_surface (mask, key.x_scale * radius, GTK_BLUR_X);
+          _gtk_cairo_blur_surface (mask, key.y_scale * radius, GTK_BLUR_Y);
+        }
       cairo_destroy (mask_cr);
-      g_hash_table_insert (corner_mask_cache, g_memdup (&key, sizeof (key)), mask);
+      shadow_mask_cache_insert (&key, mask);
     }
 
   gdk_cairo_set_source_rgba (cr, _gtk_css_rgba_value_get_rgba (shadow->color));
@@ -824,6 +959,107 @@ draw_shadow_corner (const GtkCssValue   *shadow,
   cairo_pattern_destroy (pattern);
 }
 
+/* The blurred part of an outset side is a blurred step, repeated
+ * along the side. It only depends on the blur radius, the scale and
+ * where the edge is inside the first pixel, so we render it once into
+ * a surface that is a single pixel wide (or high) and pad it along
+ * the side.
+ *
+ * This is only possible if the opposite edge of the box is outside
+ * the area affected by the blur, otherwise we return %FALSE.
+ */
+static gboolean
+draw_cached_shadow_side (const GtkCssValue *shadow,
+                         cairo_t           *cr,
+                         GtkRoundedBox     *box,
+                         GtkCssSide         side,
+                         int                x1,
+                         int                y1)
+{
+  ShadowMaskKey key = { 0, };
+  gdouble radius, clip_radius;
+  gdouble edge, length, extent;
+  gboolean vertical;
+  cairo_surface_t *mask;
+  cairo_pattern_t *pattern;
+  cairo_matrix_t matrix;
+  int origin;
+
+  if (has_empty_clip (cr))
+    return TRUE;
+
+  radius = _gtk_css_number_value_get (shadow->radius, 0);
+  clip_radius = _gtk_cairo_blur_compute_pixels (radius);
+
+  vertical = side == GTK_CSS_TOP || side == GTK_CSS_BOTTOM;
+  if (vertical)
+    {
+      edge = side == GTK_CSS_TOP ? box->box.y : box->box.y + box->box.height;
+      length = box->box.height;
+      origin = y1 - clip_radius;
+    }
+  else
+    {
+      edge = side == GTK_CSS_LEFT ? box->box.x : box->box.x + box->box.width;
+      length = box->box.width;
+      origin = x1 - clip_radius;
+    }
+
+  /* The mask covers the side area plus the blur radius on both ends */
+  extent = 4 * clip_radius + 1;
+  if (length < extent)
+    return FALSE;
+
+  key.type = SHADOW_MASK_SIDE;
+  key.radius = radius;
+  key.side = side;
+  key.offset = edge - floor (edge);
+  get_device_scale (cr, &key.x_scale, &key.y_scale);
+
+  mask = shadow_mask_cache_lookup (&key);
+  if (mask == NULL)
+    {
+      cairo_t *mask_cr;
+      double pos = edge - origin;
+
+      mask = cairo_surface_create_similar_image (cairo_get_target (cr), CAIRO_FORMAT_A8,
+                                                 vertical ? 1 : key.x_scale * extent,
+                                                 vertical ? key.y_scale * extent : 1);
+      cairo_surface_set_device_scale (mask, key.x_scale, key.y_scale);
+      mask_cr = cairo_create (mask);
+
+      if (side == GTK_CSS_TOP)
+        cairo_rectangle (mask_cr, 0, pos, 1, extent - pos);
+      else if (side == GTK_CSS_BOTTOM)
+        cairo_rectangle (mask_cr, 0, 0, 1, pos);
+      else if (side == GTK_CSS_LEFT)
+        cairo_rectangle (mask_cr, pos, 0, extent - pos, 1);
+      else
+        cairo_rectangle (mask_cr, 0, 0, pos, 1);
+      cairo_fill (mask_cr);
+      cairo_destroy (mask_cr);
+
+      if (vertical)
+        _gtk_cairo_blur_surface (mask, key.y_scale * radius, GTK_BLUR_Y);
+      else
+        _gtk_cairo_blur_surface (mask, key.x_scale * radius, GTK_BLUR_X);
+      shadow_mask_cache_insert (&key, mask);
+    }
+
+  gdk_cairo_set_source_rgba (cr, _gtk_css_rgba_value_get_rgba (shadow->color));
+  pattern = cairo_pattern_create_for_surface (mask);
+  cairo_pattern_set_extend (pattern, CAIRO_EXTEND_PAD);
+  if (vertical)
+    cairo_matrix_init_translate (&matrix, 0, -origin);
+  else
+    cairo_matrix_init_translate (&matrix, -origin, 0);
+  cairo_pattern_set_matrix (pattern, &matrix);
+  cairo_mask (cr, pattern);
+  cairo_pattern_destroy (pattern);
+
+  return TRUE;
+}
+
 static void
 draw_shadow_side (const GtkCssValue   *shadow,
                   cairo_t             *cr,
@@ -880,7 +1116,9 @@ draw_shadow_side (const GtkCssValue   *shadow,
 
   cairo_rectangle (cr, x1, y1, x2 - x1, y2 - y1);
   cairo_clip (cr);
-  draw_shadow (shadow, cr, box, clip_box, blur_flags);
+
+  if (shadow->inset || !draw_cached_shadow_side (shadow, cr, box, side, x1, y1))
+    draw_shadow (shadow, cr, box, clip_box, blur_flags);
 }
 
 void
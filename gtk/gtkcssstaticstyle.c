@@ -38,8 +38,157 @@
 #include "gtkstylepropertyprivate.h"
 #include "gtkstyleproviderprivate.h"
 
+#include <string.h>
+
 G_DEFINE_TYPE (GtkCssStaticStyle, gtk_css_static_style, GTK_TYPE_CSS_STYLE)
 
+struct _GtkCssValueBlock
+{
+  guint ref_count;
+  guint hash;
+  GtkCssValue *values[GTK_CSS_VALUE_BLOCK_SIZE];
+};
+
+struct _GtkCssStaticStyleSection
+{
+  guint id;
+  GtkCssSection *section;
+};
+
+#define BLOCK_INDEX(id) ((id) / GTK_CSS_VALUE_BLOCK_SIZE)
+#define BLOCK_OFFSET(id) ((id) % GTK_CSS_VALUE_BLOCK_SIZE)
+
+/* All value blocks in use, so identical blocks can be shared.
+ *
+ * Like the rest of the CSS machinery, styles are only created and
+ * freed on the main thread, so neither this table nor the recent
+ * values below are locked.
+ */
+static GHashTable *value_blocks = NULL;
+
+/* The last few distinct values computed for each property, most
+ * recent first. Computed values that are equal to one of them are
+ * replaced by it, so equal values are shared between styles that are
+ * not related to each other, and so are the blocks holding them.
+ */
+#define N_RECENT_VALUES 4
+static GtkCssValue *recent_values[GTK_CSS_PROPERTY_N_PROPERTIES][N_RECENT_VALUES];
+static guint n_static_styles = 0;
+static gsize n_sections_total = 0;
+
+static guint
+gtk_css_value_block_hash (gconstpointer data)
+{
+  const GtkCssValueBlock *block = data;
+
+  return block->hash;
+}
+
+static gboolean
+gtk_css_value_block_equal (gconstpointer data1,
+                           gconstpointer data2)
+{
+  const GtkCssValueBlock *block1 = data1;
+  const GtkCssValueBlock *block2 = data2;
+
+  return memcmp (block1->values, block2->values, sizeof (block1->values)) == 0;
+}
+
+static GtkCssValueBlock *
+gtk_css_value_block_ref (GtkCssValueBlock *block)
+{
+  block->ref_count++;
+
+  return block;
+}
+
+static void
+gtk_css_value_block_unref (GtkCssValueBlock *block)
+{
+  guint i;
+
+  block->ref_count--;
+  if (block->ref_count > 0)
+    return;
+
+  g_hash_table_remove (value_blocks, block);
+
+  for (i = 0; i < GTK_CSS_VALUE_BLOCK_SIZE; i++)
+    {
+      if (block->values[i])
+        _gtk_css_value_unref (block->values[i]);
+    }
+
+  g_slice_free (GtkCssValueBlock, block);
+}
+
+/* Returns a block with the given values, either an existing
+ * identical one or a new one. */
+static GtkCssValueBlock *
+gtk_css_value_block_lookup (GtkCssValue **values)
+{
+  GtkCssValueBlock key, *block;
+  guint i;
+
+  if (value_blocks == NULL)
+    value_blocks = g_hash_table_new (gtk_css_value_block_hash, gtk_css_value_block_equal);
+
+  key.hash = 0;
+  for (i = 0; i < GTK_CSS_VALUE_BLOCK_SIZE; i++)
+    {
+      key.values[i] = values[i];
+      key.hash = (key.hash << 5) - key.hash + g_direct_hash (values[i]);
+    }
+
+  block = g_hash_table_lookup (value_blocks, &key);
+  if (block)
+    return gtk_css_value_block_ref (block);
+
+  block = g_slice_new (GtkCssValueBlock);
+  *block = key;
+  block->ref_count = 1;
+  for (i = 0; i < GTK_CSS_VALUE_BLOCK_SIZE; i++)
+    {
+      if (block->values[i])
+        _gtk_css_value_ref (block->values[i]);
+    }
+
+  g_hash_table_add (value_blocks, block);
+
+  return block;
+}
+
+/* Takes a reference to @value and returns a reference to a value
+ * that is equal to it, preferably one that is already in use. */
+static GtkCssValue *
+gtk_css_value_intern (guint        id,
+                      GtkCssValue *value)
+{
+  GtkCssValue **recent = recent_values[id];
+  GtkCssValue *result;
+  guint i;
+
+  for (i = 0; i < N_RECENT_VALUES && recent[i]; i++)
+    {
+      if (recent[i] == value || _gtk_css_value_equal (recent[i], value))
+        {
+          result = recent[i];
+          memmove (&recent[1], &recent[0], i * sizeof (GtkCssValue *));
+          recent[0] = result;
+
+          _gtk_css_value_unref (value);
+          return _gtk_css_value_ref (result);
+        }
+    }
+
+  if (recent[N_RECENT_VALUES - 1])
+    _gtk_css_value_unref (recent[N_RECENT_VALUES - 1]);
+  memmove (&recent[1], &recent[0], (N_RECENT_VALUES - 1) * sizeof (GtkCssValue *));
+  recent[0] = _gtk_css_value_ref (value);
+
+  return value;
+}
+
 static GtkCssValue *
 gtk_css_static_style_get_value (GtkCssStyle *style,
                                 guint        id)
@@ -53,20 +202,46 @@ gtk_css_static_style_get_value (GtkCssStyle *style,
       return _gtk_css_style_property_get_initial_value (prop);
     }
 
-  return sstyle->values[id];
+  if (G_UNLIKELY (sstyle->building))
+    return sstyle->building[id];
+
+  return sstyle->blocks[BLOCK_INDEX (id)]->values[BLOCK_OFFSET (id)];
+}
+
+static GtkCssStaticStyleSection *
+gtk_css_static_style_find_section (GtkCssStaticStyle *style,
+                                   guint              id)
+{
+  guint min, max;
+
+  min = 0;
+  max = style->n_sections;
+  while (min < max)
+    {
+      guint mid = (min + max) / 2;
+
+      if (style->sections[mid].id == id)
+        return &style->sections[mid];
+      else if (style->sections[mid].id < id)
+        min = mid + 1;
+      else
+        max = mid;
+    }
+
+  return NULL;
 }
 
 static GtkCssSection *
 gtk_css_static_style_get_section (GtkCssStyle *style,
                                     guint        id)
 {
-  GtkCssStaticStyle *sstyle = GTK_CSS_STATIC_STYLE (style);
+  GtkCssStaticStyleSection *section;
 
-  if (sstyle->sections == NULL ||
-      id >= sstyle->sections->len)
+  section = gtk_css_static_style_find_section (GTK_CSS_STATIC_STYLE (style), id);
+  if (section == NULL)
     return NULL;
 
-  return g_ptr_array_index (sstyle->sections, id);
+  return section->section;
 }
 
 static void
@@ -75,20 +250,36 @@ gtk_css_static_style_dispose (GObject *object)
   GtkCssStaticStyle *style = GTK_CSS_STATIC_STYLE (object);
   guint i;
 
-  for (i = 0; i < GTK_CSS_PROPERTY_N_PROPERTIES; i++)
-    {
-      if (style->values[i])
-        _gtk_css_value_unref (style->values[i]);
-    }
-  if (style->sections)
+  if (style->building)
     {
-      g_ptr_array_unref (style->sections);
-      style->sections = NULL;
+      for (i = 0; i < GTK_CSS_PROPERTY_N_PROPERTIES; i++)
+        {
+          if (style->building[i])
+            _gtk_css_value_unref (style->building[i]);
+        }
+      g_clear_pointer (&style->building, g_free);
     }
 
+  for (i = 0; i < GTK_CSS_N_VALUE_BLOCKS; i++)
+    g_clear_pointer (&style->blocks[i], gtk_css_value_block_unref);
+
+  for (i = 0; i < style->n_sections; i++)
+    gtk_css_section_unref (style->sections[i].section);
+  n_sections_total -= style->n_sections;
+  g_clear_pointer (&style->sections, g_free);
+  style->n_sections = 0;
+
   G_OBJECT_CLASS (gtk_css_static_style_parent_class)->dispose (object);
 }
 
+static void
+gtk_css_static_style_finalize (GObject *object)
+{
+  n_static_styles--;
+
+  G_OBJECT_CLASS (gtk_css_static_style_parent_class)->finalize (object);
+}
+
 static void
 gtk_css_static_style_class_init (GtkCssStaticStyleClass *klass)
 {
@@ -96,6 +287,7 @@ gtk_css_static_style_class_init (GtkCssStaticStyleClass *klass)
   GtkCssStyleClass *style_class = GTK_CSS_STYLE_CLASS (klass);
 
   object_class->dispose = gtk_css_static_style_dispose;
+  object_class->finalize = gtk_css_static_style_finalize;
 
   style_class->get_value = gtk_css_static_style_get_value;
   style_class->get_section = gtk_css_static_style_get_section;
@@ -104,13 +296,51 @@ gtk_css_static_style_class_init (GtkCssStaticStyleClass *klass)
 static void
 gtk_css_static_style_init (GtkCssStaticStyle *style)
 {
+  style->building = g_new0 (GtkCssValue *, GTK_CSS_PROPERTY_N_PROPERTIES);
+
+  n_static_styles++;
 }
 
 static void
-maybe_unref_section (gpointer section)
+gtk_css_static_style_set_section (GtkCssStaticStyle *style,
+                                  guint              id,
+                                  GtkCssSection     *section)
 {
-  if (section)
-    gtk_css_section_unref (section);
+  GtkCssStaticStyleSection *existing;
+  guint i;
+
+  existing = gtk_css_static_style_find_section (style, id);
+  if (existing)
+    {
+      if (section)
+        {
+          gtk_css_section_ref (section);
+          gtk_css_section_unref (existing->section);
+          existing->section = section;
+        }
+      else
+        {
+          i = existing - style->sections;
+          gtk_css_section_unref (existing->section);
+          memmove (&style->sections[i], &style->sections[i + 1],
+                   (style->n_sections - i - 1) * sizeof (GtkCssStaticStyleSection));
+          style->n_sections--;
+          n_sections_total--;
+        }
+      return;
+    }
+
+  if (section == NULL)
+    return;
+
+  /* Values are computed in order of their ids, so this usually appends */
+  style->sections = g_renew (GtkCssStaticStyleSection, style->sections, style->n_sections + 1);
+  for (i = style->n_sections; i > 0 && style->sections[i - 1].id > id; i--)
+    style->sections[i] = style->sections[i - 1];
+  style->sections[i].id = id;
+  style->sections[i].section = gtk_css_section_ref (section);
+  style->n_sections++;
+  n_sections_total++;
 }
 
 static void
@@ -119,25 +349,109 @@ gtk_css_static_style_set_value (GtkCssStaticStyle *style,
                                 GtkCssValue       *value,
                                 GtkCssSection     *section)
 {
-  if (style->values[id])
-    _gtk_css_value_unref (style->values[id]);
-  style->values[id] = _gtk_css_value_ref (value);
+  if (style->building)
+    {
+      if (style->building[id])
+        _gtk_css_value_unref (style->building[id]);
+      style->building[id] = _gtk_css_value_ref (value);
+    }
+  else
+    {
+      /* Copy on write */
+      GtkCssValueBlock *block = style->blocks[BLOCK_INDEX (id)];
+      GtkCssValue *values[GTK_CSS_VALUE_BLOCK_SIZE];
+
+      memcpy (values, block->values, sizeof (values));
+      values[BLOCK_OFFSET (id)] = value;
+      style->blocks[BLOCK_INDEX (id)] = gtk_css_value_block_lookup (values);
+      gtk_css_value_block_unref (block);
+    }
+
+  gtk_css_static_style_set_section (style, id, section);
+}
+
+/* Moves the values into shared blocks once they are all computed.
+ *
+ * Values that are equal to the parent's are replaced by the parent's
+ * value, so that blocks of inherited or default values end up identical
+ * to the parent's blocks and get shared. Other values are interned, so
+ * that siblings and unrelated nodes with the same styling share their
+ * blocks as well.
+ */
+static void
+gtk_css_static_style_compact (GtkCssStaticStyle *style,
+                              GtkCssStyle       *parent)
+{
+  GtkCssValue **values = style->building;
+  guint i;
 
-  if (style->sections && style->sections->len > id && g_ptr_array_index (style->sections, id))
+  if (parent)
     {
-      gtk_css_section_unref (g_ptr_array_index (style->sections, id));
-      g_ptr_array_index (style->sections, id) = NULL;
+      for (i = 0; i < GTK_CSS_PROPERTY_N_PROPERTIES; i++)
+        {
+          GtkCssValue *parent_value;
+
+          if (values[i] == NULL)
+            continue;
+
+          parent_value = gtk_css_style_get_value (parent, i);
+          if (parent_value == values[i])
+            continue;
+
+          if (parent_value != NULL &&
+              _gtk_css_value_equal (values[i], parent_value))
+            {
+              _gtk_css_value_unref (values[i]);
+              values[i] = _gtk_css_value_ref (parent_value);
+            }
+          else
+            values[i] = gtk_css_value_intern (i, values[i]);
+        }
+    }
+  else
+    {
+      for (i = 0; i < GTK_CSS_PROPERTY_N_PROPERTIES; i++)
+        {
+          if (values[i])
+            values[i] = gtk_css_value_intern (i, values[i]);
+        }
     }
 
-  if (section)
+  for (i = 0; i < GTK_CSS_N_VALUE_BLOCKS; i++)
     {
-      if (style->sections == NULL)
-        style->sections = g_ptr_array_new_with_free_func (maybe_unref_section);
-      if (style->sections->len <= id)
-        g_ptr_array_set_size (style->sections, id + 1);
+      GtkCssValue *block_values[GTK_CSS_VALUE_BLOCK_SIZE] = { NULL, };
+      guint first = i * GTK_CSS_VALUE_BLOCK_SIZE;
 
-      g_ptr_array_index (style->sections, id) = gtk_css_section_ref (section);
+      memcpy (block_values, &values[first],
+              MIN (GTK_CSS_VALUE_BLOCK_SIZE, GTK_CSS_PROPERTY_N_PROPERTIES - first) * sizeof (GtkCssValue *));
+      style->blocks[i] = gtk_css_value_block_lookup (block_values);
+    }
+
+  for (i = 0; i < GTK_CSS_PROPERTY_N_PROPERTIES; i++)
+    {
+      if (values[i])
+        _gtk_css_value_unref (values[i]);
     }
+  g_clear_pointer (&style->building, g_free);
+}
+
+/**
+ * gtk_css_static_style_get_statistics:
+ * @statistics: return location for the statistics
+ *
+ * Gets information about the memory used by all static styles,
+ * for use in the inspector.
+ */
+void
+gtk_css_static_style_get_statistics (GtkCssStaticStyleStatistics *statistics)
+{
+  statistics->n_styles = n_static_styles;
+  statistics->n_blocks = value_blocks ? g_hash_table_size (value_blocks) : 0;
+  statistics->size = n_static_styles * sizeof (GtkCssValueBlock *) * GTK_CSS_N_VALUE_BLOCKS
+                     + statistics->n_blocks * sizeof (GtkCssValueBlock)
+                     + n_sections_total * sizeof (GtkCssStaticStyleSection);
+  statistics->unshared_size = n_static_styles * (sizeof (GtkCssValue *) + sizeof (GtkCssSection *))
+                              * GTK_CSS_PROPERTY_N_PROPERTIES;
 }
 
 static GtkCssStyle *default_style;
@@ -197,6 +511,8 @@ gtk_css_static_style_new_compute (GtkStyleProviderPrivate *provider,
                            result,
                            parent);
 
+  gtk_css_static_style_compact (result, parent);
+
   _gtk_css_lookup_free (lookup);
 
   return GTK_CSS_STYLE (result);
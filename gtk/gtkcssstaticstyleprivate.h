@@ -32,19 +32,39 @@ G_BEGIN_DECLS
 #define GTK_IS_CSS_STATIC_STYLE_CLASS(obj)  (G_TYPE_CHECK_CLASS_TYPE (obj, GTK_TYPE_CSS_STATIC_STYLE))
 #define GTK_CSS_STATIC_STYLE_GET_CLASS(obj) (G_TYPE_INSTANCE_GET_CLASS ((obj), GTK_TYPE_CSS_STATIC_STYLE, GtkCssStaticStyleClass))
 
+/* The values of a style are stored in blocks of consecutive properties.
+ * Blocks are immutable once the style is computed and are shared between
+ * all styles with identical values for them.
+ */
+#define GTK_CSS_VALUE_BLOCK_SIZE 8
+#define GTK_CSS_N_VALUE_BLOCKS ((GTK_CSS_PROPERTY_N_PROPERTIES + GTK_CSS_VALUE_BLOCK_SIZE - 1) / GTK_CSS_VALUE_BLOCK_SIZE)
+
 typedef struct _GtkCssStaticStyle           GtkCssStaticStyle;
 typedef struct _GtkCssStaticStyleClass      GtkCssStaticStyleClass;
+typedef struct _GtkCssValueBlock            GtkCssValueBlock;
+typedef struct _GtkCssStaticStyleSection    GtkCssStaticStyleSection;
+typedef struct _GtkCssStaticStyleStatistics GtkCssStaticStyleStatistics;
 
 struct _GtkCssStaticStyle
 {
   GtkCssStyle parent;
 
-  GtkCssValue           *values[GTK_CSS_PROPERTY_N_PROPERTIES]; /* the values */
-  GPtrArray             *sections;             /* sections the values are defined in */
+  GtkCssValueBlock      *blocks[GTK_CSS_N_VALUE_BLOCKS]; /* the values */
+  GtkCssValue          **building;             /* all values while the style is computed, NULL afterwards */
+  GtkCssStaticStyleSection *sections;          /* sections the values are defined in, sorted by id */
+  guint                  n_sections;
 
   GtkCssChange           change;               /* change as returned by value lookup */
 };
 
+struct _GtkCssStaticStyleStatistics
+{
+  guint n_styles;               /* number of static styles */
+  guint n_blocks;               /* number of distinct value blocks */
+  gsize size;                   /* memory used for values and sections */
+  gsize unshared_size;          /* memory that would be used without sharing */
+};
+
 struct _GtkCssStaticStyleClass
 {
   GtkCssStyleClass parent_class;
@@ -66,6 +86,8 @@ void                    gtk_css_static_style_compute_value      (GtkCssStaticSty
 
 GtkCssChange            gtk_css_static_style_get_change         (GtkCssStaticStyle      *style);
 
+void                    gtk_css_static_style_get_statistics     (GtkCssStaticStyleStatistics *statistics);
+
 G_END_DECLS
 
 #endif /* __GTK_CSS_STATIC_STYLE_PRIVATE_H__ */
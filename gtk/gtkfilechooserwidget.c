@@ -4259,6 +4259,17 @@ time_sort_func (GtkTreeModel *model,
   return result;
 }
 
+/* The columns that name_sort_func(), size_sort_func() and
+ * time_sort_func() read; they don't touch anything else, so the
+ * browse model may run them on several threads.
+ */
+static const int browse_sort_columns[] = {
+  MODEL_COL_IS_FOLDER,
+  MODEL_COL_NAME_COLLATED,
+  MODEL_COL_SIZE,
+  MODEL_COL_TIME
+};
+
 static gint
 recent_sort_func (GtkTreeModel *model,
                   GtkTreeIter  *a,
@@ -5155,6 +5166,9 @@ set_list_model (GtkFileChooserWidget  *impl,
   gtk_tree_sortable_set_sort_func (GTK_TREE_SORTABLE (priv->browse_files_model), MODEL_COL_SIZE, size_sort_func, impl, NULL);
   gtk_tree_sortable_set_sort_func (GTK_TREE_SORTABLE (priv->browse_files_model), MODEL_COL_TIME, time_sort_func, impl, NULL);
   gtk_tree_sortable_set_default_sort_func (GTK_TREE_SORTABLE (priv->browse_files_model), NULL, NULL, NULL);
+  _gtk_file_system_model_set_sort_columns (priv->browse_files_model,
+                                           browse_sort_columns,
+                                           G_N_ELEMENTS (browse_sort_columns));
   set_sort_column (impl);
   priv->list_sort_ascending = TRUE;
   g_signal_connect (priv->browse_files_model, "sort-column-changed",
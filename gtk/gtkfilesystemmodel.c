@@ -26,6 +26,7 @@
 #include "gtkfilesystem.h"
 #include "gtkintl.h"
 #include "gtkmarshalers.h"
+#include "gtkparallelsortprivate.h"
 #include "gtktreedatalist.h"
 #include "gtktreednd.h"
 #include "gtktreemodel.h"
@@ -179,6 +180,8 @@ struct _GtkFileSystemModel
   GtkTreeIterCompareFunc default_sort_func; /* default sort function */
   gpointer              default_sort_data; /* data to pass to default sort func */
   GDestroyNotify        default_sort_destroy; /* function to call to destroy default_sort_data */
+  int *                 sort_columns;   /* columns read by thread-safe sort functions, or NULL */
+  guint                 n_sort_columns; /* number of columns in sort_columns */
 
   guint                 frozen;         /* number of times we're frozen */
 
@@ -766,6 +769,66 @@ compare_array_element (gconstpointer a, gconstpointer b, gpointer user_data)
   return data->func (GTK_TREE_MODEL (data->model), &itera, &iterb, data->data) * data->order;
 }
 
+static int
+compare_array_index (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+  SortData *data = user_data;
+  GtkTreeIter itera, iterb;
+
+  ITER_INIT_FROM_INDEX (data->model, &itera, *(const guint *) a);
+  ITER_INIT_FROM_INDEX (data->model, &iterb, *(const guint *) b);
+  return data->func (GTK_TREE_MODEL (data->model), &itera, &iterb, data->data) * data->order;
+}
+
+/* Sorts large directories on several threads when the sort functions
+ * have been declared thread-safe with _gtk_file_system_model_set_sort_columns().
+ * Returns FALSE if the model has to be sorted on this thread instead.
+ */
+static gboolean
+gtk_file_system_model_sort_parallel (GtkFileSystemModel *model,
+                                     SortData           *data)
+{
+  guint n_nodes = model->files->len - 1; /* don't sort the editable row */
+  guint *indices;
+  gchar *nodes;
+  guint i, c;
+
+  if (model->sort_columns == NULL || n_nodes < GTK_PARALLEL_SORT_MIN_ELEMENTS)
+    return FALSE;
+
+  /* Fill in all the values the sort functions read, so that the
+   * comparisons only read cached values. */
+  for (i = 1; i <= n_nodes; i++)
+    {
+      GtkTreeIter iter;
+
+      ITER_INIT_FROM_INDEX (model, &iter, i);
+      for (c = 0; c < model->n_sort_columns; c++)
+        {
+          if (!_gtk_file_system_model_get_value (model, &iter, model->sort_columns[c]))
+            return FALSE;
+        }
+    }
+
+  /* Sort indices, so the nodes stay in place for the comparisons */
+  indices = g_new (guint, n_nodes);
+  for (i = 0; i < n_nodes; i++)
+    indices[i] = i + 1;
+
+  gtk_parallel_sort (indices, n_nodes, sizeof (guint), compare_array_index, data);
+
+  nodes = g_memdup (get_node (model, 1), n_nodes * model->node_size);
+  for (i = 0; i < n_nodes; i++)
+    memcpy (get_node (model, i + 1),
+            nodes + (indices[i] - 1) * model->node_size,
+            model->node_size);
+
+  g_free (nodes);
+  g_free (indices);
+
+  return TRUE;
+}
+
 static void
 gtk_file_system_model_sort (GtkFileSystemModel *model)
 {
@@ -787,11 +850,12 @@ gtk_file_system_model_sort (GtkFileSystemModel *model)
       n_visible_rows = node_get_tree_row (model, model->files->len - 1) + 1;
       model->n_nodes_valid = 0;
       g_hash_table_remove_all (model->file_lookup);
-      g_qsort_with_data (get_node (model, 1), /* start at index 1; don't sort the editable row */
-                         model->files->len - 1,
-                         model->node_size,
-                         compare_array_element,
-                         &data);
+      if (!gtk_file_system_model_sort_parallel (model, &data))
+        g_qsort_with_data (get_node (model, 1), /* start at index 1; don't sort the editable row */
+                           model->files->len - 1,
+                           model->node_size,
+                           compare_array_element,
+                           &data);
       g_assert (model->n_nodes_valid == 0);
       g_assert (g_hash_table_size (model->file_lookup) == 0);
       if (n_visible_rows)
@@ -1074,6 +1138,7 @@ gtk_file_system_model_finalize (GObject *object)
   _gtk_tree_data_list_header_free (model->sort_list);
   if (model->default_sort_destroy)
     model->default_sort_destroy (model->default_sort_data);
+  g_free (model->sort_columns);
 
   G_OBJECT_CLASS (_gtk_file_system_model_parent_class)->finalize (object);
 }
@@ -2119,6 +2184,41 @@ _gtk_file_system_model_clear_cache (GtkFileSystemModel *model,
   /* FIXME: resort? */
 }
 
+/**
+ * _gtk_file_system_model_set_sort_columns:
+ * @model: a #GtkFileSystemModel
+ * @columns: (allow-none): the columns the sort functions read, or %NULL
+ * @n_columns: the number of elements in @columns
+ *
+ * Declares that all sort functions of @model are thread-safe: they only
+ * read the given @columns through _gtk_file_system_model_get_value()
+ * and don't touch anything that could change while sorting. Large
+ * directories are then sorted on several threads, after the values
+ * of these columns have been filled in for every file.
+ * Pass %NULL to sort on the main thread only, which is the default.
+ **/
+void
+_gtk_file_system_model_set_sort_columns (GtkFileSystemModel *model,
+                                         const int          *columns,
+                                         guint               n_columns)
+{
+  guint i;
+
+  g_return_if_fail (GTK_IS_FILE_SYSTEM_MODEL (model));
+  g_return_if_fail (columns != NULL || n_columns == 0);
+
+  for (i = 0; i < n_columns; i++)
+    g_return_if_fail (columns[i] >= 0 && (guint) columns[i] < model->n_columns);
+
+  g_free (model->sort_columns);
+
+  if (columns)
+    model->sort_columns = g_memdup (columns, n_columns * sizeof (int));
+  else
+    model->sort_columns = NULL;
+  model->n_sort_columns = n_columns;
+}
+
 /**
  * _gtk_file_system_model_add_and_query_file:
  * @model: a #GtkFileSystemModel
@@ -90,6 +90,9 @@ void                _gtk_file_system_model_set_filter_folders (GtkFileSystemMode
 							     gboolean            show_folders);
 void                _gtk_file_system_model_clear_cache      (GtkFileSystemModel *model,
                                                              int                 column);
+void                _gtk_file_system_model_set_sort_columns (GtkFileSystemModel *model,
+                                                             const int          *columns,
+                                                             guint               n_columns);
 
 void                _gtk_file_system_model_set_filter       (GtkFileSystemModel *model,
                                                              GtkFileFilter      *filter);
@@ -2323,6 +2323,210 @@ gtk_list_store_insert_with_valuesv (GtkListStore *list_store,
   gtk_tree_path_free (path);
 }
 
+/**
+ * gtk_list_store_insert_rows_with_valuesv:
+ * @list_store: A #GtkListStore
+ * @iter: (out) (allow-none): An unset #GtkTreeIter to set to the first
+ *     new row, or %NULL.
+ * @position: position to insert the new rows, or -1 to append them
+ * @n_rows: the number of rows to insert
+ * @columns: (array length=n_values): an array of column numbers
+ * @values: (array): an array of @n_rows times @n_values GValues, holding
+ *     the values of the first row, followed by those of the second
+ *     row, and so on
+ * @n_values: the length of the @columns array
+ *
+ * Inserts @n_rows rows at @position and fills them with @values,
+ * like calling gtk_list_store_insert_with_valuesv() @n_rows times.
+ *
+ * The rows are announced with a single #GtkTreeModel::rows-inserted
+ * signal, which allows views and proxy models to handle them in one
+ * pass. This is a lot faster when populating a store that is already
+ * connected to a view.
+ *
+ * If the list is sorted, the rows end up at their sorted positions
+ * and are announced one by one.
+ *
+ * Since: 3.22
+ */
+void
+gtk_list_store_insert_rows_with_valuesv (GtkListStore *list_store,
+					 GtkTreeIter  *iter,
+					 gint          position,
+					 gint          n_rows,
+					 gint         *columns,
+					 GValue       *values,
+					 gint          n_values)
+{
+  GtkListStorePrivate *priv;
+  GtkTreePath *path;
+  GSequenceIter *ptr;
+  GtkTreeIter first_iter, tmp_iter;
+  gint length, i;
+
+  g_return_if_fail (GTK_IS_LIST_STORE (list_store));
+  g_return_if_fail (n_rows >= 0);
+  g_return_if_fail (n_values == 0 || values != NULL);
+
+  priv = list_store->priv;
+
+  if (n_rows == 0)
+    return;
+
+  if (GTK_LIST_STORE_IS_SORTED (list_store))
+    {
+      for (i = 0; i < n_rows; i++)
+        gtk_list_store_insert_with_valuesv (list_store,
+                                            i == 0 ? iter : NULL,
+                                            position,
+                                            columns,
+                                            values + i * n_values,
+                                            n_values);
+      return;
+    }
+
+  priv->columns_dirty = TRUE;
+
+  length = g_sequence_get_length (priv->seq);
+  if (position > length || position < 0)
+    position = length;
+
+  ptr = g_sequence_get_iter_at_pos (priv->seq, position);
+
+  first_iter.stamp = priv->stamp;
+  first_iter.user_data = NULL;
+
+  for (i = 0; i < n_rows; i++)
+    {
+      gboolean changed = FALSE;
+      gboolean maybe_need_sort = FALSE;
+
+      tmp_iter.stamp = priv->stamp;
+      tmp_iter.user_data = g_sequence_insert_before (ptr, NULL);
+
+      if (i == 0)
+        first_iter = tmp_iter;
+
+      gtk_list_store_set_vector_internal (list_store, &tmp_iter,
+                                          &changed, &maybe_need_sort,
+                                          columns, values + i * n_values,
+                                          n_values);
+    }
+
+  priv->length += n_rows;
+
+  path = gtk_tree_path_new_from_indices (position, -1);
+  gtk_tree_model_rows_inserted (GTK_TREE_MODEL (list_store), path, &first_iter, n_rows);
+  gtk_tree_path_free (path);
+
+  if (iter)
+    *iter = first_iter;
+}
+
+/**
+ * gtk_list_store_replace_rows_with_valuesv:
+ * @list_store: A #GtkListStore
+ * @position: the position of the first row to replace
+ * @n_rows: the number of rows to replace
+ * @columns: (array length=n_values): an array of column numbers
+ * @values: (array): an array of @n_rows times @n_values GValues, holding
+ *     the new values of the first row, followed by those of the second
+ *     row, and so on
+ * @n_values: the length of the @columns array
+ *
+ * Sets the values of @n_rows consecutive rows starting at @position,
+ * like calling gtk_list_store_set_valuesv() on each of them, but
+ * without looking up every row separately.
+ *
+ * The values of all rows are set before #GtkTreeModel::row-changed is
+ * emitted for the rows that changed, once per row.
+ *
+ * If the list is sorted, the rows are set one by one and move to their
+ * sorted positions as they change.
+ *
+ * Since: 3.22
+ */
+void
+gtk_list_store_replace_rows_with_valuesv (GtkListStore *list_store,
+					  gint          position,
+					  gint          n_rows,
+					  gint         *columns,
+					  GValue       *values,
+					  gint          n_values)
+{
+  GtkListStorePrivate *priv;
+  GSequenceIter **rows;
+  GSequenceIter *ptr;
+  GtkTreePath *path;
+  GtkTreeIter iter;
+  gboolean *changed;
+  gint i;
+
+  g_return_if_fail (GTK_IS_LIST_STORE (list_store));
+  g_return_if_fail (position >= 0 && n_rows >= 0);
+  g_return_if_fail (position + n_rows <= g_sequence_get_length (list_store->priv->seq));
+  g_return_if_fail (n_values == 0 || values != NULL);
+
+  priv = list_store->priv;
+
+  if (n_rows == 0)
+    return;
+
+  /* Find all rows first, sorting may move them around */
+  rows = g_new (GSequenceIter *, n_rows);
+  ptr = g_sequence_get_iter_at_pos (priv->seq, position);
+  for (i = 0; i < n_rows; i++)
+    {
+      rows[i] = ptr;
+      ptr = g_sequence_iter_next (ptr);
+    }
+
+  iter.stamp = priv->stamp;
+
+  if (GTK_LIST_STORE_IS_SORTED (list_store))
+    {
+      for (i = 0; i < n_rows; i++)
+        {
+          iter.user_data = rows[i];
+          gtk_list_store_set_valuesv (list_store, &iter, columns,
+                                      values + i * n_values, n_values);
+        }
+
+      g_free (rows);
+      return;
+    }
+
+  changed = g_new0 (gboolean, n_rows);
+  for (i = 0; i < n_rows; i++)
+    {
+      gboolean maybe_need_sort = FALSE;
+
+      iter.user_data = rows[i];
+      gtk_list_store_set_vector_internal (list_store, &iter,
+                                          &changed[i], &maybe_need_sort,
+                                          columns, values + i * n_values,
+                                          n_values);
+    }
+  g_free (rows);
+
+  /* Handlers may change the store, so look the rows up by path */
+  path = gtk_tree_path_new_from_indices (position, -1);
+  for (i = 0; i < n_rows; i++)
+    {
+      if (changed[i])
+        {
+          if (!gtk_list_store_get_iter (GTK_TREE_MODEL (list_store), &iter, path))
+            break;
+
+          gtk_tree_model_row_changed (GTK_TREE_MODEL (list_store), path, &iter);
+        }
+
+      gtk_tree_path_next (path);
+    }
+  gtk_tree_path_free (path);
+  g_free (changed);
+}
+
 /* GtkBuildable custom tag implementation
  *
  * <columns>
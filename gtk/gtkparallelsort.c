@@ -0,0 +1,254 @@
+/* GTK - The GIMP Toolkit
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gtkparallelsortprivate.h"
+
+#include <string.h>
+
+/* The most pieces a sort is split into. Each piece is sorted on its
+ * own thread, then the pieces are merged pairwise.
+ */
+#define MAX_PIECES 16
+
+typedef struct _SortJob SortJob;
+typedef struct _SortTask SortTask;
+
+struct _SortJob
+{
+  gsize            element_size;
+  GCompareDataFunc compare_func;
+  gpointer         user_data;
+
+  GMutex           mutex;
+  GCond            cond;
+  guint            n_pending;
+};
+
+struct _SortTask
+{
+  SortJob     *job;
+  const gchar *src;
+  gchar       *dest;    /* NULL to sort the range of src in place */
+  gsize        start;
+  gsize        middle;
+  gsize        end;
+};
+
+static void
+sort_task_run (SortTask *task)
+{
+  SortJob *job = task->job;
+  gsize size = job->element_size;
+  const gchar *left, *left_end, *right, *right_end;
+  gchar *out;
+
+  if (task->dest == NULL)
+    {
+      g_qsort_with_data (task->src + task->start * size,
+                         task->end - task->start,
+                         size,
+                         job->compare_func,
+                         job->user_data);
+      return;
+    }
+
+  left = task->src + task->start * size;
+  left_end = right = task->src + task->middle * size;
+  right_end = task->src + task->end * size;
+  out = task->dest + task->start * size;
+
+  while (left < left_end && right < right_end)
+    {
+      /* Take from the left on ties, so the sort stays stable */
+      if (job->compare_func (right, left, job->user_data) < 0)
+        {
+          memcpy (out, right, size);
+          right += size;
+        }
+      else
+        {
+          memcpy (out, left, size);
+          left += size;
+        }
+      out += size;
+    }
+
+  memcpy (out, left, left_end - left);
+  out += left_end - left;
+  memcpy (out, right, right_end - right);
+}
+
+static void
+sort_task_func (gpointer data,
+                gpointer user_data)
+{
+  SortTask *task = data;
+  SortJob *job = task->job;
+
+  sort_task_run (task);
+
+  g_mutex_lock (&job->mutex);
+  job->n_pending--;
+  if (job->n_pending == 0)
+    g_cond_signal (&job->cond);
+  g_mutex_unlock (&job->mutex);
+}
+
+static GThreadPool *
+get_thread_pool (void)
+{
+  static gsize pool = 0;
+
+  if (g_once_init_enter (&pool))
+    {
+      GThreadPool *new_pool;
+
+      new_pool = g_thread_pool_new (sort_task_func, NULL,
+                                    MAX (g_get_num_processors () - 1, 1),
+                                    FALSE, NULL);
+      g_once_init_leave (&pool, (gsize) new_pool);
+    }
+
+  return (GThreadPool *) pool;
+}
+
+/* Runs the first task on the calling thread and the others on the
+ * thread pool, and returns once all of them are done.
+ */
+static void
+run_tasks (SortJob  *job,
+           SortTask *tasks,
+           guint     n_tasks)
+{
+  GThreadPool *pool = get_thread_pool ();
+  guint i;
+
+  job->n_pending = n_tasks - 1;
+
+  for (i = 1; i < n_tasks; i++)
+    {
+      if (!g_thread_pool_push (pool, &tasks[i], NULL))
+        sort_task_func (&tasks[i], NULL);
+    }
+
+  sort_task_run (&tasks[0]);
+
+  g_mutex_lock (&job->mutex);
+  while (job->n_pending > 0)
+    g_cond_wait (&job->cond, &job->mutex);
+  g_mutex_unlock (&job->mutex);
+}
+
+/*
+ * gtk_parallel_sort:
+ * @base: start of the array to sort
+ * @n_elements: number of elements in the array
+ * @element_size: size of one element
+ * @compare_func: function to compare two elements
+ * @user_data: data to pass to @compare_func
+ *
+ * Sorts an array like g_qsort_with_data() and gives the same, stable
+ * result. Large arrays are split into pieces that are sorted on a
+ * thread pool and merged afterwards.
+ *
+ * @compare_func is called from several threads at once, so it must
+ * not modify anything and may only read data that no other thread
+ * modifies while the sort is running. In particular, it must not
+ * call into GTK or compute values lazily.
+ */
+void
+gtk_parallel_sort (gpointer         base,
+                   gsize            n_elements,
+                   gsize            element_size,
+                   GCompareDataFunc compare_func,
+                   gpointer         user_data)
+{
+  SortJob job;
+  SortTask tasks[MAX_PIECES];
+  gsize bounds[MAX_PIECES + 1];
+  guint n_pieces, i;
+  gchar *buffer, *src, *dest, *tmp;
+
+  n_pieces = CLAMP (g_get_num_processors (), 1, MAX_PIECES);
+
+  if (n_elements < GTK_PARALLEL_SORT_MIN_ELEMENTS || n_pieces < 2)
+    {
+      g_qsort_with_data (base, n_elements, element_size,
+                         compare_func, user_data);
+      return;
+    }
+
+  job.element_size = element_size;
+  job.compare_func = compare_func;
+  job.user_data = user_data;
+  g_mutex_init (&job.mutex);
+  g_cond_init (&job.cond);
+
+  for (i = 0; i <= n_pieces; i++)
+    bounds[i] = n_elements * i / n_pieces;
+
+  for (i = 0; i < n_pieces; i++)
+    {
+      tasks[i].job = &job;
+      tasks[i].src = base;
+      tasks[i].dest = NULL;
+      tasks[i].start = bounds[i];
+      tasks[i].middle = bounds[i];
+      tasks[i].end = bounds[i + 1];
+    }
+
+  run_tasks (&job, tasks, n_pieces);
+
+  buffer = g_malloc (n_elements * element_size);
+  src = base;
+  dest = buffer;
+
+  while (n_pieces > 1)
+    {
+      guint n_tasks = 0;
+
+      /* An odd piece at the end is merged with nothing, i.e. copied */
+      for (i = 0; i < n_pieces; i += 2)
+        {
+          tasks[n_tasks].job = &job;
+          tasks[n_tasks].src = src;
+          tasks[n_tasks].dest = dest;
+          tasks[n_tasks].start = bounds[i];
+          tasks[n_tasks].middle = bounds[MIN (i + 1, n_pieces)];
+          tasks[n_tasks].end = bounds[MIN (i + 2, n_pieces)];
+
+          bounds[n_tasks] = bounds[i];
+          n_tasks++;
+        }
+      bounds[n_tasks] = n_elements;
+
+      run_tasks (&job, tasks, n_tasks);
+
+      n_pieces = n_tasks;
+      tmp = src;
+      src = dest;
+      dest = tmp;
+    }
+
+  if (src != base)
+    memcpy (base, src, n_elements * element_size);
+
+  g_free (buffer);
+  g_mutex_clear (&job.mutex);
+  g_cond_clear (&job.cond);
+}
@@ -0,0 +1,35 @@
+/* GTK - The GIMP Toolkit
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GTK_PARALLEL_SORT_PRIVATE_H__
+#define __GTK_PARALLEL_SORT_PRIVATE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Below this many elements, sorting is not worth splitting up */
+#define GTK_PARALLEL_SORT_MIN_ELEMENTS 16384
+
+void gtk_parallel_sort (gpointer         base,
+                        gsize            n_elements,
+                        gsize            element_size,
+                        GCompareDataFunc compare_func,
+                        gpointer         user_data);
+
+G_END_DECLS
+
+#endif /* __GTK_PARALLEL_SORT_PRIVATE_H__ */
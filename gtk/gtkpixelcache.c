@@ -22,31 +22,47 @@
 #include "gtkpixelcacheprivate.h"
 #include "gtkrenderbackgroundprivate.h"
 #include "gtkstylecontextprivate.h"
+#include "gdk/gdk-private.h"
 
 #define BLOW_CACHE_TIMEOUT_SEC 20
 
-/* The extra size of the offscreen surface we allocate
+/* The extra size of the offscreen area we keep around the view
    to make scrolling more efficient */
 #define DEFAULT_EXTRA_SIZE 64
 
-/* When resizing viewport we allow this extra
-   size to avoid constantly reallocating when resizing */
-#define ALLOW_SMALLER_SIZE_FACTOR 0.5
-#define ALLOW_LARGER_SIZE_FACTOR  1.25
+/* The canvas is cached in square tiles of this size */
+#define TILE_SIZE 256
+
+/* Number of tiles we keep besides the ones needed for the current
+   view, so that scrolling back to recently viewed content is fast */
+#define MAX_RETAINED_TILES 24
+
+typedef struct _GtkPixelCacheTile GtkPixelCacheTile;
+
+struct _GtkPixelCacheTile {
+  /* Position of the tile in the canvas, in units of TILE_SIZE */
+  int x;
+  int y;
 
-struct _GtkPixelCache {
   cairo_surface_t *surface;
-  cairo_content_t content;
 
-  /* Valid if surface != NULL */
-  int surface_x;
-  int surface_y;
-  int surface_w;
-  int surface_h;
-  double surface_scale;
+  /* In tile coordinates, may be null if not dirty */
+  cairo_region_t *dirty;
+
+  GList lru_link;
+};
 
-  /* may be null if not dirty */
-  cairo_region_t *surface_dirty;
+struct _GtkPixelCache {
+  /* GtkPixelCacheTile, keyed by position */
+  GHashTable *tiles;
+  /* Most recently used first */
+  GQueue lru;
+
+  cairo_content_t content;
+
+  /* Valid if there are tiles */
+  cairo_content_t tile_content;
+  double tile_scale;
 
   GSource *timeout_source;
 
@@ -57,12 +73,60 @@ struct _GtkPixelCache {
   guint is_opaque : 1;
 };
 
+static guint
+gtk_pixel_cache_tile_hash (gconstpointer data)
+{
+  const GtkPixelCacheTile *tile = data;
+
+  return (guint) tile->x * 31 + (guint) tile->y;
+}
+
+static gboolean
+gtk_pixel_cache_tile_equal (gconstpointer data1,
+                            gconstpointer data2)
+{
+  const GtkPixelCacheTile *tile1 = data1;
+  const GtkPixelCacheTile *tile2 = data2;
+
+  return tile1->x == tile2->x && tile1->y == tile2->y;
+}
+
+static void
+gtk_pixel_cache_tile_get_rect (GtkPixelCacheTile     *tile,
+                               cairo_rectangle_int_t *rect)
+{
+  rect->x = tile->x * TILE_SIZE;
+  rect->y = tile->y * TILE_SIZE;
+  rect->width = TILE_SIZE;
+  rect->height = TILE_SIZE;
+}
+
+static void
+gtk_pixel_cache_remove_tile (GtkPixelCache     *cache,
+                             GtkPixelCacheTile *tile)
+{
+  g_queue_unlink (&cache->lru, &tile->lru_link);
+  g_hash_table_remove (cache->tiles, tile);
+
+  cairo_surface_destroy (tile->surface);
+  g_clear_pointer (&tile->dirty, cairo_region_destroy);
+  g_slice_free (GtkPixelCacheTile, tile);
+}
+
+static void
+gtk_pixel_cache_remove_all_tiles (GtkPixelCache *cache)
+{
+  while (cache->lru.tail)
+    gtk_pixel_cache_remove_tile (cache, cache->lru.tail->data);
+}
+
 GtkPixelCache *
 _gtk_pixel_cache_new ()
 {
   GtkPixelCache *cache;
 
   cache = g_new0 (GtkPixelCache, 1);
+  cache->tiles = g_hash_table_new (gtk_pixel_cache_tile_hash, gtk_pixel_cache_tile_equal);
   cache->extra_width = DEFAULT_EXTRA_SIZE;
   cache->extra_height = DEFAULT_EXTRA_SIZE;
 
@@ -76,16 +140,15 @@ _gtk_pixel_cache_free (GtkPixelCache *cache)
     return;
 
   if (cache->timeout_source ||
-      cache->surface ||
-      cache->surface_dirty)
+      cache->lru.length > 0)
     {
-      g_warning ("pixel cache freed that wasn't unmapped: tag %u surface %p dirty %p",
-                 g_source_get_id (cache->timeout_source), cache->surface, cache->surface_dirty);
+      g_warning ("pixel cache freed that wasn't unmapped: tag %u tiles %u",
+                 g_source_get_id (cache->timeout_source), cache->lru.length);
     }
 
   g_clear_pointer (&cache->timeout_source, g_source_destroy);
-  g_clear_pointer (&cache->surface, cairo_surface_destroy);
-  g_clear_pointer (&cache->surface_dirty, cairo_region_destroy);
+  gtk_pixel_cache_remove_all_tiles (cache);
+  g_hash_table_unref (cache->tiles);
 
   g_free (cache);
 }
@@ -125,65 +188,73 @@ _gtk_pixel_cache_invalidate (GtkPixelCache  *cache,
                              cairo_region_t *region)
 {
   cairo_rectangle_int_t r;
-  cairo_region_t *free_region = NULL;
+  GList *l;
 
-  if (cache->surface == NULL ||
+  if (cache->lru.length == 0 ||
       (region != NULL && cairo_region_is_empty (region)))
     return;
 
-  if (region == NULL)
+  for (l = cache->lru.head; l; l = l->next)
     {
-      r.x = cache->surface_x;
-      r.y = cache->surface_y;
-      r.width = cache->surface_w;
-      r.height = cache->surface_h;
+      GtkPixelCacheTile *tile = l->data;
+      cairo_region_t *tile_region;
 
-      free_region = region =
-        cairo_region_create_rectangle (&r);
-    }
+      gtk_pixel_cache_tile_get_rect (tile, &r);
 
-  if (cache->surface_dirty == NULL)
-    {
-      cache->surface_dirty = cairo_region_copy (region);
-      cairo_region_translate (cache->surface_dirty,
-                              -cache->surface_x,
-                              -cache->surface_y);
-    }
-  else
-    {
-      cairo_region_translate (region,
-                              -cache->surface_x,
-                              -cache->surface_y);
-      cairo_region_union (cache->surface_dirty, region);
-      cairo_region_translate (region,
-                              cache->surface_x,
-                              cache->surface_y);
-    }
+      if (region == NULL)
+        {
+          tile_region = cairo_region_create_rectangle (&r);
+        }
+      else
+        {
+          if (cairo_region_contains_rectangle (region, &r) == CAIRO_REGION_OVERLAP_OUT)
+            continue;
 
-  if (free_region)
-    cairo_region_destroy (free_region);
+          tile_region = cairo_region_copy (region);
+          cairo_region_intersect_rectangle (tile_region, &r);
+        }
+
+      cairo_region_translate (tile_region, -r.x, -r.y);
+
+      if (tile->dirty == NULL)
+        {
+          tile->dirty = tile_region;
+        }
+      else
+        {
+          cairo_region_union (tile->dirty, tile_region);
+          cairo_region_destroy (tile_region);
+        }
+    }
+}
 
-  r.x = 0;
-  r.y = 0;
-  r.width = cache->surface_w;
-  r.height = cache->surface_h;
+static inline int
+tile_index (int coord)
+{
+  /* Round towards negative infinity */
+  if (coord < 0)
+    return -((-coord + TILE_SIZE - 1) / TILE_SIZE);
 
-  cairo_region_intersect_rectangle (cache->surface_dirty, &r);
+  return coord / TILE_SIZE;
 }
 
-static void
-_gtk_pixel_cache_create_surface_if_needed (GtkPixelCache         *cache,
-                                           GdkWindow             *window,
-                                           cairo_rectangle_int_t *view_rect,
-                                           cairo_rectangle_int_t *canvas_rect)
+/* Computes the area of the canvas that should be cached, that is the
+ * visible part plus some extra size for scrolling. Returns FALSE if
+ * the view should not be cached at all.
+ */
+static gboolean
+_gtk_pixel_cache_get_cached_area (GtkPixelCache         *cache,
+                                  GdkWindow             *window,
+                                  cairo_rectangle_int_t *view_rect,
+                                  cairo_rectangle_int_t *canvas_rect,
+                                  cairo_rectangle_int_t *area)
 {
-  cairo_rectangle_int_t rect;
-  int surface_w, surface_h;
+  cairo_rectangle_int_t bounds;
   cairo_content_t content;
 
 #ifdef G_ENABLE_DEBUG
   if (GTK_DISPLAY_DEBUG_CHECK (gdk_window_get_display (window), NO_PIXEL_CACHE))
-    return;
+    return FALSE;
 #endif
 
   content = cache->content;
@@ -195,199 +266,232 @@ _gtk_pixel_cache_create_surface_if_needed (GtkPixelCache         *cache,
         content = CAIRO_CONTENT_COLOR_ALPHA;
     }
 
-  surface_w = view_rect->width;
-  if (canvas_rect->width > surface_w)
-    surface_w = MIN (surface_w + cache->extra_width, canvas_rect->width);
-
-  surface_h = view_rect->height;
-  if (canvas_rect->height > surface_h)
-    surface_h = MIN (surface_h + cache->extra_height, canvas_rect->height);
-
-  /* If current surface can't fit view_rect or is too large, kill it */
-  if (cache->surface != NULL &&
-      (cairo_surface_get_content (cache->surface) != content ||
-       cache->surface_w < MAX(view_rect->width, surface_w * ALLOW_SMALLER_SIZE_FACTOR) ||
-       cache->surface_w > surface_w * ALLOW_LARGER_SIZE_FACTOR ||
-       cache->surface_h < MAX(view_rect->height, surface_h * ALLOW_SMALLER_SIZE_FACTOR) ||
-       cache->surface_h > surface_h * ALLOW_LARGER_SIZE_FACTOR ||
-       cache->surface_scale != gdk_window_get_scale_factor (window)))
-    {
-      cairo_surface_destroy (cache->surface);
-      cache->surface = NULL;
-      if (cache->surface_dirty)
-        cairo_region_destroy (cache->surface_dirty);
-      cache->surface_dirty = NULL;
-    }
+  /* If the tiles don't fit the window anymore, kill them */
+  if (cache->lru.length > 0 &&
+      (cache->tile_content != content ||
+       cache->tile_scale != gdk_window_get_scale_factor (window)))
+    gtk_pixel_cache_remove_all_tiles (cache);
+
+  cache->tile_content = content;
+  cache->tile_scale = gdk_window_get_scale_factor (window);
 
-  /* Don't allocate a surface if view >= canvas, as we won't
+  /* Don't cache if view >= canvas, as we won't
    * be scrolling then anyway, unless the widget requested it.
    */
-  if (cache->surface == NULL &&
-      (cache->always_cache ||
-       (view_rect->width < canvas_rect->width ||
-        view_rect->height < canvas_rect->height)))
+  if (!cache->always_cache &&
+      view_rect->width >= canvas_rect->width &&
+      view_rect->height >= canvas_rect->height)
+    {
+      gtk_pixel_cache_remove_all_tiles (cache);
+      return FALSE;
+    }
+
+  /* Position of view inside canvas */
+  area->x = -canvas_rect->x;
+  area->y = -canvas_rect->y;
+  area->width = view_rect->width;
+  area->height = view_rect->height;
+
+  /* Cache the whole view, even where it is larger than the canvas */
+  bounds.x = 0;
+  bounds.y = 0;
+  bounds.width = canvas_rect->width;
+  bounds.height = canvas_rect->height;
+  gdk_rectangle_union (area, &bounds, &bounds);
+
+  if (canvas_rect->width > view_rect->width)
     {
-      cache->surface_x = -canvas_rect->x;
-      cache->surface_y = -canvas_rect->y;
-      cache->surface_w = surface_w;
-      cache->surface_h = surface_h;
-      cache->surface_scale = gdk_window_get_scale_factor (window);
-
-      cache->surface =
-        gdk_window_create_similar_surface (window, content,
-                                           surface_w, surface_h);
-      rect.x = 0;
-      rect.y = 0;
-      rect.width = surface_w;
-      rect.height = surface_h;
-      cache->surface_dirty =
-        cairo_region_create_rectangle (&rect);
+      area->x -= cache->extra_width / 2;
+      area->width += cache->extra_width;
     }
+  if (canvas_rect->height > view_rect->height)
+    {
+      area->y -= cache->extra_height / 2;
+      area->height += cache->extra_height;
+    }
+
+  return gdk_rectangle_intersect (area, &bounds, area);
 }
 
+/* Repaints the dirty parts of @dirty_tiles. The draw function is
+ * called only once, clipped to the union of the dirty regions, and the
+ * result is copied into the tiles, since drawing the canvas is usually
+ * much more expensive than the copies.
+ */
 static void
-_gtk_pixel_cache_set_position (GtkPixelCache         *cache,
-                               cairo_rectangle_int_t *view_rect,
-                               cairo_rectangle_int_t *canvas_rect)
+_gtk_pixel_cache_repaint_tiles (GtkPixelCache         *cache,
+                                GPtrArray             *dirty_tiles,
+                                GdkWindow             *window,
+                                GtkPixelCacheDrawFunc  draw,
+                                cairo_rectangle_int_t *view_rect,
+                                cairo_rectangle_int_t *canvas_rect,
+                                gpointer               user_data)
 {
-  cairo_rectangle_int_t r, view_pos;
-  cairo_region_t *copy_region;
-  int new_surf_x, new_surf_y;
+  cairo_rectangle_int_t extents;
+  cairo_region_t *region;
+  cairo_surface_t *surface;
   cairo_t *backing_cr;
+  gint64 start_time;
+  guint i;
 
-  if (cache->surface == NULL)
-    return;
-
-  /* Position of view inside canvas */
-  view_pos.x = -canvas_rect->x;
-  view_pos.y = -canvas_rect->y;
-  view_pos.width = view_rect->width;
-  view_pos.height = view_rect->height;
-
-  /* Reposition so all is visible */
-  if (view_pos.x < cache->surface_x ||
-      view_pos.x + view_pos.width > cache->surface_x + cache->surface_w ||
-      view_pos.y < cache->surface_y ||
-      view_pos.y + view_pos.height > cache->surface_y + cache->surface_h)
+  /* The dirty regions are in tile coordinates, collect them in canvas
+   * coordinates */
+  region = cairo_region_create ();
+  for (i = 0; i < dirty_tiles->len; i++)
     {
-      new_surf_x = cache->surface_x;
-      if (view_pos.x < cache->surface_x)
-        new_surf_x = MAX (view_pos.x + view_pos.width - cache->surface_w, 0);
-      else if (view_pos.x + view_pos.width >
-               cache->surface_x + cache->surface_w)
-        new_surf_x = MIN (view_pos.x, canvas_rect->width - cache->surface_w);
-
-      new_surf_y = cache->surface_y;
-      if (view_pos.y < cache->surface_y)
-        new_surf_y = MAX (view_pos.y + view_pos.height - cache->surface_h, 0);
-      else if (view_pos.y + view_pos.height >
-               cache->surface_y + cache->surface_h)
-        new_surf_y = MIN (view_pos.y, canvas_rect->height - cache->surface_h);
-
-      r.x = 0;
-      r.y = 0;
-      r.width = cache->surface_w;
-      r.height = cache->surface_h;
-      copy_region = cairo_region_create_rectangle (&r);
-
-      if (cache->surface_dirty)
-        {
-          cairo_region_subtract (copy_region, cache->surface_dirty);
-          cairo_region_destroy (cache->surface_dirty);
-          cache->surface_dirty = NULL;
-        }
+      GtkPixelCacheTile *tile = g_ptr_array_index (dirty_tiles, i);
 
-      cairo_region_translate (copy_region,
-                              cache->surface_x - new_surf_x,
-                              cache->surface_y - new_surf_y);
-      cairo_region_intersect_rectangle (copy_region, &r);
-
-      backing_cr = cairo_create (cache->surface);
-      gdk_cairo_region (backing_cr, copy_region);
-      cairo_set_operator (backing_cr, CAIRO_OPERATOR_SOURCE);
-      cairo_clip (backing_cr);
-      cairo_push_group (backing_cr);
-      cairo_set_source_surface (backing_cr, cache->surface,
-                                cache->surface_x - new_surf_x,
-                                cache->surface_y - new_surf_y);
-      cairo_paint (backing_cr);
-      cairo_pop_group_to_source (backing_cr);
+      cairo_region_translate (tile->dirty, tile->x * TILE_SIZE, tile->y * TILE_SIZE);
+      cairo_region_union (region, tile->dirty);
+      cairo_region_translate (tile->dirty, -tile->x * TILE_SIZE, -tile->y * TILE_SIZE);
+    }
+
+  if (cairo_region_is_empty (region))
+    goto out;
+
+  start_time = g_get_monotonic_time ();
+
+  cairo_region_get_extents (region, &extents);
+  surface = gdk_window_create_similar_surface (window, cache->tile_content,
+                                               extents.width, extents.height);
+
+  backing_cr = cairo_create (surface);
+  cairo_translate (backing_cr, -extents.x, -extents.y);
+  gdk_cairo_region (backing_cr, region);
+  cairo_clip (backing_cr);
+  cairo_translate (backing_cr,
+                   -canvas_rect->x - view_rect->x,
+                   -canvas_rect->y - view_rect->y);
+
+  cairo_save (backing_cr);
+  draw (backing_cr, user_data);
+  cairo_restore (backing_cr);
+
+#ifdef G_ENABLE_DEBUG
+  if (GTK_DISPLAY_DEBUG_CHECK (gdk_window_get_display (window), PIXEL_CACHE))
+    {
+      GdkRGBA colors[] = {
+        { 1, 0, 0, 0.08},
+        { 0, 1, 0, 0.08},
+        { 0, 0, 1, 0.08},
+        { 1, 0, 1, 0.08},
+        { 1, 1, 0, 0.08},
+        { 0, 1, 1, 0.08},
+      };
+      static int current_color = 0;
+
+      gdk_cairo_set_source_rgba (backing_cr, &colors[(current_color++) % G_N_ELEMENTS (colors)]);
       cairo_paint (backing_cr);
-      cairo_destroy (backing_cr);
+    }
+#endif
+
+  cairo_destroy (backing_cr);
+
+  for (i = 0; i < dirty_tiles->len; i++)
+    {
+      GtkPixelCacheTile *tile = g_ptr_array_index (dirty_tiles, i);
+      cairo_t *tile_cr;
+
+      tile_cr = cairo_create (tile->surface);
+      gdk_cairo_region (tile_cr, tile->dirty);
+      cairo_clip (tile_cr);
+      cairo_set_operator (tile_cr, CAIRO_OPERATOR_SOURCE);
+      cairo_set_source_surface (tile_cr, surface,
+                                extents.x - tile->x * TILE_SIZE,
+                                extents.y - tile->y * TILE_SIZE);
+      cairo_paint (tile_cr);
+      cairo_destroy (tile_cr);
+    }
+
+  cairo_surface_destroy (surface);
 
-      cache->surface_x = new_surf_x;
-      cache->surface_y = new_surf_y;
+  if (GDK_PRIVATE_CALL (gdk_frame_recorder_is_enabled) ())
+    GDK_PRIVATE_CALL (gdk_frame_recorder_add) ("pixel-cache", "repaint",
+                                               start_time, g_get_monotonic_time ());
 
-      cairo_region_xor_rectangle (copy_region, &r);
-      cache->surface_dirty = copy_region;
+ out:
+  for (i = 0; i < dirty_tiles->len; i++)
+    {
+      GtkPixelCacheTile *tile = g_ptr_array_index (dirty_tiles, i);
+
+      g_clear_pointer (&tile->dirty, cairo_region_destroy);
     }
+
+  cairo_region_destroy (region);
 }
 
+/* Makes sure all tiles covering @area exist and are up to date, and
+ * drops the least recently used tiles beyond what we want to keep.
+ */
 static void
-_gtk_pixel_cache_repaint (GtkPixelCache         *cache,
-                          GdkWindow             *window,
-                          GtkPixelCacheDrawFunc  draw,
-                          cairo_rectangle_int_t *view_rect,
-                          cairo_rectangle_int_t *canvas_rect,
-                          gpointer               user_data)
+_gtk_pixel_cache_update_tiles (GtkPixelCache         *cache,
+                               GdkWindow             *window,
+                               cairo_rectangle_int_t *area,
+                               GtkPixelCacheDrawFunc  draw,
+                               cairo_rectangle_int_t *view_rect,
+                               cairo_rectangle_int_t *canvas_rect,
+                               gpointer               user_data)
 {
-  cairo_t *backing_cr;
-  cairo_region_t *region_dirty = cache->surface_dirty;
-  cache->surface_dirty = NULL;
+  cairo_rectangle_int_t tile_rect = { 0, 0, TILE_SIZE, TILE_SIZE };
+  GPtrArray *dirty_tiles;
+  int x, y, x1, y1, x2, y2;
+  guint n_needed;
 
-  if (cache->surface &&
-      region_dirty &&
-      !cairo_region_is_empty (region_dirty))
-    {
-      backing_cr = cairo_create (cache->surface);
-      gdk_cairo_region (backing_cr, region_dirty);
-      cairo_clip (backing_cr);
-      cairo_translate (backing_cr,
-                       -cache->surface_x - canvas_rect->x - view_rect->x,
-                       -cache->surface_y - canvas_rect->y - view_rect->y);
-
-      cairo_save (backing_cr);
-      cairo_set_source_rgba (backing_cr,
-                             0.0, 0, 0, 0.0);
-      cairo_set_operator (backing_cr, CAIRO_OPERATOR_SOURCE);
-      cairo_paint (backing_cr);
-      cairo_restore (backing_cr);
+  x1 = tile_index (area->x);
+  y1 = tile_index (area->y);
+  x2 = tile_index (area->x + area->width - 1);
+  y2 = tile_index (area->y + area->height - 1);
 
-      cairo_save (backing_cr);
-      draw (backing_cr, user_data);
-      cairo_restore (backing_cr);
+  dirty_tiles = g_ptr_array_new ();
 
-#ifdef G_ENABLE_DEBUG
-      if (GTK_DISPLAY_DEBUG_CHECK (gdk_window_get_display (window), PIXEL_CACHE))
+  for (y = y1; y <= y2; y++)
+    {
+      for (x = x1; x <= x2; x++)
         {
-          GdkRGBA colors[] = {
-            { 1, 0, 0, 0.08},
-            { 0, 1, 0, 0.08},
-            { 0, 0, 1, 0.08},
-            { 1, 0, 1, 0.08},
-            { 1, 1, 0, 0.08},
-            { 0, 1, 1, 0.08},
-          };
-          static int current_color = 0;
-
-          gdk_cairo_set_source_rgba (backing_cr, &colors[(current_color++) % G_N_ELEMENTS (colors)]);
-          cairo_paint (backing_cr);
+          GtkPixelCacheTile key, *tile;
+
+          key.x = x;
+          key.y = y;
+          tile = g_hash_table_lookup (cache->tiles, &key);
+
+          if (tile)
+            {
+              g_queue_unlink (&cache->lru, &tile->lru_link);
+            }
+          else
+            {
+              tile = g_slice_new0 (GtkPixelCacheTile);
+              tile->x = x;
+              tile->y = y;
+              tile->lru_link.data = tile;
+              tile->surface = gdk_window_create_similar_surface (window, cache->tile_content,
+                                                                 TILE_SIZE, TILE_SIZE);
+              tile->dirty = cairo_region_create_rectangle (&tile_rect);
+              g_hash_table_add (cache->tiles, tile);
+            }
+
+          g_queue_push_head_link (&cache->lru, &tile->lru_link);
+
+          if (tile->dirty)
+            g_ptr_array_add (dirty_tiles, tile);
         }
-#endif
-
-      cairo_destroy (backing_cr);
     }
 
-  if (region_dirty)
-    cairo_region_destroy (region_dirty);
+  if (dirty_tiles->len > 0)
+    _gtk_pixel_cache_repaint_tiles (cache, dirty_tiles, window, draw,
+                                    view_rect, canvas_rect, user_data);
+  g_ptr_array_unref (dirty_tiles);
+
+  n_needed = (x2 - x1 + 1) * (y2 - y1 + 1);
+  while (cache->lru.length > n_needed + MAX_RETAINED_TILES)
+    gtk_pixel_cache_remove_tile (cache, cache->lru.tail->data);
 }
 
 static void
 gtk_pixel_cache_blow_cache (GtkPixelCache *cache)
 {
   g_clear_pointer (&cache->timeout_source, g_source_destroy);
-  g_clear_pointer (&cache->surface, cairo_surface_destroy);
-  g_clear_pointer (&cache->surface_dirty, cairo_region_destroy);
+  gtk_pixel_cache_remove_all_tiles (cache);
 }
 
 static gboolean
@@ -425,6 +529,9 @@ _gtk_pixel_cache_draw (GtkPixelCache         *cache,
                        GtkPixelCacheDrawFunc  draw,
                        gpointer               user_data)
 {
+  cairo_rectangle_int_t area;
+  cairo_surface_t *surface = NULL;
+
   if (cache->timeout_source)
     {
       gint64 deadline;
@@ -441,23 +548,46 @@ _gtk_pixel_cache_draw (GtkPixelCache         *cache,
       g_source_set_name (cache->timeout_source, "[gtk+] blow_cache_cb");
     }
 
-  _gtk_pixel_cache_create_surface_if_needed (cache, window,
-                                             view_rect, canvas_rect);
-  _gtk_pixel_cache_set_position (cache, view_rect, canvas_rect);
-  _gtk_pixel_cache_repaint (cache, window, draw, view_rect, canvas_rect, user_data);
+  if (_gtk_pixel_cache_get_cached_area (cache, window, view_rect, canvas_rect, &area))
+    {
+      _gtk_pixel_cache_update_tiles (cache, window, &area, draw,
+                                     view_rect, canvas_rect, user_data);
+      surface = ((GtkPixelCacheTile *) cache->lru.head->data)->surface;
+    }
 
-  if (cache->surface && context_is_unscaled (cr) &&
+  if (surface && context_is_unscaled (cr) &&
       /* Don't use backing surface if rendering elsewhere */
-      cairo_surface_get_type (cache->surface) == cairo_surface_get_type (cairo_get_target (cr)))
+      cairo_surface_get_type (surface) == cairo_surface_get_type (cairo_get_target (cr)))
     {
-      cairo_save (cr);
-      cairo_set_source_surface (cr, cache->surface,
-                                cache->surface_x + view_rect->x + canvas_rect->x,
-                                cache->surface_y + view_rect->y + canvas_rect->y);
-      cairo_rectangle (cr, view_rect->x, view_rect->y,
-                       view_rect->width, view_rect->height);
-      cairo_fill (cr);
-      cairo_restore (cr);
+      cairo_rectangle_int_t view_pos;
+      GList *l;
+
+      /* Position of view inside canvas */
+      view_pos.x = -canvas_rect->x;
+      view_pos.y = -canvas_rect->y;
+      view_pos.width = view_rect->width;
+      view_pos.height = view_rect->height;
+
+      for (l = cache->lru.head; l; l = l->next)
+        {
+          GtkPixelCacheTile *tile = l->data;
+          cairo_rectangle_int_t r;
+
+          gtk_pixel_cache_tile_get_rect (tile, &r);
+          if (!gdk_rectangle_intersect (&r, &view_pos, &r))
+            continue;
+
+          cairo_save (cr);
+          cairo_set_source_surface (cr, tile->surface,
+                                    tile->x * TILE_SIZE + view_rect->x + canvas_rect->x,
+                                    tile->y * TILE_SIZE + view_rect->y + canvas_rect->y);
+          cairo_rectangle (cr,
+                           r.x + view_rect->x + canvas_rect->x,
+                           r.y + view_rect->y + canvas_rect->y,
+                           r.width, r.height);
+          cairo_fill (cr);
+          cairo_restore (cr);
+        }
     }
   else
     {
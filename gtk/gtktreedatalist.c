@@ -570,3 +570,31 @@ _gtk_tree_data_list_set_header (GList                  *header_list,
 
   return header_list;
 }
+
+GList *
+_gtk_tree_data_list_remove_header (GList *header_list,
+				   gint   sort_column_id)
+{
+  GList *list;
+
+  for (list = header_list; list; list = list->next)
+    {
+      GtkTreeDataSortHeader *header = (GtkTreeDataSortHeader*) list->data;
+
+      if (header->sort_column_id != sort_column_id)
+	continue;
+
+      if (header->destroy)
+	{
+	  GDestroyNotify d = header->destroy;
+
+	  header->destroy = NULL;
+	  d (header->data);
+	}
+
+      g_slice_free (GtkTreeDataSortHeader, header);
+      return g_list_delete_link (header_list, list);
+    }
+
+  return header_list;
+}
@@ -77,5 +77,7 @@ GList                 *_gtk_tree_data_list_set_header  (GList                  *
 							GtkTreeIterCompareFunc  func,
 							gpointer                data,
 							GDestroyNotify          destroy);
+GList                 *_gtk_tree_data_list_remove_header (GList        *header_list,
+							  gint          sort_column_id);
 
 #endif /* __GTK_TREE_DATA_LIST_H__ */
@@ -247,11 +247,15 @@ enum {
   ROW_HAS_CHILD_TOGGLED,
   ROW_DELETED,
   ROWS_REORDERED,
+  ROWS_INSERTED,
   LAST_SIGNAL
 };
 
 static guint tree_model_signals[LAST_SIGNAL] = { 0 };
 
+/* Detail of row-inserted emissions that replay a rows-inserted range */
+static GQuark range_quark;
+
 struct _GtkTreePath
 {
   gint depth;    /* Number of elements */
@@ -273,6 +277,12 @@ static void      row_inserted_marshal       (GClosure          *closure,
                                              const GValue      *param_values,
                                              gpointer           invocation_hint,
                                              gpointer           marshal_data);
+static void      rows_inserted_marshal      (GClosure          *closure,
+                                             GValue /* out */  *return_value,
+                                             guint              n_param_value,
+                                             const GValue      *param_values,
+                                             gpointer           invocation_hint,
+                                             gpointer           marshal_data);
 static void      row_deleted_marshal        (GClosure          *closure,
                                              GValue /* out */  *return_value,
                                              guint              n_param_value,
@@ -337,6 +347,9 @@ gtk_tree_model_base_init (gpointer g_class)
       GType row_inserted_params[2];
       GType row_deleted_params[1];
       GType rows_reordered_params[3];
+      GType rows_inserted_params[3];
+
+      range_quark = g_quark_from_static_string ("range");
 
       row_inserted_params[0] = GTK_TYPE_TREE_PATH | G_SIGNAL_TYPE_STATIC_SCOPE;
       row_inserted_params[1] = GTK_TYPE_TREE_ITER;
@@ -347,6 +360,10 @@ gtk_tree_model_base_init (gpointer g_class)
       rows_reordered_params[1] = GTK_TYPE_TREE_ITER;
       rows_reordered_params[2] = G_TYPE_POINTER;
 
+      rows_inserted_params[0] = GTK_TYPE_TREE_PATH | G_SIGNAL_TYPE_STATIC_SCOPE;
+      rows_inserted_params[1] = GTK_TYPE_TREE_ITER;
+      rows_inserted_params[2] = G_TYPE_INT;
+
       /**
        * GtkTreeModel::row-changed:
        * @tree_model: the #GtkTreeModel on which the signal is emitted
@@ -391,13 +408,19 @@ gtk_tree_model_base_init (gpointer g_class)
        * Note that the row may still be empty at this point, since
        * it is a common pattern to first insert an empty row, and
        * then fill it with the desired values.
+       *
+       * Rows that were inserted together and announced with
+       * #GtkTreeModel::rows-inserted are emitted with the "range"
+       * detail. Unlike rows inserted one at a time, the rows that
+       * follow @path in the range are already in the model when
+       * the signal is emitted for @path.
        */
       closure = g_closure_new_simple (sizeof (GClosure), NULL);
       g_closure_set_marshal (closure, row_inserted_marshal);
       tree_model_signals[ROW_INSERTED] =
         g_signal_newv (I_("row-inserted"),
                        GTK_TYPE_TREE_MODEL,
-                       G_SIGNAL_RUN_FIRST,
+                       G_SIGNAL_RUN_FIRST | G_SIGNAL_DETAILED,
                        closure,
                        NULL, NULL,
                        _gtk_marshal_VOID__BOXED_BOXED,
@@ -479,6 +502,42 @@ gtk_tree_model_base_init (gpointer g_class)
                        _gtk_marshal_VOID__BOXED_BOXED_POINTER,
                        G_TYPE_NONE, 3,
                        rows_reordered_params);
+
+      /**
+       * GtkTreeModel::rows-inserted:
+       * @tree_model: the #GtkTreeModel on which the signal is emitted
+       * @path: a #GtkTreePath-struct identifying the first new row
+       * @iter: a valid #GtkTreeIter-struct pointing to the first new row
+       * @n_rows: the number of rows that have been inserted
+       *
+       * This signal is emitted when @n_rows consecutive sibling rows,
+       * starting at @path, have been inserted in the model at once.
+       *
+       * After this signal, #GtkTreeModel::row-inserted is emitted for
+       * each of the rows with the "range" detail, so handlers that
+       * only know about single rows keep working. Note that all of the
+       * rows are already present in the model at that point: a handler
+       * that looks beyond the row it is given, for example at the
+       * number of children of its parent, sees every row of the range
+       * from the first emission on.
+       *
+       * Handlers that deal with the whole range here can skip these
+       * emissions of #GtkTreeModel::row-inserted by checking the
+       * detail of g_signal_get_invocation_hint() in their handler.
+       *
+       * Since: 3.22
+       */
+      closure = g_closure_new_simple (sizeof (GClosure), NULL);
+      g_closure_set_marshal (closure, rows_inserted_marshal);
+      tree_model_signals[ROWS_INSERTED] =
+        g_signal_newv (I_("rows-inserted"),
+                       GTK_TYPE_TREE_MODEL,
+                       G_SIGNAL_RUN_FIRST,
+                       closure,
+                       NULL, NULL,
+                       _gtk_marshal_VOID__BOXED_BOXED_INT,
+                       G_TYPE_NONE, 3,
+                       rows_inserted_params);
       initialized = TRUE;
     }
 }
@@ -500,10 +559,14 @@ row_inserted_marshal (GClosure          *closure,
   GObject *model = g_value_get_object (param_values + 0);
   GtkTreePath *path = (GtkTreePath *)g_value_get_boxed (param_values + 1);
   GtkTreeIter *iter = (GtkTreeIter *)g_value_get_boxed (param_values + 2);
+  GSignalInvocationHint *hint = invocation_hint;
 
-  /* first, we need to update internal row references */
-  gtk_tree_row_ref_inserted ((RowRefList *)g_object_get_data (model, ROW_REF_DATA_STRING),
-                             path, iter);
+  /* first, we need to update internal row references, unless
+   * rows-inserted already took care of this row
+   */
+  if (hint->detail != range_quark)
+    gtk_tree_row_ref_inserted ((RowRefList *)g_object_get_data (model, ROW_REF_DATA_STRING),
+                               path, iter);
 
   /* fetch the interface ->row_inserted implementation */
   iface = GTK_TREE_MODEL_GET_IFACE (model);
@@ -516,6 +579,53 @@ row_inserted_marshal (GClosure          *closure,
     row_inserted_callback (GTK_TREE_MODEL (model), path, iter);
 }
 
+static void
+rows_inserted_marshal (GClosure          *closure,
+                       GValue /* out */  *return_value,
+                       guint              n_param_values,
+                       const GValue      *param_values,
+                       gpointer           invocation_hint,
+                       gpointer           marshal_data)
+{
+  GtkTreeModelIface *iface;
+  void (* rows_inserted_callback) (GtkTreeModel *tree_model,
+                                   GtkTreePath  *path,
+                                   GtkTreeIter  *iter,
+                                   gint          n_rows);
+
+  GObject *model = g_value_get_object (param_values + 0);
+  GtkTreePath *path = (GtkTreePath *)g_value_get_boxed (param_values + 1);
+  GtkTreeIter *iter = (GtkTreeIter *)g_value_get_boxed (param_values + 2);
+  gint n_rows = g_value_get_int (param_values + 3);
+  RowRefList *refs;
+
+  /* first, we need to update internal row references */
+  refs = (RowRefList *)g_object_get_data (model, ROW_REF_DATA_STRING);
+  if (refs)
+    {
+      GtkTreePath *row_path;
+      gint i;
+
+      row_path = gtk_tree_path_copy (path);
+      for (i = 0; i < n_rows; i++)
+        {
+          gtk_tree_row_ref_inserted (refs, row_path, NULL);
+          gtk_tree_path_next (row_path);
+        }
+      gtk_tree_path_free (row_path);
+    }
+
+  /* fetch the interface ->rows_inserted implementation */
+  iface = GTK_TREE_MODEL_GET_IFACE (model);
+  rows_inserted_callback = G_STRUCT_MEMBER (gpointer, iface,
+                              G_STRUCT_OFFSET (GtkTreeModelIface,
+                                               rows_inserted));
+
+  /* Call that default signal handler, it if has been set */
+  if (rows_inserted_callback)
+    rows_inserted_callback (GTK_TREE_MODEL (model), path, iter, n_rows);
+}
+
 static void
 row_deleted_marshal (GClosure          *closure,
                      GValue /* out */  *return_value,
@@ -1855,6 +1965,96 @@ gtk_tree_model_row_inserted (GtkTreeModel *tree_model,
   g_signal_emit (tree_model, tree_model_signals[ROW_INSERTED], 0, path, iter);
 }
 
+/**
+ * gtk_tree_model_rows_inserted:
+ * @tree_model: a #GtkTreeModel
+ * @path: a #GtkTreePath-struct pointing to the first inserted row
+ * @iter: a valid #GtkTreeIter-struct pointing to the first inserted row
+ * @n_rows: the number of consecutive sibling rows that were inserted
+ *
+ * Emits the #GtkTreeModel::rows-inserted signal on @tree_model,
+ * followed by #GtkTreeModel::row-inserted with the "range" detail
+ * for each of the rows.
+ *
+ * Models should call this after inserting several adjacent rows in
+ * one go, instead of calling gtk_tree_model_row_inserted() once per
+ * row. This lets views and proxy models handle the whole range at
+ * once.
+ *
+ * Since: 3.22
+ */
+void
+gtk_tree_model_rows_inserted (GtkTreeModel *tree_model,
+                              GtkTreePath  *path,
+                              GtkTreeIter  *iter,
+                              gint          n_rows)
+{
+  GtkTreePath *row_path;
+  GtkTreeIter row_iter;
+  gboolean iters_persist;
+  gint i;
+
+  g_return_if_fail (GTK_IS_TREE_MODEL (tree_model));
+  g_return_if_fail (path != NULL);
+  g_return_if_fail (iter != NULL);
+  g_return_if_fail (n_rows >= 0);
+
+  if (n_rows == 0)
+    return;
+
+  g_object_ref (tree_model);
+
+  g_signal_emit (tree_model, tree_model_signals[ROWS_INSERTED], 0, path, iter, n_rows);
+
+  /* Replay the range one row at a time for handlers that only know
+   * about row-inserted. The detail marks these emissions, so that
+   * handlers of rows-inserted can tell them apart from rows that are
+   * inserted in the meantime.
+   */
+  iters_persist = gtk_tree_model_get_flags (tree_model) & GTK_TREE_MODEL_ITERS_PERSIST;
+  row_path = gtk_tree_path_copy (path);
+  row_iter = *iter;
+
+  for (i = 0; i < n_rows; i++)
+    {
+      if (i > 0)
+        {
+          gtk_tree_path_next (row_path);
+
+          if (iters_persist)
+            gtk_tree_model_iter_next (tree_model, &row_iter);
+          else
+            gtk_tree_model_get_iter (tree_model, &row_iter, row_path);
+        }
+
+      g_signal_emit (tree_model, tree_model_signals[ROW_INSERTED], range_quark, row_path, &row_iter);
+    }
+
+  gtk_tree_path_free (row_path);
+
+  g_object_unref (tree_model);
+}
+
+/*
+ * _gtk_tree_model_row_inserted_in_range:
+ * @tree_model: a #GtkTreeModel
+ *
+ * To be called from a #GtkTreeModel::row-inserted handler. Returns
+ * %TRUE if the current emission is part of a range that has already
+ * been announced with rows-inserted.
+ */
+gboolean
+_gtk_tree_model_row_inserted_in_range (GtkTreeModel *tree_model)
+{
+  GSignalInvocationHint *hint;
+
+  hint = g_signal_get_invocation_hint (tree_model);
+
+  return hint != NULL &&
+         hint->signal_id == tree_model_signals[ROW_INSERTED] &&
+         hint->detail == range_quark;
+}
+
 /**
  * gtk_tree_model_row_has_child_toggled:
  * @tree_model: a #GtkTreeModel
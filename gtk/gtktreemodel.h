@@ -126,6 +126,8 @@ struct _GtkTreeIter
  * @iter_parent: Sets iter to be the parent of child.
  * @ref_node: Lets the tree ref the node.
  * @unref_node: Lets the tree unref the node.
+ * @rows_inserted: Signal emitted when a range of sibling rows has been
+ *    inserted in the model. Since: 3.22
  */
 struct _GtkTreeModelIface
 {
@@ -188,6 +190,17 @@ struct _GtkTreeModelIface
 				    GtkTreeIter  *iter);
   void         (* unref_node)      (GtkTreeModel *tree_model,
 				    GtkTreeIter  *iter);
+
+  /* The interface has no padding, so new members can only be
+   * appended. That keeps the offsets of the members above; the
+   * structure is always allocated by GObject with the size GTK+
+   * registered, never by implementations, so they don't depend on
+   * its size.
+   */
+  void         (* rows_inserted)   (GtkTreeModel *tree_model,
+				    GtkTreePath  *path,
+				    GtkTreeIter  *iter,
+				    gint          n_rows);
 };
 
 
@@ -384,6 +397,11 @@ GDK_AVAILABLE_IN_ALL
 void gtk_tree_model_row_inserted          (GtkTreeModel *tree_model,
 					   GtkTreePath  *path,
 					   GtkTreeIter  *iter);
+GDK_AVAILABLE_IN_3_22
+void gtk_tree_model_rows_inserted         (GtkTreeModel *tree_model,
+					   GtkTreePath  *path,
+					   GtkTreeIter  *iter,
+					   gint          n_rows);
 GDK_AVAILABLE_IN_ALL
 void gtk_tree_model_row_has_child_toggled (GtkTreeModel *tree_model,
 					   GtkTreePath  *path,
@@ -21,6 +21,7 @@
 #include "gtkintl.h"
 #include "gtktreednd.h"
 #include "gtkprivate.h"
+#include "gtktreeprivate.h"
 #include <string.h>
 
 
@@ -291,9 +292,15 @@ struct _GtkTreeModelFilterPrivate
   /* signal ids */
   gulong changed_id;
   gulong inserted_id;
+  gulong rows_inserted_id;
   gulong has_child_toggled_id;
   gulong deleted_id;
   gulong reordered_id;
+
+  /* incremental refilter */
+  guint refilter_id;
+  GtkTreePath *refilter_path;
+  GtkTreeRowReference *refilter_row;
 };
 
 /* properties */
@@ -321,6 +328,12 @@ enum
  */
 #undef MODEL_FILTER_DEBUG
 
+/* The time, in microseconds, that a single slice of an incremental
+ * refilter may spend re-evaluating rows before yielding to the
+ * main loop.
+ */
+#define REFILTER_TIME_SLICE 4000
+
 #define FILTER_ELT(filter_elt) ((FilterElt *)filter_elt)
 #define FILTER_LEVEL(filter_level) ((FilterLevel *)filter_level)
 #define GET_ELT(siter) ((FilterElt*) (siter ? g_sequence_get (siter) : NULL))
@@ -347,6 +360,11 @@ static void         gtk_tree_model_filter_row_inserted                    (GtkTr
                                                                            GtkTreePath            *c_path,
                                                                            GtkTreeIter            *c_iter,
                                                                            gpointer                data);
+static void         gtk_tree_model_filter_rows_inserted                   (GtkTreeModel           *c_model,
+                                                                           GtkTreePath            *c_path,
+                                                                           GtkTreeIter            *c_iter,
+                                                                           gint                    n_rows,
+                                                                           gpointer                data);
 static void         gtk_tree_model_filter_row_has_child_toggled           (GtkTreeModel           *c_model,
                                                                            GtkTreePath            *c_path,
                                                                            GtkTreeIter            *c_iter,
@@ -462,6 +480,7 @@ static void         gtk_tree_model_filter_unref_path                      (GtkTr
                                                                            int                     depth);
 static void         gtk_tree_model_filter_set_root                        (GtkTreeModelFilter     *filter,
                                                                            GtkTreePath            *root);
+static void         gtk_tree_model_filter_stop_refilter                   (GtkTreeModelFilter     *filter);
 
 static GtkTreePath *gtk_real_tree_model_filter_convert_child_path_to_path (GtkTreeModelFilter     *filter,
                                                                            GtkTreePath            *child_path,
@@ -695,15 +714,29 @@ lookup_elt_with_offset (GSequence      *seq,
   return GET_ELT (siter);
 }
 
+/* Makes room for @n_rows rows inserted at @offset in the child model.
+ * This leaves a gap in the offsets, which is filled with the new nodes
+ * (via fetch_child) when they become visible.
+ */
 static void
-increase_offset_iter (gpointer data,
-                      gpointer user_data)
+increase_offsets (FilterLevel *level,
+                  gint         offset,
+                  gint         n_rows)
 {
-  FilterElt *elt = data;
-  gint offset = GPOINTER_TO_INT (user_data);
+  GSequenceIter *siter;
+  FilterElt dummy;
+
+  dummy.offset = offset;
+  siter = g_sequence_search (level->seq, &dummy, filter_elt_cmp, NULL);
+  siter = g_sequence_iter_prev (siter);
 
-  if (elt->offset >= offset)
-    elt->offset++;
+  for (; !g_sequence_iter_is_end (siter); siter = g_sequence_iter_next (siter))
+    {
+      FilterElt *elt = g_sequence_get (siter);
+
+      if (elt->offset >= offset)
+        elt->offset += n_rows;
+    }
 }
 
 static void
@@ -2105,50 +2138,20 @@ done:
     gtk_tree_path_free (c_path);
 }
 
+/* The rows have already been inserted, so we need to fixup the
+ * virtual root before handling them.
+ */
 static void
-gtk_tree_model_filter_row_inserted (GtkTreeModel *c_model,
-                                    GtkTreePath  *c_path,
-                                    GtkTreeIter  *c_iter,
-                                    gpointer      data)
+gtk_tree_model_filter_virtual_root_inserted (GtkTreeModelFilter *filter,
+                                             GtkTreePath        *c_path,
+                                             gint                n_rows)
 {
-  GtkTreeModelFilter *filter = GTK_TREE_MODEL_FILTER (data);
-  GtkTreePath *real_path = NULL;
-
-  GtkTreeIter real_c_iter;
-
-  FilterElt *elt = NULL;
-  FilterLevel *level = NULL;
-  FilterLevel *parent_level = NULL;
-  GSequenceIter *siter;
-  FilterElt dummy;
-
-  gint i = 0, offset;
-
-  gboolean free_c_path = FALSE;
-  gboolean emit_row_inserted = FALSE;
-
-  g_return_if_fail (c_path != NULL || c_iter != NULL);
-
-  if (!c_path)
-    {
-      c_path = gtk_tree_model_get_path (c_model, c_iter);
-      free_c_path = TRUE;
-    }
-
-  if (c_iter)
-    real_c_iter = *c_iter;
-  else
-    gtk_tree_model_get_iter (c_model, &real_c_iter, c_path);
-
-  /* the row has already been inserted. so we need to fixup the
-   * virtual root here first
-   */
   if (filter->priv->virtual_root)
     {
       if (gtk_tree_path_get_depth (filter->priv->virtual_root) >=
           gtk_tree_path_get_depth (c_path))
         {
-          gint depth;
+          gint depth, i;
           gint *v_indices, *c_indices;
           gboolean common_prefix = TRUE;
 
@@ -2164,39 +2167,22 @@ gtk_tree_model_filter_row_inserted (GtkTreeModel *c_model,
               }
 
           if (common_prefix && v_indices[depth] >= c_indices[depth])
-            (v_indices[depth])++;
+            v_indices[depth] += n_rows;
         }
     }
+}
 
-  /* subtract virtual root if necessary */
-  if (filter->priv->virtual_root)
-    {
-      real_path = gtk_tree_model_filter_remove_root (c_path,
-                                                     filter->priv->virtual_root);
-      /* not our child */
-      if (!real_path)
-        goto done;
-    }
-  else
-    real_path = gtk_tree_path_copy (c_path);
-
-  if (!filter->priv->root)
-    {
-      /* The root level has not been exposed to the view yet, so we
-       * need to emit signals for any node that is being inserted.
-       */
-      gtk_tree_model_filter_build_level (filter, NULL, NULL, TRUE);
-
-      /* Check if the root level was built.  Then child levels
-       * that matter have also been built (due to update_children,
-       * which triggers iter_n_children).
-       */
-      if (filter->priv->root)
-        {
-          emit_row_inserted = FALSE;
-          goto done;
-        }
-    }
+/* Returns the level that rows inserted at @real_path go into, or %NULL
+ * if that level is not cached. If the level does not exist but its
+ * parent is visible, row-has-child-toggled is emitted on the parent.
+ */
+static FilterLevel *
+gtk_tree_model_filter_get_insert_level (GtkTreeModelFilter *filter,
+                                        GtkTreePath        *real_path)
+{
+  FilterElt *elt = NULL;
+  FilterLevel *level = NULL;
+  FilterLevel *parent_level = NULL;
 
   if (gtk_tree_path_get_depth (real_path) - 1 >= 1)
     {
@@ -2210,7 +2196,7 @@ gtk_tree_model_filter_row_inserted (GtkTreeModel *c_model,
 
       if (!found)
         /* Parent is not in the cache and probably being filtered out */
-        goto done;
+        return NULL;
 
       level = elt->children;
     }
@@ -2242,29 +2228,72 @@ gtk_tree_model_filter_row_inserted (GtkTreeModel *c_model,
               gtk_tree_path_free (tmppath);
             }
         }
-      goto done;
+      return NULL;
+    }
+
+  return level;
+}
+
+static void
+gtk_tree_model_filter_insert_row (GtkTreeModelFilter *filter,
+                                  GtkTreeModel       *c_model,
+                                  GtkTreePath        *c_path,
+                                  GtkTreeIter        *c_iter)
+{
+  GtkTreePath *real_path = NULL;
+
+  FilterLevel *level = NULL;
+
+  gint i = 0, offset;
+
+  gboolean emit_row_inserted = FALSE;
+
+  /* subtract virtual root if necessary */
+  if (filter->priv->virtual_root)
+    {
+      real_path = gtk_tree_model_filter_remove_root (c_path,
+                                                     filter->priv->virtual_root);
+      /* not our child */
+      if (!real_path)
+        goto done;
+    }
+  else
+    real_path = gtk_tree_path_copy (c_path);
+
+  if (!filter->priv->root)
+    {
+      /* The root level has not been exposed to the view yet, so we
+       * need to emit signals for any node that is being inserted.
+       */
+      gtk_tree_model_filter_build_level (filter, NULL, NULL, TRUE);
+
+      /* Check if the root level was built.  Then child levels
+       * that matter have also been built (due to update_children,
+       * which triggers iter_n_children).
+       */
+      if (filter->priv->root)
+        {
+          emit_row_inserted = FALSE;
+          goto done;
+        }
     }
 
+  level = gtk_tree_model_filter_get_insert_level (filter, real_path);
+  if (!level)
+    goto done;
+
   /* let's try to insert the value */
   offset = gtk_tree_path_get_indices (real_path)[gtk_tree_path_get_depth (real_path) - 1];
 
-  /* update the offsets, yes if we didn't insert the node above, there will
-   * be a gap here. This will be filled with the node (via fetch_child) when
-   * it becomes visible
-   */
-  dummy.offset = offset;
-  siter = g_sequence_search (level->seq, &dummy, filter_elt_cmp, NULL);
-  siter = g_sequence_iter_prev (siter);
-  g_sequence_foreach_range (siter, g_sequence_get_end_iter (level->seq),
-                            increase_offset_iter, GINT_TO_POINTER (offset));
+  increase_offsets (level, offset, 1);
 
   /* only insert when visible */
-  if (gtk_tree_model_filter_visible (filter, &real_c_iter))
+  if (gtk_tree_model_filter_visible (filter, c_iter))
     {
       FilterElt *felt;
 
       felt = gtk_tree_model_filter_insert_elt_in_level (filter,
-                                                        &real_c_iter,
+                                                        c_iter,
                                                         level, offset,
                                                         &i);
 
@@ -2285,11 +2314,201 @@ done:
 
   if (real_path)
     gtk_tree_path_free (real_path);
+}
+
+static void
+gtk_tree_model_filter_row_inserted (GtkTreeModel *c_model,
+                                    GtkTreePath  *c_path,
+                                    GtkTreeIter  *c_iter,
+                                    gpointer      data)
+{
+  GtkTreeModelFilter *filter = GTK_TREE_MODEL_FILTER (data);
+  GtkTreeIter real_c_iter;
+  gboolean free_c_path = FALSE;
+
+  g_return_if_fail (c_path != NULL || c_iter != NULL);
+
+  /* Already handled by gtk_tree_model_filter_rows_inserted() */
+  if (_gtk_tree_model_row_inserted_in_range (c_model))
+    return;
+
+  if (!c_path)
+    {
+      c_path = gtk_tree_model_get_path (c_model, c_iter);
+      free_c_path = TRUE;
+    }
+
+  if (c_iter)
+    real_c_iter = *c_iter;
+  else
+    gtk_tree_model_get_iter (c_model, &real_c_iter, c_path);
+
+  gtk_tree_model_filter_virtual_root_inserted (filter, c_path, 1);
+  gtk_tree_model_filter_insert_row (filter, c_model, c_path, &real_c_iter);
 
   if (free_c_path)
     gtk_tree_path_free (c_path);
 }
 
+/* Emits rows-inserted for @n_rows visible nodes starting at @first,
+ * which were just added to @level.
+ */
+static void
+gtk_tree_model_filter_emit_rows_inserted (GtkTreeModelFilter *filter,
+                                          GtkTreeModel       *c_model,
+                                          FilterLevel        *level,
+                                          FilterElt          *first,
+                                          gint                n_rows)
+{
+  GSequenceIter *siter;
+  GtkTreePath *path;
+  GtkTreeIter iter, c_iter, children;
+  gint i;
+
+  gtk_tree_model_filter_increment_stamp (filter);
+
+  if (!gtk_tree_model_filter_elt_is_visible_in_target (level, first))
+    return;
+
+  iter.stamp = filter->priv->stamp;
+  iter.user_data = level;
+  iter.user_data2 = first;
+  path = gtk_tree_model_get_path (GTK_TREE_MODEL (filter), &iter);
+
+  if (!level->parent_level || level->ext_ref_count > 0)
+    gtk_tree_model_rows_inserted (GTK_TREE_MODEL (filter), path, &iter, n_rows);
+
+  if (level->parent_level && level->parent_elt->ext_ref_count > 0 &&
+      g_sequence_get_length (level->visible_seq) == n_rows)
+    {
+      /* These are the first visible nodes in this level, so we need
+       * to emit row-has-child-toggled on the parent.
+       */
+      gtk_tree_path_up (path);
+      gtk_tree_model_get_iter (GTK_TREE_MODEL (filter), &iter, path);
+
+      gtk_tree_model_row_has_child_toggled (GTK_TREE_MODEL (filter),
+                                            path, &iter);
+    }
+
+  gtk_tree_path_free (path);
+
+  siter = first->visible_siter;
+  for (i = 0; i < n_rows; i++)
+    {
+      FilterElt *elt = g_sequence_get (siter);
+
+      iter.stamp = filter->priv->stamp;
+      iter.user_data = level;
+      iter.user_data2 = elt;
+      gtk_tree_model_filter_convert_iter_to_child_iter (filter, &c_iter, &iter);
+
+      if (gtk_tree_model_iter_children (c_model, &children, &c_iter))
+        gtk_tree_model_filter_update_children (filter, level, elt);
+
+      siter = g_sequence_iter_next (siter);
+    }
+}
+
+static void
+gtk_tree_model_filter_rows_inserted (GtkTreeModel *c_model,
+                                     GtkTreePath  *c_path,
+                                     GtkTreeIter  *c_iter,
+                                     gint          n_rows,
+                                     gpointer      data)
+{
+  GtkTreeModelFilter *filter = GTK_TREE_MODEL_FILTER (data);
+  GtkTreePath *real_path = NULL;
+  GtkTreeIter row_iter;
+  FilterLevel *level;
+  FilterElt *run_first = NULL;
+  gint offset, run_length = 0;
+  gint i, index;
+
+  gtk_tree_model_filter_virtual_root_inserted (filter, c_path, n_rows);
+
+  if (n_rows == 1)
+    {
+      gtk_tree_model_filter_insert_row (filter, c_model, c_path, c_iter);
+      return;
+    }
+
+  /* subtract virtual root if necessary */
+  if (filter->priv->virtual_root)
+    {
+      real_path = gtk_tree_model_filter_remove_root (c_path,
+                                                     filter->priv->virtual_root);
+      /* not our child */
+      if (!real_path)
+        return;
+    }
+  else
+    real_path = gtk_tree_path_copy (c_path);
+
+  if (!filter->priv->root)
+    {
+      /* The root level has not been exposed to the view yet. Building
+       * it emits signals for all of its nodes, including the range.
+       */
+      gtk_tree_model_filter_build_level (filter, NULL, NULL, TRUE);
+
+      if (filter->priv->root)
+        goto done;
+    }
+
+  level = gtk_tree_model_filter_get_insert_level (filter, real_path);
+  if (!level)
+    goto done;
+
+  offset = gtk_tree_path_get_indices (real_path)[gtk_tree_path_get_depth (real_path) - 1];
+
+  increase_offsets (level, offset, n_rows);
+
+  /* Only visible rows are inserted. Each run of adjacent visible rows
+   * is adjacent in the filter as well and is announced as one range,
+   * before the nodes of the next run are added.
+   */
+  row_iter = *c_iter;
+  for (i = 0; i < n_rows; i++)
+    {
+      if (i > 0 && !gtk_tree_model_iter_next (c_model, &row_iter))
+        break;
+
+      if (gtk_tree_model_filter_visible (filter, &row_iter))
+        {
+          FilterElt *elt;
+
+          elt = gtk_tree_model_filter_insert_elt_in_level (filter,
+                                                           &row_iter,
+                                                           level,
+                                                           offset + i,
+                                                           &index);
+
+          /* insert_elt_in_level defaults to FALSE */
+          elt->visible_siter = g_sequence_insert_sorted (level->visible_seq,
+                                                         elt,
+                                                         filter_elt_cmp, NULL);
+          if (run_length == 0)
+            run_first = elt;
+          run_length++;
+        }
+      else if (run_length > 0)
+        {
+          gtk_tree_model_filter_emit_rows_inserted (filter, c_model, level,
+                                                    run_first, run_length);
+          run_length = 0;
+        }
+    }
+
+  if (run_length > 0)
+    gtk_tree_model_filter_emit_rows_inserted (filter, c_model, level,
+                                              run_first, run_length);
+
+done:
+  gtk_tree_model_filter_check_ancestors (filter, real_path);
+  gtk_tree_path_free (real_path);
+}
+
 static void
 gtk_tree_model_filter_row_has_child_toggled (GtkTreeModel *c_model,
                                              GtkTreePath  *c_path,
@@ -3633,12 +3852,16 @@ gtk_tree_model_filter_set_model (GtkTreeModelFilter *filter,
 {
   g_return_if_fail (GTK_IS_TREE_MODEL_FILTER (filter));
 
+  gtk_tree_model_filter_stop_refilter (filter);
+
   if (filter->priv->child_model)
     {
       g_signal_handler_disconnect (filter->priv->child_model,
                                    filter->priv->changed_id);
       g_signal_handler_disconnect (filter->priv->child_model,
                                    filter->priv->inserted_id);
+      g_signal_handler_disconnect (filter->priv->child_model,
+                                   filter->priv->rows_inserted_id);
       g_signal_handler_disconnect (filter->priv->child_model,
                                    filter->priv->has_child_toggled_id);
       g_signal_handler_disconnect (filter->priv->child_model,
@@ -3671,6 +3894,10 @@ gtk_tree_model_filter_set_model (GtkTreeModelFilter *filter,
         g_signal_connect (child_model, "row-inserted",
                           G_CALLBACK (gtk_tree_model_filter_row_inserted),
                           filter);
+      filter->priv->rows_inserted_id =
+        g_signal_connect (child_model, "rows-inserted",
+                          G_CALLBACK (gtk_tree_model_filter_rows_inserted),
+                          filter);
       filter->priv->has_child_toggled_id =
         g_signal_connect (child_model, "row-has-child-toggled",
                           G_CALLBACK (gtk_tree_model_filter_row_has_child_toggled),
@@ -4246,6 +4473,115 @@ gtk_tree_model_filter_refilter_helper (GtkTreeModel *model,
   return FALSE;
 }
 
+static void
+gtk_tree_model_filter_stop_refilter (GtkTreeModelFilter *filter)
+{
+  if (filter->priv->refilter_id != 0)
+    {
+      g_source_remove (filter->priv->refilter_id);
+      filter->priv->refilter_id = 0;
+    }
+
+  g_clear_pointer (&filter->priv->refilter_path, gtk_tree_path_free);
+  g_clear_pointer (&filter->priv->refilter_row, gtk_tree_row_reference_free);
+}
+
+/* Makes @path point at the next existing child row in depth-first
+ * order, starting at @path itself. Returns FALSE when the walk has
+ * left the subtree below the virtual root.
+ */
+static gboolean
+gtk_tree_model_filter_refilter_find_row (GtkTreeModelFilter *filter,
+                                         GtkTreePath        *path,
+                                         GtkTreeIter        *iter)
+{
+  gint root_depth = 0;
+
+  if (filter->priv->virtual_root)
+    root_depth = gtk_tree_path_get_depth (filter->priv->virtual_root);
+
+  while (!gtk_tree_model_get_iter (filter->priv->child_model, iter, path))
+    {
+      if (gtk_tree_path_get_depth (path) <= root_depth + 1)
+        return FALSE;
+
+      gtk_tree_path_up (path);
+      gtk_tree_path_next (path);
+    }
+
+  return TRUE;
+}
+
+static gboolean
+gtk_tree_model_filter_refilter_idle (gpointer data)
+{
+  GtkTreeModelFilter *filter = GTK_TREE_MODEL_FILTER (data);
+  GtkTreeModel *c_model = filter->priv->child_model;
+  GtkTreePath *path;
+  GtkTreeIter iter;
+  gint64 deadline;
+  gboolean found;
+  guint n_rows = 0;
+
+  if (filter->priv->virtual_root_deleted)
+    {
+      filter->priv->refilter_id = 0;
+      gtk_tree_model_filter_stop_refilter (filter);
+      return G_SOURCE_REMOVE;
+    }
+
+  /* Resume at the row we stopped at, which the row reference has
+   * tracked across changes to the child model. If that row has been
+   * deleted, its old path now names the row that followed it.
+   */
+  path = NULL;
+  if (filter->priv->refilter_row)
+    path = gtk_tree_row_reference_get_path (filter->priv->refilter_row);
+  if (!path)
+    path = gtk_tree_path_copy (filter->priv->refilter_path);
+
+  deadline = g_get_monotonic_time () + REFILTER_TIME_SLICE;
+  found = gtk_tree_model_filter_refilter_find_row (filter, path, &iter);
+
+  while (found)
+    {
+      GtkTreeIter child;
+
+      gtk_tree_model_filter_row_changed (c_model, path, &iter, filter);
+
+      if (gtk_tree_model_iter_children (c_model, &child, &iter))
+        {
+          gtk_tree_path_down (path);
+          iter = child;
+        }
+      else
+        {
+          gtk_tree_path_next (path);
+          if (!gtk_tree_model_iter_next (c_model, &iter))
+            found = gtk_tree_model_filter_refilter_find_row (filter, path, &iter);
+        }
+
+      if ((++n_rows % 32) == 0 && g_get_monotonic_time () >= deadline)
+        break;
+    }
+
+  if (!found)
+    {
+      gtk_tree_path_free (path);
+      filter->priv->refilter_id = 0;
+      gtk_tree_model_filter_stop_refilter (filter);
+
+      return G_SOURCE_REMOVE;
+    }
+
+  gtk_tree_path_free (filter->priv->refilter_path);
+  filter->priv->refilter_path = path;
+  gtk_tree_row_reference_free (filter->priv->refilter_row);
+  filter->priv->refilter_row = gtk_tree_row_reference_new (c_model, path);
+
+  return G_SOURCE_CONTINUE;
+}
+
 /**
  * gtk_tree_model_filter_refilter:
  * @filter: A #GtkTreeModelFilter.
@@ -4253,6 +4589,8 @@ gtk_tree_model_filter_refilter_helper (GtkTreeModel *model,
  * Emits ::row_changed for each row in the child model, which causes
  * the filter to re-evaluate whether a row is visible or not.
  *
+ * This cancels a pending gtk_tree_model_filter_refilter_incremental().
+ *
  * Since: 2.4
  */
 void
@@ -4260,12 +4598,58 @@ gtk_tree_model_filter_refilter (GtkTreeModelFilter *filter)
 {
   g_return_if_fail (GTK_IS_TREE_MODEL_FILTER (filter));
 
+  gtk_tree_model_filter_stop_refilter (filter);
+
   /* S L O W */
   gtk_tree_model_foreach (filter->priv->child_model,
                           gtk_tree_model_filter_refilter_helper,
                           filter);
 }
 
+/**
+ * gtk_tree_model_filter_refilter_incremental:
+ * @filter: A #GtkTreeModelFilter.
+ *
+ * Like gtk_tree_model_filter_refilter(), but re-evaluates the rows of
+ * the child model in short slices from an idle handler instead of all
+ * at once, so that the user interface stays responsive while a large
+ * model is being filtered. Rows appear and disappear progressively as
+ * they are reached.
+ *
+ * Changes to the child model while the refilter is in progress are
+ * handled as usual. Calling this function again restarts the refilter
+ * from the first row; calling gtk_tree_model_filter_refilter() finishes
+ * it synchronously.
+ *
+ * Since: 3.22
+ */
+void
+gtk_tree_model_filter_refilter_incremental (GtkTreeModelFilter *filter)
+{
+  GtkTreePath *path;
+
+  g_return_if_fail (GTK_IS_TREE_MODEL_FILTER (filter));
+  g_return_if_fail (filter->priv->child_model != NULL);
+
+  gtk_tree_model_filter_stop_refilter (filter);
+
+  if (filter->priv->virtual_root)
+    path = gtk_tree_path_copy (filter->priv->virtual_root);
+  else
+    path = gtk_tree_path_new ();
+  gtk_tree_path_append_index (path, 0);
+
+  filter->priv->refilter_path = path;
+  filter->priv->refilter_row = gtk_tree_row_reference_new (filter->priv->child_model,
+                                                           path);
+  filter->priv->refilter_id =
+    gdk_threads_add_idle_full (G_PRIORITY_DEFAULT_IDLE,
+                               gtk_tree_model_filter_refilter_idle,
+                               filter, NULL);
+  g_source_set_name_by_id (filter->priv->refilter_id,
+                           "[gtk+] gtk_tree_model_filter_refilter_idle");
+}
+
 /**
  * gtk_tree_model_filter_clear_cache:
  * @filter: A #GtkTreeModelFilter.
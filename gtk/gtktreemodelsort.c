@@ -26,6 +26,8 @@
 #include "gtkintl.h"
 #include "gtkprivate.h"
 #include "gtktreednd.h"
+#include "gtktreeprivate.h"
+#include "gtkparallelsortprivate.h"
 
 
 /**
@@ -42,6 +44,10 @@
  * model without modifying it. Note that the sort function used by
  * #GtkTreeModelSort is not guaranteed to be stable.
  *
+ * Sorting large models by a column whose values are expensive to fetch or
+ * compare, such as text that needs collating, can be sped up with
+ * gtk_tree_model_sort_set_sort_key_func(), which caches a sort key per row.
+ *
  * The use of this is best demonstrated through an example.  In the
  * following sample code we create two #GtkTreeView widgets each with a
  * view of the same data.  As the model is wrapped here by a
@@ -216,6 +222,7 @@
 typedef struct _SortElt SortElt;
 typedef struct _SortLevel SortLevel;
 typedef struct _SortData SortData;
+typedef struct _SortKeyHeader SortKeyHeader;
 
 struct _SortElt
 {
@@ -226,6 +233,7 @@ struct _SortElt
   gint           zero_ref_count;
   gint           old_index; /* used while sorting */
   GSequenceIter *siter; /* iter into seq */
+  GValue        *key; /* cached sort key, or NULL */
 };
 
 struct _SortLevel
@@ -236,11 +244,19 @@ struct _SortLevel
   SortLevel *parent_level;
 };
 
+struct _SortKeyHeader
+{
+  GtkTreeModelSortKeyFunc func;
+  gpointer data;
+  GDestroyNotify destroy;
+};
+
 struct _SortData
 {
   GtkTreeModelSort *tree_model_sort;
   GtkTreeIterCompareFunc sort_func;
   gpointer sort_data;
+  SortKeyHeader *key_header;
 
   GtkTreePath *parent_path;
   gint *parent_path_indices;
@@ -276,6 +292,7 @@ struct _GtkTreeModelSortPrivate
   /* signal ids */
   gulong changed_id;
   gulong inserted_id;
+  gulong rows_inserted_id;
   gulong has_child_toggled_id;
   gulong deleted_id;
   gulong reordered_id;
@@ -302,6 +319,11 @@ struct _GtkTreeModelSortPrivate
 
 #define NO_SORT_FUNC ((GtkTreeIterCompareFunc) 0x1)
 
+/* Rows are kept in the order of the child model */
+#define KEEPS_CHILD_ORDER(priv) ((priv)->sort_column_id == GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID || \
+                                 ((priv)->sort_column_id == GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID && \
+                                  (priv)->default_sort_func == NO_SORT_FUNC))
+
 #define VALID_ITER(iter, tree_model_sort) ((iter) != NULL && (iter)->user_data != NULL && (iter)->user_data2 != NULL && (tree_model_sort)->priv->stamp == (iter)->stamp)
 
 /* general (object/interface init, etc) */
@@ -327,6 +349,11 @@ static void gtk_tree_model_sort_row_inserted          (GtkTreeModel          *mo
 						       GtkTreePath           *path,
 						       GtkTreeIter           *iter,
 						       gpointer               data);
+static void gtk_tree_model_sort_rows_inserted         (GtkTreeModel          *model,
+						       GtkTreePath           *path,
+						       GtkTreeIter           *iter,
+						       gint                   n_rows,
+						       gpointer               data);
 static void gtk_tree_model_sort_row_has_child_toggled (GtkTreeModel          *model,
 						       GtkTreePath           *path,
 						       GtkTreeIter           *iter,
@@ -438,8 +465,14 @@ static gint         gtk_tree_model_sort_compare_func        (gconstpointer     a
 static gint         gtk_tree_model_sort_offset_compare_func (gconstpointer     a,
                                                              gconstpointer     b,
                                                              gpointer          user_data);
+static gint         gtk_tree_model_sort_key_compare_func    (GtkTreeModel     *model,
+                                                             GtkTreeIter      *a,
+                                                             GtkTreeIter      *b,
+                                                             gpointer          user_data);
 static void         gtk_tree_model_sort_clear_cache_helper  (GtkTreeModelSort *tree_model_sort,
                                                              SortLevel        *level);
+static void         gtk_tree_model_sort_clear_keys          (GtkTreeModelSort *tree_model_sort,
+                                                             SortLevel        *level);
 
 
 G_DEFINE_TYPE_WITH_CODE (GtkTreeModelSort, gtk_tree_model_sort, G_TYPE_OBJECT,
@@ -619,15 +652,43 @@ gtk_tree_model_sort_get_property (GObject    *object,
 static SortElt *
 sort_elt_new (void)
 {
-  return g_slice_new (SortElt);
+  SortElt *elt;
+
+  elt = g_slice_new (SortElt);
+  elt->key = NULL;
+
+  return elt;
+}
+
+static void
+sort_elt_clear_key (SortElt *elt)
+{
+  if (elt->key)
+    {
+      g_value_unset (elt->key);
+      g_slice_free (GValue, elt->key);
+      elt->key = NULL;
+    }
 }
 
 static void
 sort_elt_free (gpointer elt)
 {
+  sort_elt_clear_key (elt);
   g_slice_free (SortElt, elt);
 }
 
+static void
+sort_key_header_free (gpointer data)
+{
+  SortKeyHeader *header = data;
+
+  if (header->destroy)
+    header->destroy (header->data);
+
+  g_slice_free (SortKeyHeader, header);
+}
+
 static void
 increase_offset_iter (gpointer data,
                       gpointer user_data)
@@ -658,8 +719,15 @@ fill_sort_data (SortData         *data,
   GtkTreeModelSortPrivate *priv = tree_model_sort->priv;
 
   data->tree_model_sort = tree_model_sort;
+  data->sort_func = NULL;
+  data->sort_data = NULL;
+  data->key_header = NULL;
 
-  if (priv->sort_column_id != GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID)
+  if (priv->sort_column_id == GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID)
+    {
+      data->sort_func = NO_SORT_FUNC;
+    }
+  else if (priv->sort_column_id != GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID)
     {
       GtkTreeDataSortHeader *header;
       
@@ -681,6 +749,9 @@ fill_sort_data (SortData         *data,
       data->sort_data = priv->default_sort_data;
     }
 
+  if (data->sort_func == gtk_tree_model_sort_key_compare_func)
+    data->key_header = data->sort_data;
+
   if (level->parent_elt)
     {
       data->parent_path = gtk_tree_model_sort_elt_get_path (level->parent_level,
@@ -775,9 +846,10 @@ gtk_tree_model_sort_row_changed (GtkTreeModel *s_model,
   level = iter.user_data;
   elt = iter.user_data2;
 
+  sort_elt_clear_key (elt);
+
   if (g_sequence_get_length (level->seq) < 2 ||
-      (priv->sort_column_id == GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID &&
-       priv->default_sort_func == NO_SORT_FUNC))
+      KEEPS_CHILD_ORDER (priv))
     {
       if (free_s_path)
 	gtk_tree_path_free (start_s_path);
@@ -879,58 +951,28 @@ gtk_tree_model_sort_row_changed (GtkTreeModel *s_model,
     gtk_tree_path_free (start_s_path);
 }
 
-static void
-gtk_tree_model_sort_row_inserted (GtkTreeModel          *s_model,
-				  GtkTreePath           *s_path,
-				  GtkTreeIter           *s_iter,
-				  gpointer               data)
+/* Finds the level that rows inserted at @s_path go into, or returns
+ * %NULL if that level is not cached and the insertion can be ignored.
+ */
+static SortLevel *
+gtk_tree_model_sort_find_inserted_level (GtkTreeModelSort *tree_model_sort,
+                                         GtkTreePath      *s_path)
 {
-  GtkTreeModelSort *tree_model_sort = GTK_TREE_MODEL_SORT (data);
   GtkTreeModelSortPrivate *priv = tree_model_sort->priv;
-  GtkTreePath *path;
-  GtkTreeIter iter;
-  GtkTreeIter real_s_iter;
-
-  gint i = 0;
-
-  gboolean free_s_path = FALSE;
-
   SortElt *elt;
   SortLevel *level;
   SortLevel *parent_level = NULL;
+  gint i = 0;
 
   parent_level = level = SORT_LEVEL (priv->root);
 
-  g_return_if_fail (s_path != NULL || s_iter != NULL);
-
-  if (!s_path)
-    {
-      s_path = gtk_tree_model_get_path (s_model, s_iter);
-      free_s_path = TRUE;
-    }
-
-  if (!s_iter)
-    gtk_tree_model_get_iter (s_model, &real_s_iter, s_path);
-  else
-    real_s_iter = *s_iter;
-
-  if (!priv->root)
-    {
-      gtk_tree_model_sort_build_level (tree_model_sort, NULL, NULL);
-
-      /* the build level already put the inserted iter in the level,
-	 so no need to handle this signal anymore */
-
-      goto done_and_submit;
-    }
-
   /* find the parent level */
   while (i < gtk_tree_path_get_depth (s_path) - 1)
     {
       if (!level)
 	{
 	  /* level not yet build, we won't cover this signal */
-	  goto done;
+	  return NULL;
 	}
 
       if (g_sequence_get_length (level->seq) < gtk_tree_path_get_indices (s_path)[i])
@@ -939,19 +981,19 @@ gtk_tree_model_sort_row_inserted (GtkTreeModel          *s_model,
 		     "This possibly means that a GtkTreeModel inserted a child node\n"
 		     "before the parent was inserted.",
 		     G_STRLOC);
-	  goto done;
+	  return NULL;
 	}
 
       elt = lookup_elt_with_offset (tree_model_sort, level,
                                     gtk_tree_path_get_indices (s_path)[i],
                                     NULL);
 
-      g_return_if_fail (elt != NULL);
+      g_return_val_if_fail (elt != NULL, NULL);
 
       if (!elt->children)
 	{
 	  /* not covering this signal */
-	  goto done;
+	  return NULL;
 	}
 
       level = elt->children;
@@ -960,14 +1002,65 @@ gtk_tree_model_sort_row_inserted (GtkTreeModel          *s_model,
     }
 
   if (!parent_level)
-    goto done;
+    return NULL;
 
   if (level->ref_count == 0 && level != priv->root)
     {
       gtk_tree_model_sort_free_level (tree_model_sort, level, TRUE);
-      goto done;
+      return NULL;
     }
 
+  return parent_level;
+}
+
+static void
+gtk_tree_model_sort_row_inserted (GtkTreeModel          *s_model,
+				  GtkTreePath           *s_path,
+				  GtkTreeIter           *s_iter,
+				  gpointer               data)
+{
+  GtkTreeModelSort *tree_model_sort = GTK_TREE_MODEL_SORT (data);
+  GtkTreeModelSortPrivate *priv = tree_model_sort->priv;
+  GtkTreePath *path;
+  GtkTreeIter iter;
+  GtkTreeIter real_s_iter;
+
+  gboolean free_s_path = FALSE;
+
+  SortLevel *parent_level;
+
+  g_return_if_fail (s_path != NULL || s_iter != NULL);
+
+  /* Already handled by gtk_tree_model_sort_rows_inserted() */
+  if (_gtk_tree_model_row_inserted_in_range (s_model))
+    return;
+
+  if (!s_path)
+    {
+      s_path = gtk_tree_model_get_path (s_model, s_iter);
+      free_s_path = TRUE;
+    }
+
+  if (!s_iter)
+    gtk_tree_model_get_iter (s_model, &real_s_iter, s_path);
+  else
+    real_s_iter = *s_iter;
+
+  if (!priv->root)
+    {
+      gtk_tree_model_sort_build_level (tree_model_sort, NULL, NULL);
+
+      /* the build level already put the inserted iter in the level,
+	 so no need to handle this signal anymore */
+
+      goto done_and_submit;
+    }
+
+  parent_level = gtk_tree_model_sort_find_inserted_level (tree_model_sort,
+                                                          s_path);
+  if (!parent_level)
+    goto done;
+
   if (!gtk_tree_model_sort_insert_value (tree_model_sort,
 					 parent_level,
 					 s_path,
@@ -995,6 +1088,163 @@ gtk_tree_model_sort_row_inserted (GtkTreeModel          *s_model,
   return;
 }
 
+static void
+gtk_tree_model_sort_emit_row_inserted (GtkTreeModelSort *tree_model_sort,
+                                       SortLevel        *level,
+                                       SortElt          *elt)
+{
+  GtkTreePath *path;
+  GtkTreeIter iter;
+
+  iter.stamp = tree_model_sort->priv->stamp;
+  iter.user_data = level;
+  iter.user_data2 = elt;
+
+  path = gtk_tree_model_sort_get_path (GTK_TREE_MODEL (tree_model_sort), &iter);
+  gtk_tree_model_row_inserted (GTK_TREE_MODEL (tree_model_sort), path, &iter);
+  gtk_tree_path_free (path);
+}
+
+static void
+gtk_tree_model_sort_rows_inserted (GtkTreeModel          *s_model,
+				   GtkTreePath           *s_path,
+				   GtkTreeIter           *s_iter,
+				   gint                   n_rows,
+				   gpointer               data)
+{
+  GtkTreeModelSort *tree_model_sort = GTK_TREE_MODEL_SORT (data);
+  GtkTreeModelSortPrivate *priv = tree_model_sort->priv;
+  GtkTreeIter row_s_iter;
+  GSequenceIter *siter, *end_siter;
+  SortLevel *level;
+  SortElt *elt, *first_elt = NULL;
+  SortData sort_data;
+  gboolean unsorted;
+  gint offset, i;
+
+  offset = gtk_tree_path_get_indices (s_path)[gtk_tree_path_get_depth (s_path) - 1];
+
+  if (!priv->root)
+    {
+      gtk_tree_model_sort_build_level (tree_model_sort, NULL, NULL);
+
+      /* The new level already holds all of the new rows, sorted in
+       * one go. Only the root level is built here, rows inserted deeper
+       * down are not visible yet.
+       */
+      level = SORT_LEVEL (priv->root);
+      if (!level || gtk_tree_path_get_depth (s_path) != 1)
+        return;
+
+      gtk_tree_model_sort_increment_stamp (tree_model_sort);
+
+      if (g_sequence_get_length (level->seq) == n_rows)
+        {
+          /* Nothing else is in the level, so the rows are contiguous */
+          GtkTreePath *path;
+          GtkTreeIter iter;
+
+          iter.stamp = priv->stamp;
+          iter.user_data = level;
+          iter.user_data2 = GET_ELT (g_sequence_get_begin_iter (level->seq));
+
+          path = gtk_tree_path_new_first ();
+          gtk_tree_model_rows_inserted (GTK_TREE_MODEL (tree_model_sort),
+                                        path, &iter, n_rows);
+          gtk_tree_path_free (path);
+          return;
+        }
+
+      end_siter = g_sequence_get_end_iter (level->seq);
+      for (siter = g_sequence_get_begin_iter (level->seq);
+           siter != end_siter;
+           siter = g_sequence_iter_next (siter))
+        {
+          elt = g_sequence_get (siter);
+          if (elt->offset >= offset && elt->offset < offset + n_rows)
+            gtk_tree_model_sort_emit_row_inserted (tree_model_sort, level, elt);
+        }
+
+      return;
+    }
+
+  level = gtk_tree_model_sort_find_inserted_level (tree_model_sort, s_path);
+  if (!level)
+    return;
+
+  /* Make room for all of the new rows in a single pass, instead of
+   * walking the level once per row.
+   */
+  end_siter = g_sequence_get_end_iter (level->seq);
+  for (siter = g_sequence_get_begin_iter (level->seq);
+       siter != end_siter;
+       siter = g_sequence_iter_next (siter))
+    {
+      elt = g_sequence_get (siter);
+      if (elt->offset >= offset)
+        elt->offset += n_rows;
+    }
+
+  unsorted = KEEPS_CHILD_ORDER (priv);
+
+  fill_sort_data (&sort_data, tree_model_sort, level);
+
+  row_s_iter = *s_iter;
+  for (i = 0; i < n_rows; i++)
+    {
+      if (i > 0 && !gtk_tree_model_iter_next (s_model, &row_s_iter))
+        break;
+
+      elt = sort_elt_new ();
+      if (GTK_TREE_MODEL_SORT_CACHE_CHILD_ITERS (tree_model_sort))
+        elt->iter = row_s_iter;
+      elt->offset = offset + i;
+      elt->zero_ref_count = 0;
+      elt->ref_count = 0;
+      elt->children = NULL;
+
+      if (unsorted)
+        elt->siter = g_sequence_insert_sorted (level->seq, elt,
+                                               gtk_tree_model_sort_offset_compare_func,
+                                               &sort_data);
+      else
+        elt->siter = g_sequence_insert_sorted (level->seq, elt,
+                                               gtk_tree_model_sort_compare_func,
+                                               &sort_data);
+
+      if (i == 0)
+        first_elt = elt;
+
+      /* Sorted rows end up all over the place, so announce them one
+       * by one, each as soon as it is in the level.
+       */
+      if (!unsorted)
+        {
+          gtk_tree_model_sort_increment_stamp (tree_model_sort);
+          gtk_tree_model_sort_emit_row_inserted (tree_model_sort, level, elt);
+        }
+    }
+
+  free_sort_data (&sort_data);
+
+  if (unsorted && first_elt)
+    {
+      GtkTreePath *path;
+      GtkTreeIter iter;
+
+      gtk_tree_model_sort_increment_stamp (tree_model_sort);
+
+      iter.stamp = priv->stamp;
+      iter.user_data = level;
+      iter.user_data2 = first_elt;
+
+      path = gtk_tree_model_sort_get_path (GTK_TREE_MODEL (tree_model_sort), &iter);
+      gtk_tree_model_rows_inserted (GTK_TREE_MODEL (tree_model_sort),
+                                    path, &iter, i);
+      gtk_tree_path_free (path);
+    }
+}
+
 static void
 gtk_tree_model_sort_row_has_child_toggled (GtkTreeModel *s_model,
 					   GtkTreePath  *s_path,
@@ -1176,8 +1426,7 @@ gtk_tree_model_sort_rows_reordered (GtkTreeModel *s_model,
     }
   g_free (tmp_array);
 
-  if (priv->sort_column_id == GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID &&
-      priv->default_sort_func == NO_SORT_FUNC)
+  if (KEEPS_CHILD_ORDER (priv))
     {
       gtk_tree_model_sort_sort_level (tree_model_sort, level,
 				      FALSE, FALSE);
@@ -1704,6 +1953,10 @@ gtk_tree_model_sort_set_sort_column_id (GtkTreeSortable *sortable,
         g_return_if_fail (priv->default_sort_func != NULL);
     }
 
+  /* Cached keys belong to the previous sort column */
+  if (priv->sort_column_id != sort_column_id && priv->root)
+    gtk_tree_model_sort_clear_keys (tree_model_sort, priv->root);
+
   priv->sort_column_id = sort_column_id;
   priv->order = order;
 
@@ -1811,6 +2064,150 @@ gtk_tree_model_sort_drag_data_delete (GtkTreeDragSource *drag_source,
   return deleted;
 }
 
+/* sort keys */
+static gint
+gtk_tree_model_sort_compare_keys (const GValue *a,
+                                  const GValue *b)
+{
+#define COMPARE(x, y) ((x) < (y) ? -1 : ((x) > (y) ? 1 : 0))
+
+  switch (G_TYPE_FUNDAMENTAL (G_VALUE_TYPE (a)))
+    {
+    case G_TYPE_BOOLEAN:
+      return COMPARE (g_value_get_boolean (a), g_value_get_boolean (b));
+    case G_TYPE_CHAR:
+      return COMPARE (g_value_get_schar (a), g_value_get_schar (b));
+    case G_TYPE_UCHAR:
+      return COMPARE (g_value_get_uchar (a), g_value_get_uchar (b));
+    case G_TYPE_INT:
+      return COMPARE (g_value_get_int (a), g_value_get_int (b));
+    case G_TYPE_UINT:
+      return COMPARE (g_value_get_uint (a), g_value_get_uint (b));
+    case G_TYPE_LONG:
+      return COMPARE (g_value_get_long (a), g_value_get_long (b));
+    case G_TYPE_ULONG:
+      return COMPARE (g_value_get_ulong (a), g_value_get_ulong (b));
+    case G_TYPE_INT64:
+      return COMPARE (g_value_get_int64 (a), g_value_get_int64 (b));
+    case G_TYPE_UINT64:
+      return COMPARE (g_value_get_uint64 (a), g_value_get_uint64 (b));
+    case G_TYPE_ENUM:
+      return COMPARE (g_value_get_enum (a), g_value_get_enum (b));
+    case G_TYPE_FLAGS:
+      return COMPARE (g_value_get_flags (a), g_value_get_flags (b));
+    case G_TYPE_FLOAT:
+      return COMPARE (g_value_get_float (a), g_value_get_float (b));
+    case G_TYPE_DOUBLE:
+      return COMPARE (g_value_get_double (a), g_value_get_double (b));
+    case G_TYPE_STRING:
+      {
+        const gchar *stra = g_value_get_string (a);
+        const gchar *strb = g_value_get_string (b);
+
+        if (stra == NULL)
+          return strb == NULL ? 0 : -1;
+        if (strb == NULL)
+          return 1;
+
+        return strcmp (stra, strb);
+      }
+    default:
+      g_warning ("Sort keys of type '%s' are not supported",
+                 G_VALUE_TYPE_NAME (a));
+      return 0;
+    }
+
+#undef COMPARE
+}
+
+static void
+gtk_tree_model_sort_compute_key (GtkTreeModel  *child_model,
+                                 GtkTreeIter   *child_iter,
+                                 SortKeyHeader *header,
+                                 GValue        *key)
+{
+  header->func (child_model, child_iter, key, header->data);
+
+  if (!G_IS_VALUE (key))
+    {
+      g_warning ("GtkTreeModelSortKeyFunc did not set a sort key");
+      g_value_init (key, G_TYPE_INT);
+    }
+}
+
+static const GValue *
+sort_elt_get_key (SortData *data,
+                  SortElt  *elt)
+{
+  GtkTreeModelSortPrivate *priv = data->tree_model_sort->priv;
+  GtkTreeIter child_iter;
+
+  if (elt->key)
+    return elt->key;
+
+  if (GTK_TREE_MODEL_SORT_CACHE_CHILD_ITERS (data->tree_model_sort))
+    child_iter = elt->iter;
+  else
+    {
+      data->parent_path_indices [data->parent_path_depth-1] = elt->offset;
+      gtk_tree_model_get_iter (priv->child_model, &child_iter, data->parent_path);
+    }
+
+  elt->key = g_slice_new0 (GValue);
+  gtk_tree_model_sort_compute_key (priv->child_model, &child_iter,
+                                   data->key_header, elt->key);
+
+  return elt->key;
+}
+
+/* Installed as the sort function of columns that have a key function.
+ * The sort model itself compares cached keys instead, see
+ * gtk_tree_model_sort_compare_func(); this is only used by anyone
+ * calling the column's sort function directly.
+ */
+static gint
+gtk_tree_model_sort_key_compare_func (GtkTreeModel *model,
+                                      GtkTreeIter  *a,
+                                      GtkTreeIter  *b,
+                                      gpointer      user_data)
+{
+  SortKeyHeader *header = user_data;
+  GValue key_a = G_VALUE_INIT;
+  GValue key_b = G_VALUE_INIT;
+  gint retval;
+
+  gtk_tree_model_sort_compute_key (model, a, header, &key_a);
+  gtk_tree_model_sort_compute_key (model, b, header, &key_b);
+
+  retval = gtk_tree_model_sort_compare_keys (&key_a, &key_b);
+
+  g_value_unset (&key_a);
+  g_value_unset (&key_b);
+
+  return retval;
+}
+
+static void
+gtk_tree_model_sort_clear_keys (GtkTreeModelSort *tree_model_sort,
+                                SortLevel        *level)
+{
+  GSequenceIter *siter;
+  GSequenceIter *end_siter;
+
+  end_siter = g_sequence_get_end_iter (level->seq);
+  for (siter = g_sequence_get_begin_iter (level->seq);
+       siter != end_siter;
+       siter = g_sequence_iter_next (siter))
+    {
+      SortElt *elt = g_sequence_get (siter);
+
+      sort_elt_clear_key (elt);
+
+      if (elt->children)
+        gtk_tree_model_sort_clear_keys (tree_model_sort, elt->children);
+    }
+}
+
 /* sorting code - private */
 static gint
 gtk_tree_model_sort_compare_func (gconstpointer a,
@@ -1826,22 +2223,30 @@ gtk_tree_model_sort_compare_func (gconstpointer a,
   GtkTreeIter iter_a, iter_b;
   gint retval;
 
-  if (GTK_TREE_MODEL_SORT_CACHE_CHILD_ITERS (tree_model_sort))
+  if (data->key_header)
     {
-      iter_a = sa->iter;
-      iter_b = sb->iter;
+      retval = gtk_tree_model_sort_compare_keys (sort_elt_get_key (data, (SortElt *) sa),
+                                                 sort_elt_get_key (data, (SortElt *) sb));
     }
   else
     {
-      data->parent_path_indices [data->parent_path_depth-1] = sa->offset;
-      gtk_tree_model_get_iter (GTK_TREE_MODEL (priv->child_model), &iter_a, data->parent_path);
-      data->parent_path_indices [data->parent_path_depth-1] = sb->offset;
-      gtk_tree_model_get_iter (GTK_TREE_MODEL (priv->child_model), &iter_b, data->parent_path);
-    }
+      if (GTK_TREE_MODEL_SORT_CACHE_CHILD_ITERS (tree_model_sort))
+        {
+          iter_a = sa->iter;
+          iter_b = sb->iter;
+        }
+      else
+        {
+          data->parent_path_indices [data->parent_path_depth-1] = sa->offset;
+          gtk_tree_model_get_iter (GTK_TREE_MODEL (priv->child_model), &iter_a, data->parent_path);
+          data->parent_path_indices [data->parent_path_depth-1] = sb->offset;
+          gtk_tree_model_get_iter (GTK_TREE_MODEL (priv->child_model), &iter_b, data->parent_path);
+        }
 
-  retval = (* data->sort_func) (GTK_TREE_MODEL (priv->child_model),
-				&iter_a, &iter_b,
-				data->sort_data);
+      retval = (* data->sort_func) (GTK_TREE_MODEL (priv->child_model),
+                                    &iter_a, &iter_b,
+                                    data->sort_data);
+    }
 
   if (priv->order == GTK_SORT_DESCENDING)
     {
@@ -1884,6 +2289,66 @@ gtk_tree_model_sort_offset_compare_func (gconstpointer a,
   return retval;
 }
 
+static gint
+gtk_tree_model_sort_key_array_compare_func (gconstpointer a,
+                                            gconstpointer b,
+                                            gpointer      user_data)
+{
+  const SortElt *sa = *(SortElt * const *) a;
+  const SortElt *sb = *(SortElt * const *) b;
+  gint retval;
+
+  retval = gtk_tree_model_sort_compare_keys (sa->key, sb->key);
+
+  if (GPOINTER_TO_INT (user_data) == GTK_SORT_DESCENDING)
+    {
+      if (retval > 0)
+	retval = -1;
+      else if (retval < 0)
+	retval = 1;
+    }
+
+  return retval;
+}
+
+/* Sorts a large level by its cached keys. The keys are all extracted
+ * up front on this thread, which leaves the comparisons free of side
+ * effects so that they can run on several threads.
+ */
+static void
+gtk_tree_model_sort_sort_level_by_keys (GtkTreeModelSort *tree_model_sort,
+                                        SortLevel        *level,
+                                        SortData         *data)
+{
+  GSequenceIter *siter, *end_siter;
+  SortElt **elts;
+  gint n_elts, i;
+
+  n_elts = g_sequence_get_length (level->seq);
+  elts = g_new (SortElt *, n_elts);
+
+  i = 0;
+  end_siter = g_sequence_get_end_iter (level->seq);
+  for (siter = g_sequence_get_begin_iter (level->seq);
+       siter != end_siter;
+       siter = g_sequence_iter_next (siter))
+    {
+      SortElt *elt = g_sequence_get (siter);
+
+      sort_elt_get_key (data, elt);
+      elts[i++] = elt;
+    }
+
+  gtk_parallel_sort (elts, n_elts, sizeof (SortElt *),
+                     gtk_tree_model_sort_key_array_compare_func,
+                     GINT_TO_POINTER (tree_model_sort->priv->order));
+
+  for (i = 0; i < n_elts; i++)
+    g_sequence_move (elts[i]->siter, end_siter);
+
+  g_free (elts);
+}
+
 static void
 gtk_tree_model_sort_sort_level (GtkTreeModelSort *tree_model_sort,
 				SortLevel        *level,
@@ -1932,6 +2397,9 @@ gtk_tree_model_sort_sort_level (GtkTreeModelSort *tree_model_sort,
   if (data.sort_func == NO_SORT_FUNC)
     g_sequence_sort (level->seq, gtk_tree_model_sort_offset_compare_func,
                      &data);
+  else if (data.key_header &&
+           g_sequence_get_length (level->seq) >= GTK_PARALLEL_SORT_MIN_ELEMENTS)
+    gtk_tree_model_sort_sort_level_by_keys (tree_model_sort, level, &data);
   else
     g_sequence_sort (level->seq, gtk_tree_model_sort_compare_func, &data);
 
@@ -2062,8 +2530,7 @@ gtk_tree_model_sort_insert_value (GtkTreeModelSort *tree_model_sort,
 
   fill_sort_data (&data, tree_model_sort, level);
 
-  if (priv->sort_column_id == GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID &&
-      priv->default_sort_func == NO_SORT_FUNC)
+  if (KEEPS_CHILD_ORDER (priv))
     {
       elt->siter = g_sequence_insert_sorted (level->seq, elt,
                                              gtk_tree_model_sort_offset_compare_func,
@@ -2134,6 +2601,8 @@ gtk_tree_model_sort_set_model (GtkTreeModelSort *tree_model_sort,
                                    priv->changed_id);
       g_signal_handler_disconnect (priv->child_model,
                                    priv->inserted_id);
+      g_signal_handler_disconnect (priv->child_model,
+                                   priv->rows_inserted_id);
       g_signal_handler_disconnect (priv->child_model,
                                    priv->has_child_toggled_id);
       g_signal_handler_disconnect (priv->child_model,
@@ -2165,6 +2634,10 @@ gtk_tree_model_sort_set_model (GtkTreeModelSort *tree_model_sort,
         g_signal_connect (child_model, "row-inserted",
                           G_CALLBACK (gtk_tree_model_sort_row_inserted),
                           tree_model_sort);
+      priv->rows_inserted_id =
+        g_signal_connect (child_model, "rows-inserted",
+                          G_CALLBACK (gtk_tree_model_sort_rows_inserted),
+                          tree_model_sort);
       priv->has_child_toggled_id =
         g_signal_connect (child_model, "row-has-child-toggled",
                           G_CALLBACK (gtk_tree_model_sort_row_has_child_toggled),
@@ -2711,6 +3184,104 @@ gtk_tree_model_sort_reset_default_sort_func (GtkTreeModelSort *tree_model_sort)
   priv->sort_column_id = GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID;
 }
 
+/**
+ * gtk_tree_model_sort_set_sort_key_func:
+ * @tree_model_sort: A #GtkTreeModelSort
+ * @sort_column_id: the sort column id to set the function for
+ * @func: (allow-none): The key extraction function, or %NULL
+ * @data: (allow-none): User data to pass to @func, or %NULL
+ * @destroy: (allow-none): Destroy notifier of @data, or %NULL
+ *
+ * Makes @sort_column_id sort by a key extracted from each row of the
+ * child model instead of by a #GtkTreeIterCompareFunc. @func is called
+ * at most once per row and the key is cached until the row changes or
+ * a different sort column is selected, so sorting does not have to
+ * fetch values from the child model for every comparison.
+ *
+ * Keys may be booleans, characters, integers, enums, flags, floating
+ * point numbers or strings; strings are compared bytewise, so a
+ * collation key such as the one returned by g_utf8_collate_key() is a
+ * good choice for sorting text.
+ *
+ * This replaces the sort function of @sort_column_id, and a later
+ * call to gtk_tree_sortable_set_sort_func() for the same column
+ * replaces the key function. Passing %NULL for @func unsets both: a
+ * column of the child model then sorts by its values again, and any
+ * other column is left without a sort function. If that column is the
+ * current sort column, the model becomes unsorted.
+ *
+ * Since: 3.22
+ */
+void
+gtk_tree_model_sort_set_sort_key_func (GtkTreeModelSort        *tree_model_sort,
+                                       gint                     sort_column_id,
+                                       GtkTreeModelSortKeyFunc  func,
+                                       gpointer                 data,
+                                       GDestroyNotify           destroy)
+{
+  GtkTreeModelSortPrivate *priv;
+  SortKeyHeader *header;
+
+  g_return_if_fail (GTK_IS_TREE_MODEL_SORT (tree_model_sort));
+  g_return_if_fail (sort_column_id >= 0);
+
+  priv = tree_model_sort->priv;
+
+  if (func)
+    {
+      header = g_slice_new (SortKeyHeader);
+      header->func = func;
+      header->data = data;
+      header->destroy = destroy;
+
+      priv->sort_list = _gtk_tree_data_list_set_header (priv->sort_list,
+                                                        sort_column_id,
+                                                        gtk_tree_model_sort_key_compare_func,
+                                                        header,
+                                                        sort_key_header_free);
+    }
+  else
+    {
+      if (destroy)
+        destroy (data);
+
+      /* Columns of the child model go back to comparing their values,
+       * like after gtk_tree_model_sort_set_model(); other columns are
+       * left without a sort function.
+       */
+      if (priv->child_model &&
+          sort_column_id < gtk_tree_model_get_n_columns (priv->child_model))
+        {
+          priv->sort_list = _gtk_tree_data_list_set_header (priv->sort_list,
+                                                            sort_column_id,
+                                                            _gtk_tree_data_list_compare_func,
+                                                            GINT_TO_POINTER (sort_column_id),
+                                                            NULL);
+        }
+      else
+        {
+          priv->sort_list = _gtk_tree_data_list_remove_header (priv->sort_list,
+                                                               sort_column_id);
+
+          if (priv->sort_column_id == sort_column_id)
+            {
+              gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (tree_model_sort),
+                                                    GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID,
+                                                    priv->order);
+              return;
+            }
+        }
+    }
+
+  if (priv->sort_column_id == sort_column_id)
+    {
+      if (priv->root)
+        gtk_tree_model_sort_clear_keys (tree_model_sort, priv->root);
+
+      gtk_tree_model_sort_sort (tree_model_sort);
+    }
+}
+
 /**
  * gtk_tree_model_sort_clear_cache:
  * @tree_model_sort: A #GtkTreeModelSort
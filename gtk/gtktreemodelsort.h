@@ -39,6 +39,25 @@ typedef struct _GtkTreeModelSort        GtkTreeModelSort;
 typedef struct _GtkTreeModelSortClass   GtkTreeModelSortClass;
 typedef struct _GtkTreeModelSortPrivate GtkTreeModelSortPrivate;
 
+/**
+ * GtkTreeModelSortKeyFunc:
+ * @model: the child model of the #GtkTreeModelSort
+ * @iter: a #GtkTreeIter pointing to a row in @model
+ * @key: (out caller-allocates): A #GValue which is uninitialized, to be
+ *   initialized and set to the sort key of the row
+ * @data: (closure): user data given to gtk_tree_model_sort_set_sort_key_func()
+ *
+ * A function which extracts the key that the row pointed to by @iter
+ * is sorted by. Rows are ordered by comparing their keys, so the keys
+ * of all rows must have the same type.
+ *
+ * Since: 3.22
+ */
+typedef void (* GtkTreeModelSortKeyFunc) (GtkTreeModel *model,
+                                          GtkTreeIter  *iter,
+                                          GValue       *key,
+                                          gpointer      data);
+
 struct _GtkTreeModelSort
 {
   GObject parent;
@@ -82,6 +101,12 @@ void          gtk_tree_model_sort_convert_iter_to_child_iter (GtkTreeModelSort *
 							      GtkTreeIter      *sorted_iter);
 GDK_AVAILABLE_IN_ALL
 void          gtk_tree_model_sort_reset_default_sort_func    (GtkTreeModelSort *tree_model_sort);
+GDK_AVAILABLE_IN_3_22
+void          gtk_tree_model_sort_set_sort_key_func          (GtkTreeModelSort        *tree_model_sort,
+                                                              gint                     sort_column_id,
+                                                              GtkTreeModelSortKeyFunc  func,
+                                                              gpointer                 data,
+                                                              GDestroyNotify           destroy);
 GDK_AVAILABLE_IN_ALL
 void          gtk_tree_model_sort_clear_cache                (GtkTreeModelSort *tree_model_sort);
 GDK_AVAILABLE_IN_ALL
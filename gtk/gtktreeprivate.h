@@ -49,6 +49,7 @@ gboolean     _gtk_tree_view_find_node                 (GtkTreeView       *tree_v
 gboolean     _gtk_tree_view_get_cursor_node           (GtkTreeView       *tree_view,
 						       GtkRBTree        **tree,
 						       GtkRBNode        **node);
+gboolean     _gtk_tree_model_row_inserted_in_range    (GtkTreeModel      *tree_model);
 GtkTreePath *_gtk_tree_path_new_from_rbtree           (GtkRBTree         *tree,
 						       GtkRBNode         *node);
 void         _gtk_tree_view_queue_draw_node           (GtkTreeView       *tree_view,
@@ -1654,6 +1654,257 @@ gtk_tree_store_insert_with_valuesv (GtkTreeStore *tree_store,
   validate_tree ((GtkTreeStore *)tree_store);
 }
 
+/**
+ * gtk_tree_store_insert_rows_with_valuesv:
+ * @tree_store: A #GtkTreeStore
+ * @iter: (out) (allow-none): An unset #GtkTreeIter to set the first new
+ *     row, or %NULL.
+ * @parent: (allow-none): A valid #GtkTreeIter, or %NULL
+ * @position: position to insert the new rows, or -1 to append them
+ * @n_rows: the number of rows to insert
+ * @columns: (array length=n_values): an array of column numbers
+ * @values: (array): an array of @n_rows times @n_values GValues, holding
+ *     the values of the first row, followed by those of the second
+ *     row, and so on
+ * @n_values: the length of the @columns array
+ *
+ * Inserts @n_rows children of @parent at @position and fills them
+ * with @values, like calling gtk_tree_store_insert_with_valuesv()
+ * @n_rows times.
+ *
+ * The rows are announced with a single #GtkTreeModel::rows-inserted
+ * signal, which allows views and proxy models to handle them in one
+ * pass.
+ *
+ * If the tree is sorted, the rows end up at their sorted positions
+ * and are announced one by one.
+ *
+ * Since: 3.22
+ */
+void
+gtk_tree_store_insert_rows_with_valuesv (GtkTreeStore *tree_store,
+					 GtkTreeIter  *iter,
+					 GtkTreeIter  *parent,
+					 gint          position,
+					 gint          n_rows,
+					 gint         *columns,
+					 GValue       *values,
+					 gint          n_values)
+{
+  GtkTreeStorePrivate *priv = tree_store->priv;
+  GtkTreePath *path;
+  GNode *parent_node;
+  GNode *sibling;
+  GNode *new_node;
+  GtkTreeIter first_iter, tmp_iter;
+  gboolean had_children;
+  gint i;
+
+  g_return_if_fail (GTK_IS_TREE_STORE (tree_store));
+  g_return_if_fail (n_rows >= 0);
+  g_return_if_fail (n_values == 0 || values != NULL);
+
+  if (parent)
+    g_return_if_fail (VALID_ITER (parent, tree_store));
+
+  if (n_rows == 0)
+    return;
+
+  if (GTK_TREE_STORE_IS_SORTED (tree_store))
+    {
+      for (i = 0; i < n_rows; i++)
+        gtk_tree_store_insert_with_valuesv (tree_store,
+                                            i == 0 ? iter : NULL,
+                                            parent,
+                                            position,
+                                            columns,
+                                            values + i * n_values,
+                                            n_values);
+      return;
+    }
+
+  if (parent)
+    parent_node = parent->user_data;
+  else
+    parent_node = priv->root;
+
+  priv->columns_dirty = TRUE;
+
+  had_children = parent_node->children != NULL;
+
+  /* Look up the insertion point once, then chain the new nodes */
+  if (position < 0)
+    sibling = NULL;
+  else
+    sibling = g_node_nth_child (parent_node, position);
+
+  if (sibling)
+    sibling = sibling->prev;
+  else
+    sibling = g_node_last_child (parent_node);
+
+  first_iter.stamp = priv->stamp;
+  first_iter.user_data = NULL;
+
+  for (i = 0; i < n_rows; i++)
+    {
+      gboolean changed = FALSE;
+      gboolean maybe_need_sort = FALSE;
+
+      new_node = g_node_new (NULL);
+      if (sibling)
+        g_node_insert_after (parent_node, sibling, new_node);
+      else
+        g_node_prepend (parent_node, new_node);
+      sibling = new_node;
+
+      tmp_iter.stamp = priv->stamp;
+      tmp_iter.user_data = new_node;
+
+      if (i == 0)
+        first_iter = tmp_iter;
+
+      gtk_tree_store_set_vector_internal (tree_store, &tmp_iter,
+                                          &changed, &maybe_need_sort,
+                                          columns, values + i * n_values,
+                                          n_values);
+    }
+
+  path = gtk_tree_store_get_path (GTK_TREE_MODEL (tree_store), &first_iter);
+  gtk_tree_model_rows_inserted (GTK_TREE_MODEL (tree_store), path, &first_iter, n_rows);
+
+  if (parent_node != priv->root && !had_children)
+    {
+      gtk_tree_path_up (path);
+      gtk_tree_model_row_has_child_toggled (GTK_TREE_MODEL (tree_store), path, parent);
+    }
+
+  gtk_tree_path_free (path);
+
+  if (iter)
+    *iter = first_iter;
+
+  validate_tree ((GtkTreeStore *)tree_store);
+}
+
+/**
+ * gtk_tree_store_replace_rows_with_valuesv:
+ * @tree_store: A #GtkTreeStore
+ * @parent: (allow-none): A valid #GtkTreeIter, or %NULL
+ * @position: the position of the first child of @parent to replace
+ * @n_rows: the number of rows to replace
+ * @columns: (array length=n_values): an array of column numbers
+ * @values: (array): an array of @n_rows times @n_values GValues, holding
+ *     the new values of the first row, followed by those of the second
+ *     row, and so on
+ * @n_values: the length of the @columns array
+ *
+ * Sets the values of @n_rows consecutive children of @parent starting
+ * at @position, like calling gtk_tree_store_set_valuesv() on each of
+ * them, but without looking up every row separately.
+ *
+ * The values of all rows are set before #GtkTreeModel::row-changed is
+ * emitted for the rows that changed, once per row.
+ *
+ * If the tree is sorted, the rows are set one by one and move to their
+ * sorted positions as they change.
+ *
+ * Since: 3.22
+ */
+void
+gtk_tree_store_replace_rows_with_valuesv (GtkTreeStore *tree_store,
+					  GtkTreeIter  *parent,
+					  gint          position,
+					  gint          n_rows,
+					  gint         *columns,
+					  GValue       *values,
+					  gint          n_values)
+{
+  GtkTreeStorePrivate *priv;
+  GtkTreePath *path;
+  GtkTreeIter iter;
+  GNode *parent_node;
+  GNode **rows;
+  GNode *node;
+  gboolean *changed;
+  gint i;
+
+  g_return_if_fail (GTK_IS_TREE_STORE (tree_store));
+  g_return_if_fail (position >= 0 && n_rows >= 0);
+  g_return_if_fail (n_values == 0 || values != NULL);
+
+  if (parent)
+    g_return_if_fail (VALID_ITER (parent, tree_store));
+
+  priv = tree_store->priv;
+
+  if (parent)
+    parent_node = parent->user_data;
+  else
+    parent_node = priv->root;
+
+  g_return_if_fail ((guint) (position + n_rows) <= g_node_n_children (parent_node));
+
+  if (n_rows == 0)
+    return;
+
+  /* Find all rows first, sorting may move them around */
+  rows = g_new (GNode *, n_rows);
+  node = g_node_nth_child (parent_node, position);
+  for (i = 0; i < n_rows; i++)
+    {
+      rows[i] = node;
+      node = node->next;
+    }
+
+  iter.stamp = priv->stamp;
+
+  if (GTK_TREE_STORE_IS_SORTED (tree_store))
+    {
+      for (i = 0; i < n_rows; i++)
+        {
+          iter.user_data = rows[i];
+          gtk_tree_store_set_valuesv (tree_store, &iter, columns,
+                                      values + i * n_values, n_values);
+        }
+
+      g_free (rows);
+      return;
+    }
+
+  changed = g_new0 (gboolean, n_rows);
+  for (i = 0; i < n_rows; i++)
+    {
+      gboolean maybe_need_sort = FALSE;
+
+      iter.user_data = rows[i];
+      gtk_tree_store_set_vector_internal (tree_store, &iter,
+                                          &changed[i], &maybe_need_sort,
+                                          columns, values + i * n_values,
+                                          n_values);
+    }
+
+  iter.user_data = rows[0];
+  path = gtk_tree_store_get_path (GTK_TREE_MODEL (tree_store), &iter);
+  g_free (rows);
+
+  /* Handlers may change the store, so look the rows up by path */
+  for (i = 0; i < n_rows; i++)
+    {
+      if (changed[i])
+        {
+          if (!gtk_tree_store_get_iter (GTK_TREE_MODEL (tree_store), &iter, path))
+            break;
+
+          gtk_tree_model_row_changed (GTK_TREE_MODEL (tree_store), path, &iter);
+        }
+
+      gtk_tree_path_next (path);
+    }
+  gtk_tree_path_free (path);
+  g_free (changed);
+}
+
 /**
  * gtk_tree_store_prepend:
  * @tree_store: A #GtkTreeStore
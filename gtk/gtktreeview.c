@@ -243,6 +243,9 @@ typedef enum {
 #define GTK_TREE_VIEW_PRIORITY_SCROLL_SYNC (GTK_TREE_VIEW_PRIORITY_VALIDATE + 2)
 /* 3/5 of gdkframeclockidle.c's FRAME_INTERVAL (16667 microsecs) */
 #define GTK_TREE_VIEW_TIME_MS_PER_IDLE 10
+/* Time left to the next frame that validation doesn't touch */
+#define GTK_TREE_VIEW_FRAME_MARGIN_MS 4
+#define GTK_TREE_VIEW_MIN_TIME_MS_PER_IDLE 1
 #define SCROLL_EDGE_SIZE 15
 #define GTK_TREE_VIEW_SEARCH_DIALOG_TIMEOUT 5000
 #define AUTO_EXPAND_TIMEOUT 500
@@ -685,6 +688,11 @@ static void gtk_tree_view_row_inserted                    (GtkTreeModel    *mode
 							   GtkTreePath     *path,
 							   GtkTreeIter     *iter,
 							   gpointer         data);
+static void gtk_tree_view_rows_inserted                   (GtkTreeModel    *model,
+							   GtkTreePath     *path,
+							   GtkTreeIter     *iter,
+							   gint             n_rows,
+							   gpointer         data);
 static void gtk_tree_view_row_has_child_toggled           (GtkTreeModel    *model,
 							   GtkTreePath     *path,
 							   GtkTreeIter     *iter,
@@ -6852,6 +6860,41 @@ initialize_fixed_height_mode (GtkTreeView *tree_view)
  * the first invalid node.
  */
 
+/* Returns the time until which do_validate_rows() may keep going.
+ * While the frame clock is producing frames, this is the start of the
+ * next frame minus some room for drawing it, so that validating rows
+ * in the background doesn't make us miss frames. Otherwise there's
+ * nothing to yield to and we use the full GTK_TREE_VIEW_TIME_MS_PER_IDLE.
+ */
+static gint64
+get_validate_rows_deadline (GtkTreeView *tree_view)
+{
+  GdkFrameClock *clock;
+  gint64 now, frame_time, refresh_interval, next_frame;
+
+  now = g_get_monotonic_time ();
+
+  clock = gtk_widget_get_frame_clock (GTK_WIDGET (tree_view));
+  if (clock == NULL)
+    return now + GTK_TREE_VIEW_TIME_MS_PER_IDLE * 1000;
+
+  /* Outside of a frame this is the time of the last frame, or "now"
+   * if the clock has been idle for a while.
+   */
+  frame_time = gdk_frame_clock_get_frame_time (clock);
+  gdk_frame_clock_get_refresh_info (clock, frame_time, &refresh_interval, NULL);
+  if (refresh_interval <= 0)
+    refresh_interval = 16667;
+
+  next_frame = frame_time + refresh_interval;
+  if (next_frame <= now)
+    return now + GTK_TREE_VIEW_TIME_MS_PER_IDLE * 1000;
+
+  return CLAMP (next_frame - GTK_TREE_VIEW_FRAME_MARGIN_MS * 1000,
+                now + GTK_TREE_VIEW_MIN_TIME_MS_PER_IDLE * 1000,
+                now + GTK_TREE_VIEW_TIME_MS_PER_IDLE * 1000);
+}
+
 static gboolean
 do_validate_rows (GtkTreeView *tree_view, gboolean queue_resize)
 {
@@ -6863,7 +6906,7 @@ do_validate_rows (GtkTreeView *tree_view, gboolean queue_resize)
   gint retval = TRUE;
   GtkTreePath *path = NULL;
   GtkTreeIter iter;
-  GTimer *timer;
+  gint64 deadline;
   gint i = 0;
 
   gint y = -1;
@@ -6887,8 +6930,7 @@ do_validate_rows (GtkTreeView *tree_view, gboolean queue_resize)
       return FALSE;
     }
 
-  timer = g_timer_new ();
-  g_timer_start (timer);
+  deadline = get_validate_rows_deadline (tree_view);
 
   do
     {
@@ -6977,7 +7019,7 @@ do_validate_rows (GtkTreeView *tree_view, gboolean queue_resize)
 
       i++;
     }
-  while (g_timer_elapsed (timer, NULL) < GTK_TREE_VIEW_TIME_MS_PER_IDLE / 1000.);
+  while (g_get_monotonic_time () < deadline);
 
   if (!tree_view->priv->fixed_height_check)
    {
@@ -7028,7 +7070,6 @@ do_validate_rows (GtkTreeView *tree_view, gboolean queue_resize)
     }
 
   if (path) gtk_tree_path_free (path);
-  g_timer_destroy (timer);
 
   if (!retval && gtk_widget_get_mapped (GTK_WIDGET (tree_view)))
     update_prelight (tree_view,
@@ -9031,23 +9072,24 @@ gtk_tree_view_row_changed (GtkTreeModel *model,
 }
 
 static void
-gtk_tree_view_row_inserted (GtkTreeModel *model,
-			    GtkTreePath  *path,
-			    GtkTreeIter  *iter,
-			    gpointer      data)
+gtk_tree_view_insert_rows (GtkTreeView  *tree_view,
+			   GtkTreeModel *model,
+			   GtkTreePath  *path,
+			   GtkTreeIter  *iter,
+			   gint          n_rows)
 {
-  GtkTreeView *tree_view = (GtkTreeView *) data;
   gint *indices;
   GtkRBTree *tree;
   GtkRBNode *tmpnode = NULL;
+  GtkRBNode *first_node = NULL;
+  GtkTreePath *row_path;
+  GtkTreeIter row_iter;
   gint depth;
   gint i = 0;
   gint height;
   gboolean free_path = FALSE;
   gboolean node_visible = TRUE;
 
-  g_return_if_fail (path != NULL || iter != NULL);
-
   if (tree_view->priv->fixed_height_mode
       && tree_view->priv->fixed_height >= 0)
     height = tree_view->priv->fixed_height;
@@ -9068,7 +9110,15 @@ gtk_tree_view_row_inserted (GtkTreeModel *model,
   tree = tree_view->priv->tree;
 
   /* Update all row-references */
-  gtk_tree_row_reference_inserted (G_OBJECT (data), path);
+  row_path = gtk_tree_path_copy (path);
+  for (i = 0; i < n_rows; i++)
+    {
+      gtk_tree_row_reference_inserted (G_OBJECT (tree_view), row_path);
+      gtk_tree_path_next (row_path);
+    }
+  gtk_tree_path_free (row_path);
+
+  i = 0;
   depth = gtk_tree_path_get_depth (path);
   indices = gtk_tree_path_get_indices (path);
 
@@ -9097,7 +9147,7 @@ gtk_tree_view_row_inserted (GtkTreeModel *model,
 	   * try to catch it anyway, just to be safe, in case the model hasn't.
 	   */
 	  GtkTreePath *tmppath = _gtk_tree_path_new_from_rbtree (tree, tmpnode);
-	  gtk_tree_view_row_has_child_toggled (model, tmppath, NULL, data);
+	  gtk_tree_view_row_has_child_toggled (model, tmppath, NULL, tree_view);
 	  gtk_tree_path_free (tmppath);
           goto done;
 	}
@@ -9126,14 +9176,35 @@ gtk_tree_view_row_inserted (GtkTreeModel *model,
     }
 
   _gtk_tree_view_accessible_add (tree_view, tree, tmpnode);
+  if (height > 0)
+    _gtk_rbtree_node_mark_valid (tree, tmpnode);
+  first_node = tmpnode;
+
+  /* The remaining rows follow the first one, so there is no need to
+   * look up their position again.
+   */
+  row_iter = *iter;
+  for (i = 1; i < n_rows; i++)
+    {
+      if (!gtk_tree_model_iter_next (model, &row_iter))
+        break;
+
+      gtk_tree_model_ref_node (tree_view->priv->model, &row_iter);
+      tmpnode = _gtk_rbtree_insert_after (tree, tmpnode, height, FALSE);
+
+      _gtk_tree_view_accessible_add (tree_view, tree, tmpnode);
+      if (height > 0)
+        _gtk_rbtree_node_mark_valid (tree, tmpnode);
+    }
 
  done:
   if (height > 0)
     {
-      if (tree)
+      if (tree && first_node == NULL)
         _gtk_rbtree_node_mark_valid (tree, tmpnode);
 
-      if (node_visible && node_is_visible (tree_view, tree, tmpnode))
+      if (node_visible &&
+          (n_rows > 1 || node_is_visible (tree_view, tree, tmpnode)))
 	gtk_widget_queue_resize (GTK_WIDGET (tree_view));
       else
 	gtk_widget_queue_resize_no_redraw (GTK_WIDGET (tree_view));
@@ -9144,6 +9215,31 @@ gtk_tree_view_row_inserted (GtkTreeModel *model,
     gtk_tree_path_free (path);
 }
 
+static void
+gtk_tree_view_row_inserted (GtkTreeModel *model,
+			    GtkTreePath  *path,
+			    GtkTreeIter  *iter,
+			    gpointer      data)
+{
+  g_return_if_fail (path != NULL || iter != NULL);
+
+  /* Already handled as part of a range in gtk_tree_view_rows_inserted() */
+  if (_gtk_tree_model_row_inserted_in_range (model))
+    return;
+
+  gtk_tree_view_insert_rows ((GtkTreeView *) data, model, path, iter, 1);
+}
+
+static void
+gtk_tree_view_rows_inserted (GtkTreeModel *model,
+			     GtkTreePath  *path,
+			     GtkTreeIter  *iter,
+			     gint          n_rows,
+			     gpointer      data)
+{
+  gtk_tree_view_insert_rows ((GtkTreeView *) data, model, path, iter, n_rows);
+}
+
 static void
 gtk_tree_view_row_has_child_toggled (GtkTreeModel *model,
 				     GtkTreePath  *path,
@@ -11459,6 +11555,9 @@ gtk_tree_view_set_model (GtkTreeView  *tree_view,
       g_signal_handlers_disconnect_by_func (tree_view->priv->model,
 					    gtk_tree_view_row_inserted,
 					    tree_view);
+      g_signal_handlers_disconnect_by_func (tree_view->priv->model,
+					    gtk_tree_view_rows_inserted,
+					    tree_view);
       g_signal_handlers_disconnect_by_func (tree_view->priv->model,
 					    gtk_tree_view_row_has_child_toggled,
 					    tree_view);
@@ -11527,6 +11626,10 @@ gtk_tree_view_set_model (GtkTreeView  *tree_view,
 			"row-inserted",
 			G_CALLBACK (gtk_tree_view_row_inserted),
 			tree_view);
+      g_signal_connect (tree_view->priv->model,
+			"rows-inserted",
+			G_CALLBACK (gtk_tree_view_rows_inserted),
+			tree_view);
       g_signal_connect (tree_view->priv->model,
 			"row-has-child-toggled",
 			G_CALLBACK (gtk_tree_view_row_has_child_toggled),
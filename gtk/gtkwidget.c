@@ -69,6 +69,7 @@
 #include "gtkapplicationprivate.h"
 #include "gtkgestureprivate.h"
 #include "gtkwidgetpathprivate.h"
+#include "gdk/gdk-private.h"
 
 /* for the use of round() */
 #include "fallback-c89.c"
@@ -816,6 +817,12 @@ static void gtk_widget_on_frame_clock_update (GdkFrameClock *frame_clock,
 static gboolean event_window_is_still_viewable (GdkEvent *event);
 
 static void gtk_widget_update_input_shape (GtkWidget *widget);
+static void gtk_widget_invalidate_recording (GtkWidget *widget);
+static void gtk_widget_drop_recording (GtkWidget *widget);
+static gint64 gtk_widget_timing_begin (void);
+static void gtk_widget_timing_end (GtkWidget  *widget,
+                                   const char *category,
+                                   gint64      start_time);
 
 /* --- variables --- */
 static gint             GtkWidget_private_offset = 0;
@@ -4998,6 +5005,7 @@ gtk_widget_map (GtkWidget *widget)
 
       g_signal_emit (widget, widget_signals[MAP], 0);
 
+      gtk_widget_invalidate_recording (widget);
       if (!_gtk_widget_get_has_window (widget))
         gdk_window_invalidate_rect (priv->window, &priv->clip, FALSE);
 
@@ -5026,6 +5034,7 @@ gtk_widget_unmap (GtkWidget *widget)
       g_object_ref (widget);
       gtk_widget_push_verify_invariants (widget);
 
+      gtk_widget_invalidate_recording (widget);
       if (!_gtk_widget_get_has_window (widget))
 	gdk_window_invalidate_rect (priv->window, &priv->clip, FALSE);
       _gtk_tooltip_hide (widget);
@@ -5526,6 +5535,8 @@ gtk_widget_unrealize (GtkWidget *widget)
       g_signal_emit (widget, widget_signals[UNREALIZE], 0);
       g_assert (!widget->priv->mapped);
       gtk_widget_set_realized (widget, FALSE);
+
+      gtk_widget_drop_recording (widget);
     }
 
   gtk_widget_pop_verify_invariants (widget);
@@ -5571,6 +5582,8 @@ gtk_widget_queue_draw_region (GtkWidget            *widget,
 
   g_return_if_fail (GTK_IS_WIDGET (widget));
 
+  gtk_widget_invalidate_recording (widget);
+
   if (!_gtk_widget_get_realized (widget))
     return;
 
@@ -5964,6 +5977,7 @@ gtk_widget_size_allocate_with_baseline (GtkWidget     *widget,
   gint natural_width, natural_height, dummy;
   gint min_width, min_height;
   gint old_baseline;
+  gint64 start_time;
 
   g_return_if_fail (GTK_IS_WIDGET (widget));
 
@@ -6114,11 +6128,15 @@ gtk_widget_size_allocate_with_baseline (GtkWidget     *widget,
   if (!alloc_needed && !size_changed && !position_changed && !baseline_changed)
     goto out;
 
+  gtk_widget_invalidate_recording (widget);
+
   priv->allocated_baseline = baseline;
+  start_time = gtk_widget_timing_begin ();
   if (g_signal_has_handler_pending (widget, widget_signals[SIZE_ALLOCATE], 0, FALSE))
     g_signal_emit (widget, widget_signals[SIZE_ALLOCATE], 0, &real_allocation);
   else
     GTK_WIDGET_GET_CLASS (widget)->size_allocate (widget, &real_allocation);
+  gtk_widget_timing_end (widget, "size-allocate", start_time);
 
   /* Size allocation is god... after consulting god, no further requests or allocations are needed */
 #ifdef G_ENABLE_DEBUG
@@ -6960,6 +6978,268 @@ gtk_cairo_should_draw_window (cairo_t   *cr,
   return tmp == window;
 }
 
+static void
+gtk_widget_emit_draw (GtkWidget *widget,
+                      cairo_t   *cr)
+{
+  gboolean result;
+
+  if (g_signal_has_handler_pending (widget, widget_signals[DRAW], 0, FALSE))
+    {
+      g_signal_emit (widget, widget_signals[DRAW],
+                     0, cr,
+                     &result);
+    }
+  else if (GTK_WIDGET_GET_CLASS (widget)->draw)
+    {
+      cairo_save (cr);
+      GTK_WIDGET_GET_CLASS (widget)->draw (widget, cr);
+      cairo_restore (cr);
+    }
+}
+
+/* Recordings are kept for at most this many widgets, the least
+ * recently replayed ones are dropped first.
+ */
+#define MAX_RETAINED_RECORDINGS 256
+
+static GQueue retained_recordings = G_QUEUE_INIT;
+
+static void gtk_widget_window_invalidated (GdkWindow      *window,
+                                           cairo_region_t *region);
+
+static gboolean
+gtk_widget_retained_drawing_enabled (void)
+{
+  static gint enabled = -1;
+
+  if (G_UNLIKELY (enabled < 0))
+    {
+      enabled = g_strcmp0 (g_getenv ("GTK_RETAINED_DRAWING"), "1") == 0;
+
+      /* Applications may invalidate windows directly instead of
+       * queueing a redraw of the widget */
+      if (enabled)
+        GDK_PRIVATE_CALL (gdk_window_set_invalidate_notify) (gtk_widget_window_invalidated);
+    }
+
+  return enabled;
+}
+
+static void
+check_windowless (GtkWidget *widget,
+                  gpointer   data)
+{
+  gboolean *windowless = data;
+
+  if (*windowless && _gtk_widget_get_has_window (widget))
+    *windowless = FALSE;
+
+  if (*windowless && GTK_IS_CONTAINER (widget))
+    gtk_container_forall (GTK_CONTAINER (widget), check_windowless, windowless);
+}
+
+/* Recordings can only be used if drawing the widget into a recording
+ * surface is the same as drawing it to @cr. This is not the case for
+ * widgets that draw to multiple windows, as the children windows are
+ * drawn separately, and for scaled targets, as the rendering code picks
+ * the resolution of blurs and surfaces from the target.
+ */
+static gboolean
+gtk_widget_should_retain_drawing (GtkWidget *widget,
+                                  cairo_t   *cr)
+{
+  gboolean windowless;
+  double x_scale, y_scale;
+
+  if (!gtk_widget_retained_drawing_enabled ())
+    return FALSE;
+
+  if (!gtk_cairo_should_draw_window (cr, widget->priv->window))
+    return FALSE;
+
+  cairo_surface_get_device_scale (cairo_get_target (cr), &x_scale, &y_scale);
+  if (x_scale != 1.0 || y_scale != 1.0)
+    return FALSE;
+
+  /* Children can only gain windows by being reallocated,
+   * which drops the recording */
+  if (widget->priv->recording)
+    return TRUE;
+
+  windowless = TRUE;
+  check_windowless (widget, &windowless);
+
+  return windowless;
+}
+
+static void
+gtk_widget_draw_retained (GtkWidget *widget,
+                          cairo_t   *cr)
+{
+  GtkWidgetPrivate *priv = widget->priv;
+
+  if (priv->recording == NULL)
+    {
+      cairo_rectangle_t extents;
+      cairo_t *recording_cr;
+
+      extents.x = priv->clip.x - priv->allocation.x;
+      extents.y = priv->clip.y - priv->allocation.y;
+      extents.width = priv->clip.width;
+      extents.height = priv->clip.height;
+
+      priv->recording = cairo_recording_surface_create (CAIRO_CONTENT_COLOR_ALPHA, &extents);
+      recording_cr = cairo_create (priv->recording);
+      gtk_widget_emit_draw (widget, recording_cr);
+      cairo_destroy (recording_cr);
+
+      if (cairo_surface_status (priv->recording))
+        {
+          g_clear_pointer (&priv->recording, cairo_surface_destroy);
+          gtk_widget_emit_draw (widget, cr);
+          return;
+        }
+
+      g_queue_push_head (&retained_recordings, widget);
+      priv->recording_link = retained_recordings.head;
+
+      while (retained_recordings.length > MAX_RETAINED_RECORDINGS)
+        gtk_widget_drop_recording (g_queue_peek_tail (&retained_recordings));
+    }
+  else
+    {
+      g_queue_unlink (&retained_recordings, priv->recording_link);
+      g_queue_push_head_link (&retained_recordings, priv->recording_link);
+    }
+
+  cairo_save (cr);
+  cairo_set_source_surface (cr, priv->recording, 0, 0);
+  cairo_paint (cr);
+  cairo_restore (cr);
+}
+
+/* Per-widget timings, recorded when GDK_FRAME_RECORDER is set */
+static gint64
+gtk_widget_timing_begin (void)
+{
+  static int enabled = -1;
+
+  if (G_UNLIKELY (enabled < 0))
+    enabled = GDK_PRIVATE_CALL (gdk_frame_recorder_is_enabled) ();
+
+  return enabled ? g_get_monotonic_time () : 0;
+}
+
+static void
+gtk_widget_timing_end (GtkWidget  *widget,
+                       const char *category,
+                       gint64      start_time)
+{
+  if (start_time == 0)
+    return;
+
+  GDK_PRIVATE_CALL (gdk_frame_recorder_add) (category,
+                                             G_OBJECT_TYPE_NAME (widget),
+                                             start_time,
+                                             g_get_monotonic_time ());
+}
+
+/* Drops the recordings of @widget and all its ancestors, as their
+ * recordings include the output of @widget.
+ */
+static void
+gtk_widget_invalidate_recording (GtkWidget *widget)
+{
+  for (; widget != NULL; widget = widget->priv->parent)
+    gtk_widget_drop_recording (widget);
+}
+
+static void
+gtk_widget_drop_recording (GtkWidget *widget)
+{
+  GtkWidgetPrivate *priv = widget->priv;
+
+  if (priv->recording == NULL)
+    return;
+
+  g_queue_delete_link (&retained_recordings, priv->recording_link);
+  priv->recording_link = NULL;
+  g_clear_pointer (&priv->recording, cairo_surface_destroy);
+}
+
+typedef struct {
+  GdkWindow *window;
+  cairo_region_t *region;
+} InvalidateRecordingData;
+
+static void
+drop_recordings_in_region (GtkWidget *widget,
+                           gpointer   user_data)
+{
+  InvalidateRecordingData *data = user_data;
+  GtkWidgetPrivate *priv = widget->priv;
+
+  /* Widgets with windows are handled when walking the windows */
+  if (_gtk_widget_get_has_window (widget) ||
+      priv->window != data->window ||
+      cairo_region_contains_rectangle (data->region, &priv->clip) == CAIRO_REGION_OVERLAP_OUT)
+    return;
+
+  if (priv->recording)
+    gtk_widget_invalidate_recording (widget);
+
+  if (GTK_IS_CONTAINER (widget))
+    gtk_container_forall (GTK_CONTAINER (widget), drop_recordings_in_region, data);
+}
+
+/* Called when a region of @window is invalidated directly, drops the
+ * recordings of the widgets drawn in that region, including those in
+ * child windows.
+ */
+static void
+gtk_widget_window_invalidated (GdkWindow      *window,
+                               cairo_region_t *region)
+{
+  InvalidateRecordingData data;
+  GtkWidget *widget = NULL;
+  GList *l;
+
+  if (g_queue_is_empty (&retained_recordings))
+    return;
+
+  gdk_window_get_user_data (window, (gpointer *) &widget);
+  if (GTK_IS_CONTAINER (widget))
+    {
+      data.window = window;
+      data.region = region;
+      gtk_container_forall (GTK_CONTAINER (widget), drop_recordings_in_region, &data);
+    }
+
+  for (l = gdk_window_peek_children (window); l != NULL; l = l->next)
+    {
+      GdkWindow *child = l->data;
+      cairo_rectangle_int_t rect;
+      cairo_region_t *child_region;
+
+      if (!gdk_window_is_viewable (child))
+        continue;
+
+      gdk_window_get_position (child, &rect.x, &rect.y);
+      rect.width = gdk_window_get_width (child);
+      rect.height = gdk_window_get_height (child);
+
+      child_region = cairo_region_copy (region);
+      cairo_region_intersect_rectangle (child_region, &rect);
+      if (!cairo_region_is_empty (child_region))
+        {
+          cairo_region_translate (child_region, -rect.x, -rect.y);
+          gtk_widget_window_invalidated (child, child_region);
+        }
+      cairo_region_destroy (child_region);
+    }
+}
+
 void
 gtk_widget_draw_internal (GtkWidget *widget,
                           cairo_t   *cr,
@@ -6981,8 +7261,8 @@ gtk_widget_draw_internal (GtkWidget *widget,
   if (gdk_cairo_get_clip_rectangle (cr, NULL))
     {
       GdkWindow *event_window = NULL;
-      gboolean result;
       gboolean push_group;
+      gint64 start_time;
 
       /* If this was a cairo_t passed via gtk_widget_draw() then we don't
        * require a window; otherwise we check for the window associated
@@ -7014,18 +7294,12 @@ gtk_widget_draw_internal (GtkWidget *widget,
         g_warning ("%s %p is drawn without a current allocation. This should not happen.", G_OBJECT_TYPE_NAME (widget), widget);
 #endif
 
-      if (g_signal_has_handler_pending (widget, widget_signals[DRAW], 0, FALSE))
-        {
-          g_signal_emit (widget, widget_signals[DRAW],
-                         0, cr,
-                         &result);
-        }
-      else if (GTK_WIDGET_GET_CLASS (widget)->draw)
-        {
-          cairo_save (cr);
-          GTK_WIDGET_GET_CLASS (widget)->draw (widget, cr);
-          cairo_restore (cr);
-        }
+      start_time = gtk_widget_timing_begin ();
+      if (gtk_widget_should_retain_drawing (widget, cr))
+        gtk_widget_draw_retained (widget, cr);
+      else
+        gtk_widget_emit_draw (widget, cr);
+      gtk_widget_timing_end (widget, "draw", start_time);
 
 #ifdef G_ENABLE_DEBUG
       if (GTK_DISPLAY_DEBUG_CHECK (gtk_widget_get_display (widget), BASELINES))
@@ -12306,6 +12580,8 @@ gtk_widget_finalize (GObject *object)
 
   g_clear_object (&priv->context);
 
+  gtk_widget_drop_recording (widget);
+
   _gtk_size_request_cache_free (&priv->requests);
 
   for (l = priv->event_controllers; l; l = l->next)
@@ -12853,6 +13129,8 @@ gtk_widget_propagate_state (GtkWidget    *widget,
     {
       g_object_ref (widget);
 
+      gtk_widget_invalidate_recording (widget);
+
       if (!gtk_widget_is_sensitive (widget) && gtk_widget_has_grab (widget))
         gtk_grab_remove (widget);
 
@@ -16547,6 +16825,8 @@ gtk_widget_class_get_css_name (GtkWidgetClass *widget_class)
 void
 _gtk_widget_style_context_invalidated (GtkWidget *widget)
 {
+  gtk_widget_invalidate_recording (widget);
+
   g_signal_emit (widget, widget_signals[STYLE_UPDATED], 0);
 }
 
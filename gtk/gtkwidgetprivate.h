@@ -158,6 +158,12 @@ struct _GtkWidgetPrivate
 
   GList *event_controllers;
 
+  /* Recorded output of the last draw, replayed until the
+   * widget or one of its children needs to be redrawn.
+   */
+  cairo_surface_t *recording;
+  GList *recording_link;
+
   AtkObject *accessible;
 };
 
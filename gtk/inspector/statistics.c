@@ -27,6 +27,7 @@
 #include "gtkcelllayout.h"
 #include "gtksearchbar.h"
 #include "gtklabel.h"
+#include "gtkcssstaticstyleprivate.h"
 
 enum
 {
@@ -54,6 +55,7 @@ struct _GtkInspectorStatisticsPrivate
   guint update_source_id;
   GtkWidget *search_entry;
   GtkWidget *search_bar;
+  GtkWidget *css_statistics;
 };
 
 typedef struct {
@@ -125,6 +127,25 @@ add_type_count (GtkInspectorStatistics *sl, GType type)
   return cumulative;
 }
 
+static void
+update_css_statistics (GtkInspectorStatistics *sl)
+{
+  GtkCssStaticStyleStatistics stats;
+  gchar *size, *saved, *text;
+
+  gtk_css_static_style_get_statistics (&stats);
+
+  size = g_format_size (stats.size);
+  saved = g_format_size (stats.unshared_size > stats.size ? stats.unshared_size - stats.size : 0);
+  text = g_strdup_printf (_("CSS styles: %u, value blocks: %u, size: %s, saved by sharing: %s"),
+                          stats.n_styles, stats.n_blocks, size, saved);
+  gtk_label_set_text (GTK_LABEL (sl->priv->css_statistics), text);
+
+  g_free (text);
+  g_free (saved);
+  g_free (size);
+}
+
 static gboolean
 update_type_counts (gpointer data)
 {
@@ -144,6 +165,8 @@ update_type_counts (gpointer data)
       add_type_count (sl, type);
     }
 
+  update_css_statistics (sl);
+
   return TRUE;
 }
 
@@ -463,6 +486,7 @@ gtk_inspector_statistics_class_init (GtkInspectorStatisticsClass *klass)
   gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorStatistics, search_entry);
   gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorStatistics, search_bar);
   gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorStatistics, excuse);
+  gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorStatistics, css_statistics);
 
 }
 
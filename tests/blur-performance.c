@@ -16,6 +16,16 @@ init_surface (cairo_t *cr)
   cairo_fill (cr);
 }
 
+static const struct {
+  GtkBlurImplementation impl;
+  const char *name;
+} implementations[] = {
+  { GTK_BLUR_IMPLEMENTATION_SCALAR, "scalar" },
+  { GTK_BLUR_IMPLEMENTATION_SSE2, "sse2" },
+  { GTK_BLUR_IMPLEMENTATION_AVX2, "avx2" },
+  { GTK_BLUR_IMPLEMENTATION_NEON, "neon" }
+};
+
 int
 main (int argc, char **argv)
 {
@@ -23,7 +33,7 @@ main (int argc, char **argv)
   cairo_t *cr;
   GTimer *timer;
   double msec;
-  int i, j;
+  int i, j, k;
   int size;
 
   timer = g_timer_new ();
@@ -34,18 +44,29 @@ main (int argc, char **argv)
 
   cr = cairo_create (surface);
 
-  /* We do everything three times, first two as warmup */
-  for (j = 0; j < 2; j++)
+  for (k = 0; k < G_N_ELEMENTS (implementations); k++)
     {
-      for (i = 1; i < 16; i++)
-	{
-	  init_surface (cr);
-	  g_timer_start (timer);
-	  _gtk_cairo_blur_surface (surface, i, GTK_BLUR_X | GTK_BLUR_Y);
-	  msec = g_timer_elapsed (timer, NULL) * 1000;
-	  if (j == 1)
-	    g_print ("Radius %2d: %.2f msec, %.2f kpixels/msec:\n", i, msec, size*size/(msec*1000));
-	}
+      if (!_gtk_cairo_blur_set_implementation (implementations[k].impl))
+        {
+          g_print ("%s: not supported\n", implementations[k].name);
+          continue;
+        }
+
+      g_print ("%s:\n", implementations[k].name);
+
+      /* We do everything three times, first two as warmup */
+      for (j = 0; j < 2; j++)
+        {
+          for (i = 1; i < 16; i++)
+            {
+              init_surface (cr);
+              g_timer_start (timer);
+              _gtk_cairo_blur_surface (surface, i, GTK_BLUR_X | GTK_BLUR_Y);
+              msec = g_timer_elapsed (timer, NULL) * 1000;
+              if (j == 1)
+                g_print ("Radius %2d: %.2f msec, %.2f kpixels/msec:\n", i, msec, size*size/(msec*1000));
+            }
+        }
     }
 
   g_timer_destroy (timer);
@@ -1,34 +1,124 @@
 #include <gtk/gtk.h>
 #include <math.h>
 
+typedef struct {
+  gdouble x, y;
+  gdouble pressure;
+} TrailPoint;
+
+typedef struct {
+  int cursor_x, cursor_y;
+  GArray *history;
+} Trail;
+
 GtkAdjustment *adjustment;
-int cursor_x, cursor_y;
 
-static void
-on_motion_notify (GtkWidget      *window,
-                  GdkEventMotion *event)
+static Trail *
+trail_new (void)
+{
+  Trail *trail = g_new0 (Trail, 1);
+
+  trail->history = g_array_new (FALSE, FALSE, sizeof (TrailPoint));
+
+  return trail;
+}
+
+static gboolean
+on_motion_notify (GtkWidget      *widget,
+                  GdkEventMotion *event,
+                  Trail          *trail)
 {
-  if (event->window == gtk_widget_get_window (window))
+  if (event->window == gtk_widget_get_window (widget))
     {
       float processing_ms = gtk_adjustment_get_value (adjustment);
+      GdkTimeCoord **coords;
+      gint n_coords, i;
+
       g_usleep (processing_ms * 1000);
-      cursor_x = event->x;
-      cursor_y = event->y;
-      gtk_widget_queue_draw (window);
+
+      /* Keep the positions that were compressed into this event, so
+       * we can show what would otherwise have been lost. With a tablet,
+       * the pressure is shown as the width of the trail.
+       */
+      g_array_set_size (trail->history, 0);
+      if (gdk_event_get_history ((GdkEvent *) event, &coords, &n_coords))
+        {
+          for (i = 0; i < n_coords; i++)
+            {
+              TrailPoint point;
+
+              if (!gdk_device_get_axis (event->device, coords[i]->axes, GDK_AXIS_PRESSURE, &point.pressure))
+                point.pressure = 0.5;
+
+              if (gdk_device_get_axis (event->device, coords[i]->axes, GDK_AXIS_X, &point.x) &&
+                  gdk_device_get_axis (event->device, coords[i]->axes, GDK_AXIS_Y, &point.y))
+                g_array_append_val (trail->history, point);
+            }
+
+          gdk_device_free_history (coords, n_coords);
+        }
+
+      trail->cursor_x = event->x;
+      trail->cursor_y = event->y;
+      gtk_widget_queue_draw (widget);
     }
+
+  return FALSE;
 }
 
-static void
-on_draw (GtkWidget *window,
-         cairo_t   *cr)
+static gboolean
+on_draw (GtkWidget *widget,
+         cairo_t   *cr,
+         Trail     *trail)
 {
+  guint i;
+
   cairo_set_source_rgb (cr, 1, 1, 1);
   cairo_paint (cr);
 
   cairo_set_source_rgb (cr, 0, 0.5, 0.5);
 
-  cairo_arc (cr, cursor_x, cursor_y, 10, 0, 2 * M_PI);
+  cairo_arc (cr, trail->cursor_x, trail->cursor_y, 10, 0, 2 * M_PI);
   cairo_stroke (cr);
+
+  cairo_set_source_rgb (cr, 0.8, 0, 0);
+  cairo_set_line_cap (cr, CAIRO_LINE_CAP_ROUND);
+
+  for (i = 0; i < trail->history->len; i++)
+    {
+      TrailPoint *point = &g_array_index (trail->history, TrailPoint, i);
+      gdouble next_x, next_y;
+
+      if (i + 1 < trail->history->len)
+        {
+          next_x = g_array_index (trail->history, TrailPoint, i + 1).x;
+          next_y = g_array_index (trail->history, TrailPoint, i + 1).y;
+        }
+      else
+        {
+          next_x = trail->cursor_x;
+          next_y = trail->cursor_y;
+        }
+
+      cairo_set_line_width (cr, 1 + 4 * point->pressure);
+      cairo_move_to (cr, point->x, point->y);
+      cairo_line_to (cr, next_x, next_y);
+      cairo_stroke (cr);
+    }
+
+  return FALSE;
+}
+
+static void
+track_motion (GtkWidget *widget)
+{
+  Trail *trail = trail_new ();
+
+  gtk_widget_add_events (widget, GDK_POINTER_MOTION_MASK);
+  g_signal_connect (widget, "motion-notify-event",
+                    G_CALLBACK (on_motion_notify), trail);
+  g_signal_connect (widget, "draw",
+                    G_CALLBACK (on_draw), trail);
 }
 
 int
@@ -38,18 +128,30 @@ main (int argc, char **argv)
   GtkWidget *vbox;
   GtkWidget *label;
   GtkWidget *scale;
+  GtkWidget *area;
 
   gtk_init (&argc, &argv);
 
   window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
   gtk_window_set_default_size (GTK_WINDOW (window), 300, 300);
   gtk_widget_set_app_paintable (window, TRUE);
-  gtk_widget_add_events (window, GDK_POINTER_MOTION_MASK);
-  gtk_widget_set_app_paintable (window, TRUE);
+  track_motion (window);
 
   vbox = gtk_box_new (GTK_ORIENTATION_VERTICAL, 0);
   gtk_container_add (GTK_CONTAINER (window), vbox);
 
+  /* The drawing area has a child window of its own, so the positions
+   * in its history need to be translated from the toplevel.
+   */
+  area = gtk_drawing_area_new ();
+  gtk_widget_set_size_request (area, 150, 100);
+  gtk_widget_set_halign (area, GTK_ALIGN_END);
+  gtk_widget_set_valign (area, GTK_ALIGN_END);
+  gtk_widget_set_margin_end (area, 20);
+  gtk_widget_set_vexpand (area, TRUE);
+  track_motion (area);
+  gtk_box_pack_start (GTK_BOX (vbox), area, TRUE, TRUE, 0);
+
   adjustment = gtk_adjustment_new (20, 0, 200, 1, 10, 0);
   scale = gtk_scale_new (GTK_ORIENTATION_HORIZONTAL, adjustment);
   gtk_box_pack_end (GTK_BOX (vbox), scale, FALSE, FALSE, 0);
@@ -58,10 +160,6 @@ main (int argc, char **argv)
   gtk_widget_set_halign (label, GTK_ALIGN_CENTER);
   gtk_box_pack_end (GTK_BOX (vbox), label, FALSE, FALSE, 0);
 
-  g_signal_connect (window, "motion-notify-event",
-                    G_CALLBACK (on_motion_notify), NULL);
-  g_signal_connect (window, "draw",
-                    G_CALLBACK (on_draw), NULL);
   g_signal_connect (window, "destroy",
                     G_CALLBACK (gtk_main_quit), NULL);
 
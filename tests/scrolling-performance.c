@@ -88,7 +88,10 @@ scroll_viewport (GtkWidget     *viewport,
   return TRUE;
 }
 
+static int rows = 2;
+
 static GOptionEntry options[] = {
+  { "rows", 'r', 0, G_OPTION_ARG_INT, &rows, "Rows of content, more rows make a longer document", "ROWS" },
   { NULL }
 };
 
@@ -127,7 +130,7 @@ main (int argc, char **argv)
   grid = gtk_grid_new ();
   gtk_container_add (GTK_CONTAINER (viewport), grid);
 
-  for (i = 0; i < 4; i++)
+  for (i = 0; i < 2 * rows; i++)
     {
       GtkWidget *content = create_widget_factory_content ();
       gtk_grid_attach (GTK_GRID (grid), content,
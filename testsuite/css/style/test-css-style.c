@@ -179,6 +179,242 @@ add_test_for_file (GFile *file)
   g_free (path);
 }
 
+/* Descendant selectors, matched with the help of the ancestor filter.
+ * The filter is used when the styles of a whole toplevel are
+ * validated, which happens when it is shown.
+ */
+
+static GtkCssProvider *
+add_provider (const char *css)
+{
+  GtkCssProvider *provider;
+  GError *error = NULL;
+
+  provider = gtk_css_provider_new ();
+  gtk_css_provider_load_from_data (provider, css, -1, &error);
+  g_assert_no_error (error);
+  gtk_style_context_add_provider_for_screen (gdk_screen_get_default (),
+                                             GTK_STYLE_PROVIDER (provider),
+                                             GTK_STYLE_PROVIDER_PRIORITY_FORCE);
+
+  return provider;
+}
+
+static void
+remove_provider (GtkCssProvider *provider)
+{
+  gtk_style_context_remove_provider_for_screen (gdk_screen_get_default (),
+                                                GTK_STYLE_PROVIDER (provider));
+  g_object_unref (provider);
+}
+
+static void
+revalidate (GtkWidget *window)
+{
+  gtk_widget_hide (window);
+  gtk_widget_show (window);
+}
+
+static gboolean
+matches (GtkWidget *widget)
+{
+  GtkStyleContext *context;
+  GdkRGBA color, red = { 1, 0, 0, 1 };
+
+  context = gtk_widget_get_style_context (widget);
+  gtk_style_context_get_color (context, gtk_style_context_get_state (context), &color);
+
+  return gdk_rgba_equal (&color, &red);
+}
+
+static GtkWidget *
+add_box (GtkWidget  *parent,
+         const char *style_class)
+{
+  GtkWidget *box;
+
+  box = gtk_box_new (GTK_ORIENTATION_VERTICAL, 0);
+  if (style_class)
+    gtk_style_context_add_class (gtk_widget_get_style_context (box), style_class);
+  gtk_container_add (GTK_CONTAINER (parent), box);
+
+  return box;
+}
+
+static GtkWidget *
+add_label (GtkWidget  *parent,
+           const char *style_class)
+{
+  GtkWidget *label;
+
+  label = gtk_label_new ("Hello World!");
+  gtk_style_context_add_class (gtk_widget_get_style_context (label), style_class);
+  gtk_container_add (GTK_CONTAINER (parent), label);
+
+  return label;
+}
+
+static void
+move_widget (GtkWidget *widget,
+             GtkWidget *new_parent)
+{
+  g_object_ref (widget);
+  gtk_container_remove (GTK_CONTAINER (gtk_widget_get_parent (widget)), widget);
+  gtk_container_add (GTK_CONTAINER (new_parent), widget);
+  g_object_unref (widget);
+}
+
+static void
+test_descendant_reparent (void)
+{
+  GtkCssProvider *provider;
+  GtkWidget *window, *root, *outer, *middle, *other, *label;
+
+  provider = add_provider ("* { color: blue; }\n"
+                           ".a .b .c { color: red; }");
+
+  window = gtk_window_new (GTK_WINDOW_POPUP);
+  root = add_box (window, NULL);
+  outer = add_box (root, "a");
+  middle = add_box (outer, "b");
+  label = add_label (middle, "c");
+  other = add_box (root, "x");
+  gtk_widget_show_all (window);
+  g_assert (matches (label));
+
+  /* Away from the ancestor with .a */
+  move_widget (middle, other);
+  revalidate (window);
+  g_assert (!matches (label));
+
+  /* And back */
+  move_widget (middle, outer);
+  revalidate (window);
+  g_assert (matches (label));
+
+  /* Below a different ancestor that matches */
+  move_widget (middle, other);
+  gtk_style_context_add_class (gtk_widget_get_style_context (other), "a");
+  revalidate (window);
+  g_assert (matches (label));
+
+  /* Moving the label alone out of .b */
+  move_widget (label, other);
+  revalidate (window);
+  g_assert (!matches (label));
+
+  gtk_widget_destroy (window);
+  remove_provider (provider);
+}
+
+static void
+test_descendant_changes (void)
+{
+  GtkCssProvider *provider;
+  GtkStyleContext *context;
+  GtkWidget *window, *outer, *middle, *label;
+
+  provider = add_provider ("* { color: blue; }\n"
+                           ".a .b .c { color: red; }\n"
+                           "#one #two .d { color: red; }");
+
+  window = gtk_window_new (GTK_WINDOW_POPUP);
+  outer = add_box (window, "a");
+  middle = add_box (outer, "b");
+  label = add_label (middle, "c");
+  gtk_widget_show_all (window);
+  g_assert (matches (label));
+
+  /* Classes of an ancestor */
+  context = gtk_widget_get_style_context (outer);
+  gtk_style_context_remove_class (context, "a");
+  revalidate (window);
+  g_assert (!matches (label));
+  gtk_style_context_add_class (context, "a");
+  revalidate (window);
+  g_assert (matches (label));
+
+  /* Classes of the node itself */
+  context = gtk_widget_get_style_context (label);
+  gtk_style_context_remove_class (context, "c");
+  revalidate (window);
+  g_assert (!matches (label));
+  gtk_style_context_add_class (context, "d");
+  revalidate (window);
+  g_assert (!matches (label));
+
+  /* Names of ancestors */
+  gtk_widget_set_name (outer, "one");
+  gtk_widget_set_name (middle, "two");
+  revalidate (window);
+  g_assert (matches (label));
+  gtk_widget_set_name (outer, "three");
+  revalidate (window);
+  g_assert (!matches (label));
+  gtk_widget_set_name (outer, "one");
+  revalidate (window);
+  g_assert (matches (label));
+
+  gtk_widget_destroy (window);
+  remove_provider (provider);
+}
+
+#define DEPTH 64
+#define CLASSES_PER_LEVEL 16
+
+static void
+test_descendant_deep (void)
+{
+  GtkCssProvider *provider;
+  GtkWidget *window, *boxes[DEPTH], *label;
+  int i, j;
+
+  provider = add_provider ("* { color: blue; }\n"
+                           ".a .b .c { color: red; }");
+
+  /* Enough distinct classes on the way to fill up the filter */
+  window = gtk_window_new (GTK_WINDOW_POPUP);
+  for (i = 0; i < DEPTH; i++)
+    {
+      boxes[i] = add_box (i == 0 ? window : boxes[i - 1], NULL);
+
+      for (j = 0; j < CLASSES_PER_LEVEL; j++)
+        {
+          char *style_class = g_strdup_printf ("level-%d-%d", i, j);
+          gtk_style_context_add_class (gtk_widget_get_style_context (boxes[i]), style_class);
+          g_free (style_class);
+        }
+    }
+  gtk_style_context_add_class (gtk_widget_get_style_context (boxes[0]), "a");
+  gtk_style_context_add_class (gtk_widget_get_style_context (boxes[DEPTH / 2]), "b");
+  label = add_label (boxes[DEPTH - 1], "c");
+  gtk_widget_show_all (window);
+  g_assert (matches (label));
+
+  gtk_style_context_remove_class (gtk_widget_get_style_context (boxes[DEPTH / 2]), "b");
+  revalidate (window);
+  g_assert (!matches (label));
+
+  gtk_style_context_add_class (gtk_widget_get_style_context (boxes[DEPTH - 1]), "b");
+  revalidate (window);
+  g_assert (matches (label));
+
+  /* .b and .c on the same node are not enough */
+  gtk_style_context_remove_class (gtk_widget_get_style_context (boxes[DEPTH - 1]), "b");
+  gtk_style_context_add_class (gtk_widget_get_style_context (label), "b");
+  revalidate (window);
+  g_assert (!matches (label));
+
+  /* The lower half of the tree, moved right below .a */
+  gtk_style_context_add_class (gtk_widget_get_style_context (boxes[DEPTH / 2]), "b");
+  move_widget (boxes[DEPTH / 2], boxes[0]);
+  revalidate (window);
+  g_assert (matches (label));
+
+  gtk_widget_destroy (window);
+  remove_provider (provider);
+}
+
 static int
 compare_files (gconstpointer a, gconstpointer b)
 {
@@ -256,6 +492,10 @@ main (int argc, char **argv)
       dir = g_file_new_for_path (basedir);
       add_tests_for_files_in_directory (dir);
 
+      g_test_add_func ("/style/descendant/reparent", test_descendant_reparent);
+      g_test_add_func ("/style/descendant/changes", test_descendant_changes);
+      g_test_add_func ("/style/descendant/deep", test_descendant_deep);
+
       g_object_unref (dir);
     }
   else if (strcmp (argv[1], "--generate") == 0)
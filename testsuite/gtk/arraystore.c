@@ -0,0 +1,385 @@
+/* GtkArrayStore tests.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtk/gtk.h>
+
+#include "treemodel.h"
+
+static gint
+iter_index (GtkArrayStore *store,
+            GtkTreeIter   *iter)
+{
+  GtkTreePath *path;
+  gint index;
+
+  path = gtk_tree_model_get_path (GTK_TREE_MODEL (store), iter);
+  g_assert (path != NULL);
+  index = gtk_tree_path_get_indices (path)[0];
+  gtk_tree_path_free (path);
+
+  return index;
+}
+
+static void
+check_int_column (GtkArrayStore *store,
+                  const gint    *expected,
+                  gint           n_expected)
+{
+  GtkTreeModel *model = GTK_TREE_MODEL (store);
+  GtkTreeIter iter;
+  gboolean valid;
+  gint i = 0;
+
+  g_assert_cmpint (gtk_tree_model_iter_n_children (model, NULL), ==, n_expected);
+
+  for (valid = gtk_tree_model_get_iter_first (model, &iter);
+       valid;
+       valid = gtk_tree_model_iter_next (model, &iter))
+    {
+      gint value;
+
+      g_assert_cmpint (i, <, n_expected);
+      gtk_tree_model_get (model, &iter, 0, &value, -1);
+      g_assert_cmpint (value, ==, expected[i]);
+      g_assert_cmpint (iter_index (store, &iter), ==, i);
+      i++;
+    }
+
+  g_assert_cmpint (i, ==, n_expected);
+}
+
+static void
+array_store_test_insert (void)
+{
+  GtkArrayStore *store;
+  GtkTreeIter iter;
+  const gint expected[] = { 2, 0, 3, 1 };
+
+  store = gtk_array_store_new (1, G_TYPE_INT);
+
+  gtk_array_store_append (store, &iter);
+  gtk_array_store_set (store, &iter, 0, 0, -1);
+  gtk_array_store_append (store, &iter);
+  gtk_array_store_set (store, &iter, 0, 1, -1);
+  gtk_array_store_insert (store, &iter, 0);
+  gtk_array_store_set (store, &iter, 0, 2, -1);
+  g_assert (gtk_array_store_iter_is_valid (store, &iter));
+  g_assert_cmpint (iter_index (store, &iter), ==, 0);
+  gtk_array_store_insert (store, &iter, 2);
+  gtk_array_store_set (store, &iter, 0, 3, -1);
+
+  check_int_column (store, expected, G_N_ELEMENTS (expected));
+
+  /* Higher positions append */
+  gtk_array_store_insert (store, &iter, 100);
+  g_assert_cmpint (iter_index (store, &iter), ==, 4);
+
+  g_object_unref (store);
+}
+
+static void
+array_store_test_remove (void)
+{
+  GtkArrayStore *store;
+  GtkTreeIter iter, old;
+  const gint expected[] = { 0, 2, 3 };
+  gint i;
+
+  store = gtk_array_store_new (1, G_TYPE_INT);
+
+  for (i = 0; i < 5; i++)
+    {
+      gtk_array_store_append (store, &iter);
+      gtk_array_store_set (store, &iter, 0, i, -1);
+    }
+
+  gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter, NULL, 1);
+  old = iter;
+  g_assert (gtk_array_store_remove (store, &iter));
+  g_assert_cmpint (iter_index (store, &iter), ==, 1);
+  /* Iters do not persist */
+  g_assert (!gtk_array_store_iter_is_valid (store, &old));
+
+  gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter, NULL, 3);
+  g_assert (!gtk_array_store_remove (store, &iter));
+  g_assert (!gtk_array_store_iter_is_valid (store, &iter));
+
+  check_int_column (store, expected, G_N_ELEMENTS (expected));
+
+  gtk_array_store_clear (store);
+  check_int_column (store, NULL, 0);
+
+  g_object_unref (store);
+}
+
+static void
+array_store_test_types (void)
+{
+  GtkArrayStore *store;
+  GtkTreeIter iter;
+  GObject *object;
+  gboolean b;
+  guint u;
+  gint64 i64;
+  gdouble d;
+  gfloat f;
+  gchar *s;
+  GObject *o;
+  GtkOrientation e;
+
+  object = g_object_new (G_TYPE_OBJECT, NULL);
+
+  store = gtk_array_store_new (8,
+                               G_TYPE_BOOLEAN,
+                               G_TYPE_UINT,
+                               G_TYPE_INT64,
+                               G_TYPE_DOUBLE,
+                               G_TYPE_FLOAT,
+                               G_TYPE_STRING,
+                               G_TYPE_OBJECT,
+                               GTK_TYPE_ORIENTATION);
+
+  gtk_array_store_append (store, &iter);
+  gtk_array_store_set (store, &iter,
+                       0, TRUE,
+                       1, G_MAXUINT,
+                       2, G_MININT64,
+                       3, 0.25,
+                       4, 0.5f,
+                       5, "foo",
+                       6, object,
+                       7, GTK_ORIENTATION_VERTICAL,
+                       -1);
+
+  gtk_tree_model_get (GTK_TREE_MODEL (store), &iter,
+                      0, &b,
+                      1, &u,
+                      2, &i64,
+                      3, &d,
+                      4, &f,
+                      5, &s,
+                      6, &o,
+                      7, &e,
+                      -1);
+
+  g_assert (b);
+  g_assert_cmpuint (u, ==, G_MAXUINT);
+  g_assert_cmpint (i64, ==, G_MININT64);
+  g_assert_cmpfloat (d, ==, 0.25);
+  g_assert_cmpfloat (f, ==, 0.5f);
+  g_assert_cmpstr (s, ==, "foo");
+  g_assert (o == object);
+  g_assert_cmpint (e, ==, GTK_ORIENTATION_VERTICAL);
+
+  g_free (s);
+  g_object_unref (o);
+
+  /* The store holds a reference until the row goes away */
+  g_object_add_weak_pointer (object, (gpointer *) &object);
+  g_object_unref (object);
+  g_assert (object != NULL);
+  gtk_array_store_clear (store);
+  g_assert (object == NULL);
+
+  g_object_unref (store);
+}
+
+static void
+array_store_test_set_gvalue_to_transform (void)
+{
+  GtkArrayStore *store;
+  GtkTreeIter iter;
+  GValue value = G_VALUE_INIT;
+  gint i;
+
+  store = gtk_array_store_new (1, G_TYPE_INT);
+  gtk_array_store_append (store, &iter);
+
+  g_value_init (&value, G_TYPE_CHAR);
+  g_value_set_schar (&value, 42);
+  gtk_array_store_set_value (store, &iter, 0, &value);
+  g_value_unset (&value);
+
+  gtk_tree_model_get (GTK_TREE_MODEL (store), &iter, 0, &i, -1);
+  g_assert_cmpint (i, ==, 42);
+
+  g_object_unref (store);
+}
+
+static void
+count_rows (GtkTreeModel *model,
+            GtkTreePath  *path,
+            GtkTreeIter  *iter,
+            gpointer      data)
+{
+  (*(gint *) data)++;
+}
+
+static void
+count_ranges (GtkTreeModel *model,
+              GtkTreePath  *path,
+              GtkTreeIter  *iter,
+              gint          n_rows,
+              gpointer      data)
+{
+  (*(gint *) data)++;
+}
+
+static void
+array_store_test_column_data (void)
+{
+  GtkArrayStore *store;
+  GtkTreeIter iter;
+  const gint ints[] = { 10, 11, 12, 13 };
+  const gchar *strings[] = { "a", "b", NULL, "a" };
+  const gint expected[] = { 10, 11, 12, 13 };
+  gint first, inserted = 0, ranges = 0, changed = 0;
+  gchar *s1, *s2;
+
+  store = gtk_array_store_new (2, G_TYPE_INT, G_TYPE_STRING);
+  g_signal_connect (store, "row-inserted", G_CALLBACK (count_rows), &inserted);
+  g_signal_connect (store, "rows-inserted", G_CALLBACK (count_ranges), &ranges);
+  g_signal_connect (store, "row-changed", G_CALLBACK (count_rows), &changed);
+
+  first = gtk_array_store_append_rows (store, 0);
+  g_assert_cmpint (first, ==, 0);
+  g_assert_cmpint (inserted, ==, 0);
+  g_assert_cmpint (ranges, ==, 0);
+
+  first = gtk_array_store_append_rows (store, 4);
+  g_assert_cmpint (first, ==, 0);
+  g_assert_cmpint (inserted, ==, 4);
+  g_assert_cmpint (ranges, ==, 1);
+
+  gtk_array_store_set_column_data (store, 0, 0, 4, ints);
+  gtk_array_store_set_column_data (store, 1, 0, 4, strings);
+  g_assert_cmpint (changed, ==, 8);
+
+  check_int_column (store, expected, G_N_ELEMENTS (expected));
+
+  gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter, NULL, 2);
+  gtk_tree_model_get (GTK_TREE_MODEL (store), &iter, 1, &s1, -1);
+  g_assert (s1 == NULL);
+
+  gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter, NULL, 3);
+  gtk_tree_model_get (GTK_TREE_MODEL (store), &iter, 1, &s2, -1);
+  g_assert_cmpstr (s2, ==, "a");
+  g_free (s2);
+
+  first = gtk_array_store_append_rows (store, 2);
+  g_assert_cmpint (first, ==, 4);
+  g_assert_cmpint (gtk_tree_model_iter_n_children (GTK_TREE_MODEL (store), NULL), ==, 6);
+
+  g_object_unref (store);
+}
+
+static void
+array_store_test_rows_data (void)
+{
+  GtkArrayStore *store;
+  GtkTreeIter iter;
+  const gint ints[] = { 10, 11, 12, 13 };
+  const gchar *strings[] = { "a", "b", NULL, "a" };
+  const gint replaced[] = { 20, 21 };
+  const gint expected[] = { 10, 20, 21, 13, 0, 0 };
+  gconstpointer columns[2];
+  gint first, inserted = 0, ranges = 0, changed = 0;
+  gchar *s;
+
+  store = gtk_array_store_new (2, G_TYPE_INT, G_TYPE_STRING);
+  g_signal_connect (store, "row-inserted", G_CALLBACK (count_rows), &inserted);
+  g_signal_connect (store, "rows-inserted", G_CALLBACK (count_ranges), &ranges);
+  g_signal_connect (store, "row-changed", G_CALLBACK (count_rows), &changed);
+
+  /* Filled rows are announced once and never as changed */
+  columns[0] = ints;
+  columns[1] = strings;
+  first = gtk_array_store_append_rows_with_data (store, 4, columns);
+  g_assert_cmpint (first, ==, 0);
+  g_assert_cmpint (ranges, ==, 1);
+  g_assert_cmpint (inserted, ==, 4);
+  g_assert_cmpint (changed, ==, 0);
+
+  gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter, NULL, 1);
+  gtk_tree_model_get (GTK_TREE_MODEL (store), &iter, 1, &s, -1);
+  g_assert_cmpstr (s, ==, "b");
+  g_free (s);
+
+  /* Columns without data are left empty */
+  first = gtk_array_store_append_rows_with_data (store, 2, NULL);
+  g_assert_cmpint (first, ==, 4);
+  g_assert_cmpint (ranges, ==, 2);
+  g_assert_cmpint (inserted, ==, 6);
+  g_assert_cmpint (changed, ==, 0);
+
+  /* Replacing rows emits one row-changed per row, not per column */
+  columns[0] = replaced;
+  columns[1] = NULL;
+  gtk_array_store_set_rows_data (store, 1, 2, columns);
+  g_assert_cmpint (changed, ==, 2);
+  g_assert_cmpint (inserted, ==, 6);
+
+  check_int_column (store, expected, G_N_ELEMENTS (expected));
+
+  gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter, NULL, 1);
+  gtk_tree_model_get (GTK_TREE_MODEL (store), &iter, 1, &s, -1);
+  g_assert_cmpstr (s, ==, "b");
+  g_free (s);
+
+  g_object_unref (store);
+}
+
+static void
+array_store_test_path_to_iter (void)
+{
+  GtkArrayStore *store;
+  GtkTreeIter iter;
+  GtkTreePath *path;
+  gint first;
+
+  store = gtk_array_store_new (1, G_TYPE_INT);
+  first = gtk_array_store_append_rows (store, 1000);
+  g_assert_cmpint (first, ==, 0);
+
+  path = gtk_tree_path_new_from_indices (999, -1);
+  g_assert (gtk_tree_model_get_iter (GTK_TREE_MODEL (store), &iter, path));
+  g_assert_cmpint (iter_index (store, &iter), ==, 999);
+  g_assert (!gtk_tree_model_iter_next (GTK_TREE_MODEL (store), &iter));
+  gtk_tree_path_free (path);
+
+  path = gtk_tree_path_new_from_indices (1000, -1);
+  g_assert (!gtk_tree_model_get_iter (GTK_TREE_MODEL (store), &iter, path));
+  gtk_tree_path_free (path);
+
+  path = gtk_tree_path_new_from_indices (1, 0, -1);
+  g_assert (!gtk_tree_model_get_iter (GTK_TREE_MODEL (store), &iter, path));
+  gtk_tree_path_free (path);
+
+  g_object_unref (store);
+}
+
+void
+register_array_store_tests (void)
+{
+  g_test_add_func ("/ArrayStore/insert", array_store_test_insert);
+  g_test_add_func ("/ArrayStore/remove", array_store_test_remove);
+  g_test_add_func ("/ArrayStore/types", array_store_test_types);
+  g_test_add_func ("/ArrayStore/set-gvalue-to-transform",
+                   array_store_test_set_gvalue_to_transform);
+  g_test_add_func ("/ArrayStore/column-data", array_store_test_column_data);
+  g_test_add_func ("/ArrayStore/rows-data", array_store_test_rows_data);
+  g_test_add_func ("/ArrayStore/path-to-iter", array_store_test_path_to_iter);
+}
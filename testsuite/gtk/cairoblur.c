@@ -0,0 +1,149 @@
+/* GtkCairoBlur tests.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <locale.h>
+
+#include "../../gtk/gtkcairoblurprivate.h"
+
+#include <string.h>
+
+/* Odd sizes, so that the vectorized code paths have to deal with
+ * partial strips at the end of rows and columns */
+static const int sizes[] = { 1, 3, 7, 13, 15, 17, 31, 33, 63, 65, 129 };
+
+/* Includes radii whose box filter is wider than the surface, and one
+ * that is too large for the vectorized code paths */
+static const double radii[] = { 2, 3, 5, 7, 9, 13, 25, 51, 150 };
+
+static const GtkBlurFlags flags[] = { GTK_BLUR_X, GTK_BLUR_Y, GTK_BLUR_X | GTK_BLUR_Y };
+
+static cairo_surface_t *
+create_random_surface (int width,
+                       int height)
+{
+  cairo_surface_t *surface;
+  guchar *data;
+  int x, y, stride;
+
+  surface = cairo_image_surface_create (CAIRO_FORMAT_A8, width, height);
+  cairo_surface_flush (surface);
+  data = cairo_image_surface_get_data (surface);
+  stride = cairo_image_surface_get_stride (surface);
+
+  for (y = 0; y < height; y++)
+    for (x = 0; x < width; x++)
+      data[y * stride + x] = g_test_rand_int_range (0, 256);
+
+  cairo_surface_mark_dirty (surface);
+
+  return surface;
+}
+
+static cairo_surface_t *
+copy_surface (cairo_surface_t *surface)
+{
+  cairo_surface_t *copy;
+
+  copy = cairo_image_surface_create (CAIRO_FORMAT_A8,
+                                     cairo_image_surface_get_width (surface),
+                                     cairo_image_surface_get_height (surface));
+  cairo_surface_flush (copy);
+  g_assert_cmpint (cairo_image_surface_get_stride (copy), ==, cairo_image_surface_get_stride (surface));
+  memcpy (cairo_image_surface_get_data (copy),
+          cairo_image_surface_get_data (surface),
+          cairo_image_surface_get_stride (surface) * cairo_image_surface_get_height (surface));
+  cairo_surface_mark_dirty (copy);
+
+  return copy;
+}
+
+static void
+assert_surfaces_equal (cairo_surface_t *expected,
+                       cairo_surface_t *surface,
+                       double           radius,
+                       GtkBlurFlags     blur_flags)
+{
+  guchar *expected_data, *data;
+  int width, height, stride;
+  int x, y;
+
+  width = cairo_image_surface_get_width (surface);
+  height = cairo_image_surface_get_height (surface);
+  stride = cairo_image_surface_get_stride (surface);
+  expected_data = cairo_image_surface_get_data (expected);
+  data = cairo_image_surface_get_data (surface);
+
+  for (y = 0; y < height; y++)
+    for (x = 0; x < width; x++)
+      {
+        if (expected_data[y * stride + x] != data[y * stride + x])
+          g_error ("%dx%d surface, radius %g, flags %d: pixel %d,%d is %u, expected %u",
+                   width, height, radius, blur_flags, x, y,
+                   data[y * stride + x], expected_data[y * stride + x]);
+      }
+}
+
+static void
+test_implementation (gconstpointer data)
+{
+  GtkBlurImplementation impl = GPOINTER_TO_INT (data);
+  guint w, h, r, f;
+
+  if (!_gtk_cairo_blur_set_implementation (impl))
+    {
+      g_test_skip ("Not supported on this machine");
+      return;
+    }
+
+  for (w = 0; w < G_N_ELEMENTS (sizes); w++)
+    for (h = 0; h < G_N_ELEMENTS (sizes); h += 2)
+      for (r = 0; r < G_N_ELEMENTS (radii); r++)
+        for (f = 0; f < G_N_ELEMENTS (flags); f++)
+          {
+            cairo_surface_t *expected, *surface;
+
+            expected = create_random_surface (sizes[w], sizes[h]);
+            surface = copy_surface (expected);
+
+            _gtk_cairo_blur_set_implementation (GTK_BLUR_IMPLEMENTATION_SCALAR);
+            _gtk_cairo_blur_surface (expected, radii[r], flags[f]);
+
+            _gtk_cairo_blur_set_implementation (impl);
+            _gtk_cairo_blur_surface (surface, radii[r], flags[f]);
+
+            cairo_surface_flush (expected);
+            cairo_surface_flush (surface);
+            assert_surfaces_equal (expected, surface, radii[r], flags[f]);
+
+            cairo_surface_destroy (expected);
+            cairo_surface_destroy (surface);
+          }
+
+  _gtk_cairo_blur_set_implementation (GTK_BLUR_IMPLEMENTATION_AUTO);
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  setlocale (LC_ALL, "C");
+
+  g_test_add_data_func ("/cairoblur/sse2", GINT_TO_POINTER (GTK_BLUR_IMPLEMENTATION_SSE2), test_implementation);
+  g_test_add_data_func ("/cairoblur/avx2", GINT_TO_POINTER (GTK_BLUR_IMPLEMENTATION_AVX2), test_implementation);
+  g_test_add_data_func ("/cairoblur/neon", GINT_TO_POINTER (GTK_BLUR_IMPLEMENTATION_NEON), test_implementation);
+
+  return g_test_run ();
+}
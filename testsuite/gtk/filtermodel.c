@@ -6850,6 +6850,186 @@ test_row_changed (void)
   g_object_unref (store);
 }
 
+static void
+rows_inserted (GtkTreeModel *model,
+               GtkTreePath  *path,
+               GtkTreeIter  *iter,
+               gint          n_rows,
+               gpointer      data)
+{
+  GArray *ranges = data;
+
+  g_array_append_val (ranges, n_rows);
+}
+
+static void
+check_filter_values (GtkTreeModel *filter,
+                     const gint   *expected,
+                     gint          n_expected)
+{
+  GtkTreeIter iter;
+  gint i;
+
+  g_assert_cmpint (gtk_tree_model_iter_n_children (filter, NULL), ==, n_expected);
+
+  for (i = 0; i < n_expected; i++)
+    {
+      gint value;
+
+      g_assert (gtk_tree_model_iter_nth_child (filter, &iter, NULL, i));
+      gtk_tree_model_get (filter, &iter, 0, &value, -1);
+      g_assert_cmpint (value, ==, expected[i]);
+    }
+}
+
+static void
+test_rows_inserted (void)
+{
+  GtkTreeModel *filter;
+  GtkListStore *store;
+  GtkWidget *tree_view;
+  GValue values[8] = { G_VALUE_INIT, };
+  gint columns[] = { 0, 1 };
+  const gint expected_empty[] = { 1, 3 };
+  const gint expected[] = { 0, 1, 1, 3, 4, 3 };
+  const gint expected_runs[] = { 0, 1, 1, 3, 4, 3, 0, 1, 3 };
+  int filter_row_inserted_count = 0;
+  GArray *ranges;
+  gint i;
+
+  for (i = 0; i < 4; i++)
+    {
+      g_value_init (&values[2 * i], G_TYPE_INT);
+      g_value_set_int (&values[2 * i], i);
+      g_value_init (&values[2 * i + 1], G_TYPE_BOOLEAN);
+      g_value_set_boolean (&values[2 * i + 1], i % 2 == 1);
+    }
+
+  store = gtk_list_store_new (2, G_TYPE_INT, G_TYPE_BOOLEAN);
+  filter = gtk_tree_model_filter_new (GTK_TREE_MODEL (store), NULL);
+  gtk_tree_model_filter_set_visible_column (GTK_TREE_MODEL_FILTER (filter), 1);
+  tree_view = gtk_tree_view_new_with_model (filter);
+
+  g_signal_connect (filter, "row-inserted",
+                    G_CALLBACK (row_changed), &filter_row_inserted_count);
+  ranges = g_array_new (FALSE, FALSE, sizeof (gint));
+  g_signal_connect (filter, "rows-inserted",
+                    G_CALLBACK (rows_inserted), ranges);
+
+  /* The filter has not built its root level yet */
+  gtk_list_store_insert_rows_with_valuesv (store, NULL, -1, 4,
+                                           columns, values, 2);
+  g_assert_cmpint (filter_row_inserted_count, ==, 2);
+  check_filter_values (filter, expected_empty, G_N_ELEMENTS (expected_empty));
+
+  /* Insert in between rows the filter already knows about */
+  gtk_list_store_insert_with_values (store, NULL, 0, 0, 0, 1, TRUE, -1);
+  gtk_list_store_insert_with_values (store, NULL, 3, 0, 4, 1, TRUE, -1);
+  filter_row_inserted_count = 0;
+
+  gtk_list_store_insert_rows_with_valuesv (store, NULL, 3, 4,
+                                           columns, values, 2);
+  g_assert_cmpint (filter_row_inserted_count, ==, 2);
+  g_assert_cmpint (gtk_tree_model_iter_n_children (GTK_TREE_MODEL (store), NULL), ==, 10);
+  check_filter_values (filter, expected, G_N_ELEMENTS (expected));
+
+  /* Adjacent visible rows are announced as one range */
+  g_value_set_boolean (&values[1], TRUE);
+  g_value_set_boolean (&values[3], TRUE);
+  g_value_set_boolean (&values[5], FALSE);
+  g_value_set_boolean (&values[7], TRUE);
+  g_array_set_size (ranges, 0);
+  filter_row_inserted_count = 0;
+
+  gtk_list_store_insert_rows_with_valuesv (store, NULL, -1, 4,
+                                           columns, values, 2);
+  g_assert_cmpint (filter_row_inserted_count, ==, 3);
+  g_assert_cmpint (ranges->len, ==, 2);
+  g_assert_cmpint (g_array_index (ranges, gint, 0), ==, 2);
+  g_assert_cmpint (g_array_index (ranges, gint, 1), ==, 1);
+  check_filter_values (filter, expected_runs, G_N_ELEMENTS (expected_runs));
+
+  g_array_unref (ranges);
+
+  gtk_widget_destroy (tree_view);
+  g_object_unref (filter);
+  g_object_unref (store);
+
+  for (i = 0; i < 8; i++)
+    g_value_unset (&values[i]);
+}
+
+static gboolean
+modulus_visible_func (GtkTreeModel *model,
+                      GtkTreeIter  *iter,
+                      gpointer      data)
+{
+  gint value;
+
+  gtk_tree_model_get (model, iter, 0, &value, -1);
+
+  return value % *(gint *) data == 0;
+}
+
+static void
+test_refilter_incremental (void)
+{
+  GtkTreeIter iter;
+  GtkTreePath *path;
+  GtkTreeStore *store;
+  GtkTreeModel *filter;
+  gint modulus = 1;
+  gint i, j;
+
+  store = gtk_tree_store_new (1, G_TYPE_INT);
+  for (i = 0; i < 3; i++)
+    {
+      GtkTreeIter parent;
+
+      gtk_tree_store_insert_with_values (store, &parent, NULL, i, 0, 0, -1);
+      for (j = 0; j < 1000; j++)
+        gtk_tree_store_insert_with_values (store, &iter, &parent, j, 0, j, -1);
+    }
+
+  path = gtk_tree_path_new_from_indices (1, -1);
+  filter = gtk_tree_model_filter_new (GTK_TREE_MODEL (store), path);
+  gtk_tree_path_free (path);
+  gtk_tree_model_filter_set_visible_func (GTK_TREE_MODEL_FILTER (filter),
+                                          modulus_visible_func, &modulus,
+                                          NULL);
+  g_assert_cmpint (gtk_tree_model_iter_n_children (filter, NULL), ==, 1000);
+
+  /* Nothing changes until the main loop runs */
+  modulus = 3;
+  gtk_tree_model_filter_refilter_incremental (GTK_TREE_MODEL_FILTER (filter));
+  g_assert_cmpint (gtk_tree_model_iter_n_children (filter, NULL), ==, 1000);
+
+  /* Rows removed while the refilter is pending are accounted for */
+  path = gtk_tree_path_new_from_indices (1, 0, -1);
+  gtk_tree_model_get_iter (GTK_TREE_MODEL (store), &iter, path);
+  gtk_tree_store_remove (store, &iter);
+  gtk_tree_path_free (path);
+
+  while (g_main_context_iteration (NULL, FALSE))
+    ;
+  g_assert_cmpint (gtk_tree_model_iter_n_children (filter, NULL), ==, 333);
+
+  /* A synchronous refilter finishes a pending incremental one */
+  modulus = 2;
+  gtk_tree_model_filter_refilter_incremental (GTK_TREE_MODEL_FILTER (filter));
+  gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (filter));
+  g_assert_cmpint (gtk_tree_model_iter_n_children (filter, NULL), ==, 499);
+
+  modulus = 5;
+  gtk_tree_model_filter_refilter_incremental (GTK_TREE_MODEL_FILTER (filter));
+  g_object_unref (filter);
+  g_object_unref (store);
+
+  /* Disposing the filter cancels the idle */
+  while (g_main_context_iteration (NULL, FALSE))
+    ;
+}
+
 
 /* main */
 
@@ -7214,4 +7394,7 @@ register_filter_model_tests (void)
                    specific_bug_679910);
 
   g_test_add_func ("/TreeModelFilter/signal/row-changed", test_row_changed);
+  g_test_add_func ("/TreeModelFilter/signal/rows-inserted", test_rows_inserted);
+  g_test_add_func ("/TreeModelFilter/refilter-incremental",
+                   test_refilter_incremental);
 }
@@ -455,6 +455,155 @@ list_store_test_insert_before_NULL (void)
   g_object_unref (store);
 }
 
+typedef struct
+{
+  gint ranges;
+  gint rows;
+  gint ranged_rows;
+  gint first_n_children;
+} InsertCounts;
+
+static void
+count_row_inserted (GtkTreeModel *model,
+                    GtkTreePath  *path,
+                    GtkTreeIter  *iter,
+                    InsertCounts *counts)
+{
+  GSignalInvocationHint *hint;
+  gint value;
+
+  /* Every replayed row is valid and at its final position */
+  gtk_tree_model_get (model, iter, 0, &value, -1);
+  g_assert_cmpint (value, ==, 100 + gtk_tree_path_get_indices (path)[0]);
+
+  if (counts->rows == 0)
+    counts->first_n_children = gtk_tree_model_iter_n_children (model, NULL);
+
+  hint = g_signal_get_invocation_hint (model);
+  if (hint->detail == g_quark_from_static_string ("range"))
+    counts->ranged_rows++;
+
+  counts->rows++;
+}
+
+static void
+count_rows_inserted (GtkTreeModel *model,
+                     GtkTreePath  *path,
+                     GtkTreeIter  *iter,
+                     gint          n_rows,
+                     InsertCounts *counts)
+{
+  g_assert_cmpint (gtk_tree_path_get_indices (path)[0], ==, 1);
+  g_assert_cmpint (n_rows, ==, 3);
+
+  counts->ranges++;
+}
+
+static void
+list_store_test_insert_rows (void)
+{
+  GtkListStore *store;
+  GtkTreeRowReference *ref;
+  GtkTreePath *path;
+  GtkTreeIter iter;
+  GValue values[3] = { G_VALUE_INIT, G_VALUE_INIT, G_VALUE_INIT };
+  gint columns[] = { 0 };
+  InsertCounts counts = { 0, };
+  gint i;
+
+  store = gtk_list_store_new (1, G_TYPE_INT);
+  gtk_list_store_insert_with_values (store, NULL, -1, 0, 100, -1);
+  gtk_list_store_insert_with_values (store, NULL, -1, 0, 104, -1);
+
+  path = gtk_tree_path_new_from_indices (1, -1);
+  ref = gtk_tree_row_reference_new (GTK_TREE_MODEL (store), path);
+  gtk_tree_path_free (path);
+
+  g_signal_connect (store, "row-inserted",
+                    G_CALLBACK (count_row_inserted), &counts);
+  g_signal_connect (store, "rows-inserted",
+                    G_CALLBACK (count_rows_inserted), &counts);
+
+  for (i = 0; i < 3; i++)
+    {
+      g_value_init (&values[i], G_TYPE_INT);
+      g_value_set_int (&values[i], 101 + i);
+    }
+
+  gtk_list_store_insert_rows_with_valuesv (store, &iter, 1, 3,
+                                           columns, values, 1);
+  g_assert (iter_position (store, &iter, 1));
+
+  /* One range, replayed row by row. All of the rows are already
+   * in the store when the first one is replayed.
+   */
+  g_assert_cmpint (counts.ranges, ==, 1);
+  g_assert_cmpint (counts.rows, ==, 3);
+  g_assert_cmpint (counts.ranged_rows, ==, 3);
+  g_assert_cmpint (counts.first_n_children, ==, 5);
+
+  /* The reference moved past the range exactly once */
+  path = gtk_tree_row_reference_get_path (ref);
+  g_assert_cmpint (gtk_tree_path_get_indices (path)[0], ==, 4);
+  gtk_tree_path_free (path);
+
+  /* Single rows are not part of a range */
+  gtk_list_store_insert_with_values (store, NULL, -1, 0, 105, -1);
+  g_assert_cmpint (counts.rows, ==, 4);
+  g_assert_cmpint (counts.ranged_rows, ==, 3);
+
+  gtk_tree_row_reference_free (ref);
+  for (i = 0; i < 3; i++)
+    g_value_unset (&values[i]);
+  g_object_unref (store);
+}
+
+static void
+count_row_changed (GtkTreeModel *model,
+                   GtkTreePath  *path,
+                   GtkTreeIter  *iter,
+                   gint         *n_changed)
+{
+  gint value;
+
+  /* All rows are set before the first row-changed */
+  gtk_tree_model_get (model, iter, 0, &value, -1);
+  g_assert_cmpint (value, ==, 200 + gtk_tree_path_get_indices (path)[0]);
+
+  (*n_changed)++;
+}
+
+static void
+list_store_test_replace_rows (void)
+{
+  GtkListStore *store;
+  GValue values[3] = { G_VALUE_INIT, G_VALUE_INIT, G_VALUE_INIT };
+  gint columns[] = { 0 };
+  gint n_changed = 0;
+  gint i;
+
+  store = gtk_list_store_new (1, G_TYPE_INT);
+  for (i = 0; i < 5; i++)
+    gtk_list_store_insert_with_values (store, NULL, -1, 0, 100 + i, -1);
+
+  g_signal_connect (store, "row-changed",
+                    G_CALLBACK (count_row_changed), &n_changed);
+
+  for (i = 0; i < 3; i++)
+    {
+      g_value_init (&values[i], G_TYPE_INT);
+      g_value_set_int (&values[i], 201 + i);
+    }
+
+  gtk_list_store_replace_rows_with_valuesv (store, 1, 3, columns, values, 1);
+  g_assert_cmpint (n_changed, ==, 3);
+  g_assert_cmpint (gtk_tree_model_iter_n_children (GTK_TREE_MODEL (store), NULL), ==, 5);
+
+  for (i = 0; i < 3; i++)
+    g_value_unset (&values[i]);
+  g_object_unref (store);
+}
+
 /* setting values */
 static void
 list_store_set_gvalue_to_transform (void)
@@ -1033,6 +1182,10 @@ register_list_store_tests (void)
 		   list_store_test_insert_before);
   g_test_add_func ("/ListStore/insert-before-NULL",
 		   list_store_test_insert_before_NULL);
+  g_test_add_func ("/ListStore/insert-rows",
+		   list_store_test_insert_rows);
+  g_test_add_func ("/ListStore/replace-rows",
+		   list_store_test_replace_rows);
 
   /* setting values (FIXME) */
   g_test_add_func ("/ListStore/set-gvalue-to-transform",
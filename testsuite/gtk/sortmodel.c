@@ -1029,6 +1029,243 @@ sorted_insert (void)
   g_object_unref (ref_model);
 }
 
+static void
+sorted_insert_rows (void)
+{
+  GtkTreeIter iter;
+  GtkTreeStore *store;
+  GtkTreeModel *sort_model;
+  GtkWidget *tree_view;
+  SignalMonitor *monitor;
+  GValue values[3] = { G_VALUE_INIT, G_VALUE_INIT, G_VALUE_INIT };
+  gint columns[] = { 0 };
+  const gint new_values[] = { 50, 5, 35 };
+  gint i;
+
+  for (i = 0; i < 3; i++)
+    {
+      g_value_init (&values[i], G_TYPE_INT);
+      g_value_set_int (&values[i], new_values[i]);
+    }
+
+  store = gtk_tree_store_new (1, G_TYPE_INT);
+  sort_model = gtk_tree_model_sort_new_with_model (GTK_TREE_MODEL (store));
+  tree_view = gtk_tree_view_new_with_model (sort_model);
+
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (sort_model),
+                                        0, GTK_SORT_ASCENDING);
+
+  /* The sort model has not built its root level yet */
+  gtk_tree_store_insert_rows_with_valuesv (store, NULL, NULL, 0, 3,
+                                           columns, values, 1);
+  g_assert_cmpint (gtk_tree_model_iter_n_children (sort_model, NULL), ==, 3);
+  check_sort_order (sort_model, GTK_SORT_ASCENDING, NULL);
+
+  gtk_tree_store_insert_with_values (GTK_TREE_STORE (store), &iter, NULL, 0,
+                                     0, 30, -1);
+  gtk_tree_store_insert_with_values (GTK_TREE_STORE (store), &iter, NULL, 1,
+                                     0, 40, -1);
+
+  /* 5 30 35 40 50; each new row is announced at its sorted position */
+  g_value_set_int (&values[0], 45);
+  g_value_set_int (&values[1], 1);
+  g_value_set_int (&values[2], 33);
+
+  monitor = signal_monitor_new (sort_model);
+  signal_monitor_append_signal (monitor, ROW_INSERTED, "4");
+  signal_monitor_append_signal (monitor, ROW_INSERTED, "0");
+  signal_monitor_append_signal (monitor, ROW_INSERTED, "3");
+  gtk_tree_store_insert_rows_with_valuesv (store, NULL, NULL, 1, 3,
+                                           columns, values, 1);
+  signal_monitor_assert_is_empty (monitor);
+  signal_monitor_free (monitor);
+
+  g_assert_cmpint (gtk_tree_model_iter_n_children (sort_model, NULL), ==, 8);
+  check_sort_order (sort_model, GTK_SORT_ASCENDING, NULL);
+
+  /* Without a sort order, the rows stay together */
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (sort_model),
+                                        GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID,
+                                        GTK_SORT_ASCENDING);
+
+  monitor = signal_monitor_new (sort_model);
+  signal_monitor_append_signal (monitor, ROW_INSERTED, "2");
+  signal_monitor_append_signal (monitor, ROW_INSERTED, "3");
+  signal_monitor_append_signal (monitor, ROW_INSERTED, "4");
+  gtk_tree_store_insert_rows_with_valuesv (store, NULL, NULL, 2, 3,
+                                           columns, values, 1);
+  signal_monitor_assert_is_empty (monitor);
+
+  signal_monitor_free (monitor);
+
+  gtk_widget_destroy (tree_view);
+  g_object_unref (sort_model);
+  g_object_unref (store);
+
+  for (i = 0; i < 3; i++)
+    g_value_unset (&values[i]);
+}
+
+static void
+negated_key_func (GtkTreeModel *model,
+                  GtkTreeIter  *iter,
+                  GValue       *key,
+                  gpointer      data)
+{
+  gint value;
+
+  gtk_tree_model_get (model, iter, 0, &value, -1);
+
+  g_value_init (key, G_TYPE_INT);
+  g_value_set_int (key, -value);
+
+  (*(gint *) data)++;
+}
+
+static void
+sort_key_func (void)
+{
+  GtkTreeIter iter;
+  GtkListStore *store;
+  GtkTreeModel *sort_model;
+  gint n_calls = 0;
+  gint i;
+
+  store = gtk_list_store_new (1, G_TYPE_INT);
+  for (i = 0; i < 100; i++)
+    gtk_list_store_insert_with_values (store, NULL, i, 0, (i * 37) % 100, -1);
+
+  sort_model = gtk_tree_model_sort_new_with_model (GTK_TREE_MODEL (store));
+  gtk_tree_model_sort_set_sort_key_func (GTK_TREE_MODEL_SORT (sort_model), 0,
+                                         negated_key_func, &n_calls, NULL);
+  g_assert_cmpint (gtk_tree_model_iter_n_children (sort_model, NULL), ==, 100);
+
+  /* Each key is extracted once */
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (sort_model),
+                                        0, GTK_SORT_ASCENDING);
+  g_assert_cmpint (n_calls, ==, 100);
+  check_sort_order (sort_model, GTK_SORT_DESCENDING, NULL);
+
+  /* Changing the order keeps the keys */
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (sort_model),
+                                        0, GTK_SORT_DESCENDING);
+  g_assert_cmpint (n_calls, ==, 100);
+  check_sort_order (sort_model, GTK_SORT_ASCENDING, NULL);
+
+  /* A changed row only has its own key extracted again */
+  gtk_tree_model_get_iter_first (GTK_TREE_MODEL (store), &iter);
+  gtk_list_store_set (store, &iter, 0, 1000, -1);
+  g_assert_cmpint (n_calls, ==, 101);
+  check_sort_order (sort_model, GTK_SORT_ASCENDING, NULL);
+
+  /* New rows are sorted by key as well */
+  gtk_list_store_insert_with_values (store, NULL, 0, 0, 50, -1);
+  g_assert_cmpint (n_calls, ==, 102);
+  check_sort_order (sort_model, GTK_SORT_ASCENDING, NULL);
+
+  g_object_unref (sort_model);
+  g_object_unref (store);
+}
+
+static void
+sort_key_func_large (void)
+{
+  GtkListStore *store;
+  GtkTreeModel *sort_model;
+  gint n_calls = 0;
+  gint i;
+
+  /* Large enough to be sorted on several threads */
+  store = gtk_list_store_new (1, G_TYPE_INT);
+  for (i = 0; i < 50000; i++)
+    gtk_list_store_insert_with_values (store, NULL, i, 0, (i * 7919) % 1000, -1);
+
+  sort_model = gtk_tree_model_sort_new_with_model (GTK_TREE_MODEL (store));
+  gtk_tree_model_sort_set_sort_key_func (GTK_TREE_MODEL_SORT (sort_model), 0,
+                                         negated_key_func, &n_calls, NULL);
+  g_assert_cmpint (gtk_tree_model_iter_n_children (sort_model, NULL), ==, 50000);
+
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (sort_model),
+                                        0, GTK_SORT_ASCENDING);
+  g_assert_cmpint (n_calls, ==, 50000);
+  check_sort_order (sort_model, GTK_SORT_DESCENDING, NULL);
+
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (sort_model),
+                                        0, GTK_SORT_DESCENDING);
+  g_assert_cmpint (n_calls, ==, 50000);
+  check_sort_order (sort_model, GTK_SORT_ASCENDING, NULL);
+
+  g_object_unref (sort_model);
+  g_object_unref (store);
+}
+
+static void
+char_key_func (GtkTreeModel *model,
+               GtkTreeIter  *iter,
+               GValue       *key,
+               gpointer      data)
+{
+  gint value;
+
+  gtk_tree_model_get (model, iter, 0, &value, -1);
+
+  g_value_init (key, G_TYPE_CHAR);
+  g_value_set_schar (key, value);
+}
+
+static void
+sort_key_func_unset (void)
+{
+  GtkListStore *store;
+  GtkTreeModel *sort_model;
+  gint sort_column_id;
+  GtkSortType order;
+  gint n_calls = 0;
+  gint i;
+
+  store = gtk_list_store_new (1, G_TYPE_INT);
+  for (i = 0; i < 100; i++)
+    gtk_list_store_insert_with_values (store, NULL, i, 0, (i * 37) % 100, -1);
+
+  sort_model = gtk_tree_model_sort_new_with_model (GTK_TREE_MODEL (store));
+
+  /* Character keys */
+  gtk_tree_model_sort_set_sort_key_func (GTK_TREE_MODEL_SORT (sort_model), 0,
+                                         char_key_func, NULL, NULL);
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (sort_model),
+                                        0, GTK_SORT_ASCENDING);
+  check_sort_order (sort_model, GTK_SORT_ASCENDING, NULL);
+
+  /* A column of the child model sorts by its values again */
+  gtk_tree_model_sort_set_sort_key_func (GTK_TREE_MODEL_SORT (sort_model), 0,
+                                         negated_key_func, &n_calls, NULL);
+  check_sort_order (sort_model, GTK_SORT_DESCENDING, NULL);
+  gtk_tree_model_sort_set_sort_key_func (GTK_TREE_MODEL_SORT (sort_model), 0,
+                                         NULL, NULL, NULL);
+  check_sort_order (sort_model, GTK_SORT_ASCENDING, NULL);
+  g_assert (gtk_tree_sortable_get_sort_column_id (GTK_TREE_SORTABLE (sort_model),
+                                                  &sort_column_id, &order));
+  g_assert_cmpint (sort_column_id, ==, 0);
+
+  /* Other columns lose their sort function */
+  gtk_tree_model_sort_set_sort_key_func (GTK_TREE_MODEL_SORT (sort_model), 5,
+                                         negated_key_func, &n_calls, NULL);
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (sort_model),
+                                        5, GTK_SORT_ASCENDING);
+  check_sort_order (sort_model, GTK_SORT_DESCENDING, NULL);
+  gtk_tree_model_sort_set_sort_key_func (GTK_TREE_MODEL_SORT (sort_model), 5,
+                                         NULL, NULL, NULL);
+  g_assert (!gtk_tree_sortable_get_sort_column_id (GTK_TREE_SORTABLE (sort_model),
+                                                   &sort_column_id, &order));
+  g_assert_cmpint (sort_column_id, ==, GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID);
+
+  /* Rows still arrive without a sort function */
+  gtk_list_store_insert_with_values (store, NULL, 0, 0, 50, -1);
+  g_assert_cmpint (gtk_tree_model_iter_n_children (sort_model, NULL), ==, 101);
+
+  g_object_unref (sort_model);
+  g_object_unref (store);
+}
 
 static void
 specific_bug_300089 (void)
@@ -1317,6 +1554,14 @@ register_sort_model_tests (void)
                    rows_reordered_two_levels);
   g_test_add_func ("/TreeModelSort/sorted-insert",
                    sorted_insert);
+  g_test_add_func ("/TreeModelSort/sorted-insert-rows",
+                   sorted_insert_rows);
+  g_test_add_func ("/TreeModelSort/sort-key-func",
+                   sort_key_func);
+  g_test_add_func ("/TreeModelSort/sort-key-func-large",
+                   sort_key_func_large);
+  g_test_add_func ("/TreeModelSort/sort-key-func-unset",
+                   sort_key_func_unset);
 
   g_test_add_func ("/TreeModelSort/specific/bug-300089",
                    specific_bug_300089);
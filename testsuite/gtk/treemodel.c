@@ -28,6 +28,7 @@ main (int    argc,
   g_test_bug_base ("http://bugzilla.gnome.org/");
 
   register_list_store_tests ();
+  register_array_store_tests ();
   register_tree_store_tests ();
   register_model_ref_count_tests ();
   register_sort_model_tests ();